@@ -0,0 +1,79 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+import argparse
+import os
+import tempfile
+import time
+
+import mxnet as mx
+import numpy as np
+
+parser = argparse.ArgumentParser(description="Benchmark CSVIter parsing throughput",
+                                 formatter_class=argparse.ArgumentDefaultsHelpFormatter)
+parser.add_argument('--num-rows', type=int, default=20000, help='number of rows in the generated file')
+parser.add_argument('--num-cols', type=str, default='16,256,4096', help='comma separated column counts')
+parser.add_argument('--batch-size', type=int, default=256, help='batch size of the iterator')
+parser.add_argument('--threads', type=str, default='1,2,4,8', help='comma separated preprocess_threads')
+parser.add_argument('--dtype', type=str, default='float32', help='float32, int32 or int64')
+args = parser.parse_args()
+
+
+def generate_csv(path, num_rows, num_cols, dtype):
+    rng = np.random.RandomState(0)
+    chunk = 1000
+    with open(path, 'w') as f:
+        for start in range(0, num_rows, chunk):
+            n = min(chunk, num_rows - start)
+            if dtype == 'float32':
+                data = rng.uniform(-1000, 1000, size=(n, num_cols)).astype(np.float32)
+                np.savetxt(f, data, fmt='%.6g', delimiter=',')
+            else:
+                data = rng.randint(-100000, 100000, size=(n, num_cols))
+                np.savetxt(f, data, fmt='%d', delimiter=',')
+
+
+def measure(path, num_cols, threads):
+    it = mx.io.CSVIter(data_csv=path, data_shape=(num_cols,), batch_size=args.batch_size,
+                       round_batch=False, dtype=args.dtype, preprocess_threads=threads)
+    # warm up the page cache and the parser threads
+    for _ in it:
+        pass
+    it.reset()
+    start = time.time()
+    rows = 0
+    for batch in it:
+        batch.data[0].wait_to_read()
+        rows += args.batch_size - batch.pad
+    return rows / (time.time() - start)
+
+
+def run_benchmark():
+    tmpdir = tempfile.mkdtemp()
+    print('{:>10} {:>10} {:>10} {:>14}'.format('rows', 'cols', 'threads', 'rows/sec'))
+    for num_cols in [int(c) for c in args.num_cols.split(',')]:
+        path = os.path.join(tmpdir, 'data_%d.csv' % num_cols)
+        generate_csv(path, args.num_rows, num_cols, args.dtype)
+        for threads in [int(t) for t in args.threads.split(',')]:
+            rate = measure(path, num_cols, threads)
+            print('{:10d} {:10d} {:10d} {:14.1f}'.format(args.num_rows, num_cols, threads, rate))
+        os.remove(path)
+    os.rmdir(tmpdir)
+
+
+if __name__ == "__main__":
+    run_benchmark()
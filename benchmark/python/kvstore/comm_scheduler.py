@@ -0,0 +1,91 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+"""Step time of data parallel training with a dist kvstore.
+
+Trains a model of the gluon model zoo on synthetic data and reports the time per
+step. The Trainer pushes the gradient of parameter i with priority -i, so the
+scheduler of the workers sends the gradients of the first layers, which the next
+forward pass needs first, ahead of the others. Compare the default with the
+scheduler disabled:
+
+    for credit in 0 16777216; do
+        MXNET_KVSTORE_SCHEDULER_CREDIT=$credit python tools/launch.py -n 2 -s 2 \\
+            --launcher local python benchmark/python/kvstore/comm_scheduler.py
+    done
+
+MXNET_KVSTORE_SLICE_BYTES sets the size of the slices large gradients are split into.
+"""
+
+import argparse
+import os
+import time
+import mxnet as mx
+from mxnet import autograd, gluon
+
+parser = argparse.ArgumentParser(description="Benchmark the step time of dist kvstore",
+                                 formatter_class=argparse.ArgumentDefaultsHelpFormatter)
+parser.add_argument('--model', type=str, default='resnet18_v1',
+                    help='model of gluon.model_zoo.vision')
+parser.add_argument('--batch-size', type=int, default=32, help='batch size per worker')
+parser.add_argument('--image-size', type=int, default=224, help='height and width of the input')
+parser.add_argument('--num-classes', type=int, default=1000, help='number of classes')
+parser.add_argument('--kv-store', type=str, default='dist_sync', help='the kvstore type')
+parser.add_argument('--num-steps', type=int, default=50, help='number of timed steps')
+parser.add_argument('--warmup-steps', type=int, default=5, help='number of untimed steps')
+parser.add_argument('--gpu', action='store_true', help='train on the gpu of the local rank')
+args = parser.parse_args()
+
+
+def run():
+    kv = mx.kv.create(args.kv_store)
+    ctx = mx.gpu(kv.rank % mx.context.num_gpus()) if args.gpu else mx.cpu()
+    net = gluon.model_zoo.vision.get_model(args.model, classes=args.num_classes)
+    net.initialize(mx.init.Xavier(), ctx=ctx)
+    net.hybridize(static_alloc=True, static_shape=True)
+    trainer = gluon.Trainer(net.collect_params(), 'sgd',
+                            {'learning_rate': 0.01, 'momentum': 0.9}, kvstore=kv)
+    loss_fn = gluon.loss.SoftmaxCrossEntropyLoss()
+    data = mx.nd.random.uniform(shape=(args.batch_size, 3, args.image_size, args.image_size),
+                                ctx=ctx)
+    label = mx.nd.random.randint(0, args.num_classes, shape=(args.batch_size,),
+                                 ctx=ctx).astype('float32')
+
+    def step():
+        with autograd.record():
+            loss = loss_fn(net(data), label)
+        loss.backward()
+        trainer.step(args.batch_size)
+
+    for _ in range(args.warmup_steps):
+        step()
+    mx.nd.waitall()
+    tic = time.time()
+    for _ in range(args.num_steps):
+        step()
+    mx.nd.waitall()
+    elapsed = time.time() - tic
+    if kv.rank == 0:
+        print('%s, %d workers, credit %s, slice %s bytes: %.1f ms per step, %.1f samples/s' % (
+            args.model, kv.num_workers, os.environ.get('MXNET_KVSTORE_SCHEDULER_CREDIT', 'default'),
+            os.environ.get('MXNET_KVSTORE_SLICE_BYTES', 'default'),
+            elapsed / args.num_steps * 1000,
+            args.num_steps * args.batch_size * kv.num_workers / elapsed))
+
+
+if __name__ == '__main__':
+    run()
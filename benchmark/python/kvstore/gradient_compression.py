@@ -0,0 +1,102 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+"""Bandwidth and accuracy of the gradient compression types of dist kvstores.
+
+Every worker pushes random gradients for a set of keys and pulls the merged result
+back. Without an optimizer the servers store the merged gradient, so summing the
+pulled values over all steps and comparing with the exact sum of all workers'
+gradients shows how well the residual of each compression type compensates its error.
+
+Run all types with two local workers and two servers, e.g.:
+
+    for gc in none 2bit 1bit topk fp16 bf16; do
+        python tools/launch.py -n 2 -s 2 --launcher local \\
+            python benchmark/python/kvstore/gradient_compression.py --gc-type $gc
+    done
+"""
+
+import argparse
+import time
+import numpy as np
+import mxnet as mx
+
+parser = argparse.ArgumentParser(description="Benchmark gradient compression of dist kvstore",
+                                 formatter_class=argparse.ArgumentDefaultsHelpFormatter)
+parser.add_argument('--gc-type', type=str, default='none',
+                    help='none, 2bit, 1bit, topk, fp16 or bf16')
+parser.add_argument('--threshold', type=float, default=0.5,
+                    help='threshold of 2bit and 1bit compression')
+parser.add_argument('--ratio', type=float, default=0.01, help='ratio of topk compression')
+parser.add_argument('--kv-store', type=str, default='dist_sync', help='the kvstore type')
+parser.add_argument('--num-steps', type=int, default=50, help='number of push/pull rounds')
+parser.add_argument('--sizes', type=str, default='1000,100000,4000000',
+                    help='number of elements of each key')
+args = parser.parse_args()
+
+# bits sent per gradient value
+BITS = {'none': 32, '2bit': 2, '1bit': 1, 'fp16': 16, 'bf16': 16}
+
+
+def gradient(rank, step, size):
+    """gradient of a worker, every worker can regenerate all of them"""
+    return np.random.RandomState(rank * 100003 + step).normal(0, 0.1, size).astype(np.float32)
+
+
+def run():
+    kv = mx.kv.create(args.kv_store)
+    if args.gc_type != 'none':
+        kv.set_gradient_compression({'type': args.gc_type, 'threshold': args.threshold,
+                                     'ratio': args.ratio})
+    sizes = [int(s) for s in args.sizes.split(',')]
+    for k, size in enumerate(sizes):
+        kv.init(k, mx.nd.zeros((size,)))
+
+    outs = [mx.nd.zeros((size,)) for size in sizes]
+    pulled = [np.zeros(size) for size in sizes]
+    expected = [np.zeros(size) for size in sizes]
+    elapsed = 0
+    for step in range(args.num_steps):
+        grads = [mx.nd.array(gradient(kv.rank, step, size)) for size in sizes]
+        mx.nd.waitall()
+        tic = time.time()
+        for k, g in enumerate(grads):
+            kv.push(k, g, priority=-k)
+        for k, o in enumerate(outs):
+            kv.pull(k, out=o, priority=-k)
+        mx.nd.waitall()
+        elapsed += time.time() - tic
+        for k, size in enumerate(sizes):
+            pulled[k] += outs[k].asnumpy()
+            for r in range(kv.num_workers):
+                expected[k] += gradient(r, step, size)
+
+    total = sum(sizes)
+    bits = BITS.get(args.gc_type, 32.0 * args.ratio)
+    err = sum(np.linalg.norm(p - e) for p, e in zip(pulled, expected)) / \
+        sum(np.linalg.norm(e) for e in expected)
+    step_time = elapsed / args.num_steps
+    if kv.rank == 0:
+        print('{:>8} {:>12} {:>10} {:>16} {:>12} {:>10}'.format(
+            'type', 'elements', 'ms/step', 'MB pushed/step', 'GB/s fp32', 'rel.err'))
+        print('{:>8} {:>12d} {:>10.2f} {:>16.3f} {:>12.3f} {:>10.4f}'.format(
+            args.gc_type, total, step_time * 1000, total * bits / 8 / 1e6,
+            total * 4 * 2 / step_time / 1e9, err))
+
+
+if __name__ == "__main__":
+    run()
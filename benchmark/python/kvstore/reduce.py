@@ -0,0 +1,91 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+"""Throughput of the reduction of the local kvstore on the CPU.
+
+Pushes a list of arrays on several CPU contexts to a `local` kvstore, which sums
+them on the CPU, for dense arrays of several sizes and row_sparse arrays of
+several densities. Compare the number of threads with e.g.:
+
+    for n in 1 4 16; do
+        MXNET_KVSTORE_REDUCTION_NTHREADS=$n python benchmark/python/kvstore/reduce.py
+    done
+
+MXNET_KVSTORE_SERIAL_PUSH=1 selects the serial row_sparse reduction.
+"""
+
+import argparse
+import time
+import mxnet as mx
+from mxnet.test_utils import rand_ndarray
+
+parser = argparse.ArgumentParser(description="Benchmark the CPU reduction of the local kvstore",
+                                 formatter_class=argparse.ArgumentDefaultsHelpFormatter)
+parser.add_argument('--sizes', type=str, default='10000,1000000,10000000,50000000',
+                    help='number of elements of the dense arrays')
+parser.add_argument('--num-srcs', type=str, default='2,4,8,16',
+                    help='number of arrays summed up')
+parser.add_argument('--dtype', type=str, default='float32', help='type of the dense arrays')
+parser.add_argument('--sparse-shape', type=str, default='1000000,128',
+                    help='shape of the row_sparse arrays, empty to skip them')
+parser.add_argument('--densities', type=str, default='0.001,0.01,0.1',
+                    help='densities of the row_sparse arrays')
+parser.add_argument('--repeat', type=int, default=20, help='number of timed reductions')
+args = parser.parse_args()
+
+
+def measure(kv, key, vals):
+    """seconds per push of vals, after a warm-up push"""
+    kv.push(key, vals)
+    mx.nd.waitall()
+    tic = time.time()
+    for _ in range(args.repeat):
+        kv.push(key, vals)
+    mx.nd.waitall()
+    return (time.time() - tic) / args.repeat
+
+
+def run():
+    kv = mx.kv.create('local')
+    num_srcs = [int(n) for n in args.num_srcs.split(',')]
+    key = 0
+    print('%10s %12s %8s %10s %10s' % ('stype', 'size', 'sources', 'ms', 'GB/s'))
+    for size in [int(s) for s in args.sizes.split(',')]:
+        for n in num_srcs:
+            kv.init(key, mx.nd.zeros((size,), dtype=args.dtype))
+            vals = [mx.nd.ones((size,), ctx=mx.cpu(i), dtype=args.dtype) for i in range(n)]
+            t = measure(kv, key, vals)
+            nbytes = size * n * vals[0].asnumpy().itemsize
+            print('%10s %12d %8d %10.3f %10.2f' % ('default', size, n, t * 1e3, nbytes / t / 1e9))
+            key += 1
+    if not args.sparse_shape:
+        return
+    shape = tuple(int(s) for s in args.sparse_shape.split(','))
+    for density in [float(d) for d in args.densities.split(',')]:
+        for n in num_srcs:
+            kv.init(key, mx.nd.sparse.zeros('row_sparse', shape))
+            vals = [rand_ndarray(shape, 'row_sparse', density=density).copyto(mx.cpu(i))
+                    for i in range(n)]
+            t = measure(kv, key, vals)
+            nbytes = sum(v.data.size for v in vals) * 4
+            print('%10s %12s %8d %10.3f %10.2f' % ('rsp %g' % density, 'x'.join(map(str, shape)),
+                                                   n, t * 1e3, nbytes / t / 1e9))
+            key += 1
+
+
+if __name__ == '__main__':
+    run()
@@ -0,0 +1,82 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+"""Latency of the fused RNN operator for small-batch inference on cpu.
+
+Runs the LSTM and GRU layers of gluon, which call the RNN operator, and reports
+the time per call and per step of the sequence. Compare the packed weights of MKL
+with the default:
+
+    for packed in 0 1; do
+        MXNET_RNN_PACKED_WEIGHTS=$packed python benchmark/python/rnn/rnn_inference.py
+    done
+"""
+
+from __future__ import print_function
+
+import argparse
+import os
+import time
+from itertools import product
+
+import mxnet as mx
+from mxnet import gluon
+
+parser = argparse.ArgumentParser(description="Benchmark the cpu RNN inference latency",
+                                 formatter_class=argparse.ArgumentDefaultsHelpFormatter)
+parser.add_argument('--modes', type=str, default='lstm,gru', help='comma separated RNN modes')
+parser.add_argument('--batch-sizes', type=str, default='1,4,16', help='comma separated')
+parser.add_argument('--hidden-sizes', type=str, default='256,512,1024', help='comma separated')
+parser.add_argument('--seq-length', type=int, default=50, help='number of steps')
+parser.add_argument('--num-layers', type=int, default=1, help='number of layers')
+parser.add_argument('--bidirectional', action='store_true', help='bidirectional layers')
+parser.add_argument('--num-calls', type=int, default=20, help='number of timed calls')
+args = parser.parse_args()
+
+
+def layer(mode, hidden_size):
+    cls = gluon.rnn.LSTM if mode == 'lstm' else gluon.rnn.GRU
+    net = cls(hidden_size, num_layers=args.num_layers, bidirectional=args.bidirectional,
+              input_size=hidden_size)
+    net.initialize(mx.init.Xavier(), ctx=mx.cpu())
+    net.hybridize(static_alloc=True, static_shape=True)
+    return net
+
+
+def run():
+    print('packed weights: %s, %d layers%s, %d steps' % (
+        os.environ.get('MXNET_RNN_PACKED_WEIGHTS', '0'), args.num_layers,
+        ', bidirectional' if args.bidirectional else '', args.seq_length))
+    modes = args.modes.split(',')
+    batch_sizes = [int(n) for n in args.batch_sizes.split(',')]
+    hidden_sizes = [int(h) for h in args.hidden_sizes.split(',')]
+    for mode, hidden_size, batch_size in product(modes, hidden_sizes, batch_sizes):
+        net = layer(mode, hidden_size)
+        data = mx.nd.random.uniform(shape=(args.seq_length, batch_size, hidden_size))
+        # warm up, the first call allocates the memory of the graph
+        net(data).wait_to_read()
+        tic = time.time()
+        for _ in range(args.num_calls):
+            out = net(data)
+        out.wait_to_read()
+        elapsed = (time.time() - tic) / args.num_calls
+        print('%s hidden %4d batch %3d: %8.3f ms per call, %7.1f us per step' % (
+            mode, hidden_size, batch_size, elapsed * 1e3, elapsed * 1e6 / args.seq_length))
+
+
+if __name__ == '__main__':
+    run()
@@ -0,0 +1,103 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+"""Throughput of the cpu sparse-dense matrix products across sparsity levels.
+
+Times dot(csr, dns) and dot(dns, csr.T) against the dense dot of the same
+shapes, on random csr matrices whose rows have uniform or skewed numbers of
+non-zeros. Both are reported in GFLOP/s of the non-zero multiply-adds.
+"""
+
+from __future__ import print_function
+
+import argparse
+import time
+
+import mxnet as mx
+import numpy as np
+import scipy.sparse as sp
+
+parser = argparse.ArgumentParser(description="Benchmark the cpu sparse-dense dot",
+                                 formatter_class=argparse.ArgumentDefaultsHelpFormatter)
+parser.add_argument('--num-omp-threads', type=int, default=0,
+                    help='number of omp threads to set in MXNet, 0 keeps the default')
+parser.add_argument('--rows', type=int, default=1024, help='number of rows of the csr matrix')
+parser.add_argument('--feature-dim', type=int, default=10000,
+                    help='number of columns of the csr matrix')
+parser.add_argument('--output-dims', type=str, default='64,256,1024',
+                    help='comma separated columns of the dense operand')
+parser.add_argument('--densities', type=str, default='0.0001,0.001,0.01,0.05',
+                    help='comma separated densities of the csr matrix')
+parser.add_argument('--repeat', type=int, default=10, help='number of timed runs')
+args = parser.parse_args()
+
+
+def random_csr(rows, cols, density, skewed):
+    """csr matrix of rows x cols, whose rows have the same number of non-zeros on average, or a
+    number of non-zeros which follows a power law when skewed"""
+    if not skewed:
+        return sp.random(rows, cols, density=density, format='csr', dtype=np.float32)
+    weights = 1.0 / np.arange(1, rows + 1)
+    nnz = np.minimum(cols, np.ceil(weights / weights.sum() * rows * cols * density)).astype(int)
+    indptr = np.concatenate([[0], np.cumsum(nnz)])
+    indices = np.concatenate([np.random.choice(cols, n, replace=False) for n in nnz])
+    data = np.random.uniform(size=indptr[-1]).astype(np.float32)
+    return sp.csr_matrix((data, indices, indptr), shape=(rows, cols))
+
+
+def measure_cost(f):
+    f().wait_to_read()
+    start = time.time()
+    for _ in range(args.repeat):
+        out = f()
+    out.wait_to_read()
+    return (time.time() - start) / args.repeat
+
+
+def run():
+    if args.num_omp_threads > 0:
+        mx.base.check_call(mx.base._LIB.MXSetNumOMPThreads(mx.base.ctypes.c_int(
+            args.num_omp_threads)))
+    output_dims = [int(m) for m in args.output_dims.split(',')]
+    densities = [float(d) for d in args.densities.split(',')]
+    print('%-16s %6s %8s %6s %12s %12s %10s' % ('op', 'dim', 'density', 'skewed',
+                                                'sparse GF/s', 'dense GF/s', 'speedup'))
+    for skewed in [False, True]:
+        for density in densities:
+            scipy_csr = random_csr(args.rows, args.feature_dim, density, skewed)
+            csr = mx.nd.sparse.csr_matrix(scipy_csr)
+            dense = csr.tostype('default')
+            for dim in output_dims:
+                rhs = mx.nd.random.uniform(shape=(args.feature_dim, dim))
+                lhs = mx.nd.random.uniform(shape=(dim, args.feature_dim))
+                flops = 2.0 * scipy_csr.nnz * dim / 1e9
+                cases = [
+                    ('dot(csr, dns)', lambda: mx.nd.sparse.dot(csr, rhs),
+                     lambda: mx.nd.dot(dense, rhs)),
+                    ('dot(dns, csr.T)', lambda: mx.nd.sparse.dot(lhs, csr, transpose_b=True),
+                     lambda: mx.nd.dot(lhs, dense, transpose_b=True)),
+                ]
+                for name, sparse_f, dense_f in cases:
+                    sparse_cost = measure_cost(sparse_f)
+                    dense_cost = measure_cost(dense_f)
+                    print('%-16s %6d %8g %6s %12.2f %12.2f %10.2f' % (
+                        name, dim, density, skewed, flops / sparse_cost, flops / dense_cost,
+                        dense_cost / sparse_cost))
+
+
+if __name__ == '__main__':
+    run()
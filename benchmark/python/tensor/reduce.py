@@ -0,0 +1,73 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+
+"""Throughput of the cpu reductions along the first, a middle, the last and all axes.
+
+Times sum, mean and max of float32 arrays of several shapes and reports the time
+per call and the GB/s of the input which is read. Reducing a single axis, or
+adjacent axes, runs on contiguous rows; other axes keep the generic reduction.
+"""
+
+from __future__ import print_function
+
+import argparse
+import time
+
+import mxnet as mx
+
+parser = argparse.ArgumentParser(description="Benchmark the cpu reductions",
+                                 formatter_class=argparse.ArgumentDefaultsHelpFormatter)
+parser.add_argument('--num-omp-threads', type=int, default=0,
+                    help='number of omp threads to set in MXNet, 0 keeps the default')
+parser.add_argument('--ops', type=str, default='sum,mean,max', help='comma separated reductions')
+parser.add_argument('--shapes', type=str, default='4096x1024;128x128x128;32x512x768;64x64x64x64',
+                    help='semicolon separated shapes, of dimensions separated by x')
+parser.add_argument('--repeat', type=int, default=20, help='number of timed runs')
+args = parser.parse_args()
+
+
+def measure_cost(f):
+    f().wait_to_read()
+    start = time.time()
+    for _ in range(args.repeat):
+        out = f()
+    out.wait_to_read()
+    return (time.time() - start) / args.repeat
+
+
+def run():
+    if args.num_omp_threads > 0:
+        mx.base.check_call(mx.base._LIB.MXSetNumOMPThreads(mx.base.ctypes.c_int(
+            args.num_omp_threads)))
+    ops = args.ops.split(',')
+    shapes = [tuple(int(d) for d in s.split('x')) for s in args.shapes.split(';')]
+    print('%-6s %-20s %-10s %10s %10s' % ('op', 'shape', 'axis', 'ms', 'GB/s'))
+    for shape in shapes:
+        data = mx.nd.random.uniform(shape=shape)
+        size_gb = data.size * 4 / 1e9
+        axes = [('first', 0), ('middle', len(shape) // 2), ('last', len(shape) - 1), ('all', None)]
+        for op in ops:
+            f = getattr(mx.nd, op)
+            for name, axis in axes:
+                cost = measure_cost(lambda: f(data, axis=axis))
+                print('%-6s %-20s %-10s %10.3f %10.2f' % (
+                    op, 'x'.join(str(d) for d in shape), name, cost * 1e3, size_gb / cost))
+
+
+if __name__ == '__main__':
+    run()
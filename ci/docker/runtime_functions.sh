@@ -1051,12 +1051,24 @@ integrationtest_ubuntu_cpu_dist_kvstore() {
     ../../tools/launch.py -n 7 --launcher local python dist_sync_kvstore.py --type=gluon_step_cpu
     ../../tools/launch.py -n 7 --launcher local python dist_sync_kvstore.py --type=gluon_sparse_step_cpu
     ../../tools/launch.py -n 7 --launcher local python dist_sync_kvstore.py --type=invalid_cpu
+    ../../tools/launch.py -n 3 --launcher local python dist_sync_kvstore.py --type=elastic_cpu
+    ../../tools/launch.py -n 3 --launcher local python dist_sync_kvstore.py --type=repeated_push_cpu
     ../../tools/launch.py -n 7 --launcher local python dist_sync_kvstore.py --type=gluon_type_cpu
     ../../tools/launch.py -n 7 --launcher local python dist_sync_kvstore.py
     ../../tools/launch.py -n 7 --launcher local python dist_sync_kvstore.py --no-multiprecision
+    MXNET_KVSTORE_SERVER_THREADS=0 ../../tools/launch.py -n 7 --launcher local python dist_sync_kvstore.py
+    MXNET_KVSTORE_ROW_CACHE=1 ../../tools/launch.py -n 7 --launcher local python dist_sync_kvstore.py
+    MXNET_KVSTORE_ROW_CACHE=1 ../../tools/launch.py -n 3 --launcher local python dist_sync_kvstore.py --type=row_cache_cpu
     ../../tools/launch.py -n 7 --launcher local python dist_sync_kvstore.py --type=compressed_cpu
     ../../tools/launch.py -n 7 --launcher local python dist_sync_kvstore.py --type=compressed_cpu --no-multiprecision
     ../../tools/launch.py -n 3 --launcher local python test_server_profiling.py
+    ../../tools/launch.py -n 3 --launcher local python dist_async_kvstore.py
+    MXNET_KVSTORE_STALENESS=1 ../../tools/launch.py -n 3 --launcher local python dist_async_kvstore.py
+    MXNET_KVSTORE_CHECKPOINT_DIR=$(mktemp -d) MXNET_KVSTORE_CHECKPOINT_INTERVAL=1 \
+        PS_HEARTBEAT_INTERVAL=1 PS_HEARTBEAT_TIMEOUT=2 PS_RESEND=1 \
+        ../../tools/launch.py -n 2 -s 1 --launcher local python dist_server_recovery.py
+    ../../tools/launch.py -n 4 --launcher local python dist_ring_kvstore.py
+    ../../tools/launch.py -n 4 --launcher local python dist_ring_kvstore.py --hierarchical
 }
 
 integrationtest_ubuntu_gpu_scala() {
@@ -2316,6 +2316,33 @@ MXNET_DLL int MXKVStoreGetNumDeadNode(KVStoreHandle handle,
                                       int *number,
                                       const int timeout_sec DEFAULT(60));
 
+/**
+ * \brief Add this worker to or remove it from the workers contributing to the steps
+ *
+ * \param handle handle to the KVStore
+ * \param active 1 to join, 0 to leave
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXKVStoreSetActive(KVStoreHandle handle, const int active);
+
+/**
+ * \brief Get the number of workers contributing to the steps
+ *
+ * \param handle handle to the KVStore
+ * \param ret the number of active workers
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXKVStoreGetNumActiveWorkers(KVStoreHandle handle, int *ret);
+
+/**
+ * \brief Get the rank of this worker among the workers contributing to the steps
+ *
+ * \param handle handle to the KVStore
+ * \param ret the rank among the active workers, -1 if this worker is not active
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXKVStoreGetActiveRank(KVStoreHandle handle, int *ret);
+
 /**
  * \brief Create a RecordIO writer object
  * \param uri path to file
@@ -354,6 +354,28 @@ class KVStore {
     return 0;
   }
 
+  /*!
+   * \brief adds this worker to or removes it from the workers contributing to
+   *  the steps of a dist kvstore. in sync mode, a step is complete once all
+   *  active workers pushed. call it between two steps, e.g. before the worker
+   *  is preempted and after it was restarted.
+   * \param active whether this worker contributes to the next steps
+   */
+  virtual void SetActive(bool active) {
+    LOG(FATAL) << "the workers of a " << type_ << " kvstore cannot join or leave";
+  }
+
+  /*!
+   * \return the ranks of the workers contributing to the steps, see SetActive.
+   *
+   * All workers unless type == "dist_*"
+   */
+  virtual std::vector<int> GetActiveWorkers() {
+    std::vector<int> ranks(get_group_size());
+    for (size_t i = 0; i < ranks.size(); ++i) ranks[i] = i;
+    return ranks;
+  }
+
   /*!
    * \brief global barrier among all worker machines
    *
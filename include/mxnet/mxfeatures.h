@@ -117,6 +117,19 @@
 #define MXNET_USE_SIGNAL_HANDLER 0
 #endif
 
+/*!
+ *\brief whether to build the hot cpu kernels for SSE4.2, AVX2 and AVX-512 as well as for the
+ * baseline instruction set, and select one of them at runtime from the cpu
+ */
+#ifndef MXNET_USE_ISA_DISPATCH
+#if (defined(__x86_64__) || defined(__i386__)) && !defined(__CUDACC__) && \
+    (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5))
+#define MXNET_USE_ISA_DISPATCH 1
+#else
+#define MXNET_USE_ISA_DISPATCH 0
+#endif
+#endif
+
 
 
 namespace mxnet {
@@ -141,6 +154,13 @@ enum : uint32_t {
   CPU_SSE4A,  // AMD extensions to SSE4
   CPU_AVX,
   CPU_AVX2,
+  CPU_AVX512F,
+
+  // Hot cpu kernels built for several instruction sets, and the one selected at runtime
+  ISA_DISPATCH,
+  KERNEL_SSE4_2,
+  KERNEL_AVX2,
+  KERNEL_AVX512,
 
 
   // Multiprocessing / CPU / System
@@ -184,5 +204,19 @@ enum : uint32_t {
  */
 bool is_enabled(uint32_t feat);
 
+/*! \brief instruction sets of the cpu kernels built with MXNET_USE_ISA_DISPATCH */
+enum CpuIsa : int {
+  kIsaGeneric = 0,
+  kIsaSSE42,
+  kIsaAVX2,
+  kIsaAVX512
+};
+
+/*!
+ * \return the instruction set of the cpu kernels, the widest one the cpu supports unless
+ *  MXNET_CPU_ISA caps it. kIsaGeneric, the baseline of the build, without MXNET_USE_ISA_DISPATCH.
+ */
+CpuIsa cpu_kernel_isa();
+
 }  // namespace features
 }  // namespace mxnet
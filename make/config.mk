@@ -56,6 +56,9 @@ DEBUG = 0
 # whether to turn on segfault signal handler to log the stack trace
 USE_SIGNAL_HANDLER =
 
+# whether to build tools/colbin, the converter of the ColBinIter format
+BUILD_COLBIN_TOOL = 0
+
 # the additional link flags you want to add
 ADD_LDFLAGS =
 
@@ -154,6 +157,14 @@ endif
 # For cross compilation, please check support for F16C on target device and turn off if necessary.
 USE_F16C =
 
+#----------------------------
+# Runtime selection of the instruction set of the hot cpu kernels
+#----------------------------
+# The elementwise, broadcast and reduce kernels are also built for SSE4.2, AVX2 and AVX-512,
+# and the widest one the cpu supports is used. Set to 0 for a smaller library, with the
+# kernels built for the target architecture only.
+USE_ISA_DISPATCH =
+
 #----------------------------
 # Target architecture
 #----------------------------
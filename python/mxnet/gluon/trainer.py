@@ -20,8 +20,10 @@
 """Parameter optimizer."""
 __all__ = ['Trainer']
 
+import os
+
 from .. import optimizer as opt
-from ..model import _create_kvstore, _create_sparse_kvstore
+from ..model import _create_kvstore, _create_sparse_kvstore, _fuses_small_keys
 from .parameter import ParameterDict, Parameter
 
 class Trainer(object):
@@ -350,15 +352,25 @@ class Trainer(object):
 
         self._allreduce_grads()
 
+    def _batch_keys(self, keys):
+        """Splits the indices of parameters into the groups pushed or pulled in one call.
+        Dist kvstores fuse the small keys of one call into few messages, so while fusion is
+        enabled they get up to MXNET_UPDATE_AGGREGATION_SIZE keys per call, as in Module;
+        otherwise every key is its own call with its own priority."""
+        if not (self._distributed and _fuses_small_keys(self._kvstore)):
+            return [[k] for k in keys]
+        size = max(int(os.getenv('MXNET_UPDATE_AGGREGATION_SIZE', '16')), 1)
+        return [keys[start:start + size] for start in range(0, len(keys), size)]
+
     def _allreduce_grads(self):
         if self._kvstore:
-            for i, param in enumerate(self._params):
-                if param.grad_req != 'null':
-
-                    self._kvstore.push(i, param.list_grad(), priority=-i)
-                    if not self._update_on_kvstore:
-                        self._kvstore.pull(i, param.list_grad(), priority=-i,
-                                           ignore_sparse=self._distributed)
+            keys = [i for i, param in enumerate(self._params) if param.grad_req != 'null']
+            for batch in self._batch_keys(keys):
+                grads = [self._params[i].list_grad() for i in batch]
+                self._kvstore.push(batch, grads, priority=-batch[0])
+                if not self._update_on_kvstore:
+                    self._kvstore.pull(batch, grads, priority=-batch[0],
+                                       ignore_sparse=self._distributed)
 
     def update(self, batch_size, ignore_stale_grad=False):
         """Makes one step of parameter update.
@@ -395,6 +407,7 @@ class Trainer(object):
 
     def _update(self, ignore_stale_grad=False):
         updates = [[] for _ in self._updaters]
+        pulls = []
 
         for i, param in enumerate(self._params):
             if param.grad_req == 'null':
@@ -416,7 +429,7 @@ class Trainer(object):
                 if param._stype == 'default':
                     # 'row_sparse' parameters are not pulled immediately - they're pulled
                     # in `Block.forward`
-                    self._kvstore.pull(i, param.list_data(), priority=-i)
+                    pulls.append(i)
                 continue
 
             for upd, arr, grad in zip(updates, param.list_data(), param.list_grad()):
@@ -424,6 +437,10 @@ class Trainer(object):
                     upd.append((i, grad, arr))
                     arr._fresh_grad = False
 
+        for batch in self._batch_keys(pulls):
+            self._kvstore.pull(batch, [self._params[i].list_data() for i in batch],
+                               priority=-batch[0])
+
         if not (self._kvstore and self._update_on_kvstore):
             for updater, upd in zip(self._updaters, updates):
                 if upd:
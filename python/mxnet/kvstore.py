@@ -90,7 +90,13 @@ def _get_kvstore_server_command_type(command):
                      'kStopServer': 2,
                      'kSyncMode': 3,
                      'kSetGradientCompression': 4,
-                     'kSetProfilerParams': 5}
+                     'kSetProfilerParams': 5,
+                     'kSetStaleness': 6,
+                     'kSaveOptimizerStates': 7,
+                     'kLoadOptimizerStates': 8,
+                     'kSetWorkerActive': 9,
+                     'kGetActiveWorkers': 10,
+                     'kSetLazyUpdate': 11}
     assert (command in command_types), "Unknown command type to send to server"
     return command_types[command]
 
@@ -407,6 +413,17 @@ class KVStore(object):
         original values is stored at the sender's end as residual and added to the
         gradient in the next iteration.
 
+        Other types of compression, all of which keep a residual in the same way:
+
+        - `1bit` sends the sign of each value, so every 32 values take one float. On
+          dist kvstores the servers take a majority vote over the workers and use
+          `threshold` times the sign of the sum as the gradient (signSGD).
+          On dequantization the signs are scaled with `threshold`.
+        - `topk` sends the value with the largest magnitude out of every
+          `round(1 / ratio)` consecutive values, together with its position.
+          `ratio` defaults to 0.01.
+        - `fp16` and `bf16` cast the gradient to half precision or bfloat16 floats.
+
         When kvstore is 'local', gradient compression is used to reduce communication
         between multiple devices (gpus). Gradient is quantized on each GPU which
         computed the gradients, then sent to the GPU which merges the gradients. This
@@ -435,7 +452,7 @@ class KVStore(object):
             A dictionary specifying the type and parameters for gradient compression.
             The key `type` in this dictionary is a
             required string argument and specifies the type of gradient compression.
-            Currently `type` can be only `2bit`
+            Currently `type` can be `2bit`, `1bit`, `topk`, `fp16` or `bf16`.
             Other keys in this dictionary are optional and specific to the type
             of gradient compression.
         """
@@ -481,7 +498,8 @@ class KVStore(object):
         check_call(_LIB.MXKVStoreIsWorkerNode(ctypes.byref(is_worker)))
 
         # pylint: disable=invalid-name
-        if 'dist' in self.type and is_worker.value: # pylint: disable=unsupported-membership-test
+        # dist_ring has no servers, every worker updates its own replica
+        if 'dist' in self.type and 'ring' not in self.type and is_worker.value: # pylint: disable=unsupported-membership-test
             # send the optimizer to server
             try:
                 # use ASCII protocol 0, might be slower, but not a big ideal
@@ -493,6 +511,10 @@ class KVStore(object):
             if optimizer.multi_precision:
                 cmd = _get_kvstore_server_command_type('kSetMultiPrecision')
                 self._send_command_to_servers(cmd, '')
+            # the row caches keep the rows of a row_sparse value which a lazy update leaves
+            cmd = _get_kvstore_server_command_type('kSetLazyUpdate')
+            lazy_update = getattr(optimizer, 'lazy_update', False)
+            self._send_command_to_servers(cmd, '1' if lazy_update else '0')
         else:
             self._set_updater(opt.get_updater(optimizer))
 
@@ -535,6 +557,50 @@ class KVStore(object):
         check_call(_LIB.MXKVStoreGetGroupSize(self.handle, ctypes.byref(size)))
         return size.value
 
+    @property
+    def num_active_workers(self):
+        """Returns the number of workers contributing to the steps, see `set_active`.
+
+        Use it with `active_rank` to shard the data among the active workers.
+
+        Returns
+        -------
+        size : int
+            The number of active workers.
+        """
+        size = ctypes.c_int()
+        check_call(_LIB.MXKVStoreGetNumActiveWorkers(self.handle, ctypes.byref(size)))
+        return size.value
+
+    @property
+    def active_rank(self):
+        """Returns the rank of this worker among the active workers, see `set_active`.
+
+        Returns
+        -------
+        rank : int
+            The rank in range [0, num_active_workers), or -1 if this worker is not active.
+        """
+        rank = ctypes.c_int()
+        check_call(_LIB.MXKVStoreGetActiveRank(self.handle, ctypes.byref(rank)))
+        return rank.value
+
+    def set_active(self, active):
+        """Adds this worker to or removes it from the workers contributing to the steps
+        of a distributed kvstore.
+
+        The workers launched with the job can leave and join between two steps, e.g. a
+        worker leaves before it is preempted and joins once it is restarted. In
+        ``dist_sync`` mode, a step is complete once all active workers pushed. The values
+        of a joining worker are not changed, pull them before the next step.
+
+        Parameters
+        ----------
+        active : bool
+            Whether this worker contributes to the next steps.
+        """
+        check_call(_LIB.MXKVStoreSetActive(self.handle, ctypes.c_int(int(active))))
+
     def save_optimizer_states(self, fname, dump_optimizer=False):
         """Saves the optimizer (updater) state to a file. This is often used when checkpointing
         the model during training.
@@ -657,10 +723,20 @@ def create(name='local'):
     The weights are updated whenever gradients are received from any machine.
     No two updates happen on the same weight at the same time. However, the order is not
     guaranteed.
+    With ``MXNET_KVSTORE_STALENESS=s``, a worker waits in ``pull`` while it has pushed
+    a key more than ``s`` times more often than the slowest worker, i.e. the workers
+    train stale synchronously with a staleness bound of ``s`` steps.
+
+    ``dist_ring``: Synchronous like ``dist_sync``, but the gradients are summed with a
+    ring allreduce among the workers and every worker updates its own copy of the
+    weights, so the servers started by the launcher stay idle. Workers on the same
+    host, e.g. one per socket, first reduce among themselves. Only dense values
+    are supported and gradient compression is not.
 
     Parameters
     ----------
-    name : {'local', 'device', 'nccl', 'ngraph', 'dist_sync', 'dist_device_sync', 'dist_async'}
+    name : {'local', 'device', 'nccl', 'ngraph', 'dist_sync', 'dist_device_sync', 'dist_async',
+            'dist_ring'}
         The type of KVStore.
     Returns
     -------
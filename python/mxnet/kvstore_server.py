@@ -19,11 +19,12 @@
 """A server node for the key value store."""
 from __future__ import absolute_import
 import ctypes
+import os
 import sys
 import pickle
 import logging
-from .base import _LIB, check_call
-from .kvstore import create
+from .base import _LIB, check_call, py_str
+from .kvstore import create, _get_kvstore_server_command_type
 
 class KVStoreServer(object):
     """The key-value store server."""
@@ -56,6 +57,18 @@ class KVStoreServer(object):
                 except:
                     raise
                 self.kvstore.set_optimizer(optimizer)
+            elif cmd_id == _get_kvstore_server_command_type('kSaveOptimizerStates'):
+                # checkpoint of the server, replaces the previous one once complete
+                fname = py_str(cmd_body)
+                self.kvstore.save_optimizer_states(fname + '.tmp', dump_optimizer=True)
+                os.rename(fname + '.tmp', fname)
+            elif cmd_id == _get_kvstore_server_command_type('kLoadOptimizerStates'):
+                # restart of the server from its checkpoint
+                fname = py_str(cmd_body)
+                with open(fname, 'rb') as fin:
+                    _, optimizer = pickle.loads(fin.read())
+                self.kvstore.set_optimizer(optimizer)
+                self.kvstore.load_optimizer_states(fname)
             else:
                 print("server %d, unknown command (%d, %s)" % (
                     self.kvstore.rank, cmd_id, cmd_body))
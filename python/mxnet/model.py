@@ -136,7 +136,7 @@ def _update_params_on_kvstore_nccl(param_arrays, grad_arrays, kvstore, param_nam
     valid_param_names = [param_names[i] for i in valid_indices]
     size = len(valid_grad_arrays)
     start = 0
-    # Use aggregation by default only with NCCL
+    # Use aggregation by default only with NCCL and dist kvstores
     default_batch = '16'
     batch = int(os.getenv('MXNET_UPDATE_AGGREGATION_SIZE', default_batch))
     while start < size:
@@ -147,8 +147,18 @@ def _update_params_on_kvstore_nccl(param_arrays, grad_arrays, kvstore, param_nam
         kvstore.pull(valid_param_names[start:end], valid_param_arrays[start:end], priority=-start)
         start = end
 
+def _fuses_small_keys(kvstore):
+    """Whether kvstore fuses the small keys of one push or pull into few messages, which
+    only dist kvstores do, unless MXNET_KVSTORE_FUSION_BYTES is 0."""
+    return 'dist' in kvstore.type and \
+        int(os.getenv('MXNET_KVSTORE_FUSION_BYTES', str(1 << 20))) > 0
+
 def _update_params_on_kvstore(param_arrays, grad_arrays, kvstore, param_names):
     """Perform update of param_arrays from grad_arrays on kvstore."""
+    if _fuses_small_keys(kvstore):
+        # push and pull keys in batches, so that they can be fused
+        _update_params_on_kvstore_nccl(param_arrays, grad_arrays, kvstore, param_names)
+        return
     for index, pair in enumerate(zip(param_arrays, grad_arrays)):
         arg_list, grad_list = pair
         if grad_list[0] is None:
@@ -38,6 +38,11 @@ feature_names = [
     "CPU_SSE4A",
     "CPU_AVX",
     "CPU_AVX2",
+    "CPU_AVX512F",
+    "ISA_DISPATCH",
+    "KERNEL_SSE4_2",
+    "KERNEL_AVX2",
+    "KERNEL_AVX512",
     "OPENMP",
     "SSE",
     "F16C",
@@ -23,6 +23,7 @@
  * \brief C API of mxnet
  */
 #include <vector>
+#include <algorithm>
 #include <sstream>
 #include <string>
 #include <mutex>
@@ -1151,6 +1152,27 @@ int MXKVStoreGetNumDeadNode(KVStoreHandle handle,
   API_END();
 }
 
+int MXKVStoreSetActive(KVStoreHandle handle, const int active) {
+  API_BEGIN();
+  static_cast<KVStore*>(handle)->SetActive(active != 0);
+  API_END();
+}
+
+int MXKVStoreGetNumActiveWorkers(KVStoreHandle handle, int *ret) {
+  API_BEGIN();
+  *ret = static_cast<KVStore*>(handle)->GetActiveWorkers().size();
+  API_END();
+}
+
+int MXKVStoreGetActiveRank(KVStoreHandle handle, int *ret) {
+  API_BEGIN();
+  KVStore* kv = static_cast<KVStore*>(handle);
+  const std::vector<int> ranks = kv->GetActiveWorkers();
+  auto it = std::find(ranks.begin(), ranks.end(), kv->get_rank());
+  *ret = it == ranks.end() ? -1 : static_cast<int>(it - ranks.begin());
+  API_END();
+}
+
 struct MXRecordIOContext {
   dmlc::RecordIOWriter *writer;
   dmlc::RecordIOReader *reader;
@@ -0,0 +1,480 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ *  Copyright (c) 2019 by Contributors
+ * \file colbin_format.h
+ * \brief chunked, columnar binary training data format
+ *
+ *  All integers are little endian.
+ *
+ *  file   := header chunk* footer
+ *  header := "MXCOLBIN" version:u32 num_columns:u32
+ *            (kind:u32 dtype:i32 width:u64)*num_columns
+ *  chunk  := num_rows:u64 pad:u64, then for every column its buffers:
+ *            dense column -> values[num_rows * width]
+ *            csr column   -> indptr:i64[num_rows + 1] (starting at 0),
+ *                            indices:i64[nnz], values[nnz]
+ *  buffer := codec:u32 elem_size:u32 raw_bytes:u64 stored_bytes:u64 payload,
+ *            padded so that every payload starts on a kAlign boundary
+ *  footer := (offset:u64 num_rows:u64)*num_chunks num_chunks:u64
+ *            footer_offset:u64 "MXCOLBIN"
+ *
+ *  Uncompressed payloads are aligned and can be used in place from a
+ *  memory mapping of the file; compressed ones are decoded per chunk.
+ */
+#ifndef MXNET_IO_COLBIN_FORMAT_H_
+#define MXNET_IO_COLBIN_FORMAT_H_
+
+#include <dmlc/base.h>
+#include <dmlc/io.h>
+#include <dmlc/logging.h>
+#include <mshadow/base.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif  // _WIN32
+
+namespace mxnet {
+namespace io {
+namespace colbin {
+
+/*! \brief magic at the beginning and the end of a file */
+const char kMagic[8] = {'M', 'X', 'C', 'O', 'L', 'B', 'I', 'N'};
+/*! \brief format version */
+const uint32_t kVersion = 1;
+/*! \brief alignment of every buffer payload */
+const uint64_t kAlign = 64;
+
+/*! \brief storage of a column */
+enum ColumnKind : uint32_t {
+  kDenseColumn = 0,
+  kCSRColumn = 1
+};
+
+/*! \brief compression of a buffer */
+enum Codec : uint32_t {
+  kNoCompression = 0,
+  /*!
+   * \brief bytes of every element are transposed into planes which are then
+   *  run-length encoded, cheap to decode and effective on sparse indices,
+   *  one-hot values and low entropy float exponents
+   */
+  kShuffleRLE = 1
+};
+
+/*! \brief description of a column */
+struct ColumnDesc {
+  /*! \brief ColumnKind */
+  uint32_t kind;
+  /*! \brief mshadow type flag of the values */
+  int32_t dtype;
+  /*! \brief values per row of a dense column, number of columns of a csr one */
+  uint64_t width;
+};
+
+/*! \brief header in front of every buffer payload */
+struct BufferHeader {
+  uint32_t codec;
+  uint32_t elem_size;
+  uint64_t raw_bytes;
+  uint64_t stored_bytes;
+};
+
+/*! \brief footer entry of a chunk */
+struct ChunkIndex {
+  uint64_t offset;
+  uint64_t num_rows;
+};
+
+/*! \brief size of one value of the given mshadow type flag */
+inline size_t DTypeSize(int dtype) {
+  size_t size = 0;
+  MSHADOW_TYPE_SWITCH(dtype, DType, {
+    size = sizeof(DType);
+  });
+  return size;
+}
+
+/*! \brief round up to the next multiple of kAlign */
+inline uint64_t AlignUp(uint64_t n) {
+  return (n + kAlign - 1) / kAlign * kAlign;
+}
+
+/*!
+ * \brief kShuffleRLE encoding of n elements of elem_size bytes each.
+ *  Runs use a control byte c: c < 128 starts c + 1 literal bytes,
+ *  c >= 128 repeats the next byte c - 125 times.
+ */
+inline void ShuffleRLEEncode(const char *src, size_t n, size_t elem_size, std::string *out) {
+  const size_t nbytes = n * elem_size;
+  std::string planes(nbytes, '\0');
+  for (size_t b = 0; b < elem_size; ++b) {
+    for (size_t i = 0; i < n; ++i) {
+      planes[b * n + i] = src[i * elem_size + b];
+    }
+  }
+  out->clear();
+  out->reserve(nbytes / 2);
+  size_t i = 0, literal_begin = 0;
+  auto flush_literal = [&](size_t end) {
+    while (literal_begin < end) {
+      const size_t len = std::min<size_t>(end - literal_begin, 128);
+      out->push_back(static_cast<char>(len - 1));
+      out->append(planes, literal_begin, len);
+      literal_begin += len;
+    }
+  };
+  while (i < nbytes) {
+    size_t run = 1;
+    while (i + run < nbytes && run < 130 && planes[i + run] == planes[i]) ++run;
+    if (run >= 3) {
+      flush_literal(i);
+      out->push_back(static_cast<char>(run + 125));
+      out->push_back(planes[i]);
+      i += run;
+      literal_begin = i;
+    } else {
+      i += run;
+    }
+  }
+  flush_literal(nbytes);
+}
+
+/*! \brief decode a kShuffleRLE buffer of raw_bytes into dst */
+inline void ShuffleRLEDecode(const char *src, size_t stored_bytes, size_t raw_bytes,
+                             size_t elem_size, char *dst) {
+  std::vector<char> planes(raw_bytes);
+  const char *end = src + stored_bytes;
+  size_t pos = 0;
+  while (src != end) {
+    const uint8_t c = static_cast<uint8_t>(*src++);
+    if (c < 128) {
+      const size_t len = c + 1;
+      CHECK(pos + len <= raw_bytes && src + len <= end) << "corrupted colbin buffer";
+      std::memcpy(&planes[pos], src, len);
+      src += len;
+      pos += len;
+    } else {
+      const size_t len = c - 125;
+      CHECK(pos + len <= raw_bytes && src != end) << "corrupted colbin buffer";
+      std::memset(&planes[pos], *src++, len);
+      pos += len;
+    }
+  }
+  CHECK_EQ(pos, raw_bytes) << "corrupted colbin buffer";
+  const size_t n = raw_bytes / elem_size;
+  for (size_t b = 0; b < elem_size; ++b) {
+    for (size_t i = 0; i < n; ++i) {
+      dst[i * elem_size + b] = planes[b * n + i];
+    }
+  }
+}
+
+/*! \brief column content of a chunk, for writing or as a decoded view */
+struct ColumnData {
+  /*! \brief values, num_rows * width for dense columns, nnz for csr */
+  const void *value{nullptr};
+  /*! \brief csr row pointer with num_rows + 1 entries starting at 0 */
+  const int64_t *indptr{nullptr};
+  /*! \brief csr column indices */
+  const int64_t *index{nullptr};
+};
+
+/*! \brief writes a colbin file chunk by chunk */
+class Writer {
+ public:
+  /*!
+   * \param stream output stream, not owned
+   * \param codec compression tried on every buffer, a buffer is stored raw
+   *  when compression does not make it smaller
+   */
+  Writer(dmlc::Stream *stream, const std::vector<ColumnDesc> &columns, Codec codec)
+      : stream_(stream), columns_(columns), codec_(codec) {
+    Write(kMagic, sizeof(kMagic));
+    const uint32_t num_columns = static_cast<uint32_t>(columns_.size());
+    Write(&kVersion, sizeof(kVersion));
+    Write(&num_columns, sizeof(num_columns));
+    for (const ColumnDesc &desc : columns_) {
+      Write(&desc, sizeof(desc));
+    }
+  }
+  /*! \brief append a chunk of num_rows rows, data holds one entry per column */
+  inline void WriteChunk(uint64_t num_rows, const std::vector<ColumnData> &data) {
+    CHECK_EQ(data.size(), columns_.size());
+    if (num_rows == 0) return;
+    Pad(8);
+    chunks_.push_back(ChunkIndex{pos_, num_rows});
+    const uint64_t pad = 0;
+    Write(&num_rows, sizeof(num_rows));
+    Write(&pad, sizeof(pad));
+    for (size_t i = 0; i < columns_.size(); ++i) {
+      const ColumnDesc &desc = columns_[i];
+      const size_t vsize = DTypeSize(desc.dtype);
+      if (desc.kind == kDenseColumn) {
+        WriteBuffer(data[i].value, num_rows * desc.width, vsize);
+      } else {
+        CHECK_EQ(data[i].indptr[0], 0) << "indptr of a colbin chunk must start at 0";
+        const uint64_t nnz = data[i].indptr[num_rows];
+        WriteBuffer(data[i].indptr, num_rows + 1, sizeof(int64_t));
+        WriteBuffer(data[i].index, nnz, sizeof(int64_t));
+        WriteBuffer(data[i].value, nnz, vsize);
+      }
+    }
+  }
+  /*! \brief write the footer, the writer must not be used afterwards */
+  inline void Finish() {
+    Pad(8);
+    const uint64_t footer_offset = pos_;
+    const uint64_t num_chunks = chunks_.size();
+    if (num_chunks != 0) {
+      Write(dmlc::BeginPtr(chunks_), chunks_.size() * sizeof(ChunkIndex));
+    }
+    Write(&num_chunks, sizeof(num_chunks));
+    Write(&footer_offset, sizeof(footer_offset));
+    Write(kMagic, sizeof(kMagic));
+  }
+
+ private:
+  inline void Write(const void *ptr, size_t size) {
+    stream_->Write(ptr, size);
+    pos_ += size;
+  }
+  inline void Pad(uint64_t align) {
+    static const char zeros[kAlign] = {0};
+    const uint64_t target = (pos_ + align - 1) / align * align;
+    Write(zeros, target - pos_);
+  }
+  inline void WriteBuffer(const void *ptr, uint64_t n, size_t elem_size) {
+    BufferHeader header;
+    header.codec = kNoCompression;
+    header.elem_size = static_cast<uint32_t>(elem_size);
+    header.raw_bytes = n * elem_size;
+    header.stored_bytes = header.raw_bytes;
+    const char *payload = static_cast<const char *>(ptr);
+    if (codec_ == kShuffleRLE && n != 0) {
+      ShuffleRLEEncode(payload, n, elem_size, &scratch_);
+      if (scratch_.size() < header.raw_bytes) {
+        header.codec = kShuffleRLE;
+        header.stored_bytes = scratch_.size();
+        payload = scratch_.data();
+      }
+    }
+    // the payload, not the header, is aligned
+    static const char zeros[kAlign] = {0};
+    const uint64_t payload_pos = AlignUp(pos_ + sizeof(header));
+    Write(zeros, payload_pos - pos_ - sizeof(header));
+    Write(&header, sizeof(header));
+    Write(payload, header.stored_bytes);
+  }
+
+  dmlc::Stream *stream_;
+  std::vector<ColumnDesc> columns_;
+  Codec codec_;
+  uint64_t pos_{0};
+  std::vector<ChunkIndex> chunks_;
+  std::string scratch_;
+};
+
+/*! \brief a decoded chunk; uncompressed buffers point into the file mapping */
+struct ChunkView {
+  uint64_t num_rows{0};
+  std::vector<ColumnData> columns;
+  /*! \brief storage of decompressed buffers */
+  std::vector<std::vector<char> > decoded;
+};
+
+/*! \brief random access reader, memory maps local files */
+class Reader {
+ public:
+  explicit Reader(const std::string &uri) {
+    Open(uri);
+    CHECK_GE(size_, sizeof(kMagic) * 2 + sizeof(uint32_t) * 2 + sizeof(uint64_t) * 2)
+      << uri << " is not a colbin file";
+    CHECK_EQ(std::memcmp(data_, kMagic, sizeof(kMagic)), 0) << uri << " is not a colbin file";
+    CHECK_EQ(std::memcmp(data_ + size_ - sizeof(kMagic), kMagic, sizeof(kMagic)), 0)
+      << uri << " is truncated, the colbin footer is missing";
+    uint64_t pos = sizeof(kMagic);
+    const uint32_t version = Load<uint32_t>(&pos);
+    CHECK_EQ(version, kVersion) << "unsupported colbin version " << version;
+    const uint32_t num_columns = Load<uint32_t>(&pos);
+    for (uint32_t i = 0; i < num_columns; ++i) {
+      columns_.push_back(Load<ColumnDesc>(&pos));
+      CHECK(columns_.back().kind == kDenseColumn || columns_.back().kind == kCSRColumn)
+        << "corrupted colbin header";
+    }
+    uint64_t tail = size_ - sizeof(kMagic) - 2 * sizeof(uint64_t);
+    const uint64_t num_chunks = Load<uint64_t>(&tail);
+    uint64_t footer = Load<uint64_t>(&tail);
+    CHECK_LE(footer + num_chunks * sizeof(ChunkIndex), size_) << "corrupted colbin footer";
+    for (uint64_t i = 0; i < num_chunks; ++i) {
+      chunks_.push_back(Load<ChunkIndex>(&footer));
+    }
+  }
+  ~Reader() {
+#ifndef _WIN32
+    if (mapped_) munmap(const_cast<char *>(data_), size_);
+#endif  // _WIN32
+  }
+  inline const std::vector<ColumnDesc> &columns() const {
+    return columns_;
+  }
+  inline size_t NumChunks() const {
+    return chunks_.size();
+  }
+  /*!
+   * \brief decode chunk i into view. The sizes of its buffers are checked against the
+   *  columns, and csr buffers against their invariants, so that a corrupted or truncated
+   *  file fails here rather than being read out of bounds by the iterator.
+   */
+  inline void ReadChunk(size_t i, ChunkView *view) const {
+    CHECK_LT(i, chunks_.size());
+    uint64_t pos = chunks_[i].offset;
+    const uint64_t num_rows = Load<uint64_t>(&pos);
+    CHECK_EQ(num_rows, chunks_[i].num_rows) << "corrupted colbin chunk";
+    view->num_rows = num_rows;
+    pos += sizeof(uint64_t);
+    view->columns.assign(columns_.size(), ColumnData());
+    view->decoded.resize(columns_.size() * 3);
+    for (std::vector<char> &buf : view->decoded) buf.clear();
+    for (size_t c = 0; c < columns_.size(); ++c) {
+      const ColumnDesc &desc = columns_[c];
+      const size_t vsize = DTypeSize(desc.dtype);
+      ColumnData &col = view->columns[c];
+      if (desc.kind == kDenseColumn) {
+        col.value = ReadBuffer(&pos, Bytes(Bytes(num_rows, desc.width), vsize), vsize,
+                               &view->decoded[c * 3]);
+        continue;
+      }
+      col.indptr = static_cast<const int64_t *>(
+          ReadBuffer(&pos, Bytes(num_rows + 1, sizeof(int64_t)), sizeof(int64_t),
+                     &view->decoded[c * 3]));
+      CHECK_EQ(col.indptr[0], 0) << "corrupted colbin chunk";
+      for (uint64_t r = 0; r < num_rows; ++r) {
+        CHECK_LE(col.indptr[r], col.indptr[r + 1]) << "corrupted colbin chunk";
+      }
+      const uint64_t nnz = col.indptr[num_rows];
+      col.index = static_cast<const int64_t *>(
+          ReadBuffer(&pos, Bytes(nnz, sizeof(int64_t)), sizeof(int64_t),
+                     &view->decoded[c * 3 + 1]));
+      for (uint64_t k = 0; k < nnz; ++k) {
+        CHECK(col.index[k] >= 0 && static_cast<uint64_t>(col.index[k]) < desc.width)
+          << "corrupted colbin chunk";
+      }
+      col.value = ReadBuffer(&pos, Bytes(nnz, vsize), vsize, &view->decoded[c * 3 + 2]);
+    }
+  }
+
+ private:
+  template<typename T>
+  inline T Load(uint64_t *pos) const {
+    CHECK_LE(*pos + sizeof(T), size_) << "corrupted colbin file";
+    T v;
+    std::memcpy(&v, data_ + *pos, sizeof(T));
+    *pos += sizeof(T);
+    return v;
+  }
+  /*! \brief n * size, which fails on a count no file could hold */
+  static inline uint64_t Bytes(uint64_t n, uint64_t size) {
+    CHECK(size == 0 || n <= std::numeric_limits<uint64_t>::max() / size)
+      << "corrupted colbin chunk";
+    return n * size;
+  }
+  /*! \brief the payload of the buffer at pos, which must hold raw_bytes of elem_size */
+  inline const void *ReadBuffer(uint64_t *pos, uint64_t raw_bytes, size_t elem_size,
+                                std::vector<char> *decoded) const {
+    *pos = AlignUp(*pos + sizeof(BufferHeader)) - sizeof(BufferHeader);
+    const BufferHeader header = Load<BufferHeader>(pos);
+    CHECK(header.raw_bytes == raw_bytes && header.elem_size == elem_size &&
+          header.stored_bytes <= size_ - *pos) << "corrupted colbin chunk";
+    const char *payload = data_ + *pos;
+    *pos += header.stored_bytes;
+    if (header.codec == kNoCompression) {
+      CHECK_EQ(header.stored_bytes, raw_bytes) << "corrupted colbin chunk";
+      return payload;
+    }
+    CHECK_EQ(header.codec, kShuffleRLE) << "unknown colbin codec " << header.codec;
+    // a run of two bytes decodes to at most 130, so nothing larger is allocated
+    CHECK_LE(raw_bytes / 65, header.stored_bytes) << "corrupted colbin chunk";
+    decoded->resize(raw_bytes);
+    ShuffleRLEDecode(payload, header.stored_bytes, raw_bytes, elem_size,
+                     dmlc::BeginPtr(*decoded));
+    return dmlc::BeginPtr(*decoded);
+  }
+  inline void Open(const std::string &uri) {
+#ifndef _WIN32
+    const bool local = uri.find("://") == std::string::npos || uri.compare(0, 7, "file://") == 0;
+    if (local) {
+      const std::string path = uri.compare(0, 7, "file://") == 0 ? uri.substr(7) : uri;
+      int fd = open(path.c_str(), O_RDONLY);
+      CHECK_NE(fd, -1) << "cannot open " << path << ": " << strerror(errno);
+      struct stat st;
+      CHECK_EQ(fstat(fd, &st), 0) << "cannot stat " << path;
+      size_ = static_cast<uint64_t>(st.st_size);
+      void *ptr = size_ != 0 ? mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+      close(fd);
+      if (ptr != MAP_FAILED) {
+        data_ = static_cast<const char *>(ptr);
+        mapped_ = true;
+        return;
+      }
+    }
+#endif  // _WIN32
+    // remote file systems (and mmap failures) read the whole file through dmlc::Stream
+    std::unique_ptr<dmlc::Stream> fi(dmlc::Stream::Create(uri.c_str(), "r"));
+    const size_t kBlock = 64UL << 20;
+    size_t nread = 0;
+    do {
+      buffer_.resize(nread + kBlock);
+      nread += fi->Read(&buffer_[nread], kBlock);
+    } while (nread == buffer_.size());
+    buffer_.resize(nread);
+    // keep payloads aligned in memory as well
+    aligned_.resize(nread + kAlign);
+    char *base = dmlc::BeginPtr(aligned_);
+    base += (kAlign - reinterpret_cast<uintptr_t>(base) % kAlign) % kAlign;
+    if (nread != 0) std::memcpy(base, dmlc::BeginPtr(buffer_), nread);
+    std::vector<char>().swap(buffer_);
+    data_ = base;
+    size_ = nread;
+  }
+
+  const char *data_{nullptr};
+  uint64_t size_{0};
+  bool mapped_{false};
+  std::vector<char> buffer_;
+  std::vector<char> aligned_;
+  std::vector<ColumnDesc> columns_;
+  std::vector<ChunkIndex> chunks_;
+};
+
+}  // namespace colbin
+}  // namespace io
+}  // namespace mxnet
+#endif  // MXNET_IO_COLBIN_FORMAT_H_
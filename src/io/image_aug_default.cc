@@ -495,16 +495,15 @@ class DefaultImageAugmenter : public ImageAugmenter {
       int l = rl * param_.random_l * 2 - param_.random_l;
       int temp[3] = {h, l, s};
       int limit[3] = {180, 255, 255};
-      for (int i = 0; i < res.rows; ++i) {
-        for (int j = 0; j < res.cols; ++j) {
-          for (int k = 0; k < 3; ++k) {
-            int v = res.at<cv::Vec3b>(i, j)[k];
-            v += temp[k];
-            v = std::max(0, std::min(limit[k], v));
-            res.at<cv::Vec3b>(i, j)[k] = v;
-          }
+      // per-channel saturating shift through a lookup table, which OpenCV
+      // applies with vectorized code instead of a per-pixel at<> loop
+      cv::Mat lut(1, 256, CV_8UC3);
+      for (int v = 0; v < 256; ++v) {
+        for (int k = 0; k < 3; ++k) {
+          lut.at<cv::Vec3b>(0, v)[k] = std::max(0, std::min(limit[k], v + temp[k]));
         }
       }
+      cv::LUT(res, lut, res);
       cvtColor(res, res, CV_HLS2BGR);
     }
 
@@ -521,16 +520,15 @@ class DefaultImageAugmenter : public ImageAugmenter {
       float pca_b = eigvec[2][0] * pca_alpha_r + eigvec[2][1] * pca_alpha_g +
            eigvec[2][2] * pca_alpha_b;
       float pca[3] = { pca_b, pca_g, pca_r };
-      for (int i = 0; i < res.rows; ++i) {
-        for (int j = 0; j < res.cols; ++j) {
-          for (int k = 0; k < 3; ++k) {
-            int vp = res.at<cv::Vec3b>(i, j)[k];
-            vp += pca[k];
-            vp = std::max(0, std::min(255, vp));
-            res.at<cv::Vec3b>(i, j)[k] = vp;
-          }
+      cv::Mat lut(1, 256, CV_8UC3);
+      for (int v = 0; v < 256; ++v) {
+        for (int k = 0; k < 3; ++k) {
+          int vp = v;
+          vp += pca[k];
+          lut.at<cv::Vec3b>(0, v)[k] = std::max(0, std::min(255, vp));
         }
       }
+      cv::LUT(res, lut, res);
     }
     return res;
   }
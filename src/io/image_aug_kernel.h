@@ -0,0 +1,169 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ *  Copyright (c) 2019 by Contributors
+ * \file image_aug_kernel.h
+ * \brief fused CPU kernels turning an augmented HWC uint8 image
+ *        into the normalized CHW layout consumed by the network
+ */
+#ifndef MXNET_IO_IMAGE_AUG_KERNEL_H_
+#define MXNET_IO_IMAGE_AUG_KERNEL_H_
+
+#include <mxnet/mxfeatures.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#if MXNET_USE_ISA_DISPATCH || defined(__AVX__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+namespace mxnet {
+namespace io {
+namespace image_kernel {
+
+#if MXNET_USE_ISA_DISPATCH || defined(__AVX512F__)
+/*! \brief the first multiple of 16 elements of NormalizeRow, returns their number */
+#if MXNET_USE_ISA_DISPATCH
+__attribute__((target("avx512f")))
+#endif
+inline int NormalizeRowAVX512(float *row, const float *mean_row,
+                              float mean, float mult, float bias, int n) {
+  const __m512 vmean = _mm512_set1_ps(mean);
+  const __m512 vmult = _mm512_set1_ps(mult);
+  const __m512 vbias = _mm512_set1_ps(bias);
+  int j = 0;
+  for (; j + 16 <= n; j += 16) {
+    const __m512 m = mean_row != nullptr ? _mm512_loadu_ps(mean_row + j) : vmean;
+    __m512 x = _mm512_loadu_ps(row + j);
+    x = _mm512_add_ps(_mm512_mul_ps(_mm512_sub_ps(x, m), vmult), vbias);
+    _mm512_storeu_ps(row + j, x);
+  }
+  return j;
+}
+#endif
+
+#if MXNET_USE_ISA_DISPATCH || defined(__AVX__)
+/*! \brief the first multiple of 8 elements of NormalizeRow, returns their number */
+#if MXNET_USE_ISA_DISPATCH
+__attribute__((target("avx")))
+#endif
+inline int NormalizeRowAVX(float *row, const float *mean_row,
+                           float mean, float mult, float bias, int n) {
+  const __m256 vmean = _mm256_set1_ps(mean);
+  const __m256 vmult = _mm256_set1_ps(mult);
+  const __m256 vbias = _mm256_set1_ps(bias);
+  int j = 0;
+  for (; j + 8 <= n; j += 8) {
+    const __m256 m = mean_row != nullptr ? _mm256_loadu_ps(mean_row + j) : vmean;
+    __m256 x = _mm256_loadu_ps(row + j);
+    x = _mm256_add_ps(_mm256_mul_ps(_mm256_sub_ps(x, m), vmult), vbias);
+    _mm256_storeu_ps(row + j, x);
+  }
+  return j;
+}
+#endif
+
+/*!
+ * \brief row[j] = (row[j] - mean) * mult + bias, in place. The AVX-512 and AVX loops are
+ *  chosen at runtime from features::cpu_kernel_isa with MXNET_USE_ISA_DISPATCH, and from the
+ *  instruction set of the build otherwise.
+ * \param mean_row per-element mean, or nullptr to use the scalar mean
+ */
+inline void NormalizeRow(float *row, const float *mean_row,
+                         float mean, float mult, float bias, int n) {
+  int j = 0;
+#if MXNET_USE_ISA_DISPATCH
+  const features::CpuIsa isa = features::cpu_kernel_isa();
+  if (isa >= features::kIsaAVX512) {
+    j = NormalizeRowAVX512(row, mean_row, mean, mult, bias, n);
+  } else if (isa >= features::kIsaAVX2) {
+    j = NormalizeRowAVX(row, mean_row, mean, mult, bias, n);
+  }
+#elif defined(__AVX512F__)
+  j = NormalizeRowAVX512(row, mean_row, mean, mult, bias, n);
+#elif defined(__AVX__)
+  j = NormalizeRowAVX(row, mean_row, mean, mult, bias, n);
+#endif
+  if (mean_row != nullptr) {
+    for (; j < n; ++j) row[j] = (row[j] - mean_row[j]) * mult + bias;
+  } else {
+    for (; j < n; ++j) row[j] = (row[j] - mean) * mult + bias;
+  }
+}
+
+/*! \brief generic normalization, matching the arithmetic of iter_normalize.h */
+template<typename DType>
+inline void NormalizeRow(DType *row, const float *mean_row,
+                         float mean, float mult, float bias, int n) {
+  for (int j = 0; j < n; ++j) {
+    const float m = mean_row != nullptr ? mean_row[j] : mean;
+    row[j] = static_cast<DType>((row[j] - m) * mult + bias);
+  }
+}
+
+/*!
+ * \brief fused channel swap + layout transform + normalize + mirror.
+ *
+ *  Reads an interleaved HWC uint8 image (e.g. an OpenCV ROI, so cropping
+ *  costs nothing) and writes planar CHW output. Each output row is first
+ *  de-interleaved in source order, normalized while it is hot in L1 and
+ *  only then reversed for mirroring, so a mean image is applied at the
+ *  source pixel position exactly as the per-pixel path did.
+ *
+ * \param src first pixel of the image
+ * \param src_step distance between two source rows in bytes
+ * \param swap output channel k is read from source channel swap[k]
+ * \param normalize whether to apply mean/mult/bias (false for uint8 output)
+ * \param mean per-channel scalar mean, used when mean_img is nullptr
+ * \param mean_img CHW mean image with the output shape, or nullptr
+ * \param mean_stride row stride of mean_img in elements
+ * \param dst output tensor, rows are dst_stride elements apart
+ */
+template<typename DType>
+inline void PackImageCHW(const uint8_t *src, size_t src_step,
+                         int rows, int cols, int channels,
+                         const int *swap, bool mirror, bool normalize,
+                         const float *mean, const float *mult, const float *bias,
+                         const float *mean_img, size_t mean_stride,
+                         DType *dst, size_t dst_stride) {
+  for (int i = 0; i < rows; ++i) {
+    const uint8_t *im_row = src + i * src_step;
+    for (int k = 0; k < channels; ++k) {
+      DType *out = dst + (static_cast<size_t>(k) * rows + i) * dst_stride;
+      const uint8_t *in = im_row + swap[k];
+      for (int j = 0; j < cols; ++j) {
+        out[j] = static_cast<DType>(in[j * channels]);
+      }
+      if (normalize) {
+        const float *mean_row = mean_img != nullptr ?
+          mean_img + (static_cast<size_t>(k) * rows + i) * mean_stride : nullptr;
+        NormalizeRow(out, mean_row, mean[k], mult[k], bias[k], cols);
+      }
+      if (mirror) {
+        std::reverse(out, out + cols);
+      }
+    }
+  }
+}
+
+}  // namespace image_kernel
+}  // namespace io
+}  // namespace mxnet
+#endif  // MXNET_IO_IMAGE_AUG_KERNEL_H_
@@ -350,11 +350,17 @@ struct PrefetcherParam : public dmlc::Parameter<PrefetcherParam> {
   size_t prefetch_buffer;
   /*! \brief data type */
   dmlc::optional<int> dtype;
+  /*! \brief device whose page-locked memory holds the prefetched batches */
+  int pinned_device_id;
 
   // declare parameters
   DMLC_DECLARE_PARAMETER(PrefetcherParam) {
     DMLC_DECLARE_FIELD(prefetch_buffer).set_default(4)
         .describe("Maximum number of batches to prefetch.");
+    DMLC_DECLARE_FIELD(pinned_device_id).set_default(-1).set_lower_bound(-1)
+        .describe("Allocate the prefetched batches as Context::CPUPinned(pinned_device_id) "
+                  "so they can be copied to that GPU asynchronously. "
+                  "-1 uses regular CPU memory.");
     DMLC_DECLARE_FIELD(dtype)
       .add_enum("float32", mshadow::kFloat32)
       .add_enum("float64", mshadow::kFloat64)
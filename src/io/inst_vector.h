@@ -178,6 +178,24 @@ struct TBlobBatch {
   }
 };  // struct TBlobBatch
 
+/*!
+ * \brief batch iterators implementing this can assemble the next batch
+ *  straight into buffers owned by their consumer, e.g. a prefetch slot,
+ *  instead of an internal staging buffer that has to be copied out again.
+ */
+class DirectBatchOutput {
+ public:
+  virtual ~DirectBatchOutput() {}
+  /*!
+   * \brief set the buffers the next call to Next() writes into.
+   *  Buffers whose shape or type do not match the batch layout are ignored
+   *  and the internal buffer is used instead, so the caller has to compare
+   *  TBlobBatch::data of the result with the buffers it offered.
+   *  The buffers are only used for a single batch.
+   */
+  virtual void SetOutputBuffers(const std::vector<TBlob> &buffers) = 0;
+};
+
 class TBlobContainer : public TBlob {
  public:
   TBlobContainer(void)
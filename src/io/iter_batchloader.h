@@ -39,7 +39,7 @@ namespace mxnet {
 namespace io {
 
 /*! \brief create a batch iterator from single instance iterator */
-class BatchLoader : public IIterator<TBlobBatch> {
+class BatchLoader : public IIterator<TBlobBatch>, public DirectBatchOutput {
  public:
   explicit BatchLoader(IIterator<DataInst> *base):
     head_(1), num_overflow_(0), base_(base) {
@@ -82,19 +82,13 @@ class BatchLoader : public IIterator<TBlobBatch> {
 
     while (base_->Next()) {
       const DataInst& d = base_->Value();
-      out_.inst_index[top] = d.index;
       if (data_.size() == 0) {
         this->InitData(d);
       }
-      for (size_t i = 0; i < d.data.size(); ++i) {
-        CHECK_EQ(unit_size_[i], d.data[i].Size());
-        MSHADOW_TYPE_SWITCH(data_[i].type_flag_, DType, {
-            mshadow::Copy(
-              data_[i].get<cpu, 1, DType>().Slice(top * unit_size_[i],
-                                                  (top + 1) * unit_size_[i]),
-              d.data[i].get_with_shape<cpu, 1, DType>(mshadow::Shape1(unit_size_[i])));
-          });
+      if (top == 0) {
+        this->BindOutput();
       }
+      this->CopyInstance(top, d);
       if (++top >= param_.batch_size) {
         return true;
       }
@@ -105,18 +99,7 @@ class BatchLoader : public IIterator<TBlobBatch> {
         base_->BeforeFirst();
         for (; top < param_.batch_size; ++top, ++num_overflow_) {
           CHECK(base_->Next()) << "number of input must be bigger than batch size";
-          const DataInst& d = base_->Value();
-          out_.inst_index[top] = d.index;
-          // copy data
-          for (size_t i = 0; i < d.data.size(); ++i) {
-            CHECK_EQ(unit_size_[i], d.data[i].Size());
-            MSHADOW_TYPE_SWITCH(data_[i].type_flag_, DType, {
-                mshadow::Copy(
-                  data_[i].get<cpu, 1, DType>().Slice(top * unit_size_[i],
-                                                      (top + 1) * unit_size_[i]),
-                  d.data[i].get_with_shape<cpu, 1, DType>(mshadow::Shape1(unit_size_[i])));
-              });
-          }
+          this->CopyInstance(top, base_->Value());
         }
         out_.num_batch_padd = num_overflow_;
       } else {
@@ -130,6 +113,10 @@ class BatchLoader : public IIterator<TBlobBatch> {
     return out_;
   }
 
+  virtual void SetOutputBuffers(const std::vector<TBlob> &buffers) {
+    out_buffers_ = buffers;
+  }
+
  protected:
   /*! \brief batch parameters */
   BatchParam param_;
@@ -149,6 +136,35 @@ class BatchLoader : public IIterator<TBlobBatch> {
   std::vector<TShape> shape_;
   /*! \brief unit size */
   std::vector<size_t> unit_size_;
+  /*! \brief buffers offered by the consumer for the next batch */
+  std::vector<TBlob> out_buffers_;
+  // point the output of this batch at the offered buffers where they fit
+  inline void BindOutput() {
+    for (size_t i = 0; i < data_.size(); ++i) {
+      if (i < out_buffers_.size() &&
+          out_buffers_[i].dev_mask() == cpu::kDevMask &&
+          out_buffers_[i].type_flag_ == data_[i].type_flag_ &&
+          out_buffers_[i].shape_ == shape_[i]) {
+        out_.data[i] = out_buffers_[i];
+      } else {
+        out_.data[i] = TBlob(data_[i].dptr_, shape_[i], cpu::kDevMask, data_[i].type_flag_, 0);
+      }
+    }
+    out_buffers_.clear();
+  }
+  // copy one instance into row top of the output
+  inline void CopyInstance(index_t top, const DataInst& d) {
+    out_.inst_index[top] = d.index;
+    for (size_t i = 0; i < d.data.size(); ++i) {
+      CHECK_EQ(unit_size_[i], d.data[i].Size());
+      MSHADOW_TYPE_SWITCH(data_[i].type_flag_, DType, {
+          mshadow::Copy(
+            out_.data[i].get_with_shape<cpu, 1, DType>(mshadow::Shape1(shape_[i].Size()))
+              .Slice(top * unit_size_[i], (top + 1) * unit_size_[i]),
+            d.data[i].get_with_shape<cpu, 1, DType>(mshadow::Shape1(unit_size_[i])));
+        });
+    }
+  }
   // initialize the data holder by using from the first batch.
   inline void InitData(const DataInst& first_batch) {
     shape_.resize(first_batch.data.size());
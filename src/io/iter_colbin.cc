@@ -0,0 +1,394 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ *  Copyright (c) 2019 by Contributors
+ * \file iter_colbin.cc
+ * \brief iterator over the chunked columnar binary format of colbin_format.h
+ */
+#include <mxnet/io.h>
+#include <dmlc/base.h>
+#include <dmlc/logging.h>
+#include <dmlc/parameter.h>
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+#include "./colbin_format.h"
+#include "./iter_sparse_prefetcher.h"
+#include "./iter_sparse.h"
+
+namespace mxnet {
+namespace io {
+// ColBin parameters
+struct ColBinIterParam : public dmlc::Parameter<ColBinIterParam> {
+  /*! \brief path to the colbin file */
+  std::string path;
+  /*! \brief column returned as data */
+  int data_column;
+  /*! \brief column returned as label */
+  int label_column;
+  /*! \brief partition the data into multiple parts */
+  int num_parts;
+  /*! \brief the index of the part will read*/
+  int part_index;
+  // declare parameters
+  DMLC_DECLARE_PARAMETER(ColBinIterParam) {
+    DMLC_DECLARE_FIELD(path)
+        .describe("The input colbin file.");
+    DMLC_DECLARE_FIELD(data_column).set_default(0)
+        .describe("The column of the file returned as data.");
+    DMLC_DECLARE_FIELD(label_column).set_default(1)
+        .describe("The column of the file returned as label. "
+                  "If -1, all labels will be returned as 0.");
+    DMLC_DECLARE_FIELD(num_parts).set_default(1)
+        .describe("partition the data into multiple parts");
+    DMLC_DECLARE_FIELD(part_index).set_default(0)
+        .describe("the index of the part will read");
+  }
+};
+
+/*!
+ * \brief returns batches of a colbin file.
+ *
+ *  The blobs of a batch that lies inside one uncompressed chunk point into the
+ *  file mapping; otherwise rows are first copied chunk by chunk into buffers
+ *  that keep their capacity between batches. SparsePrefetcherIter then copies
+ *  the blobs into its own arrays, so the in-place batches save one copy, not all.
+ */
+class ColBinIter: public SparseIIterator<TBlobBatch> {
+ public:
+  ColBinIter() {}
+  virtual ~ColBinIter() {}
+
+  // intialize iterator loads data in
+  virtual void Init(const std::vector<std::pair<std::string, std::string> >& kwargs) {
+    param_.InitAllowUnknown(kwargs);
+    batch_param_.InitAllowUnknown(kwargs);
+    CHECK_GT(param_.num_parts, 0) << "number of parts should be positive";
+    CHECK_GE(param_.part_index, 0) << "part index should be non-negative";
+    CHECK_LT(param_.part_index, param_.num_parts) << "part index should be less than num_parts";
+    reader_.reset(new colbin::Reader(param_.path));
+    const auto& columns = reader_->columns();
+    CHECK_GE(param_.data_column, 0);
+    CHECK_LT(param_.data_column, static_cast<int>(columns.size()))
+        << "data_column out of range, the file has " << columns.size() << " columns";
+    CHECK_LT(param_.label_column, static_cast<int>(columns.size()))
+        << "label_column out of range, the file has " << columns.size() << " columns";
+    slots_.clear();
+    slots_.emplace_back(param_.data_column, columns[param_.data_column]);
+    if (param_.label_column >= 0) {
+      slots_.emplace_back(param_.label_column, columns[param_.label_column]);
+    }
+    const size_t num_chunks = reader_->NumChunks();
+    chunk_begin_ = num_chunks * param_.part_index / param_.num_parts;
+    chunk_end_ = num_chunks * (param_.part_index + 1) / param_.num_parts;
+    CHECK_LT(chunk_begin_, chunk_end_)
+        << "part " << param_.part_index << " of " << param_.path << " has no chunks";
+    out_.inst_index = new unsigned[batch_param_.batch_size];
+    out_.batch_size = batch_param_.batch_size;
+    size_t num_blobs = 0;
+    for (const Slot& slot : slots_) {
+      num_blobs += slot.desc.kind == colbin::kCSRColumn ? 3 : 1;
+    }
+    if (param_.label_column < 0) {
+      num_blobs += 1;
+      dummy_label_.assign(batch_param_.batch_size, 0.0f);
+    }
+    out_.data.resize(num_blobs);
+    Rewind();
+  }
+
+  virtual void BeforeFirst() {
+    // after a round_batch overflow the file was already rewound
+    if (batch_param_.round_batch == 0 || num_overflow_ == 0) {
+      Rewind();
+    } else {
+      num_overflow_ = 0;
+    }
+  }
+
+  virtual bool Next() {
+    out_.num_batch_padd = 0;
+    // if overflown from previous round, directly return false, until before first is called
+    if (num_overflow_ != 0) return false;
+    const size_t batch_size = batch_param_.batch_size;
+    if (!Available()) return false;
+    if (view_.num_rows - row_ >= batch_size && InPlace()) {
+      SetInPlaceOutput();
+      return true;
+    }
+    for (Slot& slot : slots_) slot.Clear();
+    size_t top = ReadRows(0, batch_size);
+    if (top < batch_size) {
+      if (batch_param_.round_batch != 0) {
+        Rewind();
+        num_overflow_ = batch_size - top;
+        CHECK_EQ(ReadRows(top, num_overflow_), static_cast<size_t>(num_overflow_))
+            << "number of input must be bigger than batch size";
+        out_.num_batch_padd = num_overflow_;
+      } else {
+        out_.num_batch_padd = batch_size - top;
+        PadRows(batch_size - top);
+      }
+    }
+    SetOutput();
+    return true;
+  }
+
+  virtual const TBlobBatch &Value(void) const {
+    return out_;
+  }
+
+  virtual const NDArrayStorageType GetStorageType(bool is_data) const {
+    if (!is_data && param_.label_column < 0) return kDefaultStorage;
+    const Slot& slot = slots_[is_data ? 0 : 1];
+    return slot.desc.kind == colbin::kCSRColumn ? kCSRStorage : kDefaultStorage;
+  }
+
+  virtual const TShape GetShape(bool is_data) const {
+    if (!is_data && param_.label_column < 0) {
+      return TShape(mshadow::Shape1(batch_param_.batch_size));
+    }
+    const Slot& slot = slots_[is_data ? 0 : 1];
+    return TShape(mshadow::Shape2(batch_param_.batch_size, slot.desc.width));
+  }
+
+ private:
+  /*! \brief a column returned by the iterator and its batch buffers */
+  struct Slot {
+    Slot(int column, const colbin::ColumnDesc& desc)
+        : column(column), desc(desc), value_size(colbin::DTypeSize(desc.dtype)) {}
+    inline void Clear() {
+      value.clear();
+      index.clear();
+      indptr.assign(1, 0);
+    }
+    int column;
+    colbin::ColumnDesc desc;
+    size_t value_size;
+    /*! \brief value bytes of the batch */
+    std::vector<char> value;
+    std::vector<int64_t> index;
+    std::vector<int64_t> indptr;
+  };
+
+  inline void Rewind() {
+    next_chunk_ = chunk_begin_;
+    view_.num_rows = 0;
+    row_ = 0;
+    inst_counter_ = 0;
+  }
+
+  /*! \brief make sure the current chunk has rows left, false at the end of the part */
+  inline bool Available() {
+    while (row_ == view_.num_rows) {
+      if (next_chunk_ == chunk_end_) return false;
+      reader_->ReadChunk(next_chunk_++, &view_);
+      row_ = 0;
+    }
+    return true;
+  }
+
+  /*! \brief whether the current chunk can be used without copying */
+  inline bool InPlace() const {
+    for (const Slot& slot : slots_) {
+      if (!view_.decoded[slot.column * 3].empty() ||
+          !view_.decoded[slot.column * 3 + 1].empty() ||
+          !view_.decoded[slot.column * 3 + 2].empty()) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /*! \brief point the output at rows [row_, row_ + batch_size) of the current chunk */
+  inline void SetInPlaceOutput() {
+    const size_t batch_size = batch_param_.batch_size;
+    size_t blob = 0;
+    for (Slot& slot : slots_) {
+      const colbin::ColumnData& col = view_.columns[slot.column];
+      const char* value = static_cast<const char*>(col.value);
+      if (slot.desc.kind == colbin::kDenseColumn) {
+        char* rows = const_cast<char*>(value) + row_ * slot.desc.width * slot.value_size;
+        out_.data[blob++] = TBlob(static_cast<void*>(rows),
+                                  mshadow::Shape2(batch_size, slot.desc.width),
+                                  cpu::kDevMask, slot.desc.dtype);
+      } else {
+        // indptr has to be rebased to the first row of the batch
+        const int64_t base = col.indptr[row_];
+        slot.indptr.resize(batch_size + 1);
+        for (size_t i = 0; i <= batch_size; ++i) {
+          slot.indptr[i] = col.indptr[row_ + i] - base;
+        }
+        const size_t nnz = slot.indptr[batch_size];
+        char* values = const_cast<char*>(value) + base * slot.value_size;
+        out_.data[blob++] = TBlob(static_cast<void*>(values),
+                                  mshadow::Shape1(nnz), cpu::kDevMask, slot.desc.dtype);
+        out_.data[blob++] = TBlob(const_cast<int64_t*>(col.index + base),
+                                  mshadow::Shape1(nnz), cpu::kDevMask);
+        out_.data[blob++] = TBlob(dmlc::BeginPtr(slot.indptr), mshadow::Shape1(batch_size + 1),
+                                  cpu::kDevMask);
+      }
+    }
+    SetDummyLabel(blob);
+    for (size_t i = 0; i < batch_size; ++i) {
+      out_.inst_index[i] = inst_counter_++;
+    }
+    row_ += batch_size;
+  }
+
+  /*! \brief copy up to n rows into the batch buffers starting at row top, return rows read */
+  inline size_t ReadRows(size_t top, size_t n) {
+    size_t nread = 0;
+    while (nread < n && Available()) {
+      const size_t k = std::min<size_t>(n - nread, view_.num_rows - row_);
+      for (Slot& slot : slots_) {
+        const colbin::ColumnData& col = view_.columns[slot.column];
+        const char* value = static_cast<const char*>(col.value);
+        if (slot.desc.kind == colbin::kDenseColumn) {
+          const size_t row_bytes = slot.desc.width * slot.value_size;
+          const size_t offset = slot.value.size();
+          slot.value.resize(offset + k * row_bytes);
+          std::memcpy(&slot.value[offset], value + row_ * row_bytes, k * row_bytes);
+        } else {
+          const int64_t begin = col.indptr[row_];
+          const int64_t end = col.indptr[row_ + k];
+          const int64_t base = slot.indptr.back();
+          for (size_t i = 1; i <= k; ++i) {
+            slot.indptr.push_back(base + col.indptr[row_ + i] - begin);
+          }
+          slot.index.insert(slot.index.end(), col.index + begin, col.index + end);
+          slot.value.insert(slot.value.end(), value + begin * slot.value_size,
+                            value + end * slot.value_size);
+        }
+      }
+      for (size_t i = 0; i < k; ++i) {
+        out_.inst_index[top + nread + i] = inst_counter_++;
+      }
+      row_ += k;
+      nread += k;
+    }
+    return nread;
+  }
+
+  /*! \brief fill a round_batch = false tail with empty rows */
+  inline void PadRows(size_t n) {
+    for (Slot& slot : slots_) {
+      if (slot.desc.kind == colbin::kDenseColumn) {
+        slot.value.resize(slot.value.size() + n * slot.desc.width * slot.value_size, 0);
+      } else {
+        slot.indptr.resize(slot.indptr.size() + n, slot.indptr.back());
+      }
+    }
+  }
+
+  /*! \brief point the output at the batch buffers */
+  inline void SetOutput() {
+    const size_t batch_size = batch_param_.batch_size;
+    size_t blob = 0;
+    for (Slot& slot : slots_) {
+      if (slot.desc.kind == colbin::kDenseColumn) {
+        out_.data[blob++] = TBlob(static_cast<void*>(dmlc::BeginPtr(slot.value)),
+                                  mshadow::Shape2(batch_size, slot.desc.width),
+                                  cpu::kDevMask, slot.desc.dtype);
+      } else {
+        const size_t nnz = slot.index.size();
+        out_.data[blob++] = TBlob(static_cast<void*>(dmlc::BeginPtr(slot.value)),
+                                  mshadow::Shape1(nnz), cpu::kDevMask, slot.desc.dtype);
+        out_.data[blob++] = TBlob(dmlc::BeginPtr(slot.index), mshadow::Shape1(nnz),
+                                  cpu::kDevMask);
+        out_.data[blob++] = TBlob(dmlc::BeginPtr(slot.indptr), mshadow::Shape1(batch_size + 1),
+                                  cpu::kDevMask);
+      }
+    }
+    SetDummyLabel(blob);
+  }
+
+  inline void SetDummyLabel(size_t blob) {
+    if (param_.label_column < 0) {
+      out_.data[blob] = TBlob(dmlc::BeginPtr(dummy_label_),
+                              mshadow::Shape1(batch_param_.batch_size), cpu::kDevMask);
+    }
+  }
+
+  ColBinIterParam param_;
+  BatchParam batch_param_;
+  // output batch
+  TBlobBatch out_;
+  // file reader
+  std::unique_ptr<colbin::Reader> reader_;
+  // data and label columns
+  std::vector<Slot> slots_;
+  // chunk range of this part and the next chunk to read
+  size_t chunk_begin_{0}, chunk_end_{0}, next_chunk_{0};
+  // current chunk and the next row to return from it
+  colbin::ChunkView view_;
+  size_t row_{0};
+  // internal instance counter
+  unsigned inst_counter_{0};
+  // number of instances read again from the beginning to fill the last batch
+  int num_overflow_{0};
+  // zero labels when the file has no label column
+  std::vector<real_t> dummy_label_;
+};
+
+
+DMLC_REGISTER_PARAMETER(ColBinIterParam);
+
+MXNET_REGISTER_IO_ITER(ColBinIter)
+.describe(R"code(Returns an iterator over a chunked, columnar binary file.
+
+The file holds a fixed set of columns, each either dense (a fixed number of values per row)
+or ``csr`` (sparse rows with int64 indices), stored chunk by chunk with aligned buffers, so
+local files are memory mapped and batches are read without parsing. The prefetcher copies
+every batch once into its arrays; uncompressed batches that lie inside one chunk are not
+copied before that. Buffers may optionally be compressed per chunk.
+Files are produced by the ``colbin`` tool (built with ``BUILD_COLBIN_TOOL``), which
+converts anything readable by ``CSVIter`` or ``LibSVMIter``.
+
+The `data_column` and `label_column` parameters select the columns returned as data and
+label; dense columns yield arrays of shape ``(batch_size, width)`` and ``csr`` columns yield
+``CSRNDArray`` of the same shape. If `label_column` is -1 all labels are returned as 0.
+
+When `num_parts` and `part_index` are provided, the chunks of the file are split into
+`num_parts` contiguous ranges and the iterator only reads the `part_index`-th one.
+
+Example::
+
+  # convert once
+  $ colbin LibSVMIter train.colbin data_libsvm=train.libsvm data_shape=(1000000,) batch_size=65536
+
+  >>> data_iter = mx.io.ColBinIter(path='train.colbin', batch_size=512)
+  >>> batch = data_iter.next()
+  >>> batch.data[0]
+  <CSRNDArray 512x1000000 @cpu(0)>
+
+)code" ADD_FILELINE)
+.add_arguments(ColBinIterParam::__FIELDS__())
+.add_arguments(BatchParam::__FIELDS__())
+.add_arguments(PrefetcherParam::__FIELDS__())
+.set_body([]() {
+    return new SparsePrefetcherIter(
+        new ColBinIter());
+  });
+
+}  // namespace io
+}  // namespace mxnet
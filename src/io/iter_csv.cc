@@ -27,8 +27,13 @@
 #include <dmlc/logging.h>
 #include <dmlc/parameter.h>
 #include <dmlc/data.h>
+#include <dmlc/io.h>
+#include <dmlc/omp.h>
+#include <dmlc/common.h>
+#include <algorithm>
 #include "./iter_prefetcher.h"
 #include "./iter_batchloader.h"
+#include "./text_parse.h"
 
 namespace mxnet {
 namespace io {
@@ -42,6 +47,8 @@ struct CSVIterParam : public dmlc::Parameter<CSVIterParam> {
   std::string label_csv;
   /*! \brief label shape */
   TShape label_shape;
+  /*! \brief number of threads used to parse a text chunk */
+  int preprocess_threads;
   // declare parameters
   DMLC_DECLARE_PARAMETER(CSVIterParam) {
     DMLC_DECLARE_FIELD(data_csv)
@@ -54,9 +61,124 @@ struct CSVIterParam : public dmlc::Parameter<CSVIterParam> {
     index_t shape1[] = {1};
     DMLC_DECLARE_FIELD(label_shape).set_default(TShape(shape1, shape1 + 1))
         .describe("The shape of one label.");
+    DMLC_DECLARE_FIELD(preprocess_threads).set_lower_bound(1).set_default(4)
+        .describe("The number of threads used to parse the CSV files.");
   }
 };
 
+/*!
+ * \brief reads CSV text through an InputSplit and parses every chunk into one
+ *  dense row-major block, splitting the chunk across OpenMP threads at line
+ *  boundaries. Rows are written straight into their final position.
+ */
+template<typename DType>
+class CSVChunkParser {
+ public:
+  CSVChunkParser(const std::string &uri, size_t row_length, int nthread)
+      : row_length_(row_length), nthread_(nthread) {
+    source_.reset(dmlc::InputSplit::Create(uri.c_str(), 0, 1, "text"));
+  }
+  /*! \brief rewind to the beginning of the data */
+  inline void BeforeFirst() {
+    source_->BeforeFirst();
+    num_rows_ = 0;
+  }
+  /*! \brief parse the next chunk, return false at the end of the data */
+  inline bool Next() {
+    dmlc::InputSplit::Blob chunk;
+    while (source_->NextChunk(&chunk)) {
+      ParseChunk(static_cast<const char *>(chunk.dptr),
+                 static_cast<const char *>(chunk.dptr) + chunk.size);
+      if (num_rows_ != 0) return true;
+    }
+    num_rows_ = 0;
+    return false;
+  }
+  /*! \brief number of rows in the current chunk */
+  inline size_t NumRows() const {
+    return num_rows_;
+  }
+  /*! \brief the i-th row of the current chunk */
+  inline const DType *Row(size_t i) const {
+    return dmlc::BeginPtr(rows_) + i * row_length_;
+  }
+
+ private:
+  /*! \brief parse one line of exactly row_length_ values into out */
+  inline void ParseLine(const char *p, const char *eol, DType *out) const {
+    size_t n = 0;
+    while (p != eol) {
+      CHECK_LT(n, row_length_)
+          << "The data size in CSV do not match size of shape: "
+          << "the csv row has more than " << row_length_ << " values";
+      p = ParseNumber(p, eol, out + n++);
+      while (p != eol && (*p == ' ' || *p == '\t')) ++p;
+      if (p != eol && *p == ',') ++p;
+    }
+    CHECK_EQ(n, row_length_)
+        << "The data size in CSV do not match size of shape: "
+        << "specified shape size=" << row_length_ << ", the csv row-length=" << n;
+  }
+  inline void ParseChunk(const char *begin, const char *end) {
+    const int nthread = std::max(1, std::min(nthread_,
+      static_cast<int>((end - begin) / kMinBytesPerThread) + 1));
+    std::vector<const char *> seg(nthread + 1);
+    seg[0] = SkipEOL(begin, end);
+    for (int t = 1; t < nthread; ++t) {
+      seg[t] = std::max(seg[t - 1], AlignToLine(begin, begin + (end - begin) * t / nthread, end));
+    }
+    seg[nthread] = end;
+    // pass 1: count the lines of every segment to know where its rows go.
+    // blank lines are skipped, as the dmlc parser did
+    std::vector<size_t> offset(nthread + 1, 0);
+    #pragma omp parallel for num_threads(nthread)
+    for (int t = 0; t < nthread; ++t) {
+      size_t cnt = 0;
+      for (const char *p = seg[t]; p != seg[t + 1];) {
+        const char *eol = FindEOL(p, seg[t + 1]);
+        if (!IsBlankLine(p, eol)) ++cnt;
+        p = SkipEOL(eol, seg[t + 1]);
+      }
+      offset[t + 1] = cnt;
+    }
+    for (int t = 0; t < nthread; ++t) offset[t + 1] += offset[t];
+    num_rows_ = offset[nthread];
+    rows_.resize(num_rows_ * row_length_);
+    // pass 2: parse every segment into its slice of the block
+    #pragma omp parallel for num_threads(nthread)
+    for (int t = 0; t < nthread; ++t) {
+      omp_exc_.Run([&] {
+        DType *out = dmlc::BeginPtr(rows_) + offset[t] * row_length_;
+        const char *p = seg[t];
+        while (p != seg[t + 1]) {
+          const char *eol = FindEOL(p, seg[t + 1]);
+          if (!IsBlankLine(p, eol)) {
+            ParseLine(p, eol, out);
+            out += row_length_;
+          }
+          p = SkipEOL(eol, seg[t + 1]);
+        }
+      });
+    }
+    omp_exc_.Rethrow();
+  }
+
+  /*! \brief do not hand a thread less text than this */
+  static const int kMinBytesPerThread = 1 << 16;
+  /*! \brief values per row */
+  size_t row_length_;
+  /*! \brief parser threads */
+  int nthread_;
+  /*! \brief rows parsed out of the current chunk */
+  size_t num_rows_{0};
+  /*! \brief row-major values of the current chunk */
+  std::vector<DType> rows_;
+  /*! \brief text source */
+  std::unique_ptr<dmlc::InputSplit> source_;
+  /*! \brief OMPException obj to store and rethrow exceptions from omp blocks*/
+  dmlc::OMPException omp_exc_;
+};
+
 class CSVIterBase: public IIterator<DataInst> {
  public:
   CSVIterBase() {
@@ -97,10 +219,11 @@ class CSVIterTyped: public CSVIterBase {
   // intialize iterator loads data in
   virtual void Init(const std::vector<std::pair<std::string, std::string> >& kwargs) {
     param_.InitAllowUnknown(kwargs);
-    data_parser_.reset(dmlc::Parser<uint32_t, DType>::Create(param_.data_csv.c_str(), 0, 1, "csv"));
+    data_parser_.reset(new CSVChunkParser<DType>(param_.data_csv, param_.data_shape.Size(),
+                                                 param_.preprocess_threads));
     if (param_.label_csv != "NULL") {
-      label_parser_.reset(
-        dmlc::Parser<uint32_t, DType>::Create(param_.label_csv.c_str(), 0, 1, "csv"));
+      label_parser_.reset(new CSVChunkParser<DType>(param_.label_csv, param_.label_shape.Size(),
+                                                    param_.preprocess_threads));
     } else {
       dummy_label.set_pad(false);
       dummy_label.Resize(mshadow::Shape1(1));
@@ -126,21 +249,21 @@ class CSVIterTyped: public CSVIterBase {
         end_ = true; return false;
       }
       data_ptr_ = 0;
-      data_size_ = data_parser_->Value().size;
+      data_size_ = data_parser_->NumRows();
     }
     out_.index = inst_counter_++;
     CHECK_LT(data_ptr_, data_size_);
-    out_.data[0] = AsTBlob(data_parser_->Value()[data_ptr_++], param_.data_shape);
+    out_.data[0] = AsTBlob(data_parser_->Row(data_ptr_++), param_.data_shape);
 
     if (label_parser_.get() != nullptr) {
       while (label_ptr_ >= label_size_) {
         CHECK(label_parser_->Next())
             << "Data CSV's row is smaller than the number of rows in label_csv";
         label_ptr_ = 0;
-        label_size_ = label_parser_->Value().size;
+        label_size_ = label_parser_->NumRows();
       }
       CHECK_LT(label_ptr_, label_size_);
-      out_.data[1] = AsTBlob(label_parser_->Value()[label_ptr_++], param_.label_shape);
+      out_.data[1] = AsTBlob(label_parser_->Row(label_ptr_++), param_.label_shape);
     } else {
       out_.data[1] = dummy_label;
     }
@@ -148,17 +271,13 @@ class CSVIterTyped: public CSVIterBase {
   }
 
  private:
-  inline TBlob AsTBlob(const dmlc::Row<uint32_t, DType>& row, const TShape& shape) {
-    CHECK_EQ(row.length, shape.Size())
-        << "The data size in CSV do not match size of shape: "
-        << "specified shape=" << shape << ", the csv row-length=" << row.length;
-    const DType* ptr = row.value;
+  inline TBlob AsTBlob(const DType* ptr, const TShape& shape) {
     return TBlob((DType*)ptr, shape, cpu::kDevMask, 0);  // NOLINT(*)
   }
   // dummy label
   mshadow::TensorContainer<cpu, 1, DType> dummy_label;
-  std::unique_ptr<dmlc::Parser<uint32_t, DType> > label_parser_;
-  std::unique_ptr<dmlc::Parser<uint32_t, DType> > data_parser_;
+  std::unique_ptr<CSVChunkParser<DType> > label_parser_;
+  std::unique_ptr<CSVChunkParser<DType> > data_parser_;
 };
 
 class CSVIter: public IIterator<DataInst> {
@@ -41,6 +41,7 @@
 #include "./image_augmenter.h"
 #include "./image_iter_common.h"
 #include "./inst_vector.h"
+#include "./image_aug_kernel.h"
 #include "../common/utils.h"
 
 namespace mxnet {
@@ -373,7 +374,9 @@ void ImageRecordIOParser2<DType>::ProcessImage(const cv::Mat& res,
   float RGBA_BIAS[4] = { 0 };
   float RGBA_MEAN[4] = { 0 };
   mshadow::Tensor<cpu, 3, DType>& data = (*data_ptr);
-  if (!std::is_same<DType, uint8_t>::value) {
+  const bool normalize = !std::is_same<DType, uint8_t>::value;
+  const bool use_meanimg = normalize && meanfile_ready_;
+  if (normalize) {
     RGBA_MULT[0] = contrast_scaled / normalize_param_.std_r;
     RGBA_MULT[1] = contrast_scaled / normalize_param_.std_g;
     RGBA_MULT[2] = contrast_scaled / normalize_param_.std_b;
@@ -404,36 +407,13 @@ void ImageRecordIOParser2<DType>::ProcessImage(const cv::Mat& res,
     swap_indices[3] = 3;
   }
 
-  DType RGBA[n_channels] = {};
-  for (int i = 0; i < res.rows; ++i) {
-    const uchar* im_data = res.ptr<uchar>(i);
-    for (int j = 0; j < res.cols; ++j) {
-      for (int k = 0; k < n_channels; ++k) {
-        RGBA[k] = im_data[swap_indices[k]];
-      }
-      if (!std::is_same<DType, uint8_t>::value) {
-        // normalize/mirror here to avoid memory copies
-        // logic from iter_normalize.h, function SetOutImg
-        for (int k = 0; k < n_channels; ++k) {
-          if (meanfile_ready_) {
-            RGBA[k] = (RGBA[k] - meanimg_[k][i][j]) * RGBA_MULT[k] + RGBA_BIAS[k];
-          } else {
-            RGBA[k] = (RGBA[k] - RGBA_MEAN[k]) * RGBA_MULT[k] + RGBA_BIAS[k];
-          }
-        }
-      }
-      for (int k = 0; k < n_channels; ++k) {
-        // mirror here to avoid memory copies
-        // logic from iter_normalize.h, function SetOutImg
-        if (is_mirrored) {
-          data[k][i][res.cols - j - 1] = RGBA[k];
-        } else {
-          data[k][i][j] = RGBA[k];
-        }
-      }
-      im_data += n_channels;
-    }
-  }
+  // normalize/mirror while changing layout to avoid memory copies
+  // logic from iter_normalize.h, function SetOutImg
+  image_kernel::PackImageCHW(res.ptr<uint8_t>(0), res.step[0],
+                             res.rows, res.cols, n_channels, swap_indices, is_mirrored,
+                             normalize, RGBA_MEAN, RGBA_MULT, RGBA_BIAS,
+                             use_meanimg ? meanimg_.dptr_ : nullptr, meanimg_.stride_,
+                             data.dptr_, data.stride_);
 }
 
 #if MXNET_USE_LIBJPEG_TURBO
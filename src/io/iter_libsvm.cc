@@ -25,9 +25,15 @@
 #include <dmlc/base.h>
 #include <dmlc/logging.h>
 #include <dmlc/parameter.h>
-#include <dmlc/data.h>
+#include <dmlc/io.h>
+#include <dmlc/omp.h>
+#include <dmlc/common.h>
+#include <algorithm>
+#include <cstring>
+#include <utility>
 #include "./iter_sparse_prefetcher.h"
-#include "./iter_sparse_batchloader.h"
+#include "./iter_sparse.h"
+#include "./text_parse.h"
 
 namespace mxnet {
 namespace io {
@@ -45,6 +51,8 @@ struct LibSVMIterParam : public dmlc::Parameter<LibSVMIterParam> {
   int num_parts;
   /*! \brief the index of the part will read*/
   int part_index;
+  /*! \brief number of threads used to parse a batch */
+  int preprocess_threads;
   // declare parameters
   DMLC_DECLARE_PARAMETER(LibSVMIterParam) {
     DMLC_DECLARE_FIELD(data_libsvm)
@@ -61,10 +69,192 @@ struct LibSVMIterParam : public dmlc::Parameter<LibSVMIterParam> {
         .describe("partition the data into multiple parts");
     DMLC_DECLARE_FIELD(part_index).set_default(0)
         .describe("the index of the part will read");
+    DMLC_DECLARE_FIELD(preprocess_threads).set_lower_bound(1).set_default(4)
+        .describe("The number of threads used to parse the LibSVM files.");
   }
 };
 
-class LibSVMIter: public SparseIIterator<DataInst> {
+/*! \brief the lines of a LibSVM text source, served one chunk at a time */
+class LibSVMLineSource {
+ public:
+  /*! \brief [begin, end) of one line */
+  typedef std::pair<const char*, const char*> Line;
+
+  LibSVMLineSource(const std::string& uri, int part_index, int num_parts) {
+    source_.reset(dmlc::InputSplit::Create(uri.c_str(), part_index, num_parts, "text"));
+  }
+  inline void BeforeFirst() {
+    source_->BeforeFirst();
+    lines_.clear();
+    pos_ = 0;
+  }
+  /*! \brief make sure unconsumed lines are available, return false at the end of the data */
+  inline bool Fill() {
+    dmlc::InputSplit::Blob chunk;
+    while (pos_ == lines_.size()) {
+      if (!source_->NextChunk(&chunk)) return false;
+      lines_.clear();
+      pos_ = 0;
+      const char* begin = static_cast<const char*>(chunk.dptr);
+      const char* end = begin + chunk.size;
+      for (const char* p = SkipEOL(begin, end); p != end;) {
+        const char* eol = FindEOL(p, end);
+        lines_.emplace_back(p, eol);
+        p = SkipEOL(eol, end);
+      }
+    }
+    return true;
+  }
+  /*! \brief number of unconsumed lines in the current chunk */
+  inline size_t NumLines() const {
+    return lines_.size() - pos_;
+  }
+  /*! \brief the first unconsumed line, valid until the chunk is exhausted */
+  inline const Line* Lines() const {
+    return dmlc::BeginPtr(lines_) + pos_;
+  }
+  inline void Consume(size_t n) {
+    pos_ += n;
+  }
+
+ private:
+  std::unique_ptr<dmlc::InputSplit> source_;
+  std::vector<Line> lines_;
+  size_t pos_{0};
+};
+
+/*!
+ * \brief CSR rows of one batch and their label column, assembled in place: in the
+ *  arrays of a prefetch slot when they are offered and fit, else in internal vectors.
+ *  Both keep their capacity between batches.
+ */
+class CSRBatchBuffer {
+ public:
+  /*!
+   * \brief start a batch of num_rows rows. The rows go to csr if it is a CSR array of
+   *  real_t values and int64 indices, the labels to label if it is a dense real_t array
+   *  of num_rows elements; either may be none.
+   */
+  inline void Begin(size_t num_rows, const NDArray &csr, const NDArray &label) {
+    csr_ = csr;
+    if (!csr_.is_none() && (csr_.storage_type() != kCSRStorage ||
+                            csr_.dtype() != mshadow::DataType<real_t>::kFlag ||
+                            csr_.aux_type(csr::kIdx) != mshadow::kInt64 ||
+                            csr_.aux_type(csr::kIndPtr) != mshadow::kInt64)) {
+      csr_ = NDArray();
+    }
+    nnz_ = 0;
+    if (csr_.is_none()) {
+      indptr_.resize(num_rows + 1);
+      indptr_ptr_ = dmlc::BeginPtr(indptr_);
+      capacity_ = 0;
+    } else {
+      csr_.CheckAndAllocAuxData(csr::kIndPtr, mshadow::Shape1(num_rows + 1));
+      indptr_ptr_ = csr_.aux_data(csr::kIndPtr).dptr<int64_t>();
+      // the storage holds at least the values of the previous batch
+      capacity_ = csr_.aux_shape(csr::kIdx).Size();
+    }
+    indptr_ptr_[0] = 0;
+    value_ptr_ = nullptr;
+    index_ptr_ = nullptr;
+    Resize(0);
+    label_ = label;
+    if (!label_.is_none() && (label_.storage_type() != kDefaultStorage ||
+                              label_.dtype() != mshadow::DataType<real_t>::kFlag ||
+                              label_.shape().Size() != num_rows)) {
+      label_ = NDArray();
+    }
+    if (label_.is_none()) {
+      label_vec_.resize(num_rows);
+      label_ptr_ = dmlc::BeginPtr(label_vec_);
+    } else {
+      label_ptr_ = label_.data().dptr<real_t>();
+    }
+  }
+  /*! \brief make room for nnz values and indices, keeping the first nnz() */
+  inline void Resize(size_t nnz) {
+    if (csr_.is_none()) {
+      value_.resize(nnz);
+      index_.resize(nnz);
+      value_ptr_ = dmlc::BeginPtr(value_);
+      index_ptr_ = dmlc::BeginPtr(index_);
+    } else if (nnz > capacity_ || value_ptr_ == nullptr) {
+      // a reallocation drops the rows parsed so far, which are saved first. There are
+      // only such rows when the batch spans several text chunks
+      std::vector<real_t> value(value_ptr_, value_ptr_ + nnz_);
+      std::vector<int64_t> index(index_ptr_, index_ptr_ + nnz_);
+      capacity_ = std::max(nnz, nnz_ == 0 ? capacity_ : 2 * capacity_);
+      csr_.CheckAndAllocAuxData(csr::kIdx, mshadow::Shape1(capacity_));
+      csr_.CheckAndAllocData(mshadow::Shape1(capacity_));
+      value_ptr_ = csr_.data().dptr<real_t>();
+      index_ptr_ = csr_.aux_data(csr::kIdx).dptr<int64_t>();
+      std::copy(value.begin(), value.end(), value_ptr_);
+      std::copy(index.begin(), index.end(), index_ptr_);
+    }
+    nnz_ = nnz;
+  }
+  /*! \brief number of values */
+  inline size_t nnz() const {
+    return nnz_;
+  }
+  inline real_t *value() const {
+    return value_ptr_;
+  }
+  inline int64_t *index() const {
+    return index_ptr_;
+  }
+  inline int64_t *indptr() const {
+    return indptr_ptr_;
+  }
+  inline real_t *label() const {
+    return label_ptr_;
+  }
+  /*! \brief values, indices and indptr of the batch */
+  inline void GetCSR(TBlob *out) {
+    if (!csr_.is_none()) {
+      csr_.CheckAndAllocAuxData(csr::kIdx, mshadow::Shape1(nnz_));
+      csr_.CheckAndAllocData(mshadow::Shape1(nnz_));
+      out[0] = csr_.data();
+      out[1] = csr_.aux_data(csr::kIdx);
+      out[2] = csr_.aux_data(csr::kIndPtr);
+      return;
+    }
+    out[0] = TBlob(value_ptr_, mshadow::Shape1(nnz_), cpu::kDevMask);
+    out[1] = TBlob(index_ptr_, mshadow::Shape1(nnz_), cpu::kDevMask, mshadow::kInt64);
+    out[2] = TBlob(indptr_ptr_, mshadow::Shape1(indptr_.size()), cpu::kDevMask,
+                   mshadow::kInt64);
+  }
+  /*! \brief the label column of the batch */
+  inline TBlob GetLabel() const {
+    if (!label_.is_none()) return label_.data();
+    return TBlob(label_ptr_, mshadow::Shape1(label_vec_.size()), cpu::kDevMask);
+  }
+
+ private:
+  /*! \brief the arrays of the slot, or none */
+  NDArray csr_, label_;
+  /*! \brief values and indices the storage of csr_ holds at least */
+  size_t capacity_{0};
+  size_t nnz_{0};
+  std::vector<real_t> value_;
+  std::vector<int64_t> index_;
+  std::vector<int64_t> indptr_;
+  std::vector<real_t> label_vec_;
+  real_t *value_ptr_{nullptr};
+  int64_t *index_ptr_{nullptr};
+  int64_t *indptr_ptr_{nullptr};
+  real_t *label_ptr_{nullptr};
+};
+
+/*!
+ * \brief streams LibSVM text straight into CSR batches.
+ *
+ *  Every run of lines belonging to the batch is handled in two parallel passes:
+ *  the first counts the features of each line, whose prefix sum is the indptr of
+ *  the batch, the second parses each line into its final slot of the value and
+ *  index arrays. No per-instance rows are materialized.
+ */
+class LibSVMIter: public SparseIIterator<TBlobBatch>, public DirectSparseBatchOutput {
  public:
   LibSVMIter() {}
   virtual ~LibSVMIter() {}
@@ -72,22 +262,26 @@ class LibSVMIter: public SparseIIterator<DataInst> {
   // intialize iterator loads data in
   virtual void Init(const std::vector<std::pair<std::string, std::string> >& kwargs) {
     param_.InitAllowUnknown(kwargs);
+    batch_param_.InitAllowUnknown(kwargs);
     CHECK_EQ(param_.data_shape.ndim(), 1) << "dimension of data_shape is expected to be 1";
     CHECK_GT(param_.num_parts, 0) << "number of parts should be positive";
     CHECK_GE(param_.part_index, 0) << "part index should be non-negative";
-    data_parser_.reset(dmlc::Parser<uint64_t>::Create(param_.data_libsvm.c_str(),
-                                                      param_.part_index,
-                                                      param_.num_parts, "libsvm"));
+    if (batch_param_.round_batch == 0) {
+      LOG(FATAL) << "sparse batch loader doesn't support round_batch == false yet";
+    }
+    data_source_.reset(new LibSVMLineSource(param_.data_libsvm, param_.part_index,
+                                            param_.num_parts));
     if (param_.label_libsvm != "NULL") {
-      label_parser_.reset(dmlc::Parser<uint64_t>::Create(param_.label_libsvm.c_str(),
-                                                         param_.part_index,
-                                                         param_.num_parts, "libsvm"));
+      label_source_.reset(new LibSVMLineSource(param_.label_libsvm, param_.part_index,
+                                               param_.num_parts));
       CHECK_GT(param_.label_shape.Size(), 1)
         << "label_shape is not expected to be (1,) when param_.label_libsvm is set.";
     } else {
       CHECK_EQ(param_.label_shape.Size(), 1)
         << "label_shape is expected to be (1,) when param_.label_libsvm is NULL";
     }
+    out_.inst_index = new unsigned[batch_param_.batch_size];
+    out_.batch_size = batch_param_.batch_size;
     // both data and label are of CSRStorage in libsvm format
     if (param_.label_shape.Size() > 1) {
       out_.data.resize(6);
@@ -98,100 +292,204 @@ class LibSVMIter: public SparseIIterator<DataInst> {
   }
 
   virtual void BeforeFirst() {
-    data_parser_->BeforeFirst();
-    if (label_parser_.get() != nullptr) {
-      label_parser_->BeforeFirst();
+    // after a round_batch overflow the sources were already rewound
+    if (num_overflow_ == 0) {
+      RewindSources();
+    } else {
+      num_overflow_ = 0;
     }
-    data_ptr_ = label_ptr_ = 0;
-    data_size_ = label_size_ = 0;
-    inst_counter_ = 0;
-    end_ = false;
   }
 
   virtual bool Next() {
-    if (end_) return false;
-    while (data_ptr_ >= data_size_) {
-      if (!data_parser_->Next()) {
-        end_ = true; return false;
-      }
-      data_ptr_ = 0;
-      data_size_ = data_parser_->Value().size;
-    }
-    out_.index = inst_counter_++;
-    CHECK_LT(data_ptr_, data_size_);
-    const auto data_row = data_parser_->Value()[data_ptr_++];
-    // data, indices and indptr
-    out_.data[0] = AsDataBlob(data_row);
-    out_.data[1] = AsIdxBlob(data_row);
-    out_.data[2] = AsIndPtrPlaceholder(data_row);
-
-    if (label_parser_.get() != nullptr) {
-      while (label_ptr_ >= label_size_) {
-        CHECK(label_parser_->Next())
-            << "Data LibSVM's row is smaller than the number of rows in label_libsvm";
-        label_ptr_ = 0;
-        label_size_ = label_parser_->Value().size;
-      }
-      CHECK_LT(label_ptr_, label_size_);
-      const auto label_row = label_parser_->Value()[label_ptr_++];
-      // data, indices and indptr
-      out_.data[3] = AsDataBlob(label_row);
-      out_.data[4] = AsIdxBlob(label_row);
-      out_.data[5] = AsIndPtrPlaceholder(label_row);
+    out_.num_batch_padd = 0;
+    // if overflown from previous round, directly return false, until before first is called
+    if (num_overflow_ != 0) return false;
+    const size_t batch_size = batch_param_.batch_size;
+    // assemble the batch in the arrays of the slot if they were offered
+    const NDArray none;
+    const NDArray &data_out = out_arrays_.size() > 0 ? out_arrays_[0] : none;
+    const NDArray &label_out = out_arrays_.size() > 1 ? out_arrays_[1] : none;
+    if (label_source_.get() != nullptr) {
+      data_.Begin(batch_size, data_out, none);
+      label_.Begin(batch_size, label_out, none);
     } else {
-      out_.data[3] = AsScalarLabelBlob(data_row);
+      data_.Begin(batch_size, data_out, label_out);
+    }
+    out_arrays_.clear();
+    size_t top = ReadRows(0, batch_size);
+    if (top == 0) return false;
+    if (top < batch_size) {
+      RewindSources();
+      num_overflow_ = batch_size - top;
+      CHECK_EQ(ReadRows(top, num_overflow_), static_cast<size_t>(num_overflow_))
+        << "number of input must be bigger than batch size";
+      out_.num_batch_padd = num_overflow_;
     }
+    SetOutput();
     return true;
   }
 
-  virtual const DataInst &Value(void) const {
+  virtual const TBlobBatch &Value(void) const {
     return out_;
   }
 
+  virtual void SetOutputArrays(const std::vector<NDArray> &arrays) {
+    out_arrays_ = arrays;
+  }
+
   virtual const NDArrayStorageType GetStorageType(bool is_data) const {
     if (is_data) return kCSRStorage;
     return param_.label_shape.Size() > 1 ? kCSRStorage : kDefaultStorage;
   }
 
   virtual const TShape GetShape(bool is_data) const {
-    if (is_data) return param_.data_shape;
-    return param_.label_shape;
+    const TShape& inst_shape = is_data ? param_.data_shape : param_.label_shape;
+    std::vector<index_t> shape_vec;
+    shape_vec.push_back(batch_param_.batch_size);
+    for (index_t dim = 0; dim < inst_shape.ndim(); ++dim) {
+      shape_vec.push_back(inst_shape[dim]);
+    }
+    return TShape(shape_vec.begin(), shape_vec.end());
   }
 
  private:
-  inline TBlob AsDataBlob(const dmlc::Row<uint64_t>& row) {
-    const real_t* ptr = row.value;
-    TShape shape(mshadow::Shape1(row.length));
-    return TBlob((real_t*) ptr, shape, cpu::kDevMask);  // NOLINT(*)
+  /*! \brief do not spawn threads for fewer lines than this */
+  static const size_t kMinParallelLines = 64;
+
+  inline void RewindSources() {
+    data_source_->BeforeFirst();
+    if (label_source_.get() != nullptr) {
+      label_source_->BeforeFirst();
+    }
+    inst_counter_ = 0;
   }
 
-  inline TBlob AsIdxBlob(const dmlc::Row<uint64_t>& row) {
-    const uint64_t* ptr = row.index;
-    TShape shape(mshadow::Shape1(row.length));
-    return TBlob((int64_t*) ptr, shape, cpu::kDevMask, mshadow::kInt64);  // NOLINT(*)
+  /*! \brief append up to n rows to the batch starting at row top, return rows read */
+  inline size_t ReadRows(size_t top, size_t n) {
+    size_t nread = 0;
+    while (nread < n && data_source_->Fill()) {
+      const size_t k = std::min(n - nread, data_source_->NumLines());
+      AppendRows(data_source_->Lines(), top + nread, k, param_.data_shape[0], &data_);
+      data_source_->Consume(k);
+      for (size_t done = 0; label_source_.get() != nullptr && done < k;) {
+        CHECK(label_source_->Fill())
+            << "Data LibSVM's row is smaller than the number of rows in label_libsvm";
+        const size_t m = std::min(k - done, label_source_->NumLines());
+        AppendRows(label_source_->Lines(), top + nread + done, m,
+                   param_.label_shape.Size(), &label_);
+        label_source_->Consume(m);
+        done += m;
+      }
+      for (size_t i = 0; i < k; ++i) {
+        out_.inst_index[top + nread + i] = inst_counter_++;
+      }
+      nread += k;
+    }
+    return nread;
+  }
+
+  /*! \brief next blank separated token of [p, end) */
+  static inline const char* NextToken(const char* p, const char* end, const char** token_end) {
+    while (p != end && (*p == ' ' || *p == '\t')) ++p;
+    const char* q = p;
+    while (q != end && *q != ' ' && *q != '\t') ++q;
+    *token_end = q;
+    return p;
+  }
+
+  static inline bool IsQid(const char* p, const char* end) {
+    return end - p > 4 && std::strncmp(p, "qid:", 4) == 0;
+  }
+
+  /*! \brief number of features of a line: every token after the label but qid */
+  static inline int64_t CountFeatures(const LibSVMLineSource::Line& line) {
+    int64_t nnz = 0;
+    const char* tend = line.first;
+    NextToken(line.first, line.second, &tend);  // label
+    for (const char* p = NextToken(tend, line.second, &tend);
+         p != line.second; p = NextToken(tend, line.second, &tend)) {
+      if (!IsQid(p, tend)) ++nnz;
+    }
+    return nnz;
   }
 
-  inline TBlob AsIndPtrPlaceholder(const dmlc::Row<uint64_t>& row) {
-    return TBlob(nullptr, mshadow::Shape1(0), cpu::kDevMask, mshadow::kInt64);
+  /*! \brief parse label and features of a line into their final slots */
+  static inline void ParseLine(const LibSVMLineSource::Line& line, int64_t width,
+                               real_t* label, real_t* value, int64_t* index) {
+    const char* tend = line.first;
+    const char* p = NextToken(line.first, line.second, &tend);
+    // a label:weight pair keeps the label only
+    ParseNumber(p, tend, label);
+    for (p = NextToken(tend, line.second, &tend);
+         p != line.second; p = NextToken(tend, line.second, &tend)) {
+      if (IsQid(p, tend)) continue;
+      const char* q = ParseNumber(p, tend, index);
+      CHECK(*index >= 0 && *index < width)
+          << "LibSVM feature index " << *index << " out of [0, " << width << ")";
+      if (q != tend && *q == ':') {
+        ParseNumber(q + 1, tend, value);
+      } else {
+        *value = 1.0f;
+      }
+      ++value;
+      ++index;
+    }
   }
 
-  inline TBlob AsScalarLabelBlob(const dmlc::Row<uint64_t>& row) {
-    const real_t* ptr = row.label;
-    return TBlob((real_t*) ptr, mshadow::Shape1(1), cpu::kDevMask);  // NOLINT(*)
+  /*! \brief parse n lines of features in [0, width) into the rows of buf from row_begin on */
+  inline void AppendRows(const LibSVMLineSource::Line* lines, size_t row_begin, size_t n,
+                         int64_t width, CSRBatchBuffer* buf) {
+    const int nthread = param_.preprocess_threads;
+    int64_t* indptr = buf->indptr() + row_begin;
+    const int64_t nrow = static_cast<int64_t>(n);
+    // pass 1: features per line, prefix summed into indptr
+    #pragma omp parallel for num_threads(nthread) if (n >= kMinParallelLines)
+    for (int64_t i = 0; i < nrow; ++i) {
+      indptr[i + 1] = CountFeatures(lines[i]);
+    }
+    for (size_t i = 0; i < n; ++i) indptr[i + 1] += indptr[i];
+    buf->Resize(indptr[n]);
+    // pass 2: parse every line into place
+    real_t* label = buf->label() + row_begin;
+    real_t* value = buf->value();
+    int64_t* index = buf->index();
+    #pragma omp parallel for num_threads(nthread) if (n >= kMinParallelLines)
+    for (int64_t i = 0; i < nrow; ++i) {
+      omp_exc_.Run([&] {
+        ParseLine(lines[i], width, label + i, value + indptr[i], index + indptr[i]);
+      });
+    }
+    omp_exc_.Rethrow();
+  }
+
+  /*! \brief point the output blobs at the batch buffers */
+  inline void SetOutput() {
+    data_.GetCSR(&out_.data[0]);
+    if (label_source_.get() != nullptr) {
+      label_.GetCSR(&out_.data[3]);
+    } else {
+      out_.data[3] = data_.GetLabel();
+    }
   }
 
   LibSVMIterParam param_;
-  // output instance
-  DataInst out_;
+  BatchParam batch_param_;
+  // output batch
+  TBlobBatch out_;
   // internal instance counter
   unsigned inst_counter_{0};
-  // at end
-  bool end_{false};
-  // label parser
-  size_t label_ptr_{0}, label_size_{0};
-  size_t data_ptr_{0}, data_size_{0};
-  std::unique_ptr<dmlc::Parser<uint64_t> > label_parser_;
-  std::unique_ptr<dmlc::Parser<uint64_t> > data_parser_;
+  // number of instances read again from the beginning to fill the last batch
+  int num_overflow_{0};
+  // text sources
+  std::unique_ptr<LibSVMLineSource> data_source_;
+  std::unique_ptr<LibSVMLineSource> label_source_;
+  // batch buffers
+  CSRBatchBuffer data_;
+  CSRBatchBuffer label_;
+  // arrays of the prefetch slot offered for the next batch
+  std::vector<NDArray> out_arrays_;
+  /*! \brief OMPException obj to store and rethrow exceptions from omp blocks*/
+  dmlc::OMPException omp_exc_;
 };
 
 
@@ -301,8 +599,7 @@ Example::
 .add_arguments(PrefetcherParam::__FIELDS__())
 .set_body([]() {
     return new SparsePrefetcherIter(
-        new SparseBatchLoader(
-            new LibSVMIter()));
+        new LibSVMIter());
   });
 
 }  // namespace io
@@ -43,6 +43,45 @@
 
 namespace mxnet {
 namespace io {
+/*!
+ * \brief free list of prefetch buffers, matched by shape and type.
+ *  Buffers that no longer fit their slot are parked here instead of being
+ *  freed, so iterators whose batch shapes alternate do not reallocate.
+ *  Only used from the prefetch thread.
+ */
+class BatchBufferPool {
+ public:
+  /*! \brief context of newly allocated buffers, CPU or CPUPinned */
+  inline void set_context(Context ctx) {
+    ctx_ = ctx;
+  }
+  /*! \brief get a buffer with the given shape and type */
+  inline NDArray Acquire(const TShape &shape, int dtype) {
+    for (size_t i = free_.size(); i != 0; --i) {
+      if (free_[i - 1].shape() == shape && free_[i - 1].dtype() == dtype) {
+        NDArray ret = free_[i - 1];
+        free_.erase(free_.begin() + (i - 1));
+        return ret;
+      }
+    }
+    return NDArray(shape, ctx_, false, dtype);
+  }
+  /*! \brief give back a buffer, the oldest ones are dropped beyond kMaxFree */
+  inline void Release(const NDArray &arr) {
+    if (arr.is_none()) return;
+    if (free_.size() >= kMaxFree) free_.erase(free_.begin());
+    free_.push_back(arr);
+  }
+
+ private:
+  /*! \brief maximum number of parked buffers */
+  static const size_t kMaxFree = 64;
+  /*! \brief context of new buffers */
+  Context ctx_{Context::CPU()};
+  /*! \brief parked buffers */
+  std::vector<NDArray> free_;
+};
+
 // iterator on image recordio
 class PrefetcherIter : public IIterator<DataBatch> {
  public:
@@ -67,44 +106,55 @@ class PrefetcherIter : public IIterator<DataBatch> {
     const int kMaxPrefetchBuffer = 16;
     // init thread iter
     iter.set_max_capacity(kMaxPrefetchBuffer);
+    pool_.set_context(BatchContext());
   }
 
   virtual void Init(const std::vector<std::pair<std::string, std::string> >& kwargs) {
     InitParams(kwargs);
     // use the kwarg to init batch loader
     loader_->Init(kwargs);
+    direct_ = dynamic_cast<DirectBatchOutput*>(loader_.get());
     iter.Init([this](DataBatch **dptr) {
+        if (direct_ != nullptr) {
+          // let the loader assemble the batch in the recycled slot
+          std::vector<TBlob> slot;
+          if (*dptr != nullptr) {
+            for (const NDArray &arr : (*dptr)->data) slot.push_back(arr.data());
+          }
+          direct_->SetOutputBuffers(slot);
+        }
         if (!loader_->Next()) return false;
         const TBlobBatch& batch = loader_->Value();
         if (*dptr == nullptr) {
           // allocate databatch
           *dptr = new DataBatch();
-          (*dptr)->num_batch_padd = batch.num_batch_padd;
-          (*dptr)->data.resize(batch.data.size());
-          (*dptr)->index.resize(batch.batch_size);
-          for (size_t i = 0; i < batch.data.size(); ++i) {
-            auto dtype = param_.dtype
-                             ? param_.dtype.value()
-                             : batch.data[i].type_flag_;
-            (*dptr)->data.at(i) = NDArray(batch.data[i].shape_,
-                                          Context::CPU(), false,
-                                          dtype);
-          }
         }
-        CHECK(batch.data.size() == (*dptr)->data.size());
-        // copy data over
+        DataBatch *out = *dptr;
+        for (size_t i = batch.data.size(); i < out->data.size(); ++i) {
+          pool_.Release(out->data[i]);
+        }
+        out->data.resize(batch.data.size());
+        out->index.resize(batch.batch_size);
+        out->num_batch_padd = batch.num_batch_padd;
         for (size_t i = 0; i < batch.data.size(); ++i) {
-          CHECK_EQ((*dptr)->data.at(i).shape(), batch.data[i].shape_);
-          MSHADOW_TYPE_SWITCH(batch.data[i].type_flag_, DType, {
-              mshadow::Copy(((*dptr)->data)[i].data().FlatTo2D<cpu, DType>(),
-                        batch.data[i].FlatTo2D<cpu, DType>());
+          const TBlob &src = batch.data[i];
+          auto dtype = param_.dtype ? param_.dtype.value() : src.type_flag_;
+          NDArray &dst = out->data[i];
+          if (dst.is_none() || dst.shape() != src.shape_ || dst.dtype() != dtype) {
+            pool_.Release(dst);
+            dst = pool_.Acquire(src.shape_, dtype);
+          }
+          // nothing to do if the loader wrote into the slot
+          if (dst.data().dptr_ == src.dptr_) continue;
+          MSHADOW_TYPE_SWITCH(src.type_flag_, DType, {
+              mshadow::Copy(dst.data().FlatTo2D<cpu, DType>(),
+                            src.FlatTo2D<cpu, DType>());
           });
-          (*dptr)->num_batch_padd = batch.num_batch_padd;
         }
         if (batch.inst_index) {
           std::copy(batch.inst_index,
                     batch.inst_index + batch.batch_size,
-                    (*dptr)->index.begin());
+                    out->index.begin());
         }
        return true;
       },
@@ -136,6 +186,11 @@ class PrefetcherIter : public IIterator<DataBatch> {
   }
 
  protected:
+  /*! \brief context of the prefetched batches, page-locked if pinned_device_id is set */
+  inline Context BatchContext() const {
+    return param_.pinned_device_id >= 0 ?
+      Context::CPUPinned(param_.pinned_device_id) : Context::CPU();
+  }
   /*! \brief prefetcher parameters */
   PrefetcherParam param_;
   /*! \brief backend thread */
@@ -148,6 +203,10 @@ class PrefetcherIter : public IIterator<DataBatch> {
   DataBatch *out_;
   /*! \brief queue to be recycled */
   std::queue<DataBatch*> recycle_queue_;
+  /*! \brief loader_ if it can write into the prefetch slots, else nullptr */
+  DirectBatchOutput *direct_{nullptr};
+  /*! \brief buffers that do not fit any slot right now */
+  BatchBufferPool pool_;
 };
 }  // namespace io
 }  // namespace mxnet
@@ -26,6 +26,7 @@
 
 #include <mxnet/io.h>
 #include <mxnet/ndarray.h>
+#include <vector>
 
 namespace mxnet {
 /*!
@@ -41,5 +42,24 @@ class SparseIIterator : public IIterator<DType> {
   virtual const TShape GetShape(bool is_data) const = 0;
 };  // class SparseIIterator
 
+/*!
+ * \brief sparse batch iterators implementing this can assemble the next batch
+ *  straight into the NDArrays of a prefetch slot, allocating their storage once
+ *  the number of non-zeros is known, instead of internal buffers that have to be
+ *  copied out again.
+ */
+class DirectSparseBatchOutput {
+ public:
+  virtual ~DirectSparseBatchOutput() {}
+  /*!
+   * \brief set the arrays, data then label, the next call to Next() writes into.
+   *  Arrays whose storage type or types do not match the batch layout are ignored
+   *  and internal buffers are used instead, so the caller has to compare
+   *  TBlobBatch::data of the result with the arrays it offered.
+   *  The arrays are only used for a single batch.
+   */
+  virtual void SetOutputArrays(const std::vector<NDArray> &arrays) = 0;
+};
+
 }  // namespace mxnet
 #endif  // MXNET_IO_ITER_SPARSE_H_
@@ -56,7 +56,12 @@ class SparsePrefetcherIter : public PrefetcherIter {
     PrefetcherIter::InitParams(kwargs);
     // use the kwarg to init batch loader
     sparse_loader_->Init(kwargs);
+    direct_ = dynamic_cast<DirectSparseBatchOutput*>(sparse_loader_);
     iter.Init([this](DataBatch **dptr) {
+        if (direct_ != nullptr) {
+          // let the loader assemble the batch in the arrays of the recycled slot
+          direct_->SetOutputArrays(*dptr != nullptr ? (*dptr)->data : std::vector<NDArray>());
+        }
         if (!sparse_loader_->Next()) return false;
         const TBlobBatch& batch = sparse_loader_->Value();
         if (*dptr == nullptr) {
@@ -74,35 +79,40 @@ class SparsePrefetcherIter : public PrefetcherIter {
             auto dtype = param_.dtype ? param_.dtype.value() : batch.data[data_iter].type_flag_;
             if (stype == kDefaultStorage) {
               (*dptr)->data.at(i) = NDArray(batch.data[data_iter].shape_,
-                                            Context::CPU(), false, dtype);
+                                            BatchContext(), false, dtype);
             } else {
               (*dptr)->data.at(i) = NDArray(stype, this->GetShape(is_data),
-                                            Context::CPU(), false, dtype);
+                                            BatchContext(), false, dtype);
             }
             data_iter += num_aux_data(stype) + 1;
           }
         }
-        // copy data over
+        // copy data over, unless the loader wrote into the slot
         size_t data_iter = 0;
         for (size_t i = 0; i < (*dptr)->data.size(); ++i) {
           auto& nd = ((*dptr)->data)[i];
           auto stype = nd.storage_type();
           auto& data_i = ((*dptr)->data)[i];
           if (stype == kDefaultStorage) {
-            CopyFromTo(data_i.data(), batch.data[data_iter]);
+            if (data_i.data().dptr_ != batch.data[data_iter].dptr_) {
+              CopyFromTo(data_i.data(), batch.data[data_iter]);
+            }
           } else if (stype == kCSRStorage) {
             auto& values = batch.data[data_iter];
             auto& indices = batch.data[data_iter + 1];
             auto& indptr = batch.data[data_iter + 2];
-            // allocate memory
-            CHECK_EQ(indices.shape_.Size(), values.shape_.Size());
-            nd.CheckAndAllocAuxData(csr::kIdx, indices.shape_);
-            nd.CheckAndAllocData(values.shape_);
-            nd.CheckAndAllocAuxData(csr::kIndPtr, indptr.shape_);
-            // copy values, indices and indptr
-            CopyFromTo(data_i.data(), values);
-            CopyFromTo(data_i.aux_data(csr::kIdx), indices);
-            CopyFromTo(data_i.aux_data(csr::kIndPtr), indptr);
+            // indptr is never empty, unlike values and indices
+            if (data_i.aux_data(csr::kIndPtr).dptr_ != indptr.dptr_) {
+              // allocate memory
+              CHECK_EQ(indices.shape_.Size(), values.shape_.Size());
+              nd.CheckAndAllocAuxData(csr::kIdx, indices.shape_);
+              nd.CheckAndAllocData(values.shape_);
+              nd.CheckAndAllocAuxData(csr::kIndPtr, indptr.shape_);
+              // copy values, indices and indptr
+              CopyFromTo(data_i.data(), values);
+              CopyFromTo(data_i.aux_data(csr::kIdx), indices);
+              CopyFromTo(data_i.aux_data(csr::kIndPtr), indptr);
+            }
           } else {
             LOG(FATAL) << "Storage type not implemented: " << stype;
           }
@@ -141,6 +151,8 @@ class SparsePrefetcherIter : public PrefetcherIter {
  private:
   /*! \brief internal sparse batch loader */
   SparseIIterator<TBlobBatch>* sparse_loader_;
+  /*! \brief sparse_loader_ if it can write into the prefetch slots, else nullptr */
+  DirectSparseBatchOutput* direct_{nullptr};
 
   inline void CopyFromTo(TBlob dst, const TBlob src) {
     MSHADOW_TYPE_SWITCH(src.type_flag_, DType, {
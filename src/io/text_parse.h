@@ -0,0 +1,160 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ *  Copyright (c) 2019 by Contributors
+ * \file text_parse.h
+ * \brief line and number scanning shared by the text data iterators
+ */
+#ifndef MXNET_IO_TEXT_PARSE_H_
+#define MXNET_IO_TEXT_PARSE_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <type_traits>
+
+namespace mxnet {
+namespace io {
+
+/*! \brief whether c ends a number in CSV or LibSVM text */
+inline bool IsNumberDelimiter(char c) {
+  return c == ',' || c == ' ' || c == '\t' || c == ':' || c == '\n' || c == '\r';
+}
+
+/*!
+ * \brief parse one number starting at p (leading blanks are skipped).
+ *
+ *  Plain decimal numbers are converted from an integer mantissa and an exact power
+ *  of ten in the precision of DType (float for float, double otherwise), which is
+ *  correctly rounded whenever both are exact in it: a mantissa of 24 bits and an
+ *  exponent in [-10, 10] for float, 53 bits and [-22, 22] for double. Anything else
+ *  (long mantissas, inf, nan, ...) goes through strtof or strtod on a terminated copy
+ *  of the field, so p never has to be null terminated.
+ * \return pointer to the first character after the number
+ */
+template<typename DType>
+inline const char *ParseNumber(const char *p, const char *end, DType *out) {
+  // converting a float column in double would round twice
+  typedef typename std::conditional<std::is_same<DType, float>::value,
+                                    float, double>::type Real;
+  static const Real kPow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+  };
+  const bool is_float = std::is_same<Real, float>::value;
+  const uint64_t max_mantissa = is_float ? (1ULL << 24) : (1ULL << 53);
+  const int max_exp10 = is_float ? 10 : 22;
+  while (p != end && (*p == ' ' || *p == '\t')) ++p;
+  const char *field = p;
+  bool negative = false;
+  if (p != end && (*p == '-' || *p == '+')) {
+    negative = (*p == '-');
+    ++p;
+  }
+  uint64_t mantissa = 0;
+  int digits = 0, exp10 = 0;
+  bool is_integer = true;
+  for (; p != end && *p >= '0' && *p <= '9'; ++p, ++digits) {
+    mantissa = mantissa * 10 + (*p - '0');
+  }
+  if (p != end && *p == '.') {
+    is_integer = false;
+    for (++p; p != end && *p >= '0' && *p <= '9'; ++p, ++digits) {
+      mantissa = mantissa * 10 + (*p - '0');
+      --exp10;
+    }
+  }
+  if (p != end && (*p == 'e' || *p == 'E')) {
+    is_integer = false;
+    const char *q = p + 1;
+    bool exp_negative = false;
+    if (q != end && (*q == '-' || *q == '+')) {
+      exp_negative = (*q == '-');
+      ++q;
+    }
+    int e = 0;
+    const char *exp_begin = q;
+    for (; q != end && *q >= '0' && *q <= '9' && e < 100000; ++q) e = e * 10 + (*q - '0');
+    if (q != exp_begin) {
+      exp10 += exp_negative ? -e : e;
+      p = q;
+    }
+  }
+  const bool well_formed = (p == end || IsNumberDelimiter(*p));
+  if (is_integer && std::is_integral<DType>::value && well_formed && digits > 0 &&
+      digits <= 18) {
+    *out = static_cast<DType>(negative ? -static_cast<int64_t>(mantissa)
+                                       : static_cast<int64_t>(mantissa));
+    return p;
+  }
+  if (well_formed && digits > 0 && digits <= 18 && mantissa <= max_mantissa &&
+      exp10 >= -max_exp10 && exp10 <= max_exp10) {
+    Real v = static_cast<Real>(mantissa);
+    v = exp10 < 0 ? v / kPow10[-exp10] : v * kPow10[exp10];
+    *out = static_cast<DType>(negative ? -v : v);
+    return p;
+  }
+  // slow path: let the C library deal with the field
+  const char *stop = field;
+  while (stop != end && !IsNumberDelimiter(*stop)) ++stop;
+  char buf[128];
+  const size_t len = std::min(static_cast<size_t>(stop - field), sizeof(buf) - 1);
+  std::memcpy(buf, field, len);
+  buf[len] = '\0';
+  if (std::is_integral<DType>::value && is_integer && well_formed) {
+    *out = static_cast<DType>(std::strtoll(buf, nullptr, 10));
+  } else if (is_float) {
+    *out = static_cast<DType>(std::strtof(buf, nullptr));
+  } else {
+    *out = static_cast<DType>(std::strtod(buf, nullptr));
+  }
+  return stop;
+}
+
+/*! \brief skip line terminators, return start of the next line or end */
+inline const char *SkipEOL(const char *p, const char *end) {
+  while (p != end && (*p == '\n' || *p == '\r')) ++p;
+  return p;
+}
+
+/*! \brief first '\n' or '\r' at or after p, using the vectorized memchr */
+inline const char *FindEOL(const char *p, const char *end) {
+  const char *nl = static_cast<const char *>(std::memchr(p, '\n', end - p));
+  const char *eol = nl != nullptr ? nl : end;
+  const char *cr = static_cast<const char *>(std::memchr(p, '\r', eol - p));
+  return cr != nullptr ? cr : eol;
+}
+
+/*! \brief whether [p, eol) holds nothing but blanks */
+inline bool IsBlankLine(const char *p, const char *eol) {
+  while (p != eol && (*p == ' ' || *p == '\t')) ++p;
+  return p == eol;
+}
+
+/*! \brief first line start at or after p, which may point into the middle of a line */
+inline const char *AlignToLine(const char *begin, const char *p, const char *end) {
+  if (p == begin || *(p - 1) == '\n' || *(p - 1) == '\r') return SkipEOL(p, end);
+  return SkipEOL(FindEOL(p, end), end);
+}
+
+}  // namespace io
+}  // namespace mxnet
+#endif  // MXNET_IO_TEXT_PARSE_H_
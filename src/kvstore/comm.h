@@ -30,6 +30,7 @@
 #include <vector>
 #include <tuple>
 #include <thread>
+#include <functional>
 #include "mxnet/ndarray.h"
 #include "gradient_compression.h"
 #include "../ndarray/ndarray_function.h"
@@ -143,9 +144,6 @@ class CommCPU : public Comm {
     if (stype == kDefaultStorage) {
       std::vector<Engine::VarHandle> const_vars(src.size() - 1);
       std::vector<NDArray> reduce(src.size());
-      CopyFromTo(src[0], &buf_merged, priority);
-      reduce[0] = buf_merged;
-
       if (buf.copy_buf.empty()) {
         buf.copy_buf.resize(src.size()-1);
         for (size_t j = 0; j < src.size() - 1; ++j) {
@@ -153,7 +151,12 @@ class CommCPU : public Comm {
           buf.copy_buf[j] = NDArray(
             src[0].shape(), pinned_ctx_, false, src[0].dtype());
         }
+        std::vector<NDArray> bufs(buf.copy_buf);
+        bufs.push_back(buf_merged);
+        FirstTouch(bufs, priority);
       }
+      CopyFromTo(src[0], &buf_merged, priority);
+      reduce[0] = buf_merged;
       CHECK(stype == buf.copy_buf[0].storage_type())
            << "Storage type mismatch detected. " << stype << "(src) vs. "
            << buf.copy_buf[0].storage_type() << "(buf.copy_buf)";
@@ -190,16 +193,14 @@ class CommCPU : public Comm {
         reduce[i] = buf.copy_buf[i];
         const_vars[i] = reduce[i].var();
       }
-      Resource rsc = ResourceManager::Get()->Request(buf_merged.ctx(),
-          ResourceRequest(ResourceRequest::kTempSpace));
       Engine::Get()->PushAsync(
-        [reduce, buf_merged, rsc, this](RunContext rctx, Engine::CallbackOnComplete on_complete) {
+        [reduce, buf_merged, this](RunContext rctx, Engine::CallbackOnComplete on_complete) {
           NDArray out = buf_merged;
           is_serial_push_?
             ReduceSumCPUExSerial(reduce, &out)
-            : mxnet::ndarray::ElementwiseSum(rctx.get_stream<cpu>(), rsc, reduce, &out);
+            : ReduceSumCPUExParallel(reduce, &out);
           on_complete();
-        }, Context::CPU(), const_vars, {buf_merged.var(), rsc.var},
+        }, Context::CPU(), const_vars, {buf_merged.var()},
         FnProperty::kCPUPrioritized, priority, "KVStoreReduce");
     }
 
@@ -354,61 +355,227 @@ class CommCPU : public Comm {
     });
   }
 
+  // parallel implementation of reduce sum for row sparse NDArray. The row ids
+  // are split into one range per thread, every thread merges the rows of its
+  // range, first to count them and then to sum them.
+  inline void ReduceSumCPUExParallel(const std::vector<NDArray> &in, NDArray *out) {
+    using namespace rowsparse;
+    using namespace mshadow;
+    auto stype = out->storage_type();
+    CHECK_EQ(stype, kRowSparseStorage) << "Unexpected storage type " << stype;
+    std::vector<NDArray> inputs;
+    size_t total_num_rows = 0, max_num_rows = 0, largest = 0;
+    for (const NDArray& nd : in) {
+      if (!nd.storage_initialized()) continue;
+      const size_t num_rows = nd.aux_shape(kIdx).Size();
+      if (num_rows > max_num_rows) {
+        max_num_rows = num_rows;
+        largest = inputs.size();
+      }
+      total_num_rows += num_rows;
+      inputs.push_back(nd);
+    }
+    if (total_num_rows * out->shape().ProdShape(1, out->shape().ndim()) < bigarray_bound_ ||
+        nthread_reduction_ <= 1) {
+      ReduceSumCPUExSerial(in, out);
+      return;
+    }
+    const size_t num_in = inputs.size();
+    const size_t row_len = out->shape().ProdShape(1, out->shape().ndim());
+    const int nchunks = static_cast<int>(std::min<size_t>(nthread_reduction_, max_num_rows));
+    MSHADOW_TYPE_SWITCH(out->dtype(), DType, {
+      MSHADOW_IDX_TYPE_SWITCH(out->aux_type(kIdx), IType, {
+        std::vector<const IType*> in_idx(num_in);
+        std::vector<const DType*> in_vals(num_in);
+        for (size_t i = 0; i < num_in; ++i) {
+          in_idx[i] = inputs[i].aux_data(kIdx).dptr<IType>();
+          in_vals[i] = inputs[i].data().dptr<DType>();
+        }
+        // the row ids of the largest input split the rows into chunks of about equal size
+        const IType* split_idx = in_idx[largest];
+        std::vector<std::vector<std::pair<size_t, size_t>>> ranges(
+            nchunks, std::vector<std::pair<size_t, size_t>>(num_in));
+        for (int c = 0; c < nchunks; ++c) {
+          for (size_t i = 0; i < num_in; ++i) {
+            const IType* begin = in_idx[i];
+            const IType* end = begin + inputs[i].aux_shape(kIdx).Size();
+            const IType* lo = c == 0 ? begin :
+                std::lower_bound(begin, end, split_idx[max_num_rows * c / nchunks]);
+            const IType* hi = c == nchunks - 1 ? end :
+                std::lower_bound(begin, end, split_idx[max_num_rows * (c + 1) / nchunks]);
+            ranges[c][i] = std::make_pair(lo - begin, hi - begin);
+          }
+        }
+        // merges the rows of chunk c, calling f(row id, positions of the row in the inputs)
+        auto merge = [&](int c, const std::function<void(IType, const std::vector<size_t>&)>& f) {
+          std::vector<size_t> pos(num_in), rows(num_in);
+          for (size_t i = 0; i < num_in; ++i) pos[i] = ranges[c][i].first;
+          while (true) {
+            bool found = false;
+            IType row = 0;
+            for (size_t i = 0; i < num_in; ++i) {
+              if (pos[i] < ranges[c][i].second && (!found || in_idx[i][pos[i]] < row)) {
+                row = in_idx[i][pos[i]];
+                found = true;
+              }
+            }
+            if (!found) break;
+            rows.clear();
+            for (size_t i = 0; i < num_in; ++i) {
+              if (pos[i] < ranges[c][i].second && in_idx[i][pos[i]] == row) {
+                rows.push_back(i);
+                rows.push_back(pos[i]++);
+              }
+            }
+            f(row, rows);
+          }
+        };
+        std::vector<size_t> offsets(nchunks + 1, 0);
+        #pragma omp parallel for schedule(static, 1) num_threads(nchunks)
+        for (int c = 0; c < nchunks; ++c) {
+          merge(c, [&offsets, c](IType, const std::vector<size_t>&) { ++offsets[c + 1]; });
+        }
+        for (int c = 0; c < nchunks; ++c) offsets[c + 1] += offsets[c];
+        out->CheckAndAlloc({Shape1(offsets[nchunks])});
+        IType* out_idx = out->aux_data(kIdx).dptr<IType>();
+        DType* out_vals = out->data().dptr<DType>();
+        #pragma omp parallel for schedule(static, 1) num_threads(nchunks)
+        for (int c = 0; c < nchunks; ++c) {
+          size_t k = offsets[c];
+          std::vector<const DType*> srcs;
+          merge(c, [&](IType row, const std::vector<size_t>& rows) {
+            out_idx[k] = row;
+            DType* dst = out_vals + k * row_len;
+            std::copy(in_vals[rows[0]] + rows[1] * row_len,
+                      in_vals[rows[0]] + (rows[1] + 1) * row_len, dst);
+            srcs.clear();
+            for (size_t r = 2; r < rows.size(); r += 2) {
+              srcs.push_back(in_vals[rows[r]] + rows[r + 1] * row_len);
+            }
+            SumInto(dst, srcs, 0, row_len);
+            ++k;
+          });
+        }
+      });
+    });
+  }
+
+  /**
+   * \brief dst[i] += src[0][offset + i] + ... for i in [0, size). The sum is
+   * computed in blocks which stay in the L1 cache while the sources are added
+   * to them four at a time, in loops the compiler vectorizes.
+   */
   template<typename DType>
-  inline static void ReduceSumCPU(
-      const std::vector<DType*> &dptr, size_t offset, index_t size) {
-    using namespace mshadow;  // NOLINT(*)
-    Tensor<cpu, 1, DType> in_0(dptr[0] + offset, Shape1(size));
-    for (size_t i = 1; i < dptr.size(); i+=4) {
-      switch (dptr.size() - i) {
-        case 1: {
-          Tensor<cpu, 1, DType> in_1(dptr[i] + offset, Shape1(size));
-          in_0 += in_1;
+  inline static void SumInto(DType* dst, const std::vector<const DType*>& src,
+                             size_t offset, size_t size) {
+    const size_t block = std::max<size_t>(kReduceBlockBytes / sizeof(DType), 1);
+    const size_t nsrc = src.size();
+    for (size_t b = 0; b < size; b += block) {
+      DType* __restrict__ out = dst + b;
+      const size_t n = std::min(block, size - b);
+      const size_t begin = offset + b;
+      size_t i = 0;
+      for (; i + 4 <= nsrc; i += 4) {
+        const DType* __restrict__ in_1 = src[i] + begin;
+        const DType* __restrict__ in_2 = src[i + 1] + begin;
+        const DType* __restrict__ in_3 = src[i + 2] + begin;
+        const DType* __restrict__ in_4 = src[i + 3] + begin;
+        for (size_t j = 0; j < n; ++j) out[j] += in_1[j] + in_2[j] + in_3[j] + in_4[j];
+      }
+      switch (nsrc - i) {
+        case 3: {
+          const DType* __restrict__ in_1 = src[i] + begin;
+          const DType* __restrict__ in_2 = src[i + 1] + begin;
+          const DType* __restrict__ in_3 = src[i + 2] + begin;
+          for (size_t j = 0; j < n; ++j) out[j] += in_1[j] + in_2[j] + in_3[j];
           break;
         }
         case 2: {
-          Tensor<cpu, 1, DType> in_1(dptr[i] + offset, Shape1(size));
-          Tensor<cpu, 1, DType> in_2(dptr[i+1] + offset, Shape1(size));
-          in_0 += in_1 + in_2;
+          const DType* __restrict__ in_1 = src[i] + begin;
+          const DType* __restrict__ in_2 = src[i + 1] + begin;
+          for (size_t j = 0; j < n; ++j) out[j] += in_1[j] + in_2[j];
           break;
         }
-        case 3: {
-          Tensor<cpu, 1, DType> in_1(dptr[i] + offset, Shape1(size));
-          Tensor<cpu, 1, DType> in_2(dptr[i+1] + offset, Shape1(size));
-          Tensor<cpu, 1, DType> in_3(dptr[i+2] + offset, Shape1(size));
-          in_0 += in_1 + in_2 + in_3;
+        case 1: {
+          const DType* __restrict__ in_1 = src[i] + begin;
+          for (size_t j = 0; j < n; ++j) out[j] += in_1[j];
           break;
         }
-        default: {
-          Tensor<cpu, 1, DType> in_1(dptr[i] + offset, Shape1(size));
-          Tensor<cpu, 1, DType> in_2(dptr[i+1] + offset, Shape1(size));
-          Tensor<cpu, 1, DType> in_3(dptr[i+2] + offset, Shape1(size));
-          Tensor<cpu, 1, DType> in_4(dptr[i+3] + offset, Shape1(size));
-          in_0 += in_1 + in_2 + in_3 + in_4;
+        default:
           break;
-        }
       }
     }
   }
 
+  /**
+   * \brief the first element of every chunk a reduction of total elements is
+   * split into, followed by total. There is one chunk per thread, starting at a
+   * page boundary, so that every page of the buffers is only written by one
+   * thread. With OMP_PROC_BIND set, a thread then finds the pages it touched
+   * first in FirstTouch on its own NUMA node.
+   */
+  template<typename DType>
+  inline std::vector<size_t> ReduceChunks(size_t total) const {
+    std::vector<size_t> chunks = {0};
+    if (total >= bigarray_bound_ && nthread_reduction_ > 1) {
+      const size_t page = std::max<size_t>(kPageBytes / sizeof(DType), 1);
+      const size_t num_pages = (total + page - 1) / page;
+      const size_t nchunks = std::min<size_t>(nthread_reduction_, num_pages);
+      for (size_t c = 1; c < nchunks; ++c) {
+        chunks.push_back(std::min(num_pages * c / nchunks * page, total));
+      }
+    }
+    chunks.push_back(total);
+    return chunks;
+  }
+
   template<typename DType>
   inline void ReduceSumCPUImpl(std::vector<DType*> dptr, size_t total) {
-    const size_t step = std::min(bigarray_bound_, static_cast<size_t>(4 << 10));
-    long ntask = (total + step - 1) / step; // NOLINT(*)
-    if (total < bigarray_bound_ || nthread_reduction_ <= 1) {
-      ReduceSumCPU(dptr, 0, total);
+    const std::vector<size_t> chunks = ReduceChunks<DType>(total);
+    const std::vector<const DType*> src(dptr.begin() + 1, dptr.end());
+    const int nchunks = static_cast<int>(chunks.size()) - 1;
+    if (nchunks == 1) {
+      SumInto(dptr[0], src, 0, total);
     } else {
-      #pragma omp parallel for schedule(static) num_threads(nthread_reduction_)
-      for (long j = 0; j < ntask; ++j) { // NOLINT(*)
-        size_t k = static_cast<size_t>(j);
-        size_t begin = std::min(k * step, total);
-        size_t end = std::min((k + 1) * step, total);
-        if (j == ntask - 1) CHECK_EQ(end, total);
-        ReduceSumCPU(dptr, begin, static_cast<index_t>(end - begin));
+      // chunk c is reduced by thread c, as in FirstTouch
+      #pragma omp parallel for schedule(static, 1) num_threads(nchunks)
+      for (int c = 0; c < nchunks; ++c) {
+        SumInto(dptr[0] + chunks[c], src, chunks[c], chunks[c + 1] - chunks[c]);
       }
     }
   }
 
+  /**
+   * \brief zero the buffers of a dense reduction with the threads that reduce
+   * their chunks, so that the memory of a chunk is allocated on the NUMA node
+   * of its thread
+   */
+  inline void FirstTouch(const std::vector<NDArray>& bufs, int priority) {
+    std::vector<Engine::VarHandle> mutable_vars;
+    for (const NDArray& buf : bufs) mutable_vars.push_back(buf.var());
+    Engine::Get()->PushAsync(
+      [bufs, this](RunContext rctx, Engine::CallbackOnComplete on_complete) {
+        for (NDArray buf : bufs) {
+          buf.CheckAndAlloc();
+          MSHADOW_TYPE_SWITCH(buf.dtype(), DType, {
+            DType* dptr = buf.data().dptr<DType>();
+            const std::vector<size_t> chunks = ReduceChunks<DType>(buf.shape().Size());
+            const int nchunks = static_cast<int>(chunks.size()) - 1;
+            #pragma omp parallel for schedule(static, 1) num_threads(nchunks)
+            for (int c = 0; c < nchunks; ++c) {
+              std::fill(dptr + chunks[c], dptr + chunks[c + 1], DType(0));
+            }
+          });
+        }
+        on_complete();
+      }, Context::CPU(), {}, mutable_vars,
+      FnProperty::kCPUPrioritized, priority, "KVStoreReduceFirstTouch");
+  }
+
+  /// \brief size of the blocks of SumInto, which stay in the L1 cache
+  static const size_t kReduceBlockBytes = 8 << 10;
+  static const size_t kPageBytes = 4 << 10;
+
   /// \brief temporal space for pushing and pulling
   struct BufferEntry {
     /// \brief the merged value
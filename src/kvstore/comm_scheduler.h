@@ -0,0 +1,155 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * Copyright (c) 2019 by Contributors
+ * @file   comm_scheduler.h
+ * @brief  priority scheduling of the messages to the servers
+ */
+#ifndef MXNET_KVSTORE_COMM_SCHEDULER_H_
+#define MXNET_KVSTORE_COMM_SCHEDULER_H_
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace mxnet {
+namespace kvstore {
+
+/**
+ * \brief sends messages in the order of their priority, with credit based flow control
+ *
+ * Frontends push the gradients with priority -index, so that the gradients
+ * of the first layers, which the next forward pass needs first, have the
+ * highest priority. Handing all messages to the network as soon as they are
+ * ready makes them wait in the send queue behind the gradients of the last
+ * layers, which are computed first. The scheduler instead keeps at most
+ * credit bytes in flight and holds the other messages back, so that a
+ * message with a higher priority can overtake them once it is ready.
+ */
+class CommScheduler {
+ public:
+  typedef std::function<void()> Callback;
+  /** \brief sends a message, and calls the callback once the response arrived */
+  typedef std::function<void(const Callback&)> SendFn;
+
+  /**
+   * \param credit maximum number of bytes in flight, 0 sends every message at once
+   */
+  explicit CommScheduler(size_t credit) : credit_(credit) {
+    if (credit_ > 0) {
+      thread_ = std::thread([this]() { Run(); });
+    }
+  }
+
+  ~CommScheduler() {
+    if (thread_.joinable()) {
+      {
+        std::lock_guard<std::mutex> lock(mu_);
+        stop_ = true;
+      }
+      cond_.notify_all();
+      thread_.join();
+    }
+  }
+
+  /**
+   * \brief queue a message. A message larger than the credit is sent once
+   * nothing else is in flight.
+   * \param priority higher priorities are sent first, equal ones in FIFO order
+   * \param bytes size of the message
+   * \param send function sending the message, called on the thread of the scheduler
+   */
+  void Send(int priority, size_t bytes, const SendFn& send) {
+    if (credit_ == 0) {
+      send([]() {});
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      queue_.push(Message{priority, seq_++, bytes, send});
+    }
+    cond_.notify_all();
+  }
+
+  /** \brief number of bytes sent whose response has not arrived yet */
+  size_t in_flight() {
+    std::lock_guard<std::mutex> lock(mu_);
+    return in_flight_;
+  }
+
+ private:
+  struct Message {
+    int priority;
+    uint64_t seq;
+    size_t bytes;
+    SendFn send;
+  };
+
+  /** \brief orders the queue by decreasing priority, then by increasing seq */
+  struct SentLater {
+    bool operator()(const Message& a, const Message& b) const {
+      return a.priority != b.priority ? a.priority < b.priority : a.seq > b.seq;
+    }
+  };
+
+  /**
+   * \brief sends the messages the credit allows. The responses arrive on the
+   * threads of the network library, which must not send from there.
+   */
+  void Run() {
+    std::unique_lock<std::mutex> lock(mu_);
+    while (true) {
+      cond_.wait(lock, [this]() {
+        return stop_ || (!queue_.empty() &&
+                         (in_flight_ == 0 || in_flight_ + queue_.top().bytes <= credit_));
+      });
+      if (stop_) break;
+      Message msg = queue_.top();
+      queue_.pop();
+      in_flight_ += msg.bytes;
+      lock.unlock();
+      const size_t bytes = msg.bytes;
+      msg.send([this, bytes]() {
+        {
+          std::lock_guard<std::mutex> lock(mu_);
+          in_flight_ -= bytes;
+        }
+        cond_.notify_all();
+      });
+      lock.lock();
+    }
+  }
+
+  const size_t credit_;
+  size_t in_flight_ = 0;
+  uint64_t seq_ = 0;
+  bool stop_ = false;
+  std::priority_queue<Message, std::vector<Message>, SentLater> queue_;
+  std::mutex mu_;
+  std::condition_variable cond_;
+  std::thread thread_;
+};
+
+}  // namespace kvstore
+}  // namespace mxnet
+#endif  // MXNET_KVSTORE_COMM_SCHEDULER_H_
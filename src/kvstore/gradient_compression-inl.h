@@ -27,6 +27,7 @@
 
 #include <vector>
 #include "../operator/mxnet_op.h"
+#include "./gradient_compression.h"
 
 namespace mxnet {
 namespace kvstore {
@@ -36,6 +37,10 @@ void Quantize2BitImpl(mshadow::Stream<mshadow::gpu> *s, const std::vector<mxnet:
                       const float threshold);
 void Dequantize2BitImpl(mshadow::Stream<mshadow::gpu> *s, const std::vector<mxnet::TBlob> &inputs,
                         const float threshold);
+void QuantizeImpl(mshadow::Stream<mshadow::gpu> *s, const std::vector<mxnet::TBlob> &inputs,
+                  const CompressionType type, const float threshold, const int block_size);
+void DequantizeImpl(mshadow::Stream<mshadow::gpu> *s, const std::vector<mxnet::TBlob> &inputs,
+                    const CompressionType type, const float threshold, const int block_size);
 
 struct quantize_2bit {
   MSHADOW_XINLINE static void Map(int out_block_id,
@@ -138,6 +143,212 @@ void Dequantize2BitKernelLaunch(mshadow::Stream<xpu> *s, const std::vector<mxnet
           threshold);               // positive threshold
 }
 
+struct quantize_1bit {
+  MSHADOW_XINLINE static void Map(int out_block_id,
+                                  int original_size,
+                                  float *out,
+                                  float *grad,
+                                  float *residual,
+                                  const float threshold) {
+    // this block holds the signs of upto 32 values starting from out_block_id*32,
+    // bit j is set when value j is non-negative
+    const int start = out_block_id << 5;
+    const int end = (start + 32 <= original_size) ? start + 32 : original_size;
+    uint32_t bits = 0;
+    for (int i = start; i < end; i++) {
+      residual[i] += grad[i];
+      if (residual[i] >= 0) {
+        bits |= 1U << (i - start);
+        residual[i] -= threshold;
+      } else {
+        residual[i] += threshold;
+      }
+    }
+    *reinterpret_cast<uint32_t *>(out + out_block_id) = bits;
+  }
+};
+
+struct dequantize_1bit {
+  MSHADOW_XINLINE static void Map(int i,
+                                  float *out,
+                                  float *in,
+                                  const float threshold) {
+    const uint32_t bits = *reinterpret_cast<uint32_t *>(in + (i >> 5));
+    out[i] = ((bits >> (i & 31)) & 1) ? threshold : -threshold;
+  }
+};
+
+struct quantize_topk {
+  MSHADOW_XINLINE static void Map(int out_block_id,
+                                  int original_size,
+                                  float *out,
+                                  float *grad,
+                                  float *residual,
+                                  const int block_size) {
+    // sends the largest magnitude value of each block of block_size values,
+    // packed as its fp16 value followed by its 16 bit offset in the block
+    const int start = out_block_id * block_size;
+    const int end = (start + block_size <= original_size) ? start + block_size : original_size;
+    int best = start;
+    float best_abs = -1.f;
+    for (int i = start; i < end; i++) {
+      residual[i] += grad[i];
+      const float a = residual[i] < 0 ? -residual[i] : residual[i];
+      if (a > best_abs) {
+        best_abs = a;
+        best = i;
+      }
+    }
+    const mshadow::half::half_t val(residual[best]);
+    residual[best] -= static_cast<float>(val);
+    uint16_t *packed = reinterpret_cast<uint16_t *>(out + out_block_id);
+    packed[0] = val.half_;
+    packed[1] = static_cast<uint16_t>(best - start);
+  }
+};
+
+struct dequantize_topk {
+  MSHADOW_XINLINE static void Map(int in_block_id,
+                                  int original_size,
+                                  float *out,
+                                  float *in,
+                                  const int block_size) {
+    const int start = in_block_id * block_size;
+    const int end = (start + block_size <= original_size) ? start + block_size : original_size;
+    for (int i = start; i < end; i++) {
+      out[i] = 0;
+    }
+    const uint16_t *packed = reinterpret_cast<const uint16_t *>(in + in_block_id);
+    if (start + packed[1] < end) {
+      out[start + packed[1]] = static_cast<float>(mshadow::half::half_t::Binary(packed[0]));
+    }
+  }
+};
+
+/*! \brief round to nearest even float -> bfloat16 */
+MSHADOW_XINLINE uint16_t FloatToBF16(const float value) {
+  union { float f; uint32_t u; } x;
+  x.f = value;
+  if ((x.u & 0x7fffffff) > 0x7f800000) {
+    // keep NaN a quiet NaN
+    return static_cast<uint16_t>((x.u >> 16) | 0x40);
+  }
+  return static_cast<uint16_t>((x.u + 0x7fff + ((x.u >> 16) & 1)) >> 16);
+}
+
+MSHADOW_XINLINE float BF16ToFloat(const uint16_t value) {
+  union { float f; uint32_t u; } x;
+  x.u = static_cast<uint32_t>(value) << 16;
+  return x.f;
+}
+
+template<CompressionType type>
+struct quantize_cast {
+  MSHADOW_XINLINE static void Map(int i,
+                                  float *out,
+                                  float *grad,
+                                  float *residual) {
+    // two 16 bit values are stored in every float of out
+    const float v = residual[i] + grad[i];
+    float sent;
+    if (type == CompressionType::kFP16) {
+      const mshadow::half::half_t h(v);
+      reinterpret_cast<uint16_t *>(out)[i] = h.half_;
+      sent = static_cast<float>(h);
+    } else {
+      const uint16_t h = FloatToBF16(v);
+      reinterpret_cast<uint16_t *>(out)[i] = h;
+      sent = BF16ToFloat(h);
+    }
+    residual[i] = v - sent;
+  }
+};
+
+template<CompressionType type>
+struct dequantize_cast {
+  MSHADOW_XINLINE static void Map(int i,
+                                  float *out,
+                                  float *in) {
+    const uint16_t h = reinterpret_cast<const uint16_t *>(in)[i];
+    if (type == CompressionType::kFP16) {
+      out[i] = static_cast<float>(mshadow::half::half_t::Binary(h));
+    } else {
+      out[i] = BF16ToFloat(h);
+    }
+  }
+};
+
+/*!
+ * \brief quantizes inputs[0] plus the residual inputs[1] into inputs[2]
+ * for all types other than 2bit, which keeps its own entry points
+ */
+template<typename xpu>
+void QuantizeKernelLaunch(mshadow::Stream<xpu> *s, const std::vector<mxnet::TBlob> &inputs,
+                          const CompressionType type, const float threshold,
+                          const int block_size) {
+  using mxnet::op::mxnet_op::Kernel;
+  float *grad = inputs[0].dptr<float>();
+  float *residual = inputs[1].dptr<float>();
+  float *out = inputs[2].dptr<float>();
+  const int original_size = inputs[0].Size();
+  switch (type) {
+    case CompressionType::kOneBit:
+      Kernel<quantize_1bit, xpu>::Launch(s, inputs[2].Size(), original_size,
+                                         out, grad, residual, threshold);
+      break;
+    case CompressionType::kTopK:
+      Kernel<quantize_topk, xpu>::Launch(s, inputs[2].Size(), original_size,
+                                         out, grad, residual, block_size);
+      break;
+    case CompressionType::kFP16:
+      Kernel<quantize_cast<CompressionType::kFP16>, xpu>::Launch(s, original_size,
+                                                                 out, grad, residual);
+      break;
+    case CompressionType::kBF16:
+      Kernel<quantize_cast<CompressionType::kBF16>, xpu>::Launch(s, original_size,
+                                                                 out, grad, residual);
+      break;
+    default:
+      LOG(FATAL) << "Unsupported quantization of type " << static_cast<int>(type);
+  }
+}
+
+/*!
+ * \brief dequantizes inputs[0] into inputs[1]
+ */
+template<typename xpu>
+void DequantizeKernelLaunch(mshadow::Stream<xpu> *s, const std::vector<mxnet::TBlob> &inputs,
+                            const CompressionType type, const float threshold,
+                            const int block_size) {
+  using mxnet::op::mxnet_op::Kernel;
+  float *in = inputs[0].dptr<float>();
+  float *out = inputs[1].dptr<float>();
+  const int original_size = inputs[1].Size();
+  switch (type) {
+    case CompressionType::kOneBit:
+      Kernel<dequantize_1bit, xpu>::Launch(s, original_size, out, in, threshold);
+      break;
+    case CompressionType::kTopK:
+      Kernel<dequantize_topk, xpu>::Launch(s, inputs[0].Size(), original_size,
+                                           out, in, block_size);
+      break;
+    case CompressionType::kFP16:
+      Kernel<dequantize_cast<CompressionType::kFP16>, xpu>::Launch(s, original_size, out, in);
+      break;
+    case CompressionType::kBF16:
+      Kernel<dequantize_cast<CompressionType::kBF16>, xpu>::Launch(s, original_size, out, in);
+      break;
+    default:
+      LOG(FATAL) << "Unsupported dequantization of type " << static_cast<int>(type);
+  }
+}
+
+struct majority_vote {
+  MSHADOW_XINLINE static void Map(int i, float *data, const float threshold) {
+    data[i] = data[i] > 0 ? threshold : (data[i] < 0 ? -threshold : 0);
+  }
+};
+
 inline void Quantize2BitImpl(mshadow::Stream<mshadow::cpu> *s,
                              const std::vector<mxnet::TBlob> &inputs,
                              const float threshold) {
@@ -149,6 +360,20 @@ inline void Dequantize2BitImpl(mshadow::Stream<mshadow::cpu> *s,
                                const float threshold) {
   Dequantize2BitKernelLaunch(s, inputs, threshold);
 }
+
+inline void QuantizeImpl(mshadow::Stream<mshadow::cpu> *s,
+                         const std::vector<mxnet::TBlob> &inputs,
+                         const CompressionType type, const float threshold,
+                         const int block_size) {
+  QuantizeKernelLaunch(s, inputs, type, threshold, block_size);
+}
+
+inline void DequantizeImpl(mshadow::Stream<mshadow::cpu> *s,
+                           const std::vector<mxnet::TBlob> &inputs,
+                           const CompressionType type, const float threshold,
+                           const int block_size) {
+  DequantizeKernelLaunch(s, inputs, type, threshold, block_size);
+}
 }  // namespace kvstore
 }  // namespace mxnet
 
@@ -23,6 +23,8 @@
  * \author Rahul Huilgol
  */
 
+#include <algorithm>
+#include <cmath>
 #include <vector>
 #include "kvstore_local.h"
 #include "gradient_compression.h"
@@ -44,6 +46,14 @@ void GradientCompression::SetParams(const std::vector<std::pair<std::string, std
   CHECK_GT(params.threshold, 0) << "threshold must be greater than 0";
   if (params.type == "2bit") {
     SetTwoBitCompression(params.threshold);
+  } else if (params.type == "1bit") {
+    SetOneBitCompression(params.threshold);
+  } else if (params.type == "topk") {
+    SetTopKCompression(params.ratio);
+  } else if (params.type == "fp16") {
+    SetCastCompression(CompressionType::kFP16);
+  } else if (params.type == "bf16") {
+    SetCastCompression(CompressionType::kBF16);
   } else {
     LOG(FATAL) << "Unknown type for gradient compression " << params.type;
   }
@@ -62,11 +72,30 @@ void GradientCompression::SetTwoBitCompression(const float threshold) {
   threshold_ = threshold;
 }
 
+void GradientCompression::SetOneBitCompression(const float threshold) {
+  type_ = CompressionType::kOneBit;
+  threshold_ = threshold;
+}
+
+void GradientCompression::SetTopKCompression(const float ratio) {
+  CHECK(ratio > 0 && ratio <= 0.5) << "ratio for topk compression must be in (0, 0.5]";
+  type_ = CompressionType::kTopK;
+  // offsets in a block are sent as 16 bit integers
+  block_size_ = std::min(65536, static_cast<int>(std::round(1.0 / ratio)));
+}
+
+void GradientCompression::SetCastCompression(const CompressionType type) {
+  CHECK(type == CompressionType::kFP16 || type == CompressionType::kBF16);
+  type_ = type;
+}
+
 std::string GradientCompression::EncodeParams() {
   using namespace std;  // to reduce length of next line
   string rval = get_type_str();
-  if (type_ == CompressionType::kTwoBit) {
+  if (type_ == CompressionType::kTwoBit || type_ == CompressionType::kOneBit) {
     rval += "," + to_string(threshold_);
+  } else if (type_ == CompressionType::kTopK) {
+    rval += ",," + to_string(block_size_);
   }
   return rval;
 }
@@ -80,14 +109,25 @@ void GradientCompression::DecodeParams(const std::string &s) {
       threshold_ = stof(elems[1]);
     }
   }
+  if (elems.size() > 2) {
+    block_size_ = stoi(elems[2]);
+  }
 }
 
 int GradientCompression::GetCompressionFactor() {
-  if (type_ == CompressionType::kTwoBit) {
-    return 16;
-  } else {
-    LOG(FATAL) << "Unsupported compression type: " << get_type_str();
-    return 0;
+  switch (type_) {
+    case CompressionType::kTwoBit:
+      return 16;
+    case CompressionType::kOneBit:
+      return 32;
+    case CompressionType::kTopK:
+      return block_size_;
+    case CompressionType::kFP16:
+    case CompressionType::kBF16:
+      return 2;
+    default:
+      LOG(FATAL) << "Unsupported compression type: " << get_type_str();
+      return 0;
   }
 }
 
@@ -103,35 +143,44 @@ void GradientCompression::Quantize(const mxnet::NDArray &from, mxnet::NDArray *t
   CHECK(from.shape().ndim() != 0) << "source operand has zero dimension shape";
   CHECK(to->shape().ndim() != 0) << "destination operand has zero dimension shape";
   CHECK(residual->shape().ndim() != 0) << "residual operand has zero dimension shape";
+  CHECK(type_ != CompressionType::kNone) << "Unsupported quantization of type " << get_type_str();
   const int a = from.ctx().dev_mask();
   const int b = to->ctx().dev_mask();
+  const CompressionType type = type_;
   const float threshold = threshold_;
-  if (type_ == CompressionType::kTwoBit) {
-    if (a == mshadow::cpu::kDevMask && b == mshadow::cpu::kDevMask) {
-      mxnet::Engine::Get()->PushSync([from, to, residual, threshold](mxnet::RunContext ctx) {
-        std::vector<mxnet::TBlob> inputs = {from.data(), residual->data(), to->data()};
+  const int block_size = block_size_;
+  if (a == mshadow::cpu::kDevMask && b == mshadow::cpu::kDevMask) {
+    mxnet::Engine::Get()->PushSync([from, to, residual, type, threshold, block_size]
+                                   (mxnet::RunContext ctx) {
+      std::vector<mxnet::TBlob> inputs = {from.data(), residual->data(), to->data()};
+      if (type == CompressionType::kTwoBit) {
         Quantize2BitImpl(ctx.get_stream<mshadow::cpu>(), inputs, threshold);
-      }, from.ctx(), {from.var()}, {to->var(), residual->var()},
-      mxnet::FnProperty::kNormal, priority, "QuantizeCPU");
-    } else {
-#if MXNET_USE_CUDA
-      if (a == mshadow::gpu::kDevMask && b == mshadow::gpu::kDevMask) {
-        mxnet::Engine::Get()->PushSync([from, to, residual, threshold](mxnet::RunContext ctx) {
-          std::vector<mxnet::TBlob> inputs = {from.data(), residual->data(), to->data()};
-          Quantize2BitImpl(ctx.get_stream<mshadow::gpu>(), inputs, threshold);
-          // Wait GPU kernel to complete
-          ctx.get_stream<mshadow::gpu>()->Wait();
-        }, from.ctx(), {from.var()}, {to->var(), residual->var()},
-        mxnet::FnProperty::kNormal, priority, "QuantizeGPU");
       } else {
-        LOG(FATAL) << "unknown device mask";
+        QuantizeImpl(ctx.get_stream<mshadow::cpu>(), inputs, type, threshold, block_size);
       }
+    }, from.ctx(), {from.var()}, {to->var(), residual->var()},
+    mxnet::FnProperty::kNormal, priority, "QuantizeCPU");
+  } else {
+#if MXNET_USE_CUDA
+    if (a == mshadow::gpu::kDevMask && b == mshadow::gpu::kDevMask) {
+      mxnet::Engine::Get()->PushSync([from, to, residual, type, threshold, block_size]
+                                     (mxnet::RunContext ctx) {
+        std::vector<mxnet::TBlob> inputs = {from.data(), residual->data(), to->data()};
+        if (type == CompressionType::kTwoBit) {
+          Quantize2BitImpl(ctx.get_stream<mshadow::gpu>(), inputs, threshold);
+        } else {
+          QuantizeImpl(ctx.get_stream<mshadow::gpu>(), inputs, type, threshold, block_size);
+        }
+        // Wait GPU kernel to complete
+        ctx.get_stream<mshadow::gpu>()->Wait();
+      }, from.ctx(), {from.var()}, {to->var(), residual->var()},
+      mxnet::FnProperty::kNormal, priority, "QuantizeGPU");
+    } else {
+      LOG(FATAL) << "unknown device mask";
+    }
 #else
     LOG(FATAL) << MXNET_GPU_NOT_ENABLED_ERROR;
 #endif
-    }
-  } else {
-    LOG(FATAL) << "Unsupported quantization of type " << get_type_str();
   }
 }
 
@@ -139,38 +188,61 @@ void GradientCompression::Dequantize(const mxnet::NDArray &from, mxnet::NDArray
                                      const int priority) {
   CHECK(from.shape().ndim() != 0) << "source operands has zero dimension shape";
   CHECK(to->shape().ndim() != 0) << "destination operand has zero dimension shape";
+  CHECK(type_ != CompressionType::kNone)
+    << "Unsupported dequantization of type " << get_type_str();
   const int a = from.ctx().dev_mask();
   const int b = to->ctx().dev_mask();
+  const CompressionType type = type_;
   const float threshold = threshold_;
-  if (type_ == CompressionType::kTwoBit) {
-    if (a == mshadow::cpu::kDevMask && b == mshadow::cpu::kDevMask) {
-      mxnet::Engine::Get()->PushSync([from, to, threshold](mxnet::RunContext ctx) {
-        std::vector<mxnet::TBlob> inputs = {from.data(), to->data()};
+  const int block_size = block_size_;
+  if (a == mshadow::cpu::kDevMask && b == mshadow::cpu::kDevMask) {
+    mxnet::Engine::Get()->PushSync([from, to, type, threshold, block_size]
+                                   (mxnet::RunContext ctx) {
+      std::vector<mxnet::TBlob> inputs = {from.data(), to->data()};
+      if (type == CompressionType::kTwoBit) {
         Dequantize2BitImpl(ctx.get_stream<mshadow::cpu>(), inputs, threshold);
-      }, from.ctx(), {from.var()}, {to->var()},
-      mxnet::FnProperty::kNormal, priority, "DequantizeCPU");
-    } else {
-#if MXNET_USE_CUDA
-      if (a == mshadow::gpu::kDevMask && b == mshadow::gpu::kDevMask) {
-        mxnet::Engine::Get()->PushSync([from, to, threshold](mxnet::RunContext ctx) {
-          std::vector<mxnet::TBlob> inputs = {from.data(), to->data()};
-          Dequantize2BitImpl(ctx.get_stream<mshadow::gpu>(), inputs, threshold);
-          // Wait GPU kernel to complete
-          ctx.get_stream<mshadow::gpu>()->Wait();
-        }, from.ctx(), {from.var()}, {to->var()},
-        mxnet::FnProperty::kNormal, priority, "DequantizeGPU");
       } else {
-        LOG(FATAL) << "unknown device mask";
+        DequantizeImpl(ctx.get_stream<mshadow::cpu>(), inputs, type, threshold, block_size);
       }
+    }, from.ctx(), {from.var()}, {to->var()},
+    mxnet::FnProperty::kNormal, priority, "DequantizeCPU");
+  } else {
+#if MXNET_USE_CUDA
+    if (a == mshadow::gpu::kDevMask && b == mshadow::gpu::kDevMask) {
+      mxnet::Engine::Get()->PushSync([from, to, type, threshold, block_size]
+                                     (mxnet::RunContext ctx) {
+        std::vector<mxnet::TBlob> inputs = {from.data(), to->data()};
+        if (type == CompressionType::kTwoBit) {
+          Dequantize2BitImpl(ctx.get_stream<mshadow::gpu>(), inputs, threshold);
+        } else {
+          DequantizeImpl(ctx.get_stream<mshadow::gpu>(), inputs, type, threshold, block_size);
+        }
+        // Wait GPU kernel to complete
+        ctx.get_stream<mshadow::gpu>()->Wait();
+      }, from.ctx(), {from.var()}, {to->var()},
+      mxnet::FnProperty::kNormal, priority, "DequantizeGPU");
+    } else {
+      LOG(FATAL) << "unknown device mask";
+    }
 #else
-      LOG(FATAL) << MXNET_GPU_NOT_ENABLED_ERROR;
+    LOG(FATAL) << MXNET_GPU_NOT_ENABLED_ERROR;
 #endif
-    }
-  } else {
-    LOG(FATAL) << "Unsupported dequantization of type " << get_type_str();
   }
 }
 
+void GradientCompression::FinalizeMerge(mxnet::NDArray *merged, const int priority) {
+  if (type_ != CompressionType::kOneBit) return;
+  CHECK_EQ(merged->ctx().dev_mask(), mshadow::cpu::kDevMask)
+    << "majority vote is only done on the cpu of the servers";
+  const float threshold = threshold_;
+  mxnet::Engine::Get()->PushSync([merged, threshold](mxnet::RunContext ctx) {
+    mxnet::TBlob data = merged->data();
+    mxnet::op::mxnet_op::Kernel<majority_vote, mshadow::cpu>::Launch(
+      ctx.get_stream<mshadow::cpu>(), data.Size(), data.dptr<float>(), threshold);
+  }, merged->ctx(), {}, {merged->var()},
+  mxnet::FnProperty::kNormal, priority, "MajorityVoteCPU");
+}
+
 }  // namespace kvstore
 }  // namespace mxnet
 
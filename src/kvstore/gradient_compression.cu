@@ -36,5 +36,15 @@ void Dequantize2BitImpl(mshadow::Stream<gpu>* s, const std::vector<TBlob>& input
                         const float threshold) {
   Dequantize2BitKernelLaunch(s, inputs, threshold);
 }
+
+void QuantizeImpl(mshadow::Stream<gpu>* s, const std::vector<TBlob>& inputs,
+                  const CompressionType type, const float threshold, const int block_size) {
+  QuantizeKernelLaunch(s, inputs, type, threshold, block_size);
+}
+
+void DequantizeImpl(mshadow::Stream<gpu>* s, const std::vector<TBlob>& inputs,
+                    const CompressionType type, const float threshold, const int block_size) {
+  DequantizeKernelLaunch(s, inputs, type, threshold, block_size);
+}
 }  // namespace kvstore
 }  // namespace mxnet
@@ -35,17 +35,22 @@ namespace mxnet {
 namespace kvstore {
 
 enum class CompressionType {
-  kNone, kTwoBit
+  kNone, kTwoBit, kOneBit, kTopK, kFP16, kBF16
 };
 
 struct GradientCompressionParam : public dmlc::Parameter<GradientCompressionParam> {
   std::string type;
   float threshold;
+  float ratio;
   DMLC_DECLARE_PARAMETER(GradientCompressionParam) {
     DMLC_DECLARE_FIELD(type)
-      .describe("Type of gradient compression to use, like `2bit` for example");
+      .describe("Type of gradient compression to use, one of "
+                "`2bit`, `1bit`, `topk`, `fp16` and `bf16`");
     DMLC_DECLARE_FIELD(threshold).set_default(0.5)
-      .describe("Threshold to use for 2bit gradient compression");
+      .describe("Threshold to use for 2bit gradient compression, "
+                "magnitude of the values sent by 1bit compression");
+    DMLC_DECLARE_FIELD(ratio).set_default(0.01)
+      .describe("Fraction of the gradient values sent by topk compression");
   }
 };
 
@@ -78,6 +83,25 @@ class GradientCompression {
    */
   void SetTwoBitCompression(const float threshold);
 
+  /*!
+   * \brief sets one bit (sign) gradient compression
+   * \param threshold magnitude the signs are scaled with on dequantization
+   */
+  void SetOneBitCompression(const float threshold);
+
+  /*!
+   * \brief sets top-k sparsification
+   * \param ratio fraction of values to send, the largest one out of
+   * every round(1 / ratio) consecutive values is sent
+   */
+  void SetTopKCompression(const float ratio);
+
+  /*!
+   * \brief sets compression by casting to a 16 bit float type
+   * \param type either CompressionType::kFP16 or CompressionType::kBF16
+   */
+  void SetCastCompression(const CompressionType type);
+
   /*!
    * \brief encodes parameters of gc into a string
    */
@@ -120,6 +144,15 @@ class GradientCompression {
   */
   void Dequantize(const mxnet::NDArray &from, mxnet::NDArray *to, const int priority);
 
+  /*!
+  * \brief Issues the operation a server applies to the sum of the dequantized
+  * gradients of all workers before updating. This is the majority vote of
+  * 1bit compression and a no-op for all other types.
+  * \param merged the merged gradient, modified in place
+  * \param priority Priority of the action.
+  */
+  void FinalizeMerge(mxnet::NDArray *merged, const int priority);
+
  private:
   /*!
    * \brief denotes the type of gradient compression which has been set
@@ -132,6 +165,11 @@ class GradientCompression {
    * all negative gradients will be thresholded to -1*`threshold_`
    */
   float threshold_ = 0;
+
+  /*!
+   * \brief number of consecutive values one of which is sent by topk compression
+   */
+  int block_size_ = 0;
 };
 }  // namespace kvstore
 }  // namespace mxnet
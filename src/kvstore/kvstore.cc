@@ -29,6 +29,7 @@
 
 #if MXNET_USE_DIST_KVSTORE
 #include "./kvstore_dist.h"
+#include "./kvstore_dist_ring.h"
 std::atomic<int> mxnet::kvstore::KVStoreDist::customer_id_{0};
 #endif  // MXNET_USE_DIST_KVSTORE
 #if MXNET_USE_NCCL
@@ -54,10 +55,21 @@ KVStore* KVStore::Create(const char *type_name) {
 
   if (has("dist")) {
 #if MXNET_USE_DIST_KVSTORE
-    kv = new kvstore::KVStoreDist(use_device_comm);
-    if (!has("_async") && kv->IsWorkerNode() && kv->get_rank() == 0) {
-      // configure the server to be the sync mode
-      kv->SendCommandToServers(static_cast<int>(kvstore::CommandType::kSyncMode), "");
+    if (has("_ring")) {
+      // allreduce among the workers, the servers are idle
+      kv = new kvstore::KVStoreDistRing(use_device_comm);
+    } else {
+      kv = new kvstore::KVStoreDist(use_device_comm);
+      if (kv->IsWorkerNode() && kv->get_rank() == 0) {
+        if (!has("_async")) {
+          // configure the server to be the sync mode
+          kv->SendCommandToServers(static_cast<int>(kvstore::CommandType::kSyncMode), "");
+        } else if (dmlc::GetEnv("MXNET_KVSTORE_STALENESS", -1) >= 0) {
+          // bound the number of steps a worker can be ahead of the others
+          kv->SendCommandToServers(static_cast<int>(kvstore::CommandType::kSetStaleness),
+                                   std::to_string(dmlc::GetEnv("MXNET_KVSTORE_STALENESS", -1)));
+        }
+      }
     }
 #else
     LOG(FATAL) << "compile with USE_DIST_KVSTORE=1 to use " << tname;
@@ -28,6 +28,12 @@
 #include <vector>
 #include <algorithm>
 #include <utility>
+#include <map>
+#include <unordered_map>
+#include <atomic>
+#include <memory>
+#include <cstring>
+#include "./comm_scheduler.h"
 #include "./kvstore_local.h"
 #include "mxnet/engine.h"
 #include "ps/ps.h"
@@ -44,10 +50,30 @@ namespace kvstore {
 class KVStoreDist : public KVStoreLocal {
  public:
   explicit KVStoreDist(bool use_device_comm)
-      : KVStoreLocal(use_device_comm), ps_worker_(nullptr), server_(nullptr) {
+      : KVStoreLocal(use_device_comm), ps_worker_(nullptr), server_(nullptr),
+        profile_domain_("KVStoreDist"),
+        push_msgs_("KVStoreDist Push Messages", &profile_domain_),
+        push_bytes_("KVStoreDist Push Bytes", &profile_domain_),
+        pull_msgs_("KVStoreDist Pull Messages", &profile_domain_),
+        pull_bytes_("KVStoreDist Pull Bytes", &profile_domain_),
+        row_cache_hits_("KVStoreDist Row Cache Hits", &profile_domain_),
+        row_cache_misses_("KVStoreDist Row Cache Misses", &profile_domain_),
+        scheduler_(dmlc::GetEnv("MXNET_KVSTORE_SCHEDULER_CREDIT", 16 << 20)) {
     if (IsWorkerNode()) {
       int new_customer_id = GetNewCustomerId();
       ps_worker_ = new ps::KVWorker<char>(0, new_customer_id);
+      static_cast<ps::SimpleApp*>(ps_worker_)->set_response_handle(
+          [this](const ps::SimpleData& recved, ps::SimpleApp* app) {
+            if (recved.head == static_cast<int>(CommandType::kSetWorkerActive) ||
+                recved.head == static_cast<int>(CommandType::kGetActiveWorkers)) {
+              // every server responds with the same workers
+              std::vector<std::string> ranks;
+              split(recved.body, ',', std::back_inserter(ranks));
+              std::lock_guard<std::mutex> lk(active_mu_);
+              active_workers_.clear();
+              for (const auto& rank : ranks) active_workers_.push_back(std::stoi(rank));
+            }
+          });
       ps::StartAsync(new_customer_id, "mxnet\0");
       if (!ps::Postoffice::Get()->is_recovery()) {
         ps::Postoffice::Get()->Barrier(
@@ -56,7 +82,10 @@ class KVStoreDist : public KVStoreLocal {
       }
     }
     bigarray_bound_ = dmlc::GetEnv("MXNET_KVSTORE_BIGARRAY_BOUND", 1000 * 1000);
+    fusion_bytes_ = dmlc::GetEnv("MXNET_KVSTORE_FUSION_BYTES", 1 << 20);
+    slice_bytes_ = dmlc::GetEnv("MXNET_KVSTORE_SLICE_BYTES", 4 << 20);
     log_verbose_ = dmlc::GetEnv("MXNET_KVSTORE_DIST_ROW_SPARSE_VERBOSE", false);
+    row_cache_ = dmlc::GetEnv("MXNET_KVSTORE_ROW_CACHE", false);
   }
 
   virtual ~KVStoreDist() {
@@ -109,6 +138,12 @@ class KVStoreDist : public KVStoreLocal {
   void SendCommandToServers(int cmd_id,
                             const std::string& cmd_body) override {
     CHECK_NOTNULL(ps_worker_);
+    if (ps::Postoffice::Get()->is_recovery() &&
+        (cmd_id == static_cast<int>(CommandType::kController) ||
+         cmd_id == static_cast<int>(CommandType::kSetMultiPrecision))) {
+      // a worker rejoining the job keeps the optimizer and its states on the servers
+      return;
+    }
     ps_worker_->Wait(ps_worker_->Request(cmd_id, cmd_body, ps::kServerGroup));
   }
 
@@ -116,6 +151,18 @@ class KVStoreDist : public KVStoreLocal {
 
   int get_rank() const override { return ps::MyRank(); }
 
+  void SetActive(bool active) override {
+    // the pushes and pulls issued before belong to the steps before the change
+    Engine::Get()->WaitForAll();
+    SendCommandToServers(static_cast<int>(CommandType::kSetWorkerActive), active ? "1" : "0");
+  }
+
+  std::vector<int> GetActiveWorkers() override {
+    SendCommandToServers(static_cast<int>(CommandType::kGetActiveWorkers), "");
+    std::lock_guard<std::mutex> lk(active_mu_);
+    return active_workers_;
+  }
+
   int get_num_dead_node(int node_id, int timeout) const override {
     int number = 0;
     auto dead_nodes = ps::Postoffice::Get()->GetDeadNodes(timeout);
@@ -169,6 +216,21 @@ class KVStoreDist : public KVStoreLocal {
     PSKV pull;
   };
 
+  /**
+   * \brief small dense keys of one push or pull call which are stored on the
+   * same server, sent as a single message
+   */
+  struct FusedBucket {
+    std::vector<int> keys;
+    std::vector<NDArray> bufs;
+    size_t num_bytes = 0;
+  };
+
+  /**
+   * \brief buckets by server and dtype
+   */
+  typedef std::map<std::pair<int, int>, FusedBucket> FusedBuckets;
+
   /**
    * \brief cache all key partitions
    *
@@ -193,7 +255,9 @@ class KVStoreDist : public KVStoreLocal {
     for (size_t i = 0; i < keys.size(); ++i) {
       comm_->Init(keys[i], values[i].storage_type(), values[i].shape(), values[i].dtype());
     }
-    if (get_rank() == 0 && this->ps_worker_->get_customer()->customer_id() == 0) {
+    if (get_rank() == 0 && this->ps_worker_->get_customer()->customer_id() == 0 &&
+        !ps::Postoffice::Get()->is_recovery()) {
+      // a worker rejoining the job pulls the current values instead
       Push_(keys, values, 0, false);
       // wait until the push is finished
       for (const int key : keys) {
@@ -222,6 +286,7 @@ class KVStoreDist : public KVStoreLocal {
     std::vector<std::vector<NDArray*> > grouped_vals;
     GroupKVPairsPull(keys, values, &uniq_keys, &grouped_vals, true);
 
+    FusedBuckets buckets;
     for (size_t i = 0; i < uniq_keys.size(); ++i) {
       int key = uniq_keys[i];
       // use the same array for merging to guarantee that pull always happens
@@ -235,37 +300,106 @@ class KVStoreDist : public KVStoreLocal {
         recv_buf = NDArray(grouped_vals[i][0]->shape(), pinned_ctx_,
                            true, grouped_vals[i][0]->dtype());
       }
-      auto pull_from_servers = [this, key, recv_buf](
+      if (IsFusible(recv_buf)) {
+        AddToBucket(key, recv_buf, &buckets,
+                    [this, priority](FusedBucket* bucket) { PullFused(bucket, priority); });
+      } else {
+        PullDefault(key, recv_buf, priority);
+      }
+    }
+    for (auto& bucket : buckets) {
+      PullFused(&bucket.second, priority);
+    }
+    // broadcast after all pulls are issued, so that they see the pulled values
+    for (size_t i = 0; i < uniq_keys.size(); ++i) {
+      comm_->Broadcast(uniq_keys[i], comm_buf_[uniq_keys[i]], grouped_vals[i], priority);
+    }
+  }
+
+  void PullDefault(int key, const NDArray& recv_buf, int priority) {
+    auto pull_from_servers = [this, key, recv_buf, priority](
+        RunContext rctx, Engine::CallbackOnComplete cb) {
+      // convert to ps keys
+      size_t size = recv_buf.shape().Size();
+      const int dtype = recv_buf.dtype();
+      const int num_bytes = mshadow::mshadow_sizeof(dtype);
+      PSKV& pskv = (gradient_compression_->get_type() == CompressionType::kNone) ?
+                    EncodeDefaultKey(key, size, num_bytes) :
+                    EncodeCompressedKey(key, size, false, num_bytes);
+      char* data = static_cast<char*> (recv_buf.data().dptr_);
+      if (gradient_compression_->get_type() == CompressionType::kNone) {
+        PushPullSliced(key, pskv, data, dtype, priority, false, true, cb);
+        return;
+      }
+      // false means not to delete data when SArray is deleted
+      auto vals = new ps::SArray<char>(data, size * num_bytes, false);
+      // issue pull
+      const int cmd = GetCommandType(RequestType::kCompressedPushPull, dtype);
+      CountMessages(&pull_msgs_, &pull_bytes_, pskv.keys.size(), size * num_bytes);
+      CHECK_NOTNULL(ps_worker_)->ZPull(
+        pskv.keys, vals, &pskv.lens, cmd, [vals, cb](){ delete vals; cb(); });
+    };
+
+    CHECK_NOTNULL(Engine::Get())->PushAsync(
+        pull_from_servers,
+        pinned_ctx_,
+        {},
+        {recv_buf.var()},
+        FnProperty::kNormal,
+        priority,
+        "KVStoreDistDefaultStoragePull");
+  }
+
+  /**
+   * \brief pull all keys of a bucket with one message and empty the bucket
+   */
+  void PullFused(FusedBucket* bucket, int priority) {
+    if (bucket->keys.size() == 1) {
+      PullDefault(bucket->keys[0], bucket->bufs[0], priority);
+    } else if (bucket->keys.size() > 1) {
+      PSKV pskv = EncodeFusedKey(bucket);
+      const int dtype = bucket->bufs[0].dtype();
+      NDArray& fused = fused_pull_buf_[bucket->keys[0]];
+      if (fused.is_none() || fused.shape().Size() * mshadow::mshadow_sizeof(dtype) !=
+                             static_cast<size_t>(pskv.size)) {
+        fused = NDArray(TShape{static_cast<int64_t>(pskv.size / mshadow::mshadow_sizeof(dtype))},
+                        pinned_ctx_, false, dtype);
+      }
+      const std::vector<NDArray> bufs = bucket->bufs;
+      auto pull_from_servers = [this, pskv, bufs, fused](
           RunContext rctx, Engine::CallbackOnComplete cb) {
-        // convert to ps keys
-        size_t size = recv_buf.shape().Size();
-        const int dtype = recv_buf.dtype();
-        const int num_bytes = mshadow::mshadow_sizeof(dtype);
-        PSKV& pskv = (gradient_compression_->get_type() == CompressionType::kNone) ?
-                      EncodeDefaultKey(key, size, num_bytes) :
-                      EncodeCompressedKey(key, size, false, num_bytes);
-        char* data = static_cast<char*> (recv_buf.data().dptr_);
-        // false means not to delete data when SArray is deleted
-        auto vals = new ps::SArray<char>(data, size * num_bytes, false);
-        // issue pull
-        RequestType mode = (gradient_compression_->get_type() != CompressionType::kNone) ?
-                  RequestType::kCompressedPushPull : RequestType::kDefaultPushPull;
-        const int cmd = GetCommandType(mode, dtype);
+        char* data = static_cast<char*>(fused.data().dptr_);
+        auto vals = new ps::SArray<char>(data, pskv.size, false);
+        auto lens = new ps::SArray<int>(pskv.lens);
+        const int cmd = GetCommandType(RequestType::kFusedPushPull, fused.dtype());
+        CountMessages(&pull_msgs_, &pull_bytes_, 1, pskv.size);
+        // allocate the outputs here instead of in the callback of ps-lite
+        std::vector<char*> outs;
+        for (const NDArray& buf : bufs) outs.push_back(static_cast<char*>(buf.data().dptr_));
         CHECK_NOTNULL(ps_worker_)->ZPull(
-          pskv.keys, vals, &pskv.lens, cmd, [vals, cb](){ delete vals; cb(); });
+          pskv.keys, vals, lens, cmd, [vals, lens, outs, data, cb]() {
+            size_t offset = 0;
+            for (size_t i = 0; i < outs.size(); ++i) {
+              std::memcpy(outs[i], data + offset, (*lens)[i]);
+              offset += (*lens)[i];
+            }
+            delete vals;
+            delete lens;
+            cb();
+          });
       };
-
+      std::vector<Engine::VarHandle> mutable_vars = {fused.var()};
+      for (const NDArray& buf : bufs) mutable_vars.push_back(buf.var());
       CHECK_NOTNULL(Engine::Get())->PushAsync(
           pull_from_servers,
           pinned_ctx_,
           {},
-          {recv_buf.var()},
+          mutable_vars,
           FnProperty::kNormal,
           priority,
-          "KVStoreDistDefaultStoragePull");
-
-      comm_->Broadcast(key, recv_buf, grouped_vals[i], priority);
+          "KVStoreDistFusedPull");
     }
+    *bucket = FusedBucket();
   }
 
   void PullRowSparseImpl(const std::vector<int>& keys,
@@ -317,6 +451,7 @@ class KVStoreDist : public KVStoreLocal {
     std::vector<std::vector<NDArray> > grouped_vals;
     GroupKVPairsPush(keys, values, &uniq_keys, &grouped_vals, false);
 
+    FusedBuckets buckets;
     for (size_t i = 0; i < uniq_keys.size(); ++i) {
       // merge over devices
       int key = uniq_keys[i];
@@ -343,11 +478,15 @@ class KVStoreDist : public KVStoreLocal {
       }
       const int dtype = merged.dtype();
       const int num_bytes = mshadow::mshadow_sizeof(dtype);
-      // push to servers
-      if (storage_type == kDefaultStorage) {
+      // push to servers, initialization is never fused
+      if (do_merge && IsFusible(comm_buf)) {
+        AddToBucket(key, comm_buf, &buckets,
+                    [this, priority](FusedBucket* bucket) { PushFused(bucket, priority); });
+      } else if (storage_type == kDefaultStorage) {
         if (gradient_compression_->get_type() == CompressionType::kNone) {
           PSKV& pskv = EncodeDefaultKey(key, comm_buf.shape().Size(), num_bytes);
-          PushDefault(key, comm_buf, pskv, priority);
+          // the servers initialize a key from a single message
+          PushDefault(key, comm_buf, pskv, priority, do_merge);
         } else {
           CHECK_EQ(dtype, mshadow::kFloat32) << "Gradient compression is only supported for "
                                              << "float32 type of parameters";
@@ -362,7 +501,7 @@ class KVStoreDist : public KVStoreLocal {
           if (is_active) {
             PushCompressed(key, comm_buf, pskv, priority);
           } else {
-            PushDefault(key, comm_buf, pskv, priority);
+            PushDefault(key, comm_buf, pskv, priority, false);
           }
         }
       } else if (storage_type == kRowSparseStorage) {
@@ -373,6 +512,97 @@ class KVStoreDist : public KVStoreLocal {
         LOG(FATAL) << "unknown storage type";
       }
     }
+    for (auto& bucket : buckets) {
+      PushFused(&bucket.second, priority);
+    }
+  }
+
+  /**
+   * \brief push all keys of a bucket with one message and empty the bucket
+   */
+  void PushFused(FusedBucket* bucket, int priority) {
+    if (bucket->keys.size() == 1) {
+      const NDArray& buf = bucket->bufs[0];
+      const int num_bytes = mshadow::mshadow_sizeof(buf.dtype());
+      PushDefault(bucket->keys[0], buf,
+                  EncodeDefaultKey(bucket->keys[0], buf.shape().Size(), num_bytes), priority,
+                  true);
+    } else if (bucket->keys.size() > 1) {
+      PSKV pskv = EncodeFusedKey(bucket);
+      const int dtype = bucket->bufs[0].dtype();
+      NDArray& fused = fused_push_buf_[bucket->keys[0]];
+      if (fused.is_none() || fused.shape().Size() * mshadow::mshadow_sizeof(dtype) !=
+                             static_cast<size_t>(pskv.size)) {
+        fused = NDArray(TShape{static_cast<int64_t>(pskv.size / mshadow::mshadow_sizeof(dtype))},
+                        pinned_ctx_, false, dtype);
+      }
+      const std::vector<NDArray> bufs = bucket->bufs;
+      auto push_to_servers = [this, pskv, bufs, fused, priority](
+          RunContext rctx, Engine::CallbackOnComplete cb) {
+        char* data = static_cast<char*>(fused.data().dptr_);
+        for (size_t i = 0, offset = 0; i < bufs.size(); offset += pskv.lens[i++]) {
+          std::memcpy(data + offset, bufs[i].data().dptr_, pskv.lens[i]);
+        }
+        const int cmd = GetCommandType(RequestType::kFusedPushPull, fused.dtype());
+        CountMessages(&push_msgs_, &push_bytes_, 1, pskv.size);
+        scheduler_.Send(priority, pskv.size,
+            [this, pskv, data, cmd, cb](const CommScheduler::Callback& on_response) {
+              // do push. false means no delete
+              ps::SArray<char> vals(data, pskv.size, false);
+              CHECK_NOTNULL(ps_worker_)->ZPush(pskv.keys, vals, pskv.lens, cmd,
+                                               [on_response, cb]() { on_response(); cb(); });
+            });
+      };
+      std::vector<Engine::VarHandle> const_vars;
+      for (const NDArray& buf : bufs) const_vars.push_back(buf.var());
+      Engine::Get()->PushAsync(
+          push_to_servers,
+          pinned_ctx_,
+          const_vars,
+          {fused.var()},
+          FnProperty::kNormal,
+          priority,
+          "KVStoreDistFusedPush");
+    }
+    *bucket = FusedBucket();
+  }
+
+  /**
+   * \brief report messages to the servers to the profiler, if it is running
+   */
+  inline void CountMessages(profiler::ProfileCounter* msgs, profiler::ProfileCounter* bytes,
+                            int64_t num_msgs, int64_t num_bytes) {
+    if (profiler::Profiler::Get()->GetState() == profiler::Profiler::kRunning) {
+      *msgs += num_msgs;
+      *bytes += num_bytes;
+    }
+  }
+
+  /**
+   * \brief whether a value is sent to a single server and small enough to be
+   * fused with other keys
+   */
+  inline bool IsFusible(const NDArray& buf) const {
+    return buf.storage_type() == kDefaultStorage &&
+           gradient_compression_->get_type() == CompressionType::kNone &&
+           buf.shape().Size() < bigarray_bound_ &&
+           buf.shape().Size() * mshadow::mshadow_sizeof(buf.dtype()) <= fusion_bytes_;
+  }
+
+  /**
+   * \brief add a key to the bucket of its server and dtype, after sending the
+   * bucket with flush if the key does not fit anymore
+   */
+  void AddToBucket(int key, const NDArray& buf, FusedBuckets* buckets,
+                   const std::function<void(FusedBucket*)>& flush) {
+    const int num_servers = ps::Postoffice::Get()->GetServerKeyRanges().size();
+    const int server = (key * 9973) % num_servers;
+    FusedBucket& bucket = (*buckets)[std::make_pair(server, buf.dtype())];
+    const size_t num_bytes = buf.shape().Size() * mshadow::mshadow_sizeof(buf.dtype());
+    if (bucket.num_bytes + num_bytes > fusion_bytes_) flush(&bucket);
+    bucket.keys.push_back(key);
+    bucket.bufs.push_back(buf);
+    bucket.num_bytes += num_bytes;
   }
 
   void PushCompressed(int key, const NDArray& comm_buf, const PSKV& pskv, int priority) {
@@ -395,6 +625,8 @@ class KVStoreDist : public KVStoreLocal {
         // do push. false means no delete
         ps::SArray<char> vals(data, size, false);
         int cmd = GetCommandType(RequestType::kCompressedPushPull, dtype);
+        // every server gets a meta key and a data key
+        CountMessages(&push_msgs_, &push_bytes_, pskv.keys.size() / 2, size);
         CHECK_NOTNULL(ps_worker_)->ZPush(pskv.keys, vals, pskv.lens, cmd, [cb]() { cb(); });
       };
     // acquire locks on both comm_buf and small_buf so that
@@ -409,19 +641,19 @@ class KVStoreDist : public KVStoreLocal {
       "KVStoreDistCompressedPush");
   }
 
-  void PushDefault(int key, const NDArray &send_buf, const PSKV& pskv, int priority) {
+  /**
+   * \brief push a dense value
+   * \param can_slice false if the value must be sent in one message per server,
+   * e.g. to initialize the key
+   */
+  void PushDefault(int key, const NDArray &send_buf, const PSKV& pskv, int priority,
+                   bool can_slice) {
     auto push_to_servers =
-        [this, key, pskv, send_buf](RunContext rctx, Engine::CallbackOnComplete cb) {
+        [this, key, pskv, send_buf, priority, can_slice](
+            RunContext rctx, Engine::CallbackOnComplete cb) {
           const int dtype = send_buf.dtype();
-          // convert to ps keys
-          const size_t size = send_buf.shape().Size() * mshadow::mshadow_sizeof(dtype);
           char* data = static_cast<char *>(send_buf.data().dptr_);
-          // do push. false means no delete
-          ps::SArray<char> vals(data, size, false);
-          int cmd = GetCommandType(RequestType::kDefaultPushPull, dtype);
-          CHECK_NOTNULL(ps_worker_)->ZPush(
-              pskv.keys, vals, pskv.lens,
-              cmd, [cb]() { cb(); });
+          PushPullSliced(key, pskv, data, dtype, priority, true, can_slice, cb);
         };
     Engine::Get()->PushAsync(
         push_to_servers,
@@ -433,6 +665,100 @@ class KVStoreDist : public KVStoreLocal {
         "KVStoreDistDefaultPush");
   }
 
+  /**
+   * \brief push or pull a dense value that is not compressed. The part of
+   * every server is sent in slices of at most slice_bytes_, pushes through the
+   * scheduler, so that other keys with a higher priority can overtake it.
+   * \param pskv the keys and lengths of the parts, see EncodeDefaultKey
+   * \param data the value
+   * \param push whether to push or to pull
+   * \param can_slice whether to slice the parts
+   * \param cb called once all messages are answered
+   */
+  void PushPullSliced(const int key, const PSKV& pskv, char* data, const int dtype,
+                      const int priority, const bool push, bool can_slice,
+                      const Engine::CallbackOnComplete& cb) {
+    const int num_bytes = mshadow::mshadow_sizeof(dtype);
+    // the servers only merge slices in sync mode
+    can_slice = can_slice && slice_bytes_ >= static_cast<size_t>(num_bytes) &&
+                type_.find("async") == std::string::npos;
+    const size_t slice_bytes = slice_bytes_ / num_bytes * num_bytes;
+    struct Message {
+      ps::SArray<ps::Key> keys;
+      ps::SArray<int> lens;
+      int cmd;
+      size_t offset;
+      size_t bytes;
+    };
+    std::vector<Message> msgs;
+    auto krs = ps::Postoffice::Get()->GetServerKeyRanges();
+    size_t offset = 0;
+    for (size_t i = 0; i < pskv.keys.size(); ++i) {
+      const size_t part_bytes = pskv.lens[i];
+      if (!can_slice || part_bytes <= slice_bytes) {
+        Message msg;
+        msg.keys.push_back(pskv.keys[i]);
+        msg.lens.push_back(part_bytes);
+        msg.cmd = GetCommandType(RequestType::kDefaultPushPull, dtype);
+        msg.offset = offset;
+        msg.bytes = part_bytes;
+        msgs.push_back(msg);
+      } else {
+        // a slice of n elements at element offset b is encoded as the keys
+        // begin + (key << 32) + b and begin + (key << 32) + b + n
+        const ps::Key begin = pskv.keys[i] - key;
+        const auto range = std::find_if(krs.begin(), krs.end(), [begin](const ps::Range& r) {
+          return r.begin() == begin;
+        });
+        CHECK(range != krs.end());
+        const ps::Key base = begin + (static_cast<ps::Key>(key) << 32);
+        CHECK_LT(base + part_bytes / num_bytes, range->end())
+          << "key " << key << " is too large to be sliced";
+        for (size_t b = 0; b < part_bytes; b += slice_bytes) {
+          const size_t n = std::min(slice_bytes, part_bytes - b);
+          Message msg;
+          msg.keys.push_back(base + b / num_bytes);
+          msg.keys.push_back(base + (b + n) / num_bytes);
+          msg.lens.push_back(n);
+          msg.lens.push_back(0);
+          msg.cmd = GetCommandType(RequestType::kSlicedPushPull, dtype);
+          msg.offset = offset + b;
+          msg.bytes = n;
+          msgs.push_back(msg);
+        }
+      }
+      offset += part_bytes;
+    }
+    auto remaining = std::make_shared<std::atomic<size_t>>(msgs.size());
+    auto done = [remaining, cb]() {
+      if (--(*remaining) == 0) cb();
+    };
+    for (const Message& msg : msgs) {
+      if (push) {
+        CountMessages(&push_msgs_, &push_bytes_, 1, msg.bytes);
+        scheduler_.Send(priority, msg.bytes,
+            [this, msg, data, done](const CommScheduler::Callback& on_response) {
+              // do push. false means no delete
+              ps::SArray<char> vals(data + msg.offset, msg.bytes, false);
+              CHECK_NOTNULL(ps_worker_)->ZPush(msg.keys, vals, msg.lens, msg.cmd,
+                                               [on_response, done]() { on_response(); done(); });
+            });
+      } else {
+        // pulls do not take credit, the servers answer them once the pushes
+        // of all workers are merged
+        CountMessages(&pull_msgs_, &pull_bytes_, 1, msg.bytes);
+        auto vals = new ps::SArray<char>(data + msg.offset, msg.bytes, false);
+        auto lens = new ps::SArray<int>(msg.lens);
+        CHECK_NOTNULL(ps_worker_)->ZPull(msg.keys, vals, lens, msg.cmd,
+                                         [vals, lens, done]() {
+                                           delete vals;
+                                           delete lens;
+                                           done();
+                                         });
+      }
+    }
+  }
+
   // push row sparse gradient
   void PushRowSparse(int key, const NDArray &send_buf, int priority) {
     using namespace rowsparse;
@@ -453,6 +779,9 @@ class KVStoreDist : public KVStoreLocal {
       }
       ps::SArray<char> vals(data, size * num_bytes, false);
       const int cmd = GetCommandType(RequestType::kRowSparsePushPull, send_buf.dtype());
+      // every server gets a master key of length 0
+      CountMessages(&push_msgs_, &push_bytes_,
+                    std::count(pskv.lens.begin(), pskv.lens.end(), 0), size * num_bytes);
       CHECK_NOTNULL(ps_worker_)->ZPush(pskv.keys, vals, pskv.lens, cmd, [cb]() { cb(); });
     };
     Engine::Get()->PushAsync(
@@ -466,11 +795,22 @@ class KVStoreDist : public KVStoreLocal {
   }
 
 
+  /**
+   * \brief the rows of a row_sparse key received from the servers
+   */
+  struct RowCache {
+    /*! \brief the rows, in the order they were first received */
+    std::vector<char> rows;
+    /*! \brief the offset of a row in rows, by row id */
+    std::unordered_map<int64_t, size_t> slots;
+  };
+
   // pull row sparse weight into `recv_buf` based on indices given by `indices`
   void PullRowSparse_(const int key, const NDArray& recv_buf,
                       const NDArray& indices, int priority) {
     using namespace rowsparse;
-    auto pull_from_servers = [this, key, recv_buf, indices]
+    RowCache* cache = row_cache_ ? &row_caches_[key] : nullptr;
+    auto pull_from_servers = [this, key, recv_buf, indices, cache]
       (RunContext rctx, Engine::CallbackOnComplete cb) {
       // allocate memory for the buffer
       CHECK_EQ(indices.dtype(), mshadow::kInt64);
@@ -491,13 +831,19 @@ class KVStoreDist : public KVStoreLocal {
         LOG(INFO) << "worker " << get_rank() << " pull lens: " << pskv.lens << " keys: "
                   << pskv.keys << " size: " << size;
       }
-      auto vals = new ps::SArray<char>(data, size * num_bytes, false);
-      const int cmd = GetCommandType(RequestType::kRowSparsePushPull, recv_buf.dtype());
       // copy indices to recv_buf. this needs to be done before ZPull
       // because after pull is done, the callback function returns and locks are released.
       // at this point, later functions may access the indices variable while copy happens
       mshadow::Copy(recv_buf.aux_data(kIdx).FlatTo1D<cpu, int64_t>(),
                     idx_data.FlatTo1D<cpu, int64_t>());
+      if (cache) {
+        PullCachedRows(key, pskv, dtype, offsets, unit_len * num_bytes, data, cache, cb);
+        return;
+      }
+      auto vals = new ps::SArray<char>(data, size * num_bytes, false);
+      const int cmd = GetCommandType(RequestType::kRowSparsePushPull, recv_buf.dtype());
+      CountMessages(&pull_msgs_, &pull_bytes_,
+                    std::count(pskv.lens.begin(), pskv.lens.end(), 0), size * num_bytes);
       CHECK_NOTNULL(ps_worker_)->ZPull(pskv.keys, vals, &pskv.lens,
                                        cmd,
                                        [vals, cb]() { delete vals; cb(); });
@@ -512,6 +858,62 @@ class KVStoreDist : public KVStoreLocal {
       "KVStoreDistRowSparsePull");
   }
 
+  /**
+   * \brief pulls the rows of pskv into data. the servers only send the rows
+   * which changed since this worker received them, the others are copied from
+   * the row cache of the key
+   * \param offsets the sorted ids of the rows in pskv
+   */
+  void PullCachedRows(const int key, const PSKV& pskv, const int dtype,
+                      const int64_t* offsets, const size_t row_bytes, char* data,
+                      RowCache* cache, Engine::CallbackOnComplete cb) {
+    // the keys with a zero length are the master keys of the servers
+    ps::SArray<int> req_lens;
+    req_lens.CopyFrom(pskv.lens);
+    auto vals = new ps::SArray<char>();
+    auto lens = new ps::SArray<int>();
+    const int cmd = GetCommandType(RequestType::kRowSparseCachedPull, dtype);
+    auto on_pulled = [this, key, req_lens, vals, lens, offsets, row_bytes, data, cache, cb]() {
+      CHECK_EQ(lens->size(), req_lens.size());
+      int64_t hits = 0;
+      int64_t misses = 0;
+      const char* src = vals->data();
+      char* dst = data;
+      for (size_t i = 0; i < req_lens.size(); ++i) {
+        if (req_lens[i] == 0) continue;
+        const int64_t row_id = offsets[hits + misses];
+        auto slot = cache->slots.find(row_id);
+        if ((*lens)[i] > 0) {
+          CHECK_EQ(static_cast<size_t>((*lens)[i]), row_bytes);
+          if (slot == cache->slots.end()) {
+            slot = cache->slots.emplace(row_id, cache->rows.size()).first;
+            cache->rows.resize(cache->rows.size() + row_bytes);
+          }
+          std::memcpy(&cache->rows[slot->second], src, row_bytes);
+          src += row_bytes;
+          ++misses;
+        } else {
+          CHECK(slot != cache->slots.end())
+            << "row " << row_id << " of key " << key << " is not in the row cache";
+          ++hits;
+        }
+        std::memcpy(dst, &cache->rows[slot->second], row_bytes);
+        dst += row_bytes;
+      }
+      CHECK_EQ(static_cast<size_t>(src - vals->data()), vals->size());
+      CountMessages(&pull_msgs_, &pull_bytes_,
+                    std::count(req_lens.begin(), req_lens.end(), 0), vals->size());
+      if (profiler::Profiler::Get()->GetState() == profiler::Profiler::kRunning) {
+        row_cache_hits_ += hits;
+        row_cache_misses_ += misses;
+      }
+      delete vals;
+      delete lens;
+      cb();
+    };
+    CHECK_NOTNULL(ps_worker_)->ZPull(pskv.keys, vals, lens, cmd, on_pulled);
+  }
+
   /**
    * \brief check if the keys are all unique
    */
@@ -671,6 +1073,43 @@ class KVStoreDist : public KVStoreLocal {
     return pskv;
   }
 
+  /**
+   * \brief convert the keys of a bucket to pskv, sorting the bucket by key as
+   * ps-lite expects
+   * \param bucket keys that are all stored on the same server
+   * \return PSKV used for both push and pull
+   */
+  inline PSKV EncodeFusedKey(FusedBucket* bucket) {
+    std::vector<size_t> order(bucket->keys.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::sort(order.begin(), order.end(),
+              [bucket](size_t a, size_t b) { return bucket->keys[a] < bucket->keys[b]; });
+    FusedBucket sorted;
+    for (const size_t i : order) {
+      sorted.keys.push_back(bucket->keys[i]);
+      sorted.bufs.push_back(bucket->bufs[i]);
+    }
+    sorted.num_bytes = bucket->num_bytes;
+    *bucket = sorted;
+
+    auto krs = ps::Postoffice::Get()->GetServerKeyRanges();
+    const int num_servers = krs.size();
+    CHECK_GT(num_servers, 0);
+    const int server = (bucket->keys[0] * 9973) % num_servers;
+    PSKV pskv;
+    pskv.size = 0;
+    for (size_t i = 0; i < bucket->keys.size(); ++i) {
+      ps::Key ps_key = krs[server].begin() + bucket->keys[i];
+      CHECK_LT(ps_key, krs[server].end());
+      pskv.keys.push_back(ps_key);
+      const NDArray& buf = bucket->bufs[i];
+      const int total_bytes = buf.shape().Size() * mshadow::mshadow_sizeof(buf.dtype());
+      pskv.lens.push_back(total_bytes);
+      pskv.size += total_bytes;
+    }
+    return pskv;
+  }
+
   // Note: this encoding method for row sparse keys doesn't allow cross-layer batching
   inline PSKV& EncodeRowSparseKey(const int key, const int64_t num_elem, const int64_t num_rows,
                                   const int64_t *offsets, const size_t unit_len,
@@ -744,6 +1183,14 @@ class KVStoreDist : public KVStoreLocal {
    * \brief threshold for partition
    */
   size_t bigarray_bound_;
+  /**
+   * \brief maximum size of a fused push or pull, 0 disables fusion
+   */
+  size_t fusion_bytes_;
+  /**
+   * \brief maximum size of a message of a large dense value, 0 disables slicing
+   */
+  size_t slice_bytes_;
   /**
    * \brief buffer for non-compressed data.
    * When gradient compression is active, this is used
@@ -761,7 +1208,42 @@ class KVStoreDist : public KVStoreLocal {
    * during gradient compression
    */
   std::unordered_map<int, NDArray> residual_;
+  /**
+   * \brief contiguous buffers of fused pushes and pulls, by their first key
+   */
+  std::unordered_map<int, NDArray> fused_push_buf_;
+  std::unordered_map<int, NDArray> fused_pull_buf_;
+  /**
+   * \brief the ranks of the active workers, as last reported by the servers
+   */
+  std::vector<int> active_workers_;
+  std::mutex active_mu_;
+  /**
+   * \brief whether to pull row_sparse values through the row caches
+   */
+  bool row_cache_;
+  /**
+   * \brief the row caches of the keys, created by the caller of PullRowSparse_
+   */
+  std::unordered_map<int, RowCache> row_caches_;
   bool log_verbose_;
+  /**
+   * \brief number of messages and bytes sent to or received from the servers
+   */
+  profiler::ProfileDomain profile_domain_;
+  profiler::ProfileCounter push_msgs_;
+  profiler::ProfileCounter push_bytes_;
+  profiler::ProfileCounter pull_msgs_;
+  profiler::ProfileCounter pull_bytes_;
+  /**
+   * \brief number of rows of row_sparse pulls found in or missing from the row caches
+   */
+  profiler::ProfileCounter row_cache_hits_;
+  profiler::ProfileCounter row_cache_misses_;
+  /**
+   * \brief orders the pushes by priority
+   */
+  CommScheduler scheduler_;
 };
 
 }  // namespace kvstore
@@ -0,0 +1,383 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * Copyright (c) 2019 by Contributors
+ * @file   kvstore_dist_ring.h
+ * @brief  distributed kvstore based on ring allreduce among the workers
+ */
+#ifndef MXNET_KVSTORE_KVSTORE_DIST_RING_H_
+#define MXNET_KVSTORE_KVSTORE_DIST_RING_H_
+#include <unistd.h>
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "./kvstore_local.h"
+#include "./ring_comm.h"
+#include "mxnet/engine.h"
+#include "ps/ps.h"
+#include "./kvstore_dist_server.h"
+namespace mxnet {
+namespace kvstore {
+
+/**
+ * \brief distributed kvstore without parameter servers
+ *
+ * Every worker keeps a full replica of the values. A push reduces over the
+ * local devices, then sums the result over all workers with a ring allreduce
+ * over TCP and applies the updater locally, so that no single node has to
+ * receive the gradients of all workers. ps-lite is only used to start up:
+ * it assigns the ranks, exchanges the ring addresses and implements Barrier.
+ *
+ * Small keys pushed in one call are fused into buckets of
+ * MXNET_KVSTORE_RING_FUSION_BYTES bytes that are allreduced as one message.
+ * With several workers on each host and the same number of workers on
+ * every host, the allreduce is hierarchical unless
+ * MXNET_KVSTORE_RING_HIERARCHICAL is set to 0, see HierarchicalRingComm.
+ *
+ * All workers must issue the same pushes in the same order. The allreduces
+ * run on a dedicated thread in the order they were issued.
+ */
+class KVStoreDistRing : public KVStoreLocal {
+ public:
+  explicit KVStoreDistRing(bool use_device_comm)
+      : KVStoreLocal(use_device_comm) {
+    CHECK(IsWorkerNode()) << "dist_ring kvstore is only created on workers";
+    fusion_bytes_ = dmlc::GetEnv("MXNET_KVSTORE_RING_FUSION_BYTES", 1 << 20);
+    ps_worker_ = new ps::KVWorker<char>(0, 0);
+    static_cast<ps::SimpleApp*>(ps_worker_)->set_request_handle(
+        [this](const ps::SimpleData& recved, ps::SimpleApp* app) {
+          if (recved.head == kRingAddress) {
+            std::lock_guard<std::mutex> lock(addr_mu_);
+            addrs_[ps::Postoffice::IDtoRank(recved.sender)] = recved.body;
+            addr_cond_.notify_all();
+          }
+          app->Response(recved);
+        });
+    ps::StartAsync(0, "mxnet\0");
+    if (!ps::Postoffice::Get()->is_recovery()) {
+      ps::Postoffice::Get()->Barrier(
+        0, ps::kWorkerGroup + ps::kServerGroup + ps::kScheduler);
+    }
+    ConnectRings();
+    comm_thread_ = std::thread([this]() { CommLoop(); });
+  }
+
+  virtual ~KVStoreDistRing() {
+    Engine::Get()->WaitForAll();
+    {
+      std::lock_guard<std::mutex> lock(task_mu_);
+      stop_ = true;
+    }
+    task_cond_.notify_all();
+    comm_thread_.join();
+    if (barrier_before_exit_) {
+      Barrier();
+      if (get_rank() == 0) {
+        // stop the executor at the servers started by the launcher, if any
+        SendCommandToServers(static_cast<int>(CommandType::kStopServer), "");
+      }
+    }
+    ps::Finalize(0, barrier_before_exit_);
+    delete ps_worker_;
+  }
+
+  void SetGradientCompression(const std::vector<std::pair<std::string, std::string> >
+                              & kwargs) override {
+    LOG(FATAL) << "Gradient compression is not supported by the dist_ring kvstore";
+  }
+
+  void Barrier() override {
+    ps::Postoffice::Get()->Barrier(0, ps::kWorkerGroup);
+  }
+
+  void SendCommandToServers(int cmd_id,
+                            const std::string& cmd_body) override {
+    ps_worker_->Wait(ps_worker_->Request(cmd_id, cmd_body, ps::kServerGroup));
+  }
+
+  int get_group_size() const override { return ps::NumWorkers(); }
+
+  int get_rank() const override { return ps::MyRank(); }
+
+ private:
+  /** \brief head of the requests carrying the ring addresses */
+  static const int kRingAddress = 100;
+
+  /** \brief an allreduce waiting for its turn on the communication thread */
+  struct Task {
+    std::vector<NDArray> bufs;
+    Engine::CallbackOnComplete on_complete;
+  };
+
+  /**
+   * \brief listen for the flat, the local and the cross ring, exchange the
+   * addresses with all workers and connect the rings this worker is part of
+   */
+  void ConnectRings() {
+    const int rank = get_rank();
+    const int size = get_group_size();
+    // the address the other workers reach this one at, which also decides
+    // which workers share a host
+    std::string host = dmlc::GetEnv("MXNET_KVSTORE_RING_HOST",
+                                    dmlc::GetEnv("DMLC_NODE_HOST", std::string()));
+    if (host.empty()) {
+      char name[256] = {0};
+      CHECK_EQ(gethostname(name, sizeof(name) - 1), 0);
+      host = name;
+    }
+    std::ostringstream addr;
+    addr << host << " " << ring_.Listen() << " " << local_ring_.Listen()
+         << " " << cross_ring_.Listen();
+    {
+      std::lock_guard<std::mutex> lock(addr_mu_);
+      addrs_[rank] = addr.str();
+    }
+    for (int r = 0; r < size; ++r) {
+      if (r == rank) continue;
+      const int recver = ps::Postoffice::WorkerRankToID(r);
+      ps_worker_->Wait(ps_worker_->Request(kRingAddress, addr.str(), recver));
+    }
+    std::vector<std::string> hosts(size);
+    std::vector<std::vector<int> > ports(size, std::vector<int>(3));
+    {
+      std::unique_lock<std::mutex> lock(addr_mu_);
+      addr_cond_.wait(lock, [this, size]() { return addrs_.size() == (size_t) size; });
+      for (int r = 0; r < size; ++r) {
+        std::istringstream is(addrs_[r]);
+        is >> hosts[r] >> ports[r][0] >> ports[r][1] >> ports[r][2];
+      }
+    }
+    // group the workers by host, ordered by their lowest rank
+    std::vector<std::string> host_order;
+    std::map<std::string, std::vector<int> > by_host;
+    for (int r = 0; r < size; ++r) {
+      if (by_host.find(hosts[r]) == by_host.end()) host_order.push_back(hosts[r]);
+      by_host[hosts[r]].push_back(r);
+    }
+    const size_t per_host = by_host[host_order[0]].size();
+    bool uniform = true;
+    for (const auto& h : by_host) uniform = uniform && h.second.size() == per_host;
+    hierarchical_ = dmlc::GetEnv("MXNET_KVSTORE_RING_HIERARCHICAL", true) && uniform &&
+                    per_host > 1 && host_order.size() > 1;
+    if (hierarchical_) {
+      const std::vector<int>& mine = by_host[hosts[rank]];
+      const int local_rank = std::find(mine.begin(), mine.end(), rank) - mine.begin();
+      const int host_rank = std::find(host_order.begin(), host_order.end(), hosts[rank]) -
+                            host_order.begin();
+      const int local_next = mine[(local_rank + 1) % mine.size()];
+      const int cross_next =
+        by_host[host_order[(host_rank + 1) % host_order.size()]][local_rank];
+      local_ring_.Connect(local_rank, mine.size(), hosts[local_next], ports[local_next][1]);
+      cross_ring_.Connect(host_rank, host_order.size(), hosts[cross_next],
+                          ports[cross_next][2]);
+      hier_ring_.reset(new HierarchicalRingComm(&local_ring_, &cross_ring_));
+    } else {
+      const int next = (rank + 1) % size;
+      ring_.Connect(rank, size, hosts[next], ports[next][0]);
+    }
+    LOG(INFO) << "worker " << rank << " joined the " << (hierarchical_ ? "hierarchical " : "")
+              << "ring of " << size << " workers on " << host_order.size() << " hosts";
+  }
+
+  void InitImpl(const std::vector<int>& keys,
+                const std::vector<NDArray>& values) override {
+    CheckUnique(keys);
+    for (size_t i = 0; i < keys.size(); ++i) {
+      CHECK(local_.find(keys[i]) == local_.end())
+          << "duplicate init of key " << keys[i];
+      CHECK_EQ(values[i].storage_type(), kDefaultStorage)
+          << "dist_ring kvstore only supports dense values";
+      local_[keys[i]] = values[i].Copy(pinned_ctx_);
+      comm_->Init(keys[i], values[i].storage_type(), values[i].shape(), values[i].dtype());
+      // start from the values of worker 0 everywhere
+      if (get_rank() != 0) local_[keys[i]] = 0;
+      AllReduceAsync({local_[keys[i]]}, 0);
+    }
+  }
+
+  void PushImpl(const std::vector<int>& keys,
+                const std::vector<NDArray>& values,
+                int priority) override {
+    std::vector<int> uniq_keys;
+    std::vector<std::vector<NDArray> > grouped_vals;
+    GroupKVPairsPush(keys, values, &uniq_keys, &grouped_vals, false);
+    std::vector<NDArray> bucket;
+    size_t bucket_bytes = 0;
+    for (size_t i = 0; i < uniq_keys.size(); ++i) {
+      const int key = uniq_keys[i];
+      const NDArray& merged = comm_->Reduce(key, grouped_vals[i], priority);
+      CHECK_EQ(merged.storage_type(), kDefaultStorage)
+          << "dist_ring kvstore only supports dense values";
+      // the allreduce is in place, so never run it on the pushed arrays
+      NDArray& buf = comm_buf_[key];
+      if (buf.is_none()) {
+        buf = NDArray(merged.shape(), pinned_ctx_, false, merged.dtype());
+      }
+      CopyFromTo(merged, &buf, priority);
+      const size_t bytes = buf.shape().Size() * mshadow::mshadow_sizeof(buf.dtype());
+      if (!bucket.empty() &&
+          (bucket_bytes + bytes > fusion_bytes_ || bucket[0].dtype() != buf.dtype())) {
+        AllReduceAsync(bucket, priority);
+        bucket.clear();
+        bucket_bytes = 0;
+      }
+      bucket.push_back(buf);
+      bucket_bytes += bytes;
+    }
+    if (!bucket.empty()) AllReduceAsync(bucket, priority);
+    for (const int key : uniq_keys) {
+      Update(key, comm_buf_[key]);
+    }
+  }
+
+  /** \brief apply the summed gradient to the local replica, like KVStoreLocal */
+  void Update(const int key, const NDArray& merged) {
+    NDArray& local = local_[key];
+    CHECK(!local.is_none()) << "key " << key << " has not been inited";
+    if (updater_ != nullptr) {
+      if (key_type_ == kStringKey && str_updater_ != nullptr) {
+        str_updater_(reverse_str_key_dict_[key], merged, &local);
+      } else {
+        updater_(key, merged, &local);
+      }
+    } else {
+      CopyFromTo(merged, &local);
+    }
+  }
+
+  /**
+   * \brief sum bufs over all workers in place. They are fused into one message
+   * and allreduced on the communication thread once they are ready.
+   */
+  void AllReduceAsync(const std::vector<NDArray>& bufs, int priority) {
+    std::vector<Engine::VarHandle> vars;
+    for (const NDArray& buf : bufs) vars.push_back(buf.var());
+    const uint64_t seq = next_issue_++;
+    Engine::Get()->PushAsync(
+      [this, bufs, seq](RunContext rctx, Engine::CallbackOnComplete on_complete) {
+        {
+          std::lock_guard<std::mutex> lock(task_mu_);
+          tasks_[seq] = Task{bufs, on_complete};
+        }
+        task_cond_.notify_all();
+      },
+      pinned_ctx_,
+      {},
+      vars,
+      FnProperty::kNormal,
+      priority,
+      "KVStoreDistRingAllReduce");
+  }
+
+  /** \brief runs the allreduces strictly in issue order, which is the same on all workers */
+  void CommLoop() {
+    std::unique_lock<std::mutex> lock(task_mu_);
+    while (true) {
+      task_cond_.wait(lock, [this]() { return stop_ || tasks_.count(next_run_) != 0; });
+      if (tasks_.count(next_run_) == 0) break;
+      Task task = std::move(tasks_[next_run_]);
+      tasks_.erase(next_run_++);
+      lock.unlock();
+      AllReduceBuffers(task.bufs);
+      task.on_complete();
+      lock.lock();
+    }
+  }
+
+  void AllReduceBuffers(const std::vector<NDArray>& bufs) {
+    MSHADOW_TYPE_SWITCH(bufs[0].dtype(), DType, {
+      if (bufs.size() == 1) {
+        AllReduce(bufs[0].data().dptr<DType>(), bufs[0].shape().Size());
+      } else {
+        size_t total = 0;
+        for (const NDArray& buf : bufs) total += buf.shape().Size();
+        fusion_buf_.resize(total * sizeof(DType));
+        DType* fused = reinterpret_cast<DType*>(fusion_buf_.data());
+        size_t offset = 0;
+        for (const NDArray& buf : bufs) {
+          const size_t n = buf.shape().Size();
+          std::memcpy(fused + offset, buf.data().dptr<DType>(), n * sizeof(DType));
+          offset += n;
+        }
+        AllReduce(fused, total);
+        offset = 0;
+        for (const NDArray& buf : bufs) {
+          const size_t n = buf.shape().Size();
+          std::memcpy(buf.data().dptr<DType>(), fused + offset, n * sizeof(DType));
+          offset += n;
+        }
+      }
+    });
+  }
+
+  template<typename DType>
+  void AllReduce(DType* data, size_t n) {
+    if (hierarchical_) {
+      hier_ring_->AllReduce(data, n);
+    } else {
+      ring_.AllReduce(data, n);
+    }
+  }
+
+  /** \brief for ps-lite start up, addresses and barriers */
+  ps::KVWorker<char>* ps_worker_;
+  /** \brief ring of all workers */
+  RingComm ring_;
+  /** \brief ring of the workers on this host */
+  RingComm local_ring_;
+  /** \brief ring of the workers with the same local rank on all hosts */
+  RingComm cross_ring_;
+  /** \brief whether local_ring_ and cross_ring_ are used instead of ring_ */
+  bool hierarchical_ = false;
+  std::unique_ptr<HierarchicalRingComm> hier_ring_;
+  /** \brief ring addresses of the workers by rank */
+  std::unordered_map<int, std::string> addrs_;
+  std::mutex addr_mu_;
+  std::condition_variable addr_cond_;
+  /** \brief maximum size of a fused allreduce */
+  size_t fusion_bytes_;
+  /** \brief cpu copy of the merged value of each key, allreduced in place */
+  std::unordered_map<int, NDArray> comm_buf_;
+  /** \brief staging buffer of fused allreduces, only used by comm_thread_ */
+  std::vector<char> fusion_buf_;
+  /** \brief sequence number of the next allreduce issued */
+  uint64_t next_issue_ = 0;
+  /** \brief sequence number of the next allreduce to run */
+  uint64_t next_run_ = 0;
+  /** \brief allreduces whose inputs are ready, by sequence number */
+  std::unordered_map<uint64_t, Task> tasks_;
+  bool stop_ = false;
+  std::mutex task_mu_;
+  std::condition_variable task_cond_;
+  std::thread comm_thread_;
+};
+
+}  // namespace kvstore
+}  // namespace mxnet
+#endif  // MXNET_KVSTORE_KVSTORE_DIST_RING_H_
@@ -27,17 +27,28 @@
 #include <mxnet/c_api.h>
 #include <mxnet/kvstore.h>
 #include <ps/ps.h>
+#include <dmlc/io.h>
+#include <sys/stat.h>
 #include <queue>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <limits>
 #include <string>
 #include <mutex>
 #include <condition_variable>
 #include <memory>
 #include <functional>
 #include <future>
+#include <thread>
 #include <vector>
+#include <unordered_map>
+#include <unordered_set>
 #include "../profiler/profiler.h"
 #include "../operator/tensor/elemwise_binary_op-inl.h"
 #include "../operator/tensor/init_op.h"
+#include "./sharded_executor.h"
 
 namespace mxnet {
 namespace kvstore {
@@ -45,11 +56,14 @@ namespace kvstore {
 // maintain same order in frontend.
 enum class CommandType {
   kController, kSetMultiPrecision, kStopServer, kSyncMode,
-  kSetGradientCompression, kSetProfilerParams
+  kSetGradientCompression, kSetProfilerParams, kSetStaleness,
+  kSaveOptimizerStates, kLoadOptimizerStates, kSetWorkerActive, kGetActiveWorkers,
+  kSetLazyUpdate
 };
 
 enum class RequestType {
-  kDefaultPushPull, kRowSparsePushPull, kCompressedPushPull
+  kDefaultPushPull, kRowSparsePushPull, kCompressedPushPull, kFusedPushPull,
+  kSlicedPushPull, kRowSparseCachedPull
 };
 
 struct DataHandleType {
@@ -154,7 +168,8 @@ class Executor {
 
 class KVStoreDistServer {
  public:
-  KVStoreDistServer() {
+  KVStoreDistServer()
+    : handlers_(dmlc::GetEnv("MXNET_KVSTORE_SERVER_THREADS", 4)) {
     using namespace std::placeholders;
     ps_server_ = new ps::KVServer<char>(0);
     static_cast<ps::SimpleApp*>(ps_server_)->set_request_handle(
@@ -164,9 +179,12 @@ class KVStoreDistServer {
     sync_mode_ = false;
     gradient_compression_ = std::make_shared<GradientCompression>();
     log_verbose_ = dmlc::GetEnv("MXNET_KVSTORE_DIST_ROW_SPARSE_VERBOSE", false);
+    checkpoint_dir_ = dmlc::GetEnv("MXNET_KVSTORE_CHECKPOINT_DIR", std::string());
+    checkpoint_interval_ = dmlc::GetEnv("MXNET_KVSTORE_CHECKPOINT_INTERVAL", 60);
   }
 
   ~KVStoreDistServer() {
+    StopCheckpoints();
     profiler::Profiler::Get()->SetState(profiler::Profiler::ProfilerState(0));
     delete ps_server_;
   }
@@ -185,26 +203,52 @@ class KVStoreDistServer {
    * \brief blocked until received the command \a kSyncMode
    */
   void Run() {
+    if (!checkpoint_dir_.empty()) {
+      checkpoint_thread_ = std::thread([this]() { CheckpointLoop(); });
+    }
     exec_.Start();
   }
 
  private:
   struct UpdateBuf {
     std::vector<ps::KVMeta> request;
+    // number of elements merged in the current round of a dense key, see MergeSyncPush
+    size_t num_merged = 0;
+    // number of elements each worker merged in the current round, by sender
+    std::unordered_map<int, size_t> sender_merged;
+    // pushes of workers which pushed all of their part of the current round, to the next round
+    struct QueuedPush {
+      int sender;
+      size_t offset;
+      NDArray value;
+    };
+    std::vector<QueuedPush> queued;
+    // the type and keys of the last push, to complete the round when a worker leaves
+    DataHandleType type;
+    std::vector<int> keys;
     NDArray merged;
     // temp_array is used to cast received values as float32 for computation if required
     NDArray temp_array;
   };
 
   void CommandHandle(const ps::SimpleData& recved, ps::SimpleApp* app) {
+    InitOnce();
+    // commands apply between the requests received before and after them
+    handlers_.WaitAll();
+    std::string response;
     CommandType recved_type = static_cast<CommandType>(recved.head);
     switch (recved_type) {
       case CommandType::kStopServer:
+        StopCheckpoints();
         exec_.Stop();
         break;
       case CommandType::kSyncMode:
         sync_mode_ = true;
         break;
+      case CommandType::kSetStaleness:
+        staleness_ = std::stoi(recved.body);
+        CHECK_GE(staleness_, 0);
+        break;
       case CommandType::kSetGradientCompression:
         gradient_compression_->DecodeParams(recved.body);
         break;
@@ -229,8 +273,114 @@ class KVStoreDistServer {
             controller_(recved.head, recved.body);
           });
         break;
+      case CommandType::kSetWorkerActive:
+        handlers_.ExecExclusive([this, &recved]() {
+          SetWorkerActive(recved.sender, recved.body == "1");
+        });
+        response = ActiveWorkers();
+        break;
+      case CommandType::kGetActiveWorkers:
+        response = ActiveWorkers();
+        break;
+      case CommandType::kSetLazyUpdate:
+        lazy_update_ = recved.body == "1";
+        break;
+      case CommandType::kSaveOptimizerStates:
+      case CommandType::kLoadOptimizerStates:
+        LOG(FATAL) << "command " << recved.head << " is only sent to the controller of a server";
+        break;
+    }
+    app->Response(recved, response);
+  }
+
+  /**
+   * \brief initializes the members which depend on ps-lite being started, and
+   * restores the checkpoint of a restarted server
+   */
+  void InitOnce() {
+    std::call_once(init_once_, [this]() {
+      active_workers_.assign(ps::NumWorkers(), true);
+      num_active_workers_ = ps::NumWorkers();
+      Restore();
+    });
+  }
+
+  /**
+   * \brief adds a worker to or removes it from the workers contributing to the
+   * rounds of sync mode and to the clocks of the staleness bound. a worker
+   * changes its membership between two steps, with no push in an incomplete round
+   */
+  void SetWorkerActive(const int sender, const bool active) {
+    const int rank = ps::Postoffice::IDtoRank(sender);
+    if (active_workers_[rank] == active) return;
+    for (auto* bufs : {&update_buf_, &fused_update_buf_}) {
+      for (const auto& entry : *bufs) {
+        bool pushed = false;
+        for (const auto& req : entry.second.request) pushed = pushed || req.sender == sender;
+        CHECK(!pushed) << "worker " << rank << " changes its membership in the middle of a step,"
+                       << " it pushed key " << entry.first;
+      }
+    }
+    {
+      std::lock_guard<std::mutex> lk(pulls_mu_);
+      for (const auto& round : round_senders_) {
+        CHECK(!round.second.count(sender)) << "worker " << rank << " changes its membership"
+          << " in the middle of a step, it pushed key " << round.first;
+      }
+      // a joining worker starts at the clock of the slowest of the other active workers,
+      // its own clock stopped when it left
+      for (auto& clock : clocks_) {
+        if (active) clock.second[rank] = SlowestClock(clock.second);
+      }
+      active_workers_[rank] = active;
+      if (active) {
+        ++num_active_workers_;
+      } else {
+        --num_active_workers_;
+      }
+      CHECK_GT(num_active_workers_, 0) << "the last active worker cannot leave";
+    }
+    LOG(INFO) << "worker " << rank << (active ? " joined, " : " left, ")
+              << num_active_workers_ << " active workers";
+    // the rounds waiting for a worker which left are complete
+    for (auto& entry : update_buf_) {
+      UpdateBuf& updates = entry.second;
+      if (!updates.request.empty()) {
+        if (updates.type.requestType == RequestType::kCompressedPushPull &&
+            updates.request.size() == num_active_workers_) {
+          gradient_compression_->FinalizeMerge(&updates.merged, 0);
+        }
+        ApplyUpdates(updates.type, entry.first, &updates, ps_server_);
+      } else if (updates.num_merged > 0) {
+        CompleteMergedRound(updates.type, &updates, ps_server_);
+      }
+    }
+    for (auto& entry : fused_update_buf_) {
+      if (entry.second.num_merged > 0) {
+        CompleteMergedRound(entry.second.type, &entry.second, ps_server_);
+      }
     }
-    app->Response(recved);
+    RespondDeferredPulls(ps_server_);
+  }
+
+  /** \brief the ranks of the active workers, separated by commas */
+  std::string ActiveWorkers() {
+    std::string ranks;
+    for (size_t rank = 0; rank < active_workers_.size(); ++rank) {
+      if (!active_workers_[rank]) continue;
+      if (!ranks.empty()) ranks += ",";
+      ranks += std::to_string(rank);
+    }
+    return ranks;
+  }
+
+  /** \brief the clock of the slowest active worker, requires pulls_mu_ */
+  int SlowestClock(const std::vector<int>& clock) {
+    int slowest = std::numeric_limits<int>::max();
+    for (size_t rank = 0; rank < clock.size(); ++rank) {
+      if (active_workers_[rank]) slowest = std::min(slowest, clock[rank]);
+    }
+    return slowest;
   }
 
   /*
@@ -261,7 +411,7 @@ class KVStoreDistServer {
                                     mshadow::kFloat32);
           }
         }
-        CHECK(update.request.size() == 0)
+        CHECK(update.request.size() == 0 && update.num_merged == 0)
           << ps::MyRank() << "Multiprecision mode can not be set while pushes are underway."
           << "Please set optimizer before pushing keys." << key << " " << update.request.size();
 
@@ -273,6 +423,204 @@ class KVStoreDistServer {
     }
   }
 
+  /** \brief the checkpoint directory of this server */
+  std::string CheckpointDir() const {
+    return checkpoint_dir_ + "/server_" + std::to_string(ps::MyRank());
+  }
+
+  /**
+   * \brief writes a checkpoint every checkpoint_interval_ seconds until StopCheckpoints
+   */
+  void CheckpointLoop() {
+    InitOnce();
+    for (const auto& dir : {checkpoint_dir_, CheckpointDir()}) {
+      CHECK(mkdir(dir.c_str(), 0755) == 0 || errno == EEXIST)
+        << "cannot create the checkpoint directory " << dir;
+    }
+    std::unique_lock<std::mutex> lk(checkpoint_mu_);
+    while (!checkpoint_cond_.wait_for(lk, std::chrono::seconds(checkpoint_interval_),
+                                      [this]() { return stop_checkpoints_; })) {
+      lk.unlock();
+      Checkpoint();
+      lk.lock();
+    }
+  }
+
+  void StopCheckpoints() {
+    {
+      std::lock_guard<std::mutex> lk(checkpoint_mu_);
+      stop_checkpoints_ = true;
+    }
+    checkpoint_cond_.notify_all();
+    if (checkpoint_thread_.joinable()) checkpoint_thread_.join();
+  }
+
+  /**
+   * \brief saves the values changed since the last checkpoint, the states of the
+   * optimizer and the settings of the server. the values are copied while no
+   * request is handled and written afterwards. the files of a checkpoint are named
+   * by its step and never overwritten. the manifest, which lists the file of every
+   * key, replaces the previous one once they are complete, so that a crash while
+   * saving leaves the previous checkpoint. the files it no longer lists are removed
+   */
+  void Checkpoint() {
+    const std::string dir = CheckpointDir();
+    const uint64_t step = checkpoint_step_ + 1;
+    std::vector<int> keys;
+    std::vector<std::pair<int, std::vector<NDArray>>> copies;
+    uint64_t optimizer_step = optimizer_states_step_;
+    std::string active_workers;
+    handlers_.ExecExclusive([&]() {
+      active_workers = ActiveWorkers();
+      std::unordered_map<int, NDArray> realt;
+      for (const auto& entry : store_realt_) {
+        if (!entry.second.is_none()) realt[entry.first] = entry.second;
+      }
+      for (const auto& entry : store_) {
+        const NDArray& stored = entry.second;
+        if (stored.is_none()) continue;
+        keys.push_back(entry.first);
+        auto version = std::make_pair(stored.var(), stored.version());
+        auto& saved = saved_versions_[entry.first];
+        if (saved == version) continue;
+        saved = version;
+        std::vector<NDArray> arrays = {SnapshotOf(stored)};
+        if (realt.count(entry.first)) arrays.push_back(SnapshotOf(realt[entry.first]));
+        copies.emplace_back(entry.first, std::move(arrays));
+      }
+      if (copies.empty() || !updater_) return;
+      // the updater is python, run it on the main thread as well
+      exec_.Exec([this, &dir, step]() {
+        controller_(static_cast<int>(CommandType::kSaveOptimizerStates),
+                    CheckpointFile(dir, "optimizer_states", step));
+      });
+      optimizer_step = step;
+    });
+    if (copies.empty()) return;
+    std::vector<std::string> stale;
+    for (const auto& copy : copies) {
+      const std::vector<std::string> names = {"store", "store_realt"};
+      WriteAtomically(CheckpointFile(dir, "key_" + std::to_string(copy.first), step),
+                      [&](dmlc::Stream* fo) {
+        for (const auto& array : copy.second) array.WaitToRead();
+        NDArray::Save(fo, copy.second,
+                      std::vector<std::string>(names.begin(), names.begin() + copy.second.size()));
+      });
+      uint64_t& saved_step = saved_steps_[copy.first];
+      if (saved_step != 0) {
+        stale.push_back(CheckpointFile(dir, "key_" + std::to_string(copy.first), saved_step));
+      }
+      saved_step = step;
+    }
+    std::vector<uint64_t> key_steps;
+    for (const int key : keys) key_steps.push_back(saved_steps_[key]);
+    WriteAtomically(dir + "/meta", [&](dmlc::Stream* fo) {
+      fo->Write(step);
+      fo->Write(sync_mode_);
+      fo->Write(multi_precision_);
+      fo->Write(staleness_);
+      fo->Write(gradient_compression_->EncodeParams());
+      fo->Write(keys);
+      fo->Write(key_steps);
+      fo->Write(optimizer_step);
+      fo->Write(active_workers);
+    });
+    if (optimizer_states_step_ != 0 && optimizer_states_step_ != optimizer_step) {
+      stale.push_back(CheckpointFile(dir, "optimizer_states", optimizer_states_step_));
+    }
+    checkpoint_step_ = step;
+    optimizer_states_step_ = optimizer_step;
+    for (const auto& path : stale) std::remove(path.c_str());
+    if (log_verbose_) {
+      LOG(INFO) << "checkpoint " << step << " of " << copies.size() << " of " << keys.size()
+                << " keys";
+    }
+  }
+
+  /**
+   * \brief restores the checkpoint of a server which restarted after a failure,
+   * before any request is handled. the files the manifest lists have to be complete
+   */
+  void Restore() {
+    if (checkpoint_dir_.empty() || !ps::Postoffice::Get()->is_recovery()) return;
+    const std::string dir = CheckpointDir();
+    std::unique_ptr<dmlc::Stream> fi(dmlc::Stream::Create((dir + "/meta").c_str(), "r", true));
+    if (!fi) {
+      LOG(WARNING) << "no checkpoint to restore in " << dir;
+      return;
+    }
+    uint64_t step = 0, optimizer_step = 0;
+    std::string compression;
+    std::vector<int> keys;
+    std::vector<uint64_t> key_steps;
+    std::string active_workers;
+    CHECK(fi->Read(&step) && fi->Read(&sync_mode_) && fi->Read(&multi_precision_) &&
+          fi->Read(&staleness_) && fi->Read(&compression) && fi->Read(&keys) &&
+          fi->Read(&key_steps) && fi->Read(&optimizer_step) && fi->Read(&active_workers))
+      << "invalid checkpoint " << dir;
+    CHECK_EQ(keys.size(), key_steps.size()) << "invalid checkpoint " << dir;
+    CHECK_LE(optimizer_step, step) << "invalid checkpoint " << dir;
+    gradient_compression_->DecodeParams(compression);
+    std::vector<std::string> ranks;
+    mxnet::kvstore::split(active_workers, ',', std::back_inserter(ranks));
+    active_workers_.assign(ps::NumWorkers(), false);
+    num_active_workers_ = ranks.size();
+    for (const auto& rank : ranks) active_workers_[std::stoi(rank)] = true;
+    for (size_t i = 0; i < keys.size(); ++i) {
+      const int key = keys[i];
+      CHECK(key_steps[i] > 0 && key_steps[i] <= step) << "invalid checkpoint " << dir;
+      const std::string path = CheckpointFile(dir, "key_" + std::to_string(key), key_steps[i]);
+      std::unique_ptr<dmlc::Stream> fk(dmlc::Stream::Create(path.c_str(), "r", true));
+      CHECK(fk) << "checkpoint " << step << " misses " << path;
+      std::vector<NDArray> arrays;
+      std::vector<std::string> names;
+      NDArray::Load(fk.get(), &arrays, &names);
+      CHECK(!arrays.empty() && arrays.size() <= 2 && names[0] == "store")
+        << "invalid checkpoint file " << path;
+      store_[key] = arrays[0];
+      if (arrays.size() > 1) store_realt_[key] = arrays[1];
+      saved_steps_[key] = key_steps[i];
+    }
+    if (optimizer_step != 0) {
+      const std::string path = CheckpointFile(dir, "optimizer_states", optimizer_step);
+      CHECK(std::unique_ptr<dmlc::Stream>(dmlc::Stream::Create(path.c_str(), "r", true)))
+        << "checkpoint " << step << " misses " << path;
+      exec_.Exec([this, &path]() {
+        controller_(static_cast<int>(CommandType::kLoadOptimizerStates), path);
+      });
+    }
+    checkpoint_step_ = step;
+    optimizer_states_step_ = optimizer_step;
+    LOG(INFO) << "server " << ps::MyRank() << " restored " << keys.size()
+              << " keys of checkpoint " << step << " from " << dir;
+  }
+
+  /** \brief the file of a checkpoint written at the step */
+  static std::string CheckpointFile(const std::string& dir, const std::string& name,
+                                    const uint64_t step) {
+    return dir + "/" + name + "_" + std::to_string(step);
+  }
+
+  /** \brief a copy of the current value of an array */
+  static NDArray SnapshotOf(const NDArray& src) {
+    NDArray copy = src.storage_type() == kDefaultStorage ?
+        NDArray(src.shape(), src.ctx(), false, src.dtype()) :
+        NDArray(src.storage_type(), src.shape(), src.ctx(), true, src.dtype());
+    CopyFromTo(src, &copy);
+    return copy;
+  }
+
+  /** \brief writes a file, which is replaced only once it is complete */
+  static void WriteAtomically(const std::string& path,
+                              const std::function<void(dmlc::Stream*)>& write) {
+    const std::string tmp = path + ".tmp";
+    {
+      std::unique_ptr<dmlc::Stream> fo(dmlc::Stream::Create(tmp.c_str(), "w"));
+      write(fo.get());
+    }
+    CHECK_EQ(std::rename(tmp.c_str(), path.c_str()), 0) << "cannot write " << path;
+  }
+
   void ProcessServerProfilerCommands(KVStoreServerProfilerCommand type, const std::string& body) {
     switch (type) {
       case KVStoreServerProfilerCommand::kSetConfig:
@@ -322,12 +670,101 @@ class KVStoreDistServer {
     }
   }
 
+  /*
+   * Requests are handled by the threads of handlers_, those of a key in the
+   * order they were received. A fused request waits for all requests
+   * received before it, as its keys can belong to different threads.
+   */
   void DataHandleEx(const ps::KVMeta& req_meta,
                     const ps::KVPairs<char>& req_data,
                     ps::KVServer<char>* server) {
+    InitOnce();
     DataHandleType type = DepairDataHandleType(req_meta.cmd);
+    auto handle = [this, type, req_meta, req_data, server]() {
+      DataHandle(type, req_meta, req_data, server);
+    };
+    if (type.requestType == RequestType::kFusedPushPull) {
+      handlers_.ExecExclusive(handle);
+    } else {
+      handlers_.Exec(RequestKey(type, req_meta, req_data), handle);
+    }
+  }
+
+  /** \brief the key of a request which is not fused */
+  int RequestKey(const DataHandleType type, const ps::KVMeta& req_meta,
+                 const ps::KVPairs<char>& req_data) {
+    if (req_data.keys.empty()) return 0;
+    switch (type.requestType) {
+      case RequestType::kCompressedPushPull:
+        // a push starts with the original size
+        return DecodeKey(req_data.keys[req_meta.push && req_data.keys.size() > 1 ? 1 : 0]);
+      case RequestType::kSlicedPushPull:
+        return static_cast<int>((req_data.keys[0] - ps::Postoffice::Get()->
+                                 GetServerKeyRanges()[ps::MyRank()].begin()) >> 32);
+      default:
+        return DecodeKey(req_data.keys[0]);
+    }
+  }
+
+  /** \brief the keys of a request */
+  std::vector<int> RequestKeys(const DataHandleType type, const ps::KVMeta& req_meta,
+                               const ps::KVPairs<char>& req_data) {
+    if (type.requestType != RequestType::kFusedPushPull) {
+      return {RequestKey(type, req_meta, req_data)};
+    }
+    std::vector<int> keys(req_data.keys.size());
+    for (size_t i = 0; i < keys.size(); ++i) keys[i] = DecodeKey(req_data.keys[i]);
+    return keys;
+  }
+
+  void DataHandle(const DataHandleType type, const ps::KVMeta& req_meta,
+                  const ps::KVPairs<char>& req_data,
+                  ps::KVServer<char>* server) {
+    if (staleness_ >= 0) {
+      DataHandleStale(type, req_meta, req_data, server);
+      return;
+    }
+    DispatchDataHandle(type, req_meta, req_data, server);
+  }
+
+  /*
+   * In async mode with a staleness bound, the server counts the pushes of
+   * every worker to every key, its clock. The pull of a worker whose clock is
+   * more than staleness_ ahead of the slowest worker waits until the slowest
+   * worker has caught up. Every worker has to push every key in every step.
+   */
+  void DataHandleStale(const DataHandleType type, const ps::KVMeta& req_meta,
+                       const ps::KVPairs<char>& req_data,
+                       ps::KVServer<char>* server) {
+    const std::vector<int> keys = RequestKeys(type, req_meta, req_data);
+    if (!req_meta.push) {
+      if (DeferPull(type, keys, req_meta, req_data)) return;
+      DispatchDataHandle(type, req_meta, req_data, server);
+      return;
+    }
+    // the push initializing a key is not a step
+    bool inited = true;
+    for (const int key : keys) inited = inited && !store_[key].is_none();
+    DispatchDataHandle(type, req_meta, req_data, server);
+    if (!inited) return;
+    {
+      std::lock_guard<std::mutex> lk(pulls_mu_);
+      const int rank = ps::Postoffice::IDtoRank(req_meta.sender);
+      for (const int key : keys) {
+        auto& clock = clocks_[key];
+        if (clock.empty()) clock.resize(ps::NumWorkers(), 0);
+        ++clock[rank];
+      }
+    }
+    RespondDeferredPulls(server);
+  }
+
+  void DispatchDataHandle(const DataHandleType type, const ps::KVMeta& req_meta,
+                          const ps::KVPairs<char>& req_data,
+                          ps::KVServer<char>* server) {
     switch (type.requestType) {
       case RequestType::kRowSparsePushPull:
+      case RequestType::kRowSparseCachedPull:
         DataHandleRowSparse(type, req_meta, req_data, server);
         break;
       case RequestType::kCompressedPushPull:
@@ -336,6 +773,12 @@ class KVStoreDistServer {
       case RequestType::kDefaultPushPull:
         DataHandleDefault(type, req_meta, req_data, server);
         break;
+      case RequestType::kFusedPushPull:
+        DataHandleFused(type, req_meta, req_data, server);
+        break;
+      case RequestType::kSlicedPushPull:
+        DataHandleSliced(type, req_meta, req_data, server);
+        break;
     }
   }
 
@@ -345,7 +788,8 @@ class KVStoreDistServer {
 
   inline void ApplyUpdates(const DataHandleType type, const int key,
                            UpdateBuf *update_buf, ps::KVServer<char>* server) {
-    if (!sync_mode_ || update_buf->request.size() == (size_t) ps::NumWorkers()) {
+    update_buf->type = type;
+    if (!sync_mode_ || update_buf->request.size() == num_active_workers_) {
       // let the main thread to execute updater_, which is necessary for python
       auto& stored = has_multi_precision_copy(type) ? store_realt_[key] : store_[key];
       auto& update =  sync_mode_ ? update_buf->merged : update_buf->temp_array;
@@ -360,6 +804,9 @@ class KVStoreDistServer {
         CopyFromTo(update_buf->merged, &stored);
       }
 
+      if (stored.storage_type() == kRowSparseStorage) {
+        BumpRowVersions(key, update);
+      }
       if (log_verbose_)  {
         LOG(INFO) << "sent response to " << update_buf->request.size() << " workers";
       }
@@ -374,6 +821,29 @@ class KVStoreDistServer {
     }
   }
 
+  /**
+   * \brief marks the rows a row_sparse update changed, so that the row caches
+   * of the workers fetch them again
+   */
+  void BumpRowVersions(const int key, const NDArray& update) {
+    auto& versions = row_versions_[key];
+    if (versions.empty()) return;
+    if (!updater_ || !lazy_update_) {
+      // the stored value is replaced by the merged gradient, or the updater can
+      // change every row, e.g. by weight decay or momentum
+      for (auto& version : versions) ++version;
+      return;
+    }
+    // a lazy updater changes the rows of the gradient only
+    update.WaitToRead();
+    if (!update.storage_initialized()) return;
+    const size_t num_rows = update.aux_shape(rowsparse::kIdx).Size();
+    MSHADOW_IDX_TYPE_SWITCH(update.aux_type(rowsparse::kIdx), IType, {
+      const IType* idx = update.aux_data(rowsparse::kIdx).dptr<IType>();
+      for (size_t i = 0; i < num_rows; ++i) ++versions[idx[i]];
+    });
+  }
+
   void DecodeRowIds(const ps::SArray<ps::Key> &keys, int64_t *indices,
                     const int64_t master_key, const int64_t num_rows) {
     indices[0] = 0;
@@ -447,6 +917,59 @@ class KVStoreDistServer {
     server->Response(req_meta, response);
   }
 
+  /**
+   * \brief responds to the pull of a worker with a row cache. a row the worker
+   * already received in its current version is answered with an empty value
+   */
+  void RowSparseCachedPullResponse(const DataHandleType type,
+                                   const int master_key,
+                                   const size_t num_rows,
+                                   const ps::KVMeta& req_meta,
+                                   const ps::KVPairs<char>& req_data,
+                                   ps::KVServer<char>* server) {
+    if (log_verbose_) LOG(INFO) << "cached pull: " << master_key;
+    ps::KVPairs<char> response;
+    std::vector<int> lens(req_data.keys.size(), 0);
+    response.keys = req_data.keys;
+    if (num_rows == 0) {
+      response.lens.CopyFrom(lens.begin(), lens.end());
+      server->Response(req_meta, response);
+      return;
+    }
+    const NDArray& stored = store_[master_key];
+    if (has_multi_precision_copy(type)) stored.WaitToRead();
+    CHECK(!stored.is_none()) << "init " << master_key << " first";
+    auto shape = stored.shape();
+    auto unit_len = shape.ProdShape(1, shape.ndim());
+    const int num_bytes = mshadow::mshadow_sizeof(type.dtype);
+    const int unit_size = unit_len * num_bytes;
+    const char* data = static_cast<char *> (stored.data().dptr_);
+    // the versions start with the first cached pull of the key
+    auto& versions = row_versions_[master_key];
+    if (versions.empty()) versions.assign(shape[0], 1);
+    auto& sent_versions = sent_versions_[master_key];
+    if (sent_versions.empty()) sent_versions.resize(ps::NumWorkers());
+    auto& sent = sent_versions[ps::Postoffice::Get()->IDtoRank(req_meta.sender)];
+    if (sent.empty()) sent.assign(shape[0], 0);
+    std::vector<int64_t> row_ids;
+    for (size_t i = 1; i <= num_rows; i++) {
+      int64_t row_id = DecodeKey(req_data.keys[i]) - master_key;
+      if (sent[row_id] != versions[row_id]) {
+        sent[row_id] = versions[row_id];
+        lens[i] = unit_size;
+        row_ids.push_back(row_id);
+      }
+    }
+    response.vals.resize(row_ids.size() * unit_size);
+    #pragma omp parallel for
+    for (size_t i = 0; i < row_ids.size(); i++) {
+      response.vals.segment(i * unit_size, (i + 1) * unit_size)
+          .CopyFrom(data + row_ids[i] * unit_size, unit_size);
+    }
+    response.lens.CopyFrom(lens.begin(), lens.end());
+    server->Response(req_meta, response);
+  }
+
   void InitRowSparseStored(const DataHandleType type,
                            const int master_key,
                            const size_t num_rows,
@@ -471,6 +994,8 @@ class KVStoreDistServer {
     if (has_multi_precision_copy(type)) {
       store_[master_key] = NDArray(kRowSparseStorage, dshape, Context(), true, type.dtype);
     }
+    row_versions_[master_key].clear();
+    sent_versions_[master_key].clear();
     Engine::Get()->PushAsync(
     [this, recved, stored, type](RunContext ctx, Engine::CallbackOnComplete on_complete) {
       NDArray rsp = stored;
@@ -573,6 +1098,8 @@ class KVStoreDistServer {
           ApplyUpdates(type, master_key, &updates, server);
         }
       }
+    } else if (type.requestType == RequestType::kRowSparseCachedPull) {
+      RowSparseCachedPullResponse(type, master_key, num_rows, req_meta, req_data, server);
     } else {
       // pull
       RowSparsePullResponse(type, master_key, num_rows, req_meta, req_data, server);
@@ -624,7 +1151,7 @@ class KVStoreDistServer {
       TBlob recv_blob(reinterpret_cast<real_t*>(req_data.vals.data()), dshape, cpu::kDevMask);
       NDArray recved = NDArray(recv_blob, 0);
 
-      NDArray decomp_buf = decomp_buf_[key];
+      NDArray& decomp_buf = decomp_buf_[key];
       dshape = TShape{(int64_t) original_size};
 
       if (decomp_buf.is_none()) {
@@ -649,6 +1176,10 @@ class KVStoreDistServer {
           merged.merged += decomp_buf;
         }
         merged.request.push_back(req_meta);
+        if (merged.request.size() == num_active_workers_) {
+          // e.g. majority vote of 1bit compression
+          gradient_compression_->FinalizeMerge(&merged.merged, 0);
+        }
         ApplyUpdates(type, key, &merged, server);
       } else {
         // async push
@@ -703,42 +1234,329 @@ class KVStoreDistServer {
           stored_dtype.WaitToRead();
         }
         stored.WaitToRead();
+      } else if (sync_mode_) {
+        MergeSyncPush(type, {key}, 0, recved, &update_buf_[key], req_meta, server);
       } else {
         auto &updates = update_buf_[key];
-        if (sync_mode_ && updates.merged.is_none()) {
-          updates.merged = NDArray(dshape, Context(), false,
-                                   has_multi_precision_copy(type) ? mshadow::kFloat32 : type.dtype);
-        }
         if (has_multi_precision_copy(type) && updates.temp_array.is_none()) {
           updates.temp_array = NDArray(dshape, Context(), false, mshadow::kFloat32);
         }
-        if (updates.request.empty()) {
-          if (sync_mode_) {
-            CopyFromTo(recved, updates.merged);
-          } else {
-            if (has_multi_precision_copy(type)) {
-              CopyFromTo(recved, updates.temp_array);
-            } else {
-              updates.temp_array = recved;
-            }
-          }
+        if (has_multi_precision_copy(type)) {
+          CopyFromTo(recved, updates.temp_array);
         } else {
-          CHECK(sync_mode_);
-          if (has_multi_precision_copy(type)) {
-            CopyFromTo(recved, updates.temp_array);
-            updates.merged += updates.temp_array;
-          } else {
-            updates.merged += recved;
-          }
+          updates.temp_array = recved;
         }
         updates.request.push_back(req_meta);
         ApplyUpdates(type, key, &updates, server);
       }
     } else {
+      if (sync_mode_ && DeferPull(type, {key}, req_meta, req_data)) return;
       DefaultStorageResponse(type, key, req_meta, req_data, server);
     }
   }
 
+  /*
+   * A fused request carries several small dense keys stored on this server.
+   * In sync mode all workers fuse the same keys, so the pushes are merged per
+   * bucket, identified by its first key.
+   */
+  void DataHandleFused(const DataHandleType type, const ps::KVMeta& req_meta,
+                       const ps::KVPairs<char> &req_data,
+                       ps::KVServer<char>* server) {
+    const size_t num_keys = req_data.keys.size();
+    const int num_bytes = mshadow::mshadow_sizeof(type.dtype);
+    std::vector<int> keys(num_keys);
+    for (size_t i = 0; i < num_keys; ++i) keys[i] = DecodeKey(req_data.keys[i]);
+    if (!req_meta.push) {
+      if (sync_mode_ && DeferPull(type, keys, req_meta, req_data)) return;
+      FusedPullResponse(type, req_meta, req_data, server);
+      return;
+    }
+    CHECK_EQ(req_data.lens.size(), num_keys);
+    size_t ds[] = {(size_t) req_data.vals.size() / num_bytes};
+    TShape dshape(ds, ds + 1);
+    TBlob recv_blob;
+    MSHADOW_REAL_TYPE_SWITCH(type.dtype, DType, {
+      recv_blob = TBlob(reinterpret_cast<DType*>(req_data.vals.data()), dshape, cpu::kDevMask);
+    })
+    NDArray recved = NDArray(recv_blob, 0);
+    if (sync_mode_) {
+      MergeSyncPush(type, keys, 0, recved, &fused_update_buf_[keys[0]], req_meta, server);
+      return;
+    }
+    NDArray update = recved;
+    if (has_multi_precision_copy(type)) {
+      update = NDArray(dshape, Context(), false, mshadow::kFloat32);
+      CopyFromTo(recved, &update);
+    }
+    for (size_t i = 0, offset = 0; i < num_keys; offset += req_data.lens[i++] / num_bytes) {
+      auto& stored = has_multi_precision_copy(type) ? store_realt_[keys[i]] : store_[keys[i]];
+      CHECK(!stored.is_none()) << "init " << keys[i] << " first";
+      NDArray part = update.Slice(offset, offset + req_data.lens[i] / num_bytes)
+                     .Reshape(stored.shape());
+      exec_.Exec([this, &keys, i, &part, &stored]() {
+        CHECK(updater_) << "Updater needs to be set for async mode";
+        updater_(keys[i], part, &stored);
+      });
+      if (has_multi_precision_copy(type)) CopyFromTo(stored, store_[keys[i]]);
+      store_[keys[i]].WaitToRead();
+    }
+    server->Response(req_meta);
+  }
+
+  void FusedPullResponse(const DataHandleType type, const ps::KVMeta& req_meta,
+                         const ps::KVPairs<char> &req_data,
+                         ps::KVServer<char>* server) {
+    const size_t num_keys = req_data.keys.size();
+    const int num_bytes = mshadow::mshadow_sizeof(type.dtype);
+    ps::KVPairs<char> response;
+    response.keys = req_data.keys;
+    std::vector<int> lens(num_keys);
+    size_t len = 0;
+    for (size_t i = 0; i < num_keys; ++i) {
+      const NDArray& stored = store_[DecodeKey(req_data.keys[i])];
+      CHECK(!stored.is_none()) << "init " << DecodeKey(req_data.keys[i]) << " first";
+      if (has_multi_precision_copy(type)) stored.WaitToRead();
+      lens[i] = stored.shape().Size() * num_bytes;
+      len += lens[i];
+    }
+    response.lens.CopyFrom(lens.begin(), lens.end());
+    response.vals.resize(len);
+    for (size_t i = 0, offset = 0; i < num_keys; offset += lens[i++]) {
+      const NDArray& stored = store_[DecodeKey(req_data.keys[i])];
+      response.vals.segment(offset, offset + lens[i]).CopyFrom(
+        static_cast<const char*>(stored.data().dptr_), lens[i]);
+    }
+    server->Response(req_meta, response);
+  }
+
+  /*
+   * A slice of a large dense key, only sent in sync mode. Its elements
+   * [offset, offset + n) are encoded as the keys (key << 32) + offset and
+   * (key << 32) + offset + n.
+   */
+  void DataHandleSliced(const DataHandleType type, const ps::KVMeta& req_meta,
+                        const ps::KVPairs<char> &req_data,
+                        ps::KVServer<char>* server) {
+    CHECK_EQ(req_data.keys.size(), (size_t)2);
+    CHECK(sync_mode_) << "sliced pushes and pulls need the sync mode";
+    const ps::Key begin = ps::Postoffice::Get()->GetServerKeyRanges()[ps::MyRank()].begin();
+    const ps::Key first = req_data.keys[0] - begin;
+    const int key = static_cast<int>(first >> 32);
+    const size_t offset = first & 0xffffffff;
+    const size_t size = req_data.keys[1] - req_data.keys[0];
+    const int num_bytes = mshadow::mshadow_sizeof(type.dtype);
+    const NDArray& stored = store_[key];
+    CHECK(!stored.is_none()) << "init " << key << " first";
+    CHECK_LE(offset + size, stored.shape().Size());
+    if (req_meta.push) {
+      CHECK_EQ(req_data.vals.size(), size * num_bytes);
+      TBlob recv_blob;
+      MSHADOW_REAL_TYPE_SWITCH(type.dtype, DType, {
+        recv_blob = TBlob(reinterpret_cast<DType*>(req_data.vals.data()),
+                          mshadow::Shape1(size), cpu::kDevMask);
+      })
+      MergeSyncPush(type, {key}, offset, NDArray(recv_blob, 0), &update_buf_[key],
+                    req_meta, server);
+    } else {
+      if (DeferPull(type, {key}, req_meta, req_data)) return;
+      SlicedPullResponse(type, req_meta, req_data, server);
+    }
+  }
+
+  void SlicedPullResponse(const DataHandleType type, const ps::KVMeta& req_meta,
+                          const ps::KVPairs<char> &req_data,
+                          ps::KVServer<char>* server) {
+    const ps::Key begin = ps::Postoffice::Get()->GetServerKeyRanges()[ps::MyRank()].begin();
+    const ps::Key first = req_data.keys[0] - begin;
+    const int num_bytes = mshadow::mshadow_sizeof(type.dtype);
+    const NDArray& stored = store_[static_cast<int>(first >> 32)];
+    if (has_multi_precision_copy(type)) stored.WaitToRead();
+    const size_t len = (req_data.keys[1] - req_data.keys[0]) * num_bytes;
+    ps::KVPairs<char> response;
+    response.keys = req_data.keys;
+    response.lens = {static_cast<int>(len), 0};
+    response.vals.CopyFrom(static_cast<const char*>(stored.data().dptr_) +
+                           (first & 0xffffffff) * num_bytes, len);
+    server->Response(req_meta, response);
+  }
+
+  /*
+   * Merges a dense push into the current round of the keys, which starts with
+   * the first push after the previous round and ends once every worker has
+   * pushed every element of the keys, possibly in several slices. The pushes
+   * are answered at once, so that a worker never waits for the other workers
+   * before it can send its next push. Instead, a pull waits in DeferPull until
+   * the round its worker pushed to is complete.
+   * \param keys keys of the merged buffer, concatenated
+   * \param offset position of recved in the merged buffer
+   */
+  void MergeSyncPush(const DataHandleType type, const std::vector<int>& keys,
+                     const size_t offset, const NDArray& recved, UpdateBuf* updates,
+                     const ps::KVMeta& req_meta, ps::KVServer<char>* server) {
+    const bool multi_precision = has_multi_precision_copy(type);
+    size_t total = 0;
+    for (const int key : keys) {
+      CHECK(!store_[key].is_none()) << "init " << key << " first";
+      total += store_[key].shape().Size();
+    }
+    const int merged_dtype = multi_precision ? mshadow::kFloat32 : type.dtype;
+    if (updates->merged.is_none() || updates->merged.shape().Size() != total ||
+        updates->merged.dtype() != merged_dtype) {
+      CHECK_EQ(updates->num_merged, 0)
+        << "all workers have to fuse the same keys, the pushes to key " << keys[0]
+        << " have different sizes";
+      updates->merged = NDArray(mshadow::Shape1(total), Context(), false, merged_dtype);
+      if (multi_precision) {
+        updates->temp_array = NDArray(mshadow::Shape1(total), Context(), false,
+                                      mshadow::kFloat32);
+      }
+    }
+    const size_t size = recved.shape().Size();
+    CHECK_LE(offset + size, total);
+    updates->type = type;
+    updates->keys = keys;
+    if (updates->sender_merged[req_meta.sender] + size > total) {
+      // the worker pushes again before the other workers completed the round
+      NDArray value(recved.shape(), Context(), false, recved.dtype());
+      CopyFromTo(recved, &value);
+      value.WaitToRead();
+      updates->queued.push_back(UpdateBuf::QueuedPush{req_meta.sender, offset, value});
+      server->Response(req_meta);
+      return;
+    }
+    MergeIntoRound(req_meta.sender, offset, recved, updates);
+    server->Response(req_meta);
+    CompleteMergedRound(type, updates, server);
+    updates->merged.WaitToRead();
+  }
+
+  /** \brief adds a push of the sender to the current round of MergeSyncPush */
+  void MergeIntoRound(const int sender, const size_t offset, const NDArray& recved,
+                      UpdateBuf* updates) {
+    const size_t size = recved.shape().Size();
+    if (updates->num_merged == 0) updates->merged = 0;
+    NDArray merged = updates->merged.Slice(offset, offset + size);
+    if (has_multi_precision_copy(updates->type)) {
+      NDArray temp = updates->temp_array.Slice(offset, offset + size);
+      CopyFromTo(recved, &temp);
+      merged += temp;
+    } else {
+      merged += recved;
+    }
+    updates->num_merged += size;
+    updates->sender_merged[sender] += size;
+    std::lock_guard<std::mutex> lk(pulls_mu_);
+    for (const int key : updates->keys) round_senders_[key].insert(sender);
+  }
+
+  /**
+   * \brief updates the keys of a round of MergeSyncPush once all active workers
+   * pushed to it, and starts the next round with the pushes queued meanwhile
+   */
+  void CompleteMergedRound(const DataHandleType type, UpdateBuf* updates,
+                           ps::KVServer<char>* server) {
+    const bool multi_precision = has_multi_precision_copy(type);
+    const std::vector<int>& keys = updates->keys;
+    if (updates->num_merged != updates->merged.shape().Size() * num_active_workers_) return;
+    for (size_t i = 0, begin = 0; i < keys.size(); ++i) {
+      const int key = keys[i];
+      auto& stored = multi_precision ? store_realt_[key] : store_[key];
+      NDArray update = updates->merged.Slice(begin, begin + stored.shape().Size())
+                                      .Reshape(stored.shape());
+      begin += stored.shape().Size();
+      if (updater_) {
+        // let the main thread to execute updater_, which is necessary for python
+        exec_.Exec([this, key, &update, &stored]() {
+          CHECK(updater_);
+          updater_(key, update, &stored);
+        });
+      } else {
+        // if no updater, just copy
+        CopyFromTo(update, &stored);
+      }
+      if (multi_precision) CopyFromTo(stored, store_[key]);
+    }
+    updates->num_merged = 0;
+    updates->sender_merged.clear();
+    for (const int key : keys) store_[key].WaitToRead();
+    {
+      std::lock_guard<std::mutex> lk(pulls_mu_);
+      for (const int key : keys) round_senders_.erase(key);
+    }
+    std::vector<UpdateBuf::QueuedPush> queued;
+    queued.swap(updates->queued);
+    for (UpdateBuf::QueuedPush& push : queued) {
+      const size_t size = push.value.shape().Size();
+      if (updates->sender_merged[push.sender] + size > updates->merged.shape().Size()) {
+        updates->queued.push_back(std::move(push));
+      } else {
+        MergeIntoRound(push.sender, push.offset, push.value, updates);
+      }
+    }
+    updates->merged.WaitToRead();
+    RespondDeferredPulls(server);
+    // the queued pushes complete the next round when a worker left meanwhile
+    CompleteMergedRound(type, updates, server);
+  }
+
+  /*
+   * Keeps a pull of a worker back while the worker has pushed to an incomplete
+   * round of one of the keys.
+   * \return whether the pull was deferred
+   */
+  bool DeferPull(const DataHandleType type, const std::vector<int>& keys,
+                 const ps::KVMeta& req_meta, const ps::KVPairs<char> &req_data) {
+    std::lock_guard<std::mutex> lk(pulls_mu_);
+    if (!IsPulledTooEarly(keys, req_meta.sender)) return false;
+    deferred_pulls_.push_back(DeferredPull{type, req_meta, req_data, keys});
+    return true;
+  }
+
+  /** \brief requires pulls_mu_ */
+  bool IsPulledTooEarly(const std::vector<int>& keys, const int sender) {
+    for (const int key : keys) {
+      auto it = round_senders_.find(key);
+      if (it != round_senders_.end() && it->second.count(sender)) return true;
+    }
+    const int rank = ps::Postoffice::IDtoRank(sender);
+    if (staleness_ >= 0 && active_workers_[rank]) {
+      for (const int key : keys) {
+        auto it = clocks_.find(key);
+        if (it == clocks_.end()) continue;
+        if (it->second[rank] - SlowestClock(it->second) > staleness_) return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * \brief respond to the pulls no longer waiting for a round or for the clocks
+   * of their keys
+   */
+  void RespondDeferredPulls(ps::KVServer<char>* server) {
+    std::vector<DeferredPull> pulls;
+    {
+      std::lock_guard<std::mutex> lk(pulls_mu_);
+      std::vector<DeferredPull> deferred;
+      for (DeferredPull& pull : deferred_pulls_) {
+        if (IsPulledTooEarly(pull.keys, pull.meta.sender)) {
+          deferred.push_back(std::move(pull));
+        } else {
+          pulls.push_back(std::move(pull));
+        }
+      }
+      deferred_pulls_.swap(deferred);
+    }
+    // a pull is handled with the requests of its keys, whichever key completed
+    for (const DeferredPull& pull : pulls) {
+      handlers_.Post(std::vector<size_t>(pull.keys.begin(), pull.keys.end()),
+                     [this, pull, server]() {
+                       DataHandle(pull.type, pull.meta, pull.data, server);
+                     });
+    }
+  }
+
   int DecodeKey(ps::Key key) {
     auto kr = ps::Postoffice::Get()->GetServerKeyRanges()[ps::MyRank()];
     return key - kr.begin();
@@ -755,23 +1573,106 @@ class KVStoreDistServer {
   /**
    * \brief store_ contains the value at kvstore for each key
    */
-  std::unordered_map<int, NDArray> store_;
-  std::unordered_map<int, NDArray> store_realt_;
+  KeyMap<NDArray> store_;
+  KeyMap<NDArray> store_realt_;
 
   /**
    * \brief merge_buf_ is a buffer used if sync_mode is true. It represents
    * values from different workers being merged. The store will be updated
    * to this value when values from all workers are pushed into this buffer.
    */
-  std::unordered_map<int, UpdateBuf> update_buf_;
+  KeyMap<UpdateBuf> update_buf_;
+
+  /**
+   * \brief fused_update_buf_ merges the fused pushes of several keys, by the
+   * first key of the bucket
+   */
+  KeyMap<UpdateBuf> fused_update_buf_;
+
+  /**
+   * \brief the workers which pushed to the incomplete round of a dense key in sync mode
+   */
+  std::unordered_map<int, std::unordered_set<int>> round_senders_;
+
+  struct DeferredPull {
+    DataHandleType type;
+    ps::KVMeta meta;
+    ps::KVPairs<char> data;
+    std::vector<int> keys;
+  };
+  /**
+   * \brief pulls waiting for the rounds their workers pushed to
+   */
+  std::vector<DeferredPull> deferred_pulls_;
+  /**
+   * \brief maximum number of pushes a worker can be ahead of the slowest worker
+   * in async mode, -1 for no bound
+   */
+  int staleness_ = -1;
+  /**
+   * \brief whether the optimizer of the workers only changes the rows of a row_sparse
+   * gradient, so that the other rows stay in the row caches
+   */
+  bool lazy_update_ = false;
+  /**
+   * \brief the number of pushes of every worker to a key, with a staleness bound
+   */
+  std::unordered_map<int, std::vector<int>> clocks_;
+  /**
+   * \brief the workers contributing to the rounds of sync mode and to the clocks,
+   * by rank. changed while no request is handled
+   */
+  std::vector<bool> active_workers_;
+  size_t num_active_workers_ = 0;
+
+  /**
+   * \brief protects round_senders_, deferred_pulls_, clocks_ and active_workers_, which are
+   * shared by all keys
+   */
+  std::mutex pulls_mu_;
 
   /**
    * \brief decomp_buf_ is a buffer into which compressed values are
    * decompressed before merging to the store. used when compress_!='none'
    */
-  std::unordered_map<int, NDArray> decomp_buf_;
+  KeyMap<NDArray> decomp_buf_;
+
+  /**
+   * \brief row_versions_[key][row] counts the updates of a row of a row_sparse
+   * key, from the first cached pull of the key on. sent_versions_[key][rank][row]
+   * is the version of the row the worker of the rank has in its row cache
+   */
+  KeyMap<std::vector<uint32_t>> row_versions_;
+  KeyMap<std::vector<std::vector<uint32_t>>> sent_versions_;
+
+  /**
+   * \brief directory of the checkpoints, empty for none. see Checkpoint and Restore
+   */
+  std::string checkpoint_dir_;
+  int checkpoint_interval_;
+  std::thread checkpoint_thread_;
+  bool stop_checkpoints_ = false;
+  std::mutex checkpoint_mu_;
+  std::condition_variable checkpoint_cond_;
+  std::once_flag init_once_;
+  /**
+   * \brief the variables and versions of the values in the last checkpoint, used by
+   * the checkpoint thread only
+   */
+  std::unordered_map<int, std::pair<Engine::VarHandle, size_t>> saved_versions_;
+  /**
+   * \brief the step of the last checkpoint, and the steps of the files of the keys and
+   * of the states of the optimizer it lists, 0 for none
+   */
+  uint64_t checkpoint_step_ = 0;
+  std::unordered_map<int, uint64_t> saved_steps_;
+  uint64_t optimizer_states_step_ = 0;
 
   Executor exec_;
+  /**
+   * \brief handles the requests, the threads are stopped before the state above is destroyed
+   */
+  ShardedExecutor handlers_;
   ps::KVServer<char>* ps_server_;
 
   // whether to LOG verbose information
@@ -0,0 +1,298 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * Copyright (c) 2019 by Contributors
+ * @file   ring_comm.h
+ * @brief  ring allreduce over TCP sockets
+ */
+#ifndef MXNET_KVSTORE_RING_COMM_H_
+#define MXNET_KVSTORE_RING_COMM_H_
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <dmlc/logging.h>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace mxnet {
+namespace kvstore {
+
+/**
+ * \brief a ring of processes, each connected to the next one by a TCP socket.
+ *
+ * A sum allreduce of n values is a reduce-scatter followed by an allgather,
+ * each taking size - 1 steps in which every member sends n / size values to
+ * the next member while receiving n / size values from the previous one.
+ * Every member thus sends 2 * (size - 1) / size * n values, independent of
+ * the number of members.
+ */
+class RingComm {
+ public:
+  RingComm() {}
+
+  ~RingComm() {
+    Close();
+  }
+
+  /**
+   * \brief start listening on an ephemeral port of all interfaces
+   * \return the port, which the previous member of the ring connects to
+   */
+  int Listen() {
+    listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    CHECK_GE(listen_fd_, 0) << "socket() failed: " << strerror(errno);
+    int one = 1;
+    setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = 0;
+    CHECK_EQ(bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)), 0)
+      << "bind() failed: " << strerror(errno);
+    CHECK_EQ(listen(listen_fd_, 4), 0) << "listen() failed: " << strerror(errno);
+    socklen_t len = sizeof(addr);
+    CHECK_EQ(getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &len), 0);
+    return ntohs(addr.sin_port);
+  }
+
+  /**
+   * \brief join the ring, must be called after Listen() by all members
+   * \param rank position of this process in the ring
+   * \param size number of members
+   * \param next_host host of member (rank + 1) % size
+   * \param next_port port returned by Listen() on that member
+   */
+  void Connect(int rank, int size, const std::string& next_host, int next_port) {
+    CHECK_GE(rank, 0);
+    CHECK_LT(rank, size);
+    rank_ = rank;
+    size_ = size;
+    if (size_ == 1) return;
+    send_fd_ = ConnectTo(next_host, next_port);
+    recv_fd_ = accept(listen_fd_, nullptr, nullptr);
+    CHECK_GE(recv_fd_, 0) << "accept() failed: " << strerror(errno);
+    SetSocketOptions(recv_fd_);
+  }
+
+  /** \brief close all sockets */
+  void Close() {
+    for (int *fd : {&listen_fd_, &send_fd_, &recv_fd_}) {
+      if (*fd >= 0) close(*fd);
+      *fd = -1;
+    }
+  }
+
+  int rank() const { return rank_; }
+
+  int size() const { return size_; }
+
+  /** \brief first element of chunk idx when n elements are split over the ring */
+  size_t ChunkBegin(size_t n, int idx) const {
+    return n * idx / size_;
+  }
+
+  /** \brief the chunk this member holds the result of after ReduceScatter */
+  int OwnedChunk() const {
+    return (rank_ + 1) % size_;
+  }
+
+  /** \brief sum n elements of data over all members, in place */
+  template<typename DType>
+  void AllReduce(DType* data, size_t n) {
+    ReduceScatter(data, n);
+    AllGather(data, n);
+  }
+
+  /**
+   * \brief afterwards chunk OwnedChunk() of data is the sum over all members,
+   * the other chunks hold partial sums
+   */
+  template<typename DType>
+  void ReduceScatter(DType* data, size_t n) {
+    for (int s = 0; s + 1 < size_; ++s) {
+      const int send_idx = (rank_ - s + size_) % size_;
+      const int recv_idx = (rank_ - s - 1 + 2 * size_) % size_;
+      DType* recv = data + ChunkBegin(n, recv_idx);
+      const size_t recv_len = ChunkBegin(n, recv_idx + 1) - ChunkBegin(n, recv_idx);
+      recv_buf_.resize(recv_len * sizeof(DType));
+      SendRecv(reinterpret_cast<const char*>(data + ChunkBegin(n, send_idx)),
+               (ChunkBegin(n, send_idx + 1) - ChunkBegin(n, send_idx)) * sizeof(DType),
+               recv_buf_.data(), recv_len * sizeof(DType));
+      const DType* partial = reinterpret_cast<const DType*>(recv_buf_.data());
+      for (size_t i = 0; i < recv_len; ++i) {
+        recv[i] += partial[i];
+      }
+    }
+  }
+
+  /**
+   * \brief distributes chunk OwnedChunk() of every member to all members,
+   * the inverse of the communication pattern of ReduceScatter
+   */
+  template<typename DType>
+  void AllGather(DType* data, size_t n) {
+    for (int s = 0; s + 1 < size_; ++s) {
+      const int send_idx = (rank_ + 1 - s + size_) % size_;
+      const int recv_idx = (rank_ - s + size_) % size_;
+      SendRecv(reinterpret_cast<const char*>(data + ChunkBegin(n, send_idx)),
+               (ChunkBegin(n, send_idx + 1) - ChunkBegin(n, send_idx)) * sizeof(DType),
+               reinterpret_cast<char*>(data + ChunkBegin(n, recv_idx)),
+               (ChunkBegin(n, recv_idx + 1) - ChunkBegin(n, recv_idx)) * sizeof(DType));
+    }
+  }
+
+ private:
+  static void SetSocketOptions(int fd) {
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+#ifdef SO_NOSIGPIPE
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+    const int flags = fcntl(fd, F_GETFL, 0);
+    CHECK_EQ(fcntl(fd, F_SETFL, flags | O_NONBLOCK), 0);
+  }
+
+  static int ConnectTo(const std::string& host, int port) {
+    addrinfo hints, *res = nullptr;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    const int err = getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &res);
+    CHECK_EQ(err, 0) << "cannot resolve " << host << ": " << gai_strerror(err);
+    // the peer listens before publishing its port, retry only for transient errors
+    int fd = -1;
+    for (int retry = 0; retry < 50; ++retry) {
+      fd = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+      CHECK_GE(fd, 0) << "socket() failed: " << strerror(errno);
+      if (connect(fd, res->ai_addr, res->ai_addrlen) == 0) break;
+      close(fd);
+      fd = -1;
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    freeaddrinfo(res);
+    CHECK_GE(fd, 0) << "cannot connect to " << host << ":" << port << ": " << strerror(errno);
+    SetSocketOptions(fd);
+    return fd;
+  }
+
+  /** \brief send sbytes to the next member while receiving rbytes from the previous one */
+  void SendRecv(const char* sbuf, size_t sbytes, char* rbuf, size_t rbytes) {
+#ifdef MSG_NOSIGNAL
+    const int send_flags = MSG_NOSIGNAL;
+#else
+    const int send_flags = 0;
+#endif
+    size_t sent = 0, recvd = 0;
+    while (sent < sbytes || recvd < rbytes) {
+      pollfd fds[2];
+      int nfds = 0, si = -1, ri = -1;
+      if (sent < sbytes) {
+        fds[nfds].fd = send_fd_;
+        fds[nfds].events = POLLOUT;
+        si = nfds++;
+      }
+      if (recvd < rbytes) {
+        fds[nfds].fd = recv_fd_;
+        fds[nfds].events = POLLIN;
+        ri = nfds++;
+      }
+      if (poll(fds, nfds, -1) < 0) {
+        CHECK_EQ(errno, EINTR) << "poll() failed: " << strerror(errno);
+        continue;
+      }
+      if (si >= 0 && fds[si].revents != 0) {
+        const ssize_t k = send(send_fd_, sbuf + sent, sbytes - sent, send_flags);
+        if (k >= 0) {
+          sent += k;
+        } else {
+          CHECK(errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+            << "send() to the next ring member failed: " << strerror(errno);
+        }
+      }
+      if (ri >= 0 && fds[ri].revents != 0) {
+        const ssize_t k = recv(recv_fd_, rbuf + recvd, rbytes - recvd, 0);
+        CHECK_NE(k, 0) << "the previous ring member closed the connection";
+        if (k > 0) {
+          recvd += k;
+        } else {
+          CHECK(errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+            << "recv() from the previous ring member failed: " << strerror(errno);
+        }
+      }
+    }
+  }
+
+  int rank_ = 0;
+  int size_ = 1;
+  int listen_fd_ = -1;
+  /** \brief connection to the next member */
+  int send_fd_ = -1;
+  /** \brief connection from the previous member */
+  int recv_fd_ = -1;
+  /** \brief partial sums received during ReduceScatter */
+  std::vector<char> recv_buf_;
+};
+
+/**
+ * \brief two level allreduce for several processes per host, e.g. one per socket.
+ *
+ * The processes of a host reduce-scatter over a ring through the loopback
+ * interface, then every process allreduces its chunk with the processes
+ * at the same position on the other hosts, and finally the host ring
+ * allgathers the chunks. Only 1 / (processes per host) of the data crosses
+ * the network from each process.
+ */
+class HierarchicalRingComm {
+ public:
+  /**
+   * \param local ring of the processes on this host
+   * \param cross ring of the processes with the same local rank on all hosts
+   */
+  HierarchicalRingComm(RingComm* local, RingComm* cross)
+    : local_(local), cross_(cross) {}
+
+  template<typename DType>
+  void AllReduce(DType* data, size_t n) {
+    local_->ReduceScatter(data, n);
+    const int chunk = local_->OwnedChunk();
+    const size_t begin = local_->ChunkBegin(n, chunk);
+    cross_->AllReduce(data + begin, local_->ChunkBegin(n, chunk + 1) - begin);
+    local_->AllGather(data, n);
+  }
+
+ private:
+  RingComm* local_;
+  RingComm* cross_;
+};
+
+}  // namespace kvstore
+}  // namespace mxnet
+#endif  // MXNET_KVSTORE_RING_COMM_H_
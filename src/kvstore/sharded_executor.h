@@ -0,0 +1,230 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * Copyright (c) 2019 by Contributors
+ * @file   sharded_executor.h
+ * @brief  threads handling the requests of a server by key
+ */
+#ifndef MXNET_KVSTORE_SHARDED_EXECUTOR_H_
+#define MXNET_KVSTORE_SHARDED_EXECUTOR_H_
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace mxnet {
+namespace kvstore {
+
+/**
+ * \brief runs the functions of the same shard in order on one of several threads
+ */
+class ShardedExecutor {
+ public:
+  typedef std::function<void()> Func;
+
+  /**
+   * \param num_threads number of threads, 0 runs every function on the calling thread
+   */
+  explicit ShardedExecutor(int num_threads) : queues_(num_threads) {
+    for (int i = 0; i < num_threads; ++i) {
+      threads_.emplace_back([this, i]() { Run(i); });
+    }
+  }
+
+  ~ShardedExecutor() {
+    {
+      std::lock_guard<std::mutex> lk(mu_);
+      stop_ = true;
+    }
+    cond_.notify_all();
+    for (auto& thread : threads_) thread.join();
+  }
+
+  /**
+   * \brief run a function after the functions queued before with the same shard
+   */
+  void Exec(size_t shard, const Func& func) {
+    std::lock_guard<std::mutex> exclusive(exclusive_mu_);
+    if (threads_.empty()) {
+      func();
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lk(mu_);
+      queues_[shard % queues_.size()].push(func);
+      ++pending_;
+    }
+    cond_.notify_all();
+  }
+
+  /**
+   * \brief run a function of the shards after the functions queued before with
+   * any of them, while no function of them runs. called from the functions run
+   * by the executor, including the exclusive ones, which queue it to run later
+   */
+  void Post(const std::vector<size_t>& shards, const Func& func) {
+    if (threads_.empty()) {
+      func();
+      return;
+    }
+    std::vector<size_t> queues;
+    for (size_t shard : shards) queues.push_back(shard % queues_.size());
+    std::sort(queues.begin(), queues.end());
+    queues.erase(std::unique(queues.begin(), queues.end()), queues.end());
+    {
+      std::lock_guard<std::mutex> lk(mu_);
+      if (queues.size() == 1) {
+        queues_[queues[0]].push(func);
+        ++pending_;
+      } else {
+        // the threads of the queues wait for each other, and the last one runs func.
+        // the parts are queued at once, in the same order as those of other functions
+        auto barrier = std::make_shared<Barrier>(queues.size());
+        for (size_t idx : queues) {
+          queues_[idx].push([barrier, func]() { barrier->Arrive(func); });
+          ++pending_;
+        }
+      }
+    }
+    cond_.notify_all();
+  }
+
+  /**
+   * \brief run a function on the calling thread once all queued functions are done,
+   * and before the ones queued afterwards. can be called from any thread but those
+   * of the executor
+   */
+  void ExecExclusive(const Func& func) {
+    std::lock_guard<std::mutex> exclusive(exclusive_mu_);
+    {
+      std::unique_lock<std::mutex> lk(mu_);
+      idle_cond_.wait(lk, [this]() { return pending_ == 0; });
+      exclusive_ = true;
+    }
+    try {
+      func();
+    } catch (...) {
+      EndExclusive();
+      throw;
+    }
+    EndExclusive();
+  }
+
+  /**
+   * \brief block until all queued functions are done
+   */
+  void WaitAll() {
+    std::unique_lock<std::mutex> lk(mu_);
+    idle_cond_.wait(lk, [this]() { return pending_ == 0; });
+  }
+
+ private:
+  /** \brief the part of a function of several shards queued on each of their threads */
+  class Barrier {
+   public:
+    explicit Barrier(size_t count) : count_(count) {}
+
+    void Arrive(const Func& func) {
+      std::unique_lock<std::mutex> lk(mu_);
+      if (--count_ == 0) {
+        func();
+        done_ = true;
+        cond_.notify_all();
+      } else {
+        cond_.wait(lk, [this]() { return done_; });
+      }
+    }
+
+   private:
+    size_t count_;
+    bool done_ = false;
+    std::mutex mu_;
+    std::condition_variable cond_;
+  };
+
+  void EndExclusive() {
+    {
+      std::lock_guard<std::mutex> lk(mu_);
+      exclusive_ = false;
+    }
+    cond_.notify_all();
+  }
+
+  void Run(size_t idx) {
+    std::unique_lock<std::mutex> lk(mu_);
+    while (true) {
+      cond_.wait(lk, [this, idx]() {
+        return stop_ || (!exclusive_ && !queues_[idx].empty());
+      });
+      if (queues_[idx].empty()) break;
+      Func func = std::move(queues_[idx].front());
+      queues_[idx].pop();
+      lk.unlock();
+      func();
+      lk.lock();
+      if (--pending_ == 0) idle_cond_.notify_all();
+    }
+  }
+
+  std::vector<std::queue<Func>> queues_;
+  std::vector<std::thread> threads_;
+  size_t pending_ = 0;
+  bool stop_ = false;
+  // set while an exclusive function runs, which the functions it posts wait for
+  bool exclusive_ = false;
+  std::mutex mu_;
+  std::condition_variable cond_;
+  std::condition_variable idle_cond_;
+  // held while functions are queued, and while an exclusive function runs
+  std::mutex exclusive_mu_;
+};
+
+/**
+ * \brief a map from the keys to their state, to which the threads of a
+ * ShardedExecutor can add entries concurrently. References to the values
+ * stay valid.
+ */
+template<typename V>
+class KeyMap {
+ public:
+  typedef typename std::unordered_map<int, V>::iterator iterator;
+
+  V& operator[](int key) {
+    std::lock_guard<std::mutex> lk(mu_);
+    return map_[key];
+  }
+
+  /** \brief iteration is not thread safe, only iterate while no requests are handled */
+  iterator begin() { return map_.begin(); }
+  iterator end() { return map_.end(); }
+
+ private:
+  std::unordered_map<int, V> map_;
+  std::mutex mu_;
+};
+
+}  // namespace kvstore
+}  // namespace mxnet
+#endif  // MXNET_KVSTORE_SHARDED_EXECUTOR_H_
@@ -24,11 +24,47 @@
  */
 
 #include "mxnet/mxfeatures.h"
+#include <dmlc/parameter.h>
+#include <algorithm>
 #include <bitset>
+#include <string>
 
 namespace mxnet {
 namespace features {
 
+/*!
+ * \brief the widest instruction set of the cpu kernels which the cpu and the os support, at
+ *  most the one named by MXNET_CPU_ISA
+ */
+static CpuIsa DetectCpuIsa() {
+#if MXNET_USE_ISA_DISPATCH
+  // the cpu model is not yet known in the constructors of static objects
+  __builtin_cpu_init();
+  CpuIsa isa = kIsaGeneric;
+  if (__builtin_cpu_supports("sse4.2")) isa = kIsaSSE42;
+  if (isa == kIsaSSE42 && __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+    isa = kIsaAVX2;
+  }
+  if (isa == kIsaAVX2 && __builtin_cpu_supports("avx512f")) isa = kIsaAVX512;
+  const std::string cap = dmlc::GetEnv("MXNET_CPU_ISA", std::string());
+  if (cap.empty()) return isa;
+  const char* names[] = {"generic", "sse4.2", "avx2", "avx512"};
+  for (int i = kIsaGeneric; i <= kIsaAVX512; ++i) {
+    if (cap == names[i]) return std::min(isa, static_cast<CpuIsa>(i));
+  }
+  LOG(WARNING) << "Unknown MXNET_CPU_ISA " << cap
+               << ", expected one of generic, sse4.2, avx2 and avx512";
+  return isa;
+#else
+  return kIsaGeneric;
+#endif
+}
+
+CpuIsa cpu_kernel_isa() {
+  static const CpuIsa isa = DetectCpuIsa();
+  return isa;
+}
+
 class FeatureSet {
  public:
   FeatureSet() :
@@ -65,6 +101,15 @@ class FeatureSet {
 #if __AVX2__
     feature_bits.set(CPU_AVX2);
 #endif
+#if __AVX512F__
+    feature_bits.set(CPU_AVX512F);
+#endif
+
+    // Instruction set of the hot cpu kernels, selected at runtime
+    feature_bits.set(ISA_DISPATCH, MXNET_USE_ISA_DISPATCH);
+    feature_bits.set(KERNEL_SSE4_2, cpu_kernel_isa() == kIsaSSE42);
+    feature_bits.set(KERNEL_AVX2, cpu_kernel_isa() == kIsaAVX2);
+    feature_bits.set(KERNEL_AVX512, cpu_kernel_isa() == kIsaAVX512);
 
     // CPU
     feature_bits.set(OPENMP, MXNET_USE_OPENMP);
@@ -485,6 +485,74 @@ struct op_with_req {
   }
 };
 
+#if MXNET_USE_ISA_DISPATCH
+/*!
+ * \brief F::Run compiled for the instruction set isa. F::Run is always inlined, so that it
+ *  and the OP::Map it calls are compiled with the target attribute of the caller.
+ */
+template<int isa>
+struct isa_call;
+
+#define MXNET_ISA_CALL(isa, arch)                \
+  template<>                                     \
+  struct isa_call<isa> {                         \
+    template<typename F, typename ...Args>       \
+    __attribute__((target(arch)))                \
+    static void Run(Args... args) {              \
+      F::Run(args...);                           \
+    }                                            \
+  };
+
+MXNET_ISA_CALL(features::kIsaSSE42, "sse4.2")
+MXNET_ISA_CALL(features::kIsaAVX2, "avx2,fma")
+MXNET_ISA_CALL(features::kIsaAVX512, "avx512f,avx2,fma")
+#undef MXNET_ISA_CALL
+#endif  // MXNET_USE_ISA_DISPATCH
+
+/*!
+ * \brief calls F::Run(args...) built for the instruction set of features::cpu_kernel_isa, which
+ *  is the baseline of the build without MXNET_USE_ISA_DISPATCH
+ */
+template<typename F, typename ...Args>
+inline void IsaDispatch(Args... args) {
+#if MXNET_USE_ISA_DISPATCH
+  switch (features::cpu_kernel_isa()) {
+    case features::kIsaAVX512:
+      isa_call<features::kIsaAVX512>::template Run<F>(args...);
+      return;
+    case features::kIsaAVX2:
+      isa_call<features::kIsaAVX2>::template Run<F>(args...);
+      return;
+    case features::kIsaSSE42:
+      isa_call<features::kIsaSSE42>::template Run<F>(args...);
+      return;
+    default:
+      break;
+  }
+#endif  // MXNET_USE_ISA_DISPATCH
+  F::Run(args...);
+}
+
+/*! \brief OP::Map(i, args...) for i in [begin, end) */
+template<typename OP>
+struct map_range {
+  template<typename ...Args>
+  MSHADOW_CINLINE static void Run(const size_t begin, const size_t end, Args... args) {
+    for (size_t i = begin; i < end; ++i) {
+      OP::Map(i, args...);
+    }
+  }
+};
+
+/*! \brief OP::Map(base, length, args...) of the kernels which iterate over a block themselves */
+template<typename OP>
+struct map_block {
+  template<typename ...Args>
+  MSHADOW_CINLINE static void Run(const size_t base, const size_t length, Args... args) {
+    OP::Map(base, length, args...);
+  }
+};
+
 template<typename OP, typename xpu>
 struct Kernel;
 
@@ -572,19 +640,17 @@ struct Kernel<OP, cpu> {
     const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
     if (omp_threads < 2 || !tuned_op<PRIMITIVE_OP, DType>::UseOMP(
       N, static_cast<size_t>(omp_threads))) {
-      for (size_t i = 0; i < N; ++i) {
-        OP::Map(i, args...);
-      }
+      IsaDispatch<map_range<OP>>(size_t(0), N, args...);
     } else {
+      // a contiguous range for each thread, as the static schedule, in one call of the
+      // instruction set of the cpu
       #pragma omp parallel for num_threads(omp_threads)
-      for (index_t i = 0; i < static_cast<index_t>(N); ++i) {
-        OP::Map(i, args...);
+      for (int t = 0; t < omp_threads; ++t) {
+        IsaDispatch<map_range<OP>>(N * t / omp_threads, N * (t + 1) / omp_threads, args...);
       }
     }
 #else
-    for (size_t i = 0; i < N; ++i) {
-      OP::Map(i, args...);
-    }
+    IsaDispatch<map_range<OP>>(size_t(0), N, args...);
 #endif
   }
 
@@ -600,16 +666,17 @@ struct Kernel<OP, cpu> {
 #ifdef _OPENMP
     const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
     if (omp_threads < 2) {
-      OP::Map(0, N, args...);
+      IsaDispatch<map_block<OP>>(size_t(0), N, args...);
     } else {
       const auto length = (N + omp_threads - 1) / omp_threads;
       #pragma omp parallel for num_threads(omp_threads)
       for (index_t i = 0; i < static_cast<index_t>(N); i += length) {
-        OP::Map(i, i + length > N ? N - i : length, args...);
+        IsaDispatch<map_block<OP>>(static_cast<size_t>(i), i + length > N ? N - i : length,
+                                   args...);
       }
     }
 #else
-    OP::Map(0, N, args...);
+    IsaDispatch<map_block<OP>>(size_t(0), N, args...);
 #endif
   }
 
@@ -36,13 +36,16 @@
 #include <dmlc/logging.h>
 #include <dmlc/optional.h>
 #include <algorithm>
+#include <chrono>
 #include <map>
 #include <vector>
 #include <string>
+#include <type_traits>
 #include <utility>
 #include "../operator_common.h"
 #include "../linalg.h"
 #include "./im2col.h"
+#include "./convolution_cpu-inl.h"
 
 
 namespace mxnet {
@@ -204,33 +207,8 @@ class ConvolutionOp {
           linalg_gemm(weight_3d[g], input_3d[g], output_3d[g], false, false, s, req[conv::kOut]);
         }
       }
-    } else {
-      // allocate workspace for col_buffer
-      Tensor<xpu, 1, DType> workspace = ctx.requested[conv::kTempSpace]
-        .get_space_typed<xpu, 1, DType>(Shape1(col_buffer_size_), s);
-      // calculate the shape of col_buffer
-      TShape col_buffer_shape(num_spatial_axes_ + 1);
-      col_buffer_shape[0] = conv_in_channels_ * param_.kernel.Size();
-      for (index_t i = 1; i < col_buffer_shape.ndim(); ++i) {
-        col_buffer_shape[i] = out_data[0].shape_[i+1];
-      }
-      // create a column buffer using workspace and col_buffer_shape
-      TBlob col_buffer(workspace.dptr_, col_buffer_shape, xpu::kDevMask, DataType<DType>::kFlag);
-      Tensor<xpu, 3, DType> col_buffer_3d = col_buffer.get_with_shape<xpu, 3, DType>(
-        Shape3(group_, K, N), s);
-      for (index_t n = 0; n < num_; ++n) {
-        // transform image to col_buffer in order to use gemm
-        im2col(s, in_data[conv::kData].dptr<DType>()+n*input_dim_, in_data[conv::kData].shape_,
-               col_buffer.shape_, param_.kernel, param_.pad, param_.stride, param_.dilate,
-               col_buffer.dptr<DType>());
-        Tensor<xpu, 3, DType> output_3d = output_4d[n];
-        for (index_t g = 0; g < group_; ++g) {
-          // Legacy approach shown here for comparison:
-          //   Assign(output_3d[g], req[conv::kOut], dot(weight_3d[g], col_buffer_3d[g]));
-          linalg_gemm(weight_3d[g], col_buffer_3d[g], output_3d[g], false, false, s,
-            req[conv::kOut]);
-        }
-      }
+    } else if (!ForwardCPUAlgo(ctx, s, in_data, out_data)) {
+      ForwardIm2col(ctx, in_data, out_data, 1);
     }
 
     if (bias_term_) {
@@ -290,7 +268,7 @@ class ConvolutionOp {
           linalg_gemm(out_grad_3d[g], input_3d[g], dweight_3d[g], false, true, s, request);
         }
       }
-    } else {
+    } else if (!BackwardCPUAlgo(s, out_grad, in_data, req, in_grad)) {
       // allocate workspace for col_buffer
       Tensor<xpu, 1, DType> workspace = ctx.requested[conv::kTempSpace]
         .get_space_typed<xpu, 1, DType>(Shape1(col_buffer_size_), s);
@@ -339,6 +317,250 @@ class ConvolutionOp {
   }
 
  private:
+  /*!
+   * \brief im2col and gemm, for batch images at once. The im2col of the images of a batch
+   *  run in parallel on cpu, into one col_buffer each.
+   */
+  void ForwardIm2col(const OpContext &ctx,
+                     const std::vector<TBlob> &in_data,
+                     const std::vector<TBlob> &out_data,
+                     const index_t batch) {
+    using namespace mshadow;
+    Stream<xpu>* s = ctx.get_stream<xpu>();
+    index_t M = conv_out_channels_ / group_;
+    index_t N = conv_out_spatial_dim_;
+    index_t K = kernel_dim_;
+    Tensor<xpu, 3, DType> weight_3d = in_data[conv::kWeight].get_with_shape<xpu, 3, DType>(
+      Shape3(group_, M, K), s);
+    Tensor<xpu, 4, DType> output_4d = out_data[conv::kOut].get_with_shape<xpu, 4, DType>(
+      Shape4(num_, group_, M, N), s);
+    // allocate workspace for col_buffer
+    Tensor<xpu, 1, DType> workspace = ctx.requested[conv::kTempSpace]
+      .get_space_typed<xpu, 1, DType>(Shape1(col_buffer_size_ * batch), s);
+    // calculate the shape of col_buffer
+    TShape col_buffer_shape(num_spatial_axes_ + 1);
+    col_buffer_shape[0] = conv_in_channels_ * param_.kernel.Size();
+    for (index_t i = 1; i < col_buffer_shape.ndim(); ++i) {
+      col_buffer_shape[i] = out_data[0].shape_[i+1];
+    }
+    const int omp_threads = batch > 1 ?
+      engine::OpenMP::Get()->GetRecommendedOMPThreadCount() : 1;
+    for (index_t n0 = 0; n0 < num_; n0 += batch) {
+      const index_t images = std::min(batch, num_ - n0);
+      // transform images to col_buffer in order to use gemm
+      #pragma omp parallel for num_threads(omp_threads) if (images > 1)
+      for (index_t b = 0; b < images; ++b) {
+        im2col(s, in_data[conv::kData].dptr<DType>() + (n0 + b) * input_dim_,
+               in_data[conv::kData].shape_, col_buffer_shape, param_.kernel, param_.pad,
+               param_.stride, param_.dilate, workspace.dptr_ + b * col_buffer_size_);
+      }
+      for (index_t b = 0; b < images; ++b) {
+        // create a column buffer using workspace and col_buffer_shape
+        TBlob col_buffer(workspace.dptr_ + b * col_buffer_size_, col_buffer_shape,
+                         xpu::kDevMask, DataType<DType>::kFlag);
+        Tensor<xpu, 3, DType> col_buffer_3d = col_buffer.get_with_shape<xpu, 3, DType>(
+          Shape3(group_, K, N), s);
+        Tensor<xpu, 3, DType> output_3d = output_4d[n0 + b];
+        for (index_t g = 0; g < group_; ++g) {
+          // Legacy approach shown here for comparison:
+          //   Assign(output_3d[g], req[conv::kOut], dot(weight_3d[g], col_buffer_3d[g]));
+          linalg_gemm(weight_3d[g], col_buffer_3d[g], output_3d[g], false, false, s, kWriteTo);
+        }
+      }
+    }
+  }
+
+  /*! \brief Winograd F(2x2, 3x3) on cpu, for as many images at once as the workspace holds */
+  void ForwardWinograd(const OpContext &ctx,
+                       const std::vector<TBlob> &in_data,
+                       const std::vector<TBlob> &out_data) {
+    using namespace mshadow;
+    Stream<cpu>* s = ctx.get_stream<cpu>();
+    const TShape& ishape = in_data[conv::kData].shape_;
+    const TShape& oshape = out_data[conv::kOut].shape_;
+    const index_t C = channels_ / group_;
+    const index_t M = conv_out_channels_ / group_;
+    const index_t tiles_h = winograd::NumTiles(oshape[2]);
+    const index_t tiles_w = winograd::NumTiles(oshape[3]);
+    const index_t tiles = tiles_h * tiles_w;
+    // the transformed filters, and the transformed input and products of each image
+    const size_t filter_size = 16 * conv_out_channels_ * C;
+    const size_t image_size = 16 * (C + M) * tiles;
+    const index_t batch = std::min<index_t>(num_, std::max<size_t>(
+      1, (param_.workspace > filter_size ? param_.workspace - filter_size : 0) / image_size));
+    Tensor<cpu, 1, DType> workspace = ctx.requested[conv::kTempSpace]
+      .get_space_typed<cpu, 1, DType>(Shape1(filter_size + batch * image_size), s);
+    DType* u = workspace.dptr_;
+    DType* v = u + filter_size;
+    DType* prod = v + 16 * C * batch * tiles;
+    winograd::TransformFilters(in_data[conv::kWeight].dptr<DType>(), conv_out_channels_, C, u);
+    for (index_t n0 = 0; n0 < num_; n0 += batch) {
+      const index_t images = std::min(batch, num_ - n0);
+      const index_t P = images * tiles;
+      for (index_t g = 0; g < group_; ++g) {
+        winograd::TransformInput(in_data[conv::kData].dptr<DType>() + n0 * input_dim_
+                                 + g * C * ishape[2] * ishape[3],
+                                 images, C, input_dim_, ishape[2], ishape[3],
+                                 param_.pad[0], param_.pad[1], tiles_h, tiles_w, v);
+        for (index_t xi = 0; xi < 16; ++xi) {
+          linalg_gemm(Tensor<cpu, 2, DType>(u + (xi * conv_out_channels_ + g * M) * C,
+                                            Shape2(M, C)),
+                      Tensor<cpu, 2, DType>(v + xi * C * P, Shape2(C, P)),
+                      Tensor<cpu, 2, DType>(prod + xi * M * P, Shape2(M, P)),
+                      DType(1), DType(0), false, false, s);
+        }
+        winograd::TransformOutput(prod, images, M, output_dim_, oshape[2], oshape[3],
+                                  tiles_h, tiles_w,
+                                  out_data[conv::kOut].dptr<DType>() + n0 * output_dim_
+                                  + g * M * conv_out_spatial_dim_);
+      }
+    }
+  }
+
+  /*! \brief runs algo on cpu */
+  void ForwardCPU(int algo,
+                  const OpContext &ctx,
+                  const std::vector<TBlob> &in_data,
+                  const std::vector<TBlob> &out_data) {
+    switch (algo) {
+      case conv::kIm2col:
+        ForwardIm2col(ctx, in_data, out_data, 1);
+        break;
+      case conv::kIm2colBatch:
+        // as many images as the workspace holds
+        ForwardIm2col(ctx, in_data, out_data, std::min<index_t>(num_, std::max<index_t>(
+          1, param_.workspace / col_buffer_size_)));
+        break;
+      case conv::kWinograd:
+        ForwardWinograd(ctx, in_data, out_data);
+        break;
+      case conv::kDepthwise:
+        depthwise::Forward(DepthwiseShape(in_data[conv::kData].shape_,
+                                          out_data[conv::kOut].shape_),
+                           in_data[conv::kData].dptr<DType>(),
+                           in_data[conv::kWeight].dptr<DType>(),
+                           out_data[conv::kOut].dptr<DType>());
+        break;
+      default:
+        LOG(FATAL) << "Unknown cpu convolution algorithm " << algo;
+    }
+  }
+
+  /*!
+   * \brief the cpu algorithms which can compute this convolution. With
+   *  MXNET_CPU_CONV_AUTOTUNE=1, the first forward of a convolution times them. Otherwise
+   *  Winograd is used when possible for at least 16 channels and filters per group, and im2col
+   *  in parallel for more than one image. Depthwise convolutions always use their direct kernel.
+   */
+  int SelectCPUAlgo(const OpContext &ctx,
+                    const std::vector<TBlob> &in_data,
+                    const std::vector<TBlob> &out_data) {
+    if (IsDepthwise()) return conv::kDepthwise;
+    std::vector<int> algos{conv::kIm2col};
+    if (num_ > 1) algos.push_back(conv::kIm2colBatch);
+    const bool winograd = (std::is_same<DType, float>::value ||
+                           std::is_same<DType, double>::value) &&
+      num_spatial_axes_ == 2 && param_.kernel[0] == 3 && param_.kernel[1] == 3 &&
+      param_.stride[0] == 1 && param_.stride[1] == 1 &&
+      param_.dilate[0] == 1 && param_.dilate[1] == 1;
+    if (winograd) algos.push_back(conv::kWinograd);
+    if (algos.size() == 1) return conv::kIm2col;
+    static const bool autotune = dmlc::GetEnv("MXNET_CPU_CONV_AUTOTUNE", true);
+    return CPUConvAlgoReg<ConvolutionParam>::Get()->FindOrElseRegister(
+      param_, in_data[conv::kData].shape_, in_data[conv::kWeight].shape_,
+      mshadow::DataType<DType>::kFlag, [&]() {
+        if (!autotune) {
+          if (winograd && channels_ / group_ >= 16 && conv_out_channels_ / group_ >= 16) {
+            return static_cast<int>(conv::kWinograd);
+          }
+          return static_cast<int>(num_ > 1 ? conv::kIm2colBatch : conv::kIm2col);
+        }
+        // the second run of each algorithm is timed, the first one warms up its workspace
+        int best = conv::kIm2col;
+        double best_time = 0;
+        for (int algo : algos) {
+          ForwardCPU(algo, ctx, in_data, out_data);
+          const auto start = std::chrono::steady_clock::now();
+          ForwardCPU(algo, ctx, in_data, out_data);
+          const double time = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count();
+          if (algo == algos[0] || time < best_time) {
+            best = algo;
+            best_time = time;
+          }
+        }
+        return best;
+      });
+  }
+
+  /*! \brief forward with the selected cpu algorithm, returns false to use im2col and gemm */
+  bool ForwardCPUAlgo(const OpContext &ctx,
+                      mshadow::Stream<cpu> *s,
+                      const std::vector<TBlob> &in_data,
+                      const std::vector<TBlob> &out_data) {
+    const int algo = SelectCPUAlgo(ctx, in_data, out_data);
+    if (algo == conv::kIm2col) return false;
+    ForwardCPU(algo, ctx, in_data, out_data);
+    return true;
+  }
+
+  bool ForwardCPUAlgo(const OpContext &ctx,
+                      mshadow::Stream<gpu> *s,
+                      const std::vector<TBlob> &in_data,
+                      const std::vector<TBlob> &out_data) {
+    return false;
+  }
+
+  /*! \brief backward of the depthwise kernel, returns false to use im2col and gemm */
+  bool BackwardCPUAlgo(mshadow::Stream<cpu> *s,
+                       const std::vector<TBlob> &out_grad,
+                       const std::vector<TBlob> &in_data,
+                       const std::vector<OpReqType> &req,
+                       const std::vector<TBlob> &in_grad) {
+    if (!IsDepthwise()) return false;
+    const depthwise::Shape shape = DepthwiseShape(in_data[conv::kData].shape_,
+                                                  out_grad[conv::kOut].shape_);
+    depthwise::BackwardData(shape, out_grad[conv::kOut].dptr<DType>(),
+                            in_data[conv::kWeight].dptr<DType>(), req[conv::kData],
+                            in_grad[conv::kData].dptr<DType>());
+    depthwise::BackwardWeight(shape, out_grad[conv::kOut].dptr<DType>(),
+                              in_data[conv::kData].dptr<DType>(), req[conv::kWeight],
+                              in_grad[conv::kWeight].dptr<DType>());
+    return true;
+  }
+
+  bool BackwardCPUAlgo(mshadow::Stream<gpu> *s,
+                       const std::vector<TBlob> &out_grad,
+                       const std::vector<TBlob> &in_data,
+                       const std::vector<OpReqType> &req,
+                       const std::vector<TBlob> &in_grad) {
+    return false;
+  }
+
+  /*! \brief 2D convolution with one group per channel and one filter per group */
+  bool IsDepthwise() const {
+    return num_spatial_axes_ == 2 && group_ == channels_ && conv_out_channels_ == channels_;
+  }
+
+  depthwise::Shape DepthwiseShape(const TShape& ishape, const TShape& oshape) const {
+    depthwise::Shape shape;
+    shape.num = num_;
+    shape.channels = channels_;
+    shape.height = ishape[2];
+    shape.width = ishape[3];
+    shape.out_h = oshape[2];
+    shape.out_w = oshape[3];
+    shape.kernel_h = param_.kernel[0];
+    shape.kernel_w = param_.kernel[1];
+    shape.stride_h = param_.stride[0];
+    shape.stride_w = param_.stride[1];
+    shape.pad_h = param_.pad[0];
+    shape.pad_w = param_.pad[1];
+    shape.dilate_h = param_.dilate[0];
+    shape.dilate_w = param_.dilate[1];
+    return shape;
+  }
+
   void LayerSetUp(const TShape& ishape, const TShape& oshape) {
     channel_axis_ = 1;  // hard code channel axis
     const index_t first_spatial_axis = channel_axis_ + 1;
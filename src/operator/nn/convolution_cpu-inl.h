@@ -0,0 +1,390 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * Copyright (c) 2019 by Contributors
+ * \file convolution_cpu-inl.h
+ * \brief cpu algorithms of the convolution forward, besides im2col and gemm for every image,
+ *  and the registry of the algorithm picked for each convolution
+ */
+#ifndef MXNET_OPERATOR_NN_CONVOLUTION_CPU_INL_H_
+#define MXNET_OPERATOR_NN_CONVOLUTION_CPU_INL_H_
+
+#include <dmlc/logging.h>
+#include <dmlc/parameter.h>
+#include <mxnet/base.h>
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include "../../engine/openmp.h"
+
+namespace mxnet {
+namespace op {
+
+namespace conv {
+/*!
+ * \brief algorithms of the cpu convolution forward:
+ *  kIm2col: im2col and gemm for one image after the other
+ *  kIm2colBatch: im2col of several images in parallel, then their gemms
+ *  kWinograd: Winograd F(2x2, 3x3), for 2D 3x3 kernels with stride and dilation 1
+ *  kDepthwise: direct convolution of each channel with its filter, for 2D convolutions with
+ *    one group per channel and one filter per group
+ */
+enum ConvolutionCPUAlgo {kIm2col, kIm2colBatch, kWinograd, kDepthwise};
+}  // namespace conv
+
+/*!
+ * \brief the cpu forward algorithm picked for each convolution, by its parameters, the shapes
+ *  of its data and weight and its type. The first forward of a convolution calls algo_setter,
+ *  which may time the candidates, and the others reuse its choice.
+ */
+template<typename ParamType>
+class CPUConvAlgoReg {
+ public:
+  int FindOrElseRegister(const ParamType& param, const TShape& data_shape,
+                         const TShape& weight_shape, int dtype,
+                         const std::function<int()>& algo_setter) {
+    ParamKey key{param, data_shape, weight_shape, dtype};
+    std::lock_guard<std::mutex> guard(lock_);
+    auto i = reg_.find(key);
+    if (i != reg_.end()) return i->second;
+    const int algo = algo_setter();
+    reg_.emplace(key, algo);
+    return algo;
+  }
+
+  static CPUConvAlgoReg* Get() {
+    static CPUConvAlgoReg inst;
+    return &inst;
+  }
+
+ private:
+  struct ParamKey {
+    ParamType param;
+    TShape data_shape, weight_shape;
+    int dtype;
+
+    bool operator==(const ParamKey& other) const {
+      return this->param == other.param &&
+             this->data_shape == other.data_shape &&
+             this->weight_shape == other.weight_shape &&
+             this->dtype == other.dtype;
+    }
+  };
+
+  struct ParamHash {
+    size_t operator()(const ParamKey& key) const {
+      std::hash<ParamType> hash_param;
+      size_t ret = hash_param(key.param);
+      ret = dmlc::HashCombine(ret, key.data_shape);
+      ret = dmlc::HashCombine(ret, key.weight_shape);
+      ret = dmlc::HashCombine(ret, key.dtype);
+      return ret;
+    }
+  };
+
+  std::mutex lock_;
+  std::unordered_map<ParamKey, int, ParamHash> reg_;
+};
+
+/*!
+ * \brief Winograd F(2x2, 3x3) (Lavin and Gray, https://arxiv.org/abs/1509.09308). The output is
+ *  cut into tiles of 2x2, each computed from a 4x4 tile of the input as A^T [U * V] A, with the
+ *  transformed filter U = G g G^T and the transformed input tile V = B^T d B. The products of
+ *  the 16 elements of the tiles, summed over the channels, are 16 gemms.
+ */
+namespace winograd {
+
+/*! \brief number of tiles of 2 outputs along an axis of n outputs */
+inline index_t NumTiles(index_t n) {
+  return (n + 1) / 2;
+}
+
+/*!
+ * \brief transforms the filters of shape (num_filter, channels, 3, 3) into
+ *  U[16][num_filter][channels]
+ */
+template<typename DType>
+void TransformFilters(const DType* weight, const index_t num_filter, const index_t channels,
+                      DType* u) {
+  const index_t size = num_filter * channels;
+  const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  #pragma omp parallel for num_threads(omp_threads)
+  for (index_t mc = 0; mc < size; ++mc) {
+    const DType* g = weight + mc * 9;
+    DType gg[4][3];  // G g
+    for (int j = 0; j < 3; ++j) {
+      gg[0][j] = g[j];
+      gg[1][j] = (g[j] + g[3 + j] + g[6 + j]) / 2;
+      gg[2][j] = (g[j] - g[3 + j] + g[6 + j]) / 2;
+      gg[3][j] = g[6 + j];
+    }
+    for (int i = 0; i < 4; ++i) {
+      u[(i * 4) * size + mc] = gg[i][0];
+      u[(i * 4 + 1) * size + mc] = (gg[i][0] + gg[i][1] + gg[i][2]) / 2;
+      u[(i * 4 + 2) * size + mc] = (gg[i][0] - gg[i][1] + gg[i][2]) / 2;
+      u[(i * 4 + 3) * size + mc] = gg[i][2];
+    }
+  }
+}
+
+/*!
+ * \brief transforms the input tiles of num images into V[16][channels][num * tiles].
+ *  Channel c of image n starts at data + n * image_stride + c * height * width.
+ */
+template<typename DType>
+void TransformInput(const DType* data, const index_t num, const index_t channels,
+                    const index_t image_stride, const index_t height, const index_t width,
+                    const index_t pad_h, const index_t pad_w,
+                    const index_t tiles_h, const index_t tiles_w, DType* v) {
+  const index_t tiles = tiles_h * tiles_w;
+  const index_t p_size = num * tiles;
+  const index_t v_stride = channels * p_size;
+  const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  #pragma omp parallel for num_threads(omp_threads)
+  for (index_t nc = 0; nc < num * channels; ++nc) {
+    const index_t n = nc / channels, c = nc % channels;
+    const DType* im = data + n * image_stride + c * height * width;
+    DType* vc = v + c * p_size + n * tiles;
+    for (index_t th = 0; th < tiles_h; ++th) {
+      for (index_t tw = 0; tw < tiles_w; ++tw) {
+        // the 4x4 input tile, zero outside of the image
+        DType d[4][4];
+        const int h0 = static_cast<int>(th * 2) - static_cast<int>(pad_h);
+        const int w0 = static_cast<int>(tw * 2) - static_cast<int>(pad_w);
+        for (int i = 0; i < 4; ++i) {
+          const int h = h0 + i;
+          for (int j = 0; j < 4; ++j) {
+            const int w = w0 + j;
+            d[i][j] = (h >= 0 && h < static_cast<int>(height) &&
+                       w >= 0 && w < static_cast<int>(width)) ? im[h * width + w] : DType(0);
+          }
+        }
+        DType bd[4][4];  // B^T d
+        for (int j = 0; j < 4; ++j) {
+          bd[0][j] = d[0][j] - d[2][j];
+          bd[1][j] = d[1][j] + d[2][j];
+          bd[2][j] = d[2][j] - d[1][j];
+          bd[3][j] = d[1][j] - d[3][j];
+        }
+        DType* vt = vc + th * tiles_w + tw;
+        for (int i = 0; i < 4; ++i) {
+          vt[(i * 4) * v_stride] = bd[i][0] - bd[i][2];
+          vt[(i * 4 + 1) * v_stride] = bd[i][1] + bd[i][2];
+          vt[(i * 4 + 2) * v_stride] = bd[i][2] - bd[i][1];
+          vt[(i * 4 + 3) * v_stride] = bd[i][1] - bd[i][3];
+        }
+      }
+    }
+  }
+}
+
+/*!
+ * \brief transforms the products M[16][num_filter][num * tiles] into the output tiles of num
+ *  images. Filter m of image n starts at out + n * image_stride + m * out_h * out_w.
+ */
+template<typename DType>
+void TransformOutput(const DType* prod, const index_t num, const index_t num_filter,
+                     const index_t image_stride, const index_t out_h, const index_t out_w,
+                     const index_t tiles_h, const index_t tiles_w, DType* out) {
+  const index_t tiles = tiles_h * tiles_w;
+  const index_t p_size = num * tiles;
+  const index_t m_stride = num_filter * p_size;
+  const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  #pragma omp parallel for num_threads(omp_threads)
+  for (index_t nm = 0; nm < num * num_filter; ++nm) {
+    const index_t n = nm / num_filter, m = nm % num_filter;
+    DType* im = out + n * image_stride + m * out_h * out_w;
+    const DType* pm = prod + m * p_size + n * tiles;
+    for (index_t th = 0; th < tiles_h; ++th) {
+      for (index_t tw = 0; tw < tiles_w; ++tw) {
+        const DType* pt = pm + th * tiles_w + tw;
+        DType am[2][4];  // A^T m
+        for (int j = 0; j < 4; ++j) {
+          const DType m0 = pt[j * m_stride], m1 = pt[(4 + j) * m_stride];
+          const DType m2 = pt[(8 + j) * m_stride], m3 = pt[(12 + j) * m_stride];
+          am[0][j] = m0 + m1 + m2;
+          am[1][j] = m1 - m2 - m3;
+        }
+        for (int i = 0; i < 2; ++i) {
+          const index_t h = th * 2 + i;
+          if (h >= out_h) break;
+          const index_t w = tw * 2;
+          im[h * out_w + w] = am[i][0] + am[i][1] + am[i][2];
+          if (w + 1 < out_w) im[h * out_w + w + 1] = am[i][1] - am[i][2] - am[i][3];
+        }
+      }
+    }
+  }
+}
+
+}  // namespace winograd
+
+/*!
+ * \brief direct depthwise convolution, of NCHW data with one filter of shape (kernel_h,
+ *  kernel_w) per channel. The planes of the images and channels run in parallel, and the
+ *  loops along the rows of the output are contiguous for a stride of 1.
+ */
+namespace depthwise {
+
+/*! \brief shapes of a depthwise convolution */
+struct Shape {
+  index_t num, channels;
+  int height, width, out_h, out_w;
+  int kernel_h, kernel_w;
+  int stride_h, stride_w, pad_h, pad_w, dilate_h, dilate_w;
+};
+
+/*!
+ * \brief the outputs [begin, end) of a row which read the inputs (out * stride + offset) inside
+ *  of a row of size inputs
+ */
+inline void ValidRange(int offset, int stride, int size, int outputs, int* begin, int* end) {
+  *begin = offset >= 0 ? 0 : (stride - 1 - offset) / stride;
+  *end = offset >= size ? 0 : std::min(outputs, (size - 1 - offset) / stride + 1);
+  if (*end < *begin) *end = *begin;
+}
+
+/*! \brief number of partial sums of the dot products, which compilers vectorize */
+const int kLanes = 8;
+
+/*! \brief sum of a[i] * b[i * stride] for i in [0, n) */
+template<typename DType>
+inline DType StridedDot(const DType* a, const DType* b, int stride, int n) {
+  DType sum[kLanes] = {DType(0)};
+  int i = 0;
+  if (stride == 1) {
+    for (; i + kLanes <= n; i += kLanes) {
+      for (int l = 0; l < kLanes; ++l) sum[l] += a[i + l] * b[i + l];
+    }
+  }
+  for (; i < n; ++i) sum[0] += a[i] * b[i * stride];
+  DType ret(0);
+  for (int l = 0; l < kLanes; ++l) ret += sum[l];
+  return ret;
+}
+
+/*! \brief out = conv(data, weight) */
+template<typename DType>
+void Forward(const Shape& sh, const DType* data, const DType* weight, DType* out) {
+  const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  const int kernel_size = sh.kernel_h * sh.kernel_w;
+  #pragma omp parallel for num_threads(omp_threads)
+  for (index_t nc = 0; nc < sh.num * sh.channels; ++nc) {
+    const DType* im = data + nc * sh.height * sh.width;
+    const DType* w = weight + (nc % sh.channels) * kernel_size;
+    DType* om = out + nc * sh.out_h * sh.out_w;
+    std::fill(om, om + sh.out_h * sh.out_w, DType(0));
+    for (int kw = 0; kw < sh.kernel_w; ++kw) {
+      const int offset = kw * sh.dilate_w - sh.pad_w;
+      int begin, end;
+      ValidRange(offset, sh.stride_w, sh.width, sh.out_w, &begin, &end);
+      for (int oh = 0; oh < sh.out_h; ++oh) {
+        DType* orow = om + oh * sh.out_w;
+        for (int kh = 0; kh < sh.kernel_h; ++kh) {
+          const int h = oh * sh.stride_h + kh * sh.dilate_h - sh.pad_h;
+          if (h < 0 || h >= sh.height) continue;
+          const DType wv = w[kh * sh.kernel_w + kw];
+          const DType* irow = im + h * sh.width;
+          if (sh.stride_w == 1) {
+            for (int ow = begin; ow < end; ++ow) orow[ow] += wv * irow[ow + offset];
+          } else {
+            for (int ow = begin; ow < end; ++ow) orow[ow] += wv * irow[ow * sh.stride_w + offset];
+          }
+        }
+      }
+    }
+  }
+}
+
+/*! \brief in_grad = conv^T(out_grad, weight), added to in_grad for kAddTo */
+template<typename DType>
+void BackwardData(const Shape& sh, const DType* out_grad, const DType* weight,
+                  OpReqType req, DType* in_grad) {
+  if (req == kNullOp) return;
+  const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  const int kernel_size = sh.kernel_h * sh.kernel_w;
+  #pragma omp parallel for num_threads(omp_threads)
+  for (index_t nc = 0; nc < sh.num * sh.channels; ++nc) {
+    const DType* om = out_grad + nc * sh.out_h * sh.out_w;
+    const DType* w = weight + (nc % sh.channels) * kernel_size;
+    DType* im = in_grad + nc * sh.height * sh.width;
+    if (req != kAddTo) std::fill(im, im + sh.height * sh.width, DType(0));
+    for (int kw = 0; kw < sh.kernel_w; ++kw) {
+      const int offset = kw * sh.dilate_w - sh.pad_w;
+      int begin, end;
+      ValidRange(offset, sh.stride_w, sh.width, sh.out_w, &begin, &end);
+      for (int oh = 0; oh < sh.out_h; ++oh) {
+        const DType* orow = om + oh * sh.out_w;
+        for (int kh = 0; kh < sh.kernel_h; ++kh) {
+          const int h = oh * sh.stride_h + kh * sh.dilate_h - sh.pad_h;
+          if (h < 0 || h >= sh.height) continue;
+          const DType wv = w[kh * sh.kernel_w + kw];
+          DType* irow = im + h * sh.width;
+          if (sh.stride_w == 1) {
+            for (int ow = begin; ow < end; ++ow) irow[ow + offset] += wv * orow[ow];
+          } else {
+            for (int ow = begin; ow < end; ++ow) irow[ow * sh.stride_w + offset] += wv * orow[ow];
+          }
+        }
+      }
+    }
+  }
+}
+
+/*! \brief weight_grad = sum over the images of the correlation of out_grad and data */
+template<typename DType>
+void BackwardWeight(const Shape& sh, const DType* out_grad, const DType* data,
+                    OpReqType req, DType* weight_grad) {
+  if (req == kNullOp) return;
+  const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  const int kernel_size = sh.kernel_h * sh.kernel_w;
+  #pragma omp parallel for num_threads(omp_threads)
+  for (index_t c = 0; c < sh.channels; ++c) {
+    DType* dw = weight_grad + c * kernel_size;
+    for (int kh = 0; kh < sh.kernel_h; ++kh) {
+      for (int kw = 0; kw < sh.kernel_w; ++kw) {
+        const int offset = kw * sh.dilate_w - sh.pad_w;
+        int begin, end;
+        ValidRange(offset, sh.stride_w, sh.width, sh.out_w, &begin, &end);
+        DType sum(0);
+        for (index_t n = 0; n < sh.num; ++n) {
+          const index_t nc = n * sh.channels + c;
+          const DType* om = out_grad + nc * sh.out_h * sh.out_w;
+          const DType* im = data + nc * sh.height * sh.width;
+          for (int oh = 0; oh < sh.out_h; ++oh) {
+            const int h = oh * sh.stride_h + kh * sh.dilate_h - sh.pad_h;
+            if (h < 0 || h >= sh.height) continue;
+            sum += StridedDot(om + oh * sh.out_w + begin,
+                              im + h * sh.width + begin * sh.stride_w + offset,
+                              sh.stride_w, end - begin);
+          }
+        }
+        DType* dwv = dw + kh * sh.kernel_w + kw;
+        *dwv = req == kAddTo ? *dwv + sum : sum;
+      }
+    }
+  }
+}
+
+}  // namespace depthwise
+}  // namespace op
+}  // namespace mxnet
+#endif  // MXNET_OPERATOR_NN_CONVOLUTION_CPU_INL_H_
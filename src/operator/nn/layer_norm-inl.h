@@ -63,6 +63,22 @@ struct LayerNormParam : public dmlc::Parameter<LayerNormParam> {
   }
 };
 
+/*!
+ * \brief LayerNorm forward on cpu. Normalizing the innermost axis, it computes every row
+ *  in a single fused pass, and runs LayerNormCompute<cpu> otherwise.
+ */
+void LayerNormComputeCPU(const nnvm::NodeAttrs& attrs,
+                         const OpContext& ctx, const std::vector<TBlob>& inputs,
+                         const std::vector<OpReqType>& req,
+                         const std::vector<TBlob>& outputs);
+
+/*!
+ * \brief LayerNorm backward on cpu, fused like LayerNormComputeCPU
+ */
+void LayerNormGradComputeCPU(const nnvm::NodeAttrs& attrs,
+                             const OpContext& ctx, const std::vector<TBlob>& inputs,
+                             const std::vector<OpReqType>& req,
+                             const std::vector<TBlob>& outputs);
 
 template<typename xpu>
 void LayerNormCompute(const nnvm::NodeAttrs& attrs,
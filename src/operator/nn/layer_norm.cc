@@ -25,6 +25,8 @@
 
 #include "layer_norm-inl.h"
 #include <nnvm/op_attr_types.h>
+#include <algorithm>
+#include <cmath>
 #include "../elemwise_op_common.h"
 
 namespace mxnet {
@@ -32,6 +34,216 @@ namespace op {
 
 DMLC_REGISTER_PARAMETER(LayerNormParam);
 
+namespace layernorm {
+
+/*! \brief number of partial sums of a row, which lets the compiler vectorize the sums */
+const int kLanes = 8;
+
+/*! \brief sum of a row of n values */
+template<typename AType, typename DType>
+inline AType SumRow(const DType* x, const index_t n) {
+  AType acc[kLanes] = {0};
+  index_t i = 0;
+  for (; i + kLanes <= n; i += kLanes) {
+    for (int j = 0; j < kLanes; ++j) acc[j] += static_cast<AType>(x[i + j]);
+  }
+  AType sum = 0;
+  for (; i < n; ++i) sum += static_cast<AType>(x[i]);
+  for (int j = 0; j < kLanes; ++j) sum += acc[j];
+  return sum;
+}
+
+/*! \brief sum of (x[i] - mean)^2 */
+template<typename AType, typename DType>
+inline AType SquaredDeviationRow(const DType* x, const AType mean, const index_t n) {
+  AType acc[kLanes] = {0};
+  index_t i = 0;
+  for (; i + kLanes <= n; i += kLanes) {
+    for (int j = 0; j < kLanes; ++j) {
+      const AType d = static_cast<AType>(x[i + j]) - mean;
+      acc[j] += d * d;
+    }
+  }
+  AType sum = 0;
+  for (; i < n; ++i) {
+    const AType d = static_cast<AType>(x[i]) - mean;
+    sum += d * d;
+  }
+  for (int j = 0; j < kLanes; ++j) sum += acc[j];
+  return sum;
+}
+
+/*!
+ * \brief normalizes nrow rows of ncol values. A row stays in the cache between the passes
+ *  for its mean, its variance and the output, so the data is read from memory once.
+ */
+template<typename DType, typename AType>
+void ForwardRows(const index_t nrow, const index_t ncol, const AType eps,
+                 const DType* data, const DType* gamma, const DType* beta,
+                 DType* out, DType* mean, DType* std_dev) {
+  const int nthreads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  #pragma omp parallel for num_threads(nthreads)
+  for (index_t r = 0; r < nrow; ++r) {
+    const DType* x = data + r * ncol;
+    DType* y = out + r * ncol;
+    const AType m = SumRow<AType, DType>(x, ncol) / ncol;
+    const AType s = std::sqrt(SquaredDeviationRow(x, m, ncol) / ncol + eps);
+    const AType invstd = 1 / s;
+    // out may be data, with an inplace LayerNorm
+    for (index_t i = 0; i < ncol; ++i) {
+      y[i] = DType((static_cast<AType>(x[i]) - m) * invstd * static_cast<AType>(gamma[i])
+                   + static_cast<AType>(beta[i]));
+    }
+    mean[r] = DType(m);
+    std_dev[r] = DType(s);
+  }
+}
+
+/*!
+ * \brief gradients of nrow rows of ncol values. With w = ograd * gamma and the normalized data
+ *  x' = (data - mean) / std, grad_data = (w - mean(w) - x' * mean(w * x')) / std, which needs
+ *  one pass for the two sums and one for the output. grad_gamma = sum(ograd * x') and
+ *  grad_beta = sum(ograd) are summed in the same passes, into one buffer of 2 * ncol values
+ *  per thread at partial.
+ */
+template<typename DType, typename AType>
+void BackwardRows(const index_t nrow, const index_t ncol,
+                  const DType* ograd, const DType* data, const DType* gamma,
+                  const DType* mean, const DType* std_dev, AType* partial,
+                  DType* grad_data, DType* grad_gamma, DType* grad_beta,
+                  const std::vector<OpReqType>& req) {
+  const int nthreads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  const bool param_grads = req[1] != kNullOp || req[2] != kNullOp;
+  const index_t rows_per_thread = (nrow + nthreads - 1) / nthreads;
+  #pragma omp parallel for num_threads(nthreads)
+  for (int t = 0; t < nthreads; ++t) {
+    AType* gamma_sum = partial + 2 * t * ncol;
+    AType* beta_sum = gamma_sum + ncol;
+    if (param_grads) std::fill(gamma_sum, gamma_sum + 2 * ncol, AType(0));
+    const index_t end = std::min(nrow, (t + 1) * rows_per_thread);
+    for (index_t r = t * rows_per_thread; r < end; ++r) {
+      const DType* og = ograd + r * ncol;
+      const DType* x = data + r * ncol;
+      const AType m = static_cast<AType>(mean[r]);
+      const AType invstd = 1 / static_cast<AType>(std_dev[r]);
+      if (param_grads) {
+        for (index_t i = 0; i < ncol; ++i) {
+          const AType g = static_cast<AType>(og[i]);
+          gamma_sum[i] += g * (static_cast<AType>(x[i]) - m) * invstd;
+          beta_sum[i] += g;
+        }
+      }
+      if (req[0] == kNullOp) continue;
+      AType w_sum[kLanes] = {0};
+      AType wx_sum[kLanes] = {0};
+      index_t i = 0;
+      for (; i + kLanes <= ncol; i += kLanes) {
+        for (int j = 0; j < kLanes; ++j) {
+          const AType w = static_cast<AType>(og[i + j]) * static_cast<AType>(gamma[i + j]);
+          w_sum[j] += w;
+          wx_sum[j] += w * (static_cast<AType>(x[i + j]) - m);
+        }
+      }
+      for (; i < ncol; ++i) {
+        const AType w = static_cast<AType>(og[i]) * static_cast<AType>(gamma[i]);
+        w_sum[0] += w;
+        wx_sum[0] += w * (static_cast<AType>(x[i]) - m);
+      }
+      for (int j = 1; j < kLanes; ++j) {
+        w_sum[0] += w_sum[j];
+        wx_sum[0] += wx_sum[j];
+      }
+      const AType w_mean = w_sum[0] / ncol;
+      const AType wx_mean = wx_sum[0] * invstd / ncol;
+      DType* gx = grad_data + r * ncol;
+      for (i = 0; i < ncol; ++i) {
+        const AType w = static_cast<AType>(og[i]) * static_cast<AType>(gamma[i]);
+        const AType xhat = (static_cast<AType>(x[i]) - m) * invstd;
+        KERNEL_ASSIGN(gx[i], req[0], DType((w - w_mean - xhat * wx_mean) * invstd));
+      }
+    }
+  }
+  if (!param_grads) return;
+  #pragma omp parallel for num_threads(nthreads)
+  for (index_t i = 0; i < ncol; ++i) {
+    AType gamma_sum = 0, beta_sum = 0;
+    for (int t = 0; t < nthreads; ++t) {
+      gamma_sum += partial[2 * t * ncol + i];
+      beta_sum += partial[(2 * t + 1) * ncol + i];
+    }
+    KERNEL_ASSIGN(grad_gamma[i], req[1], DType(gamma_sum));
+    KERNEL_ASSIGN(grad_beta[i], req[2], DType(beta_sum));
+  }
+}
+
+/*!
+ * \brief whether the normalized axis of data is its innermost one, so that every mean and std
+ *  belongs to a contiguous row. Returns the length of the rows at ncol.
+ */
+inline bool IsInnermostAxis(const LayerNormParam& param, const TShape& dshape, index_t* ncol) {
+  int axis = param.axis;
+  if (axis < 0) {
+    axis += static_cast<int>(dshape.ndim());
+  }
+  CHECK(axis >= 0 && axis < static_cast<int>(dshape.ndim()))
+    << "Channel axis out of range: " << param.axis;
+  for (index_t i = axis + 1; i < dshape.ndim(); ++i) {
+    if (dshape[i] != 1) return false;
+  }
+  *ncol = dshape[axis];
+  return dshape.Size() > 0;
+}
+
+}  // namespace layernorm
+
+void LayerNormComputeCPU(const nnvm::NodeAttrs& attrs,
+                         const OpContext& ctx, const std::vector<TBlob>& inputs,
+                         const std::vector<OpReqType>& req,
+                         const std::vector<TBlob>& outputs) {
+  const LayerNormParam& param = nnvm::get<LayerNormParam>(attrs.parsed);
+  if (req[0] == kNullOp) return;
+  CHECK_NE(req[0], kAddTo);
+  CHECK_EQ(inputs.size(), 3U);
+  index_t ncol;
+  if (!layernorm::IsInnermostAxis(param, inputs[0].shape_, &ncol)) {
+    LayerNormCompute<cpu>(attrs, ctx, inputs, req, outputs);
+    return;
+  }
+  const index_t nrow = inputs[0].Size() / ncol;
+  MSHADOW_REAL_TYPE_SWITCH_EX(inputs[0].type_flag_, DType, AType, {
+    layernorm::ForwardRows<DType, AType>(
+      nrow, ncol, static_cast<AType>(param.eps),
+      inputs[layernorm::kData].dptr<DType>(), inputs[layernorm::kGamma].dptr<DType>(),
+      inputs[layernorm::kBeta].dptr<DType>(), outputs[layernorm::kOut].dptr<DType>(),
+      outputs[layernorm::kMean].dptr<DType>(), outputs[layernorm::kStd].dptr<DType>());
+  });
+}
+
+void LayerNormGradComputeCPU(const nnvm::NodeAttrs& attrs,
+                             const OpContext& ctx, const std::vector<TBlob>& inputs,
+                             const std::vector<OpReqType>& req,
+                             const std::vector<TBlob>& outputs) {
+  using namespace mshadow;
+  const LayerNormParam& param = nnvm::get<LayerNormParam>(attrs.parsed);
+  CHECK_EQ(inputs.size(), 5U);
+  index_t ncol;
+  if (!layernorm::IsInnermostAxis(param, inputs[0].shape_, &ncol)) {
+    LayerNormGradCompute<cpu>(attrs, ctx, inputs, req, outputs);
+    return;
+  }
+  const index_t nrow = inputs[0].Size() / ncol;
+  const int nthreads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  Stream<cpu> *s = ctx.get_stream<cpu>();
+  MSHADOW_REAL_TYPE_SWITCH_EX(inputs[0].type_flag_, DType, AType, {
+    Tensor<cpu, 1, AType> partial = ctx.requested[0].get_space_typed<cpu, 1, AType>(
+      Shape1(2 * nthreads * ncol), s);
+    layernorm::BackwardRows<DType, AType>(
+      nrow, ncol, inputs[0].dptr<DType>(), inputs[1].dptr<DType>(), inputs[2].dptr<DType>(),
+      inputs[3].dptr<DType>(), inputs[4].dptr<DType>(), partial.dptr_,
+      outputs[0].dptr<DType>(), outputs[1].dptr<DType>(), outputs[2].dptr<DType>(), req);
+  });
+}
+
 static bool LayerNormShape(const nnvm::NodeAttrs& attrs,
                            std::vector<TShape> *in_shape,
                            std::vector<TShape> *out_shape) {
@@ -110,7 +322,7 @@ axis to be the last item in the input shape.
 })
 .set_attr<nnvm::FInferShape>("FInferShape", LayerNormShape)
 .set_attr<nnvm::FInferType>("FInferType", ElemwiseType<3, 3>)
-.set_attr<FCompute>("FCompute<cpu>", LayerNormCompute<cpu>)
+.set_attr<FCompute>("FCompute<cpu>", LayerNormComputeCPU)
 .set_attr<nnvm::FGradient>("FGradient", [](const nnvm::NodePtr& n,
                                            const std::vector<nnvm::NodeEntry>& ograds) {
   std::vector<nnvm::NodeEntry> heads;
@@ -139,7 +351,7 @@ NNVM_REGISTER_OP(_backward_LayerNorm)
 .set_num_outputs(3)
 .set_attr<nnvm::TIsBackward>("TIsBackward", true)
 .set_attr_parser(ParamParser<LayerNormParam>)
-.set_attr<FCompute>("FCompute<cpu>", LayerNormGradCompute<cpu>)
+.set_attr<FCompute>("FCompute<cpu>", LayerNormGradComputeCPU)
 .set_attr<FResourceRequest>("FResourceRequest", [](const NodeAttrs& n) {
   return std::vector<ResourceRequest>{ResourceRequest::kTempSpace};
 });
@@ -38,6 +38,10 @@ bool SupportMKLDNNSoftmax(const SoftmaxParam &param) {
   if (param.temperature.has_value()) {
     return false;
   }
+  // nor a mask of the inputs
+  if (param.use_length) {
+    return false;
+  }
   return true;
 }
 
@@ -25,10 +25,16 @@
 #ifndef MXNET_OPERATOR_NN_SOFTMAX_INL_H_
 #define MXNET_OPERATOR_NN_SOFTMAX_INL_H_
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <type_traits>
 #include <vector>
 
 #include "../mxnet_op.h"
 #include "../operator_common.h"
+#include "../elemwise_op_common.h"
 #include "../tensor/broadcast_reduce_op.h"
 
 namespace mxnet {
@@ -51,8 +57,202 @@ struct log_softmax_fwd {
 };
 
 
-template<typename OP, bool negate, typename DType, int ndim>
-inline void Softmax(Stream<cpu> *s, DType *in, DType *out,
+/*!
+ * \brief length of row i of the softmax along an axis of size M, M without the length input
+ */
+template<typename IType>
+MSHADOW_XINLINE index_t SoftmaxLength(const IType *length, index_t i, index_t M) {
+  if (length == nullptr) return M;
+  const double len = static_cast<double>(length[i]);
+  return len <= 0 ? 0 : (len >= static_cast<double>(M) ? M : static_cast<index_t>(len));
+}
+
+
+/*! \brief elements of a contiguous row whose max and sum of exp are taken while in cache */
+const index_t kSoftmaxBlock = 256;
+/*! \brief independent partial results, so that the reductions along a row vectorize */
+const int kSoftmaxLanes = 8;
+/*! \brief bits of -87.0f and 88.0f, the bounds of the inputs of FastExp */
+const int32_t kFastExpMinBits = static_cast<int32_t>(0xC2AE0000);
+const int32_t kFastExpMaxBits = 0x42B00000;
+
+/*!
+ * \brief exp of a float with a relative error below 4e-7, against a few ulp for expf: the
+ *  power of two of the result is set in its exponent bits, and the rest is a polynomial of
+ *  degree 6 on [-ln(2)/2, ln(2)/2]. It has neither branch nor float to int conversion, so
+ *  that the loops which call it vectorize. Inputs are clamped to [-87, 88], below -87 it
+ *  gives 1.6e-38 rather than 0, and NaN gives NaN.
+ */
+inline float FastExp(float x) {
+  // the clamp is made on the bits, as a select of floats would keep the loops scalar
+  int32_t xbits;
+  std::memcpy(&xbits, &x, sizeof(xbits));
+  const int32_t below = -static_cast<int32_t>(x < -87.0f);
+  const int32_t above = -static_cast<int32_t>(x > 88.0f);
+  xbits = (xbits & ~(below | above)) | (kFastExpMinBits & below) | (kFastExpMaxBits & above);
+  std::memcpy(&x, &xbits, sizeof(x));
+  // round x / ln(2) to the integer n in the low bits of the mantissa of t
+  const float t = x * 1.44269504f + 12582912.0f;
+  int32_t n;
+  std::memcpy(&n, &t, sizeof(n));
+  n -= 0x4B400000;
+  const float fn = t - 12582912.0f;
+  // x - n * ln(2), with ln(2) split in two so that the first product is exact
+  const float r = (x - fn * 0.693145751953125f) - fn * 1.428606765330187e-6f;
+  float p = 1.3888889e-3f;
+  p = p * r + 8.3333333e-3f;
+  p = p * r + 4.1666667e-2f;
+  p = p * r + 1.6666667e-1f;
+  p = p * r + 0.5f;
+  p = p * r + 1.0f;
+  p = p * r + 1.0f;
+  const uint32_t bits = static_cast<uint32_t>(n + 127) << 23;
+  float scale;
+  std::memcpy(&scale, &bits, sizeof(scale));
+  return p * scale;
+}
+
+/*! \brief exp of the cpu softmax, which is FastExp for float when fast */
+template<bool fast, typename AType>
+struct softmax_exp {
+  static AType Map(AType x) {
+    return std::exp(x);
+  }
+};
+
+template<>
+struct softmax_exp<true, float> {
+  static float Map(float x) {
+    return FastExp(x);
+  }
+};
+
+/*! \brief type in which the cpu softmax computes, float for half precision data */
+template<typename DType>
+struct softmax_acc {
+  typedef float type;
+};
+
+template<>
+struct softmax_acc<double> {
+  typedef double type;
+};
+
+/*!
+ * \brief max and sum of exp(x - max) of the first len elements x = in * scale of a contiguous
+ *  row, in a single pass over memory: the max of each block rescales the sum of the previous
+ *  blocks, so that the block is read again from the cache for its exp.
+ */
+template<bool fast, typename AType, typename DType>
+inline void SoftmaxRowMaxSum(const DType *in, index_t len, AType scale,
+                             AType *row_max, AType *row_sum) {
+  typedef softmax_exp<fast, AType> Exp;
+  const AType lowest = -std::numeric_limits<AType>::infinity();
+  AType mmax = lowest;
+  AType sum = 0;
+  for (index_t j0 = 0; j0 < len; j0 += kSoftmaxBlock) {
+    const index_t j1 = std::min(j0 + kSoftmaxBlock, len);
+    AType lane[kSoftmaxLanes];
+    for (int l = 0; l < kSoftmaxLanes; ++l) lane[l] = mmax;
+    index_t j = j0;
+    for (; j + kSoftmaxLanes <= j1; j += kSoftmaxLanes) {
+      for (int l = 0; l < kSoftmaxLanes; ++l) {
+        const AType x = AType(in[j + l]) * scale;
+        lane[l] = lane[l] < x ? x : lane[l];
+      }
+    }
+    AType block_max = mmax;
+    for (; j < j1; ++j) {
+      const AType x = AType(in[j]) * scale;
+      block_max = block_max < x ? x : block_max;
+    }
+    for (int l = 0; l < kSoftmaxLanes; ++l) {
+      block_max = block_max < lane[l] ? lane[l] : block_max;
+    }
+    // nothing to add while the row has only -inf
+    if (block_max == lowest) continue;
+    sum *= Exp::Map(mmax - block_max);
+    mmax = block_max;
+    for (int l = 0; l < kSoftmaxLanes; ++l) lane[l] = 0;
+    for (j = j0; j + kSoftmaxLanes <= j1; j += kSoftmaxLanes) {
+      for (int l = 0; l < kSoftmaxLanes; ++l) {
+        lane[l] += Exp::Map(AType(in[j + l]) * scale - mmax);
+      }
+    }
+    for (; j < j1; ++j) {
+      sum += Exp::Map(AType(in[j]) * scale - mmax);
+    }
+    for (int l = 0; l < kSoftmaxLanes; ++l) sum += lane[l];
+  }
+  *row_max = mmax;
+  *row_sum = sum;
+}
+
+/*!
+ * \brief softmax, or log softmax, of in * scale along a contiguous row of size M, whose
+ *  elements from len on are masked out and set to 0
+ */
+template<bool fast, bool is_log, typename AType, typename DType>
+inline void SoftmaxRow(const DType *in, DType *out, index_t M, index_t len, AType scale) {
+  typedef softmax_exp<fast, AType> Exp;
+  AType mmax, sum;
+  SoftmaxRowMaxSum<fast>(in, len, scale, &mmax, &sum);
+  if (is_log) {
+    const AType log_sum = std::log(sum);
+    for (index_t j = 0; j < len; ++j) {
+      out[j] = DType((AType(in[j]) * scale - mmax) - log_sum);
+    }
+  } else {
+    const AType inv_sum = AType(1) / sum;
+    for (index_t j = 0; j < len; ++j) {
+      out[j] = DType(Exp::Map(AType(in[j]) * scale - mmax) * inv_sum);
+    }
+  }
+  for (index_t j = len; j < M; ++j) out[j] = DType(0);
+}
+
+/*!
+ * \brief gradient of the softmax, or log softmax, of in * scale along a contiguous row of
+ *  size M from its output, in two passes: the sum of OP1(ograd, out) and the gradient
+ */
+template<bool fast, bool is_log, typename OP1, typename OP2, int Req,
+         typename AType, typename DType>
+inline void SoftmaxGradRow(const DType *out, const DType *ograd, DType *igrad,
+                           index_t M, index_t len, AType scale) {
+  typedef softmax_exp<fast, AType> Exp;
+  AType lane[kSoftmaxLanes] = {0};
+  index_t j = 0;
+  for (; j + kSoftmaxLanes <= len; j += kSoftmaxLanes) {
+    for (int l = 0; l < kSoftmaxLanes; ++l) {
+      lane[l] += OP1::Map(AType(ograd[j + l]), AType(out[j + l]));
+    }
+  }
+  AType sum = 0;
+  for (; j < len; ++j) {
+    sum += OP1::Map(AType(ograd[j]), AType(out[j]));
+  }
+  for (int l = 0; l < kSoftmaxLanes; ++l) sum += lane[l];
+  for (j = 0; j < len; ++j) {
+    const AType og = AType(ograd[j]), o = AType(out[j]);
+    const AType grad = is_log ? og - Exp::Map(o) * sum : OP2::Map(og, o, sum);
+    KERNEL_ASSIGN(igrad[j], Req, DType(grad * scale));
+  }
+  for (j = len; j < M; ++j) {
+    KERNEL_ASSIGN(igrad[j], Req, DType(0));
+  }
+}
+
+/*!
+ * \brief whether the cpu softmax uses FastExp for float, from MXNET_SOFTMAX_FAST_EXP
+ */
+inline bool SoftmaxFastExp() {
+  static const bool fast = dmlc::GetEnv("MXNET_SOFTMAX_FAST_EXP", false);
+  return fast;
+}
+
+
+template<typename OP, bool negate, typename DType, typename IType, int ndim>
+inline void Softmax(Stream<cpu> *s, DType *in, DType *out, IType *length,
                     Shape<ndim> shape, int axis, const DType temperature) {
   index_t M = shape[axis];
   index_t N = shape.Size()/M;
@@ -61,13 +261,35 @@ inline void Softmax(Stream<cpu> *s, DType *in, DType *out,
   sshape[axis] = 1;
   index_t sa = stride[axis];
 
+  if (sa == 1) {
+    typedef typename softmax_acc<DType>::type AType;
+    const bool is_log = std::is_same<OP, log_softmax_fwd>::value;
+    const AType scale = (negate ? AType(-1) : AType(1)) / AType(temperature);
+    const bool fast = SoftmaxFastExp();
+    #pragma omp parallel for
+    for (int i = 0; i < static_cast<int>(N); ++i) {
+      const index_t len = SoftmaxLength(length, i, M);
+      if (fast) {
+        SoftmaxRow<true, is_log>(in + i*M, out + i*M, M, len, scale);
+      } else {
+        SoftmaxRow<false, is_log>(in + i*M, out + i*M, M, len, scale);
+      }
+    }
+    return;
+  }
+
   #pragma omp parallel for
   for (int i = 0; i < static_cast<int>(N); ++i) {
     index_t base = unravel_dot(i, sshape, stride);
+    const index_t len = SoftmaxLength(length, i, M);
+    for (index_t j = len; j < M; ++j) {
+      out[base + j*sa] = DType(0);
+    }
+    if (len == 0) continue;
 
     DType mmax = negate ? -in[base] : in[base];
     DType val;
-    for (index_t j = 1; j < M; ++j) {
+    for (index_t j = 1; j < len; ++j) {
       val = negate ? -in[base + j*sa] : in[base + j*sa];
       if (mmax < val) mmax = val;
     }
@@ -78,22 +300,22 @@ inline void Softmax(Stream<cpu> *s, DType *in, DType *out,
     // users would set it to other values.
     // Adding a branch here to save the CPU 'divide-by-1' computation at runtime
     if (temperature == 1.0) {
-      for (index_t j = 0; j < M; ++j) {
+      for (index_t j = 0; j < len; ++j) {
         in_val = negate ? -in[base + j*sa] : in[base + j*sa];
         sum += std::exp(in_val - mmax);
       }
 
-      for (index_t j = 0; j < M; ++j) {
+      for (index_t j = 0; j < len; ++j) {
         in_val = negate ? -in[base + j*sa] : in[base + j*sa];
         out[base + j*sa] = OP::Map(in_val - mmax, sum);
       }
     } else {
-      for (index_t j = 0; j < M; ++j) {
+      for (index_t j = 0; j < len; ++j) {
         in_val = negate ? -in[base + j*sa] : in[base + j*sa];
         sum += std::exp((in_val - mmax)/temperature);
       }
 
-      for (index_t j = 0; j < M; ++j) {
+      for (index_t j = 0; j < len; ++j) {
         in_val = negate ? -in[base + j*sa] : in[base + j*sa];
         out[base + j*sa] = OP::Map((in_val - mmax)/temperature, sum);
       }
@@ -118,9 +340,10 @@ struct log_softmax_bwd {
 };
 
 
-template<typename OP1, typename OP2, int Req, bool negate, typename DType, int ndim>
+template<typename OP1, typename OP2, int Req, bool negate, typename DType, typename IType,
+         int ndim>
 inline void SoftmaxGrad(Stream<cpu> *s, DType *out, DType *ograd,
-                        DType *igrad, Shape<ndim> shape, int axis,
+                        DType *igrad, IType *length, Shape<ndim> shape, int axis,
                         const DType temperature) {
   index_t M = shape[axis];
   index_t N = shape.Size()/M;
@@ -129,12 +352,32 @@ inline void SoftmaxGrad(Stream<cpu> *s, DType *out, DType *ograd,
   sshape[axis] = 1;
   index_t sa = stride[axis];
 
+  if (sa == 1) {
+    typedef typename softmax_acc<DType>::type AType;
+    const bool is_log = std::is_same<OP2, log_softmax_bwd>::value;
+    const AType scale = (negate ? AType(-1) : AType(1)) / AType(temperature);
+    const bool fast = SoftmaxFastExp();
+    #pragma omp parallel for
+    for (int i = 0; i < static_cast<int>(N); ++i) {
+      const index_t len = SoftmaxLength(length, i, M);
+      if (fast) {
+        SoftmaxGradRow<true, is_log, OP1, OP2, Req>(out + i*M, ograd + i*M, igrad + i*M,
+                                                    M, len, scale);
+      } else {
+        SoftmaxGradRow<false, is_log, OP1, OP2, Req>(out + i*M, ograd + i*M, igrad + i*M,
+                                                     M, len, scale);
+      }
+    }
+    return;
+  }
+
   #pragma omp parallel for
   for (int i = 0; i < static_cast<int>(N); ++i) {
     index_t base = unravel_dot(i, sshape, stride);
+    const index_t len = SoftmaxLength(length, i, M);
 
     DType sum = DType(0);
-    for (index_t j = 0; j < M; ++j) {
+    for (index_t j = 0; j < len; ++j) {
       sum += OP1::Map(ograd[base + j*sa], out[base + j*sa]);
     }
 
@@ -143,27 +386,30 @@ inline void SoftmaxGrad(Stream<cpu> *s, DType *out, DType *ograd,
     // Adding a branch here to save the CPU 'divide-by-1' computation at runtime
     DType final_result;
     if (temperature == 1.0) {
-      for (index_t j = 0; j < M; ++j) {
+      for (index_t j = 0; j < len; ++j) {
         final_result = negate ?
                        -OP2::Map(ograd[base + j*sa], out[base + j*sa], sum) :
                        OP2::Map(ograd[base + j*sa], out[base + j*sa], sum);
         KERNEL_ASSIGN(igrad[base + j*sa], Req, final_result);
       }
     } else {
-      for (index_t j = 0; j < M; ++j) {
+      for (index_t j = 0; j < len; ++j) {
         final_result = negate ?
                        -OP2::Map(ograd[base + j*sa], out[base + j*sa], sum) / temperature :
                        OP2::Map(ograd[base + j*sa], out[base + j*sa], sum) / temperature;
         KERNEL_ASSIGN(igrad[base + j*sa], Req, final_result);
       }
     }
+    for (index_t j = len; j < M; ++j) {
+      KERNEL_ASSIGN(igrad[base + j*sa], Req, DType(0));
+    }
   }
 }
 
 
 #ifdef __CUDACC__
-template<int x_bits, typename OP, bool negate, typename DType, int ndim>
-__global__ void softmax_compute_kernel(DType *in, DType *out, index_t M, int axis,
+template<int x_bits, typename OP, bool negate, typename DType, typename IType, int ndim>
+__global__ void softmax_compute_kernel(DType *in, DType *out, IType *length, index_t M, int axis,
                                        Shape<ndim> sshape, Shape<ndim> stride,
                                        const double temperature) {
   const unsigned x_size = 1 << x_bits;
@@ -171,9 +417,10 @@ __global__ void softmax_compute_kernel(DType *in, DType *out, index_t M, int axi
   index_t sa = stride[axis];
   index_t base = unravel_dot(blockIdx.x, sshape, stride);
   index_t x = threadIdx.x;
+  const index_t len = SoftmaxLength(length, blockIdx.x, M);
 
   red::maximum::SetInitValue(smem[x]);
-  for (index_t i = x; i < M; i += x_size) {
+  for (index_t i = x; i < len; i += x_size) {
     red::maximum::Reduce(smem[x], negate ? -in[base + i*sa] : in[base + i*sa]);
   }
   __syncthreads();
@@ -184,7 +431,7 @@ __global__ void softmax_compute_kernel(DType *in, DType *out, index_t M, int axi
 
   red::sum::SetInitValue(smem[x]);
   DType val;
-  for (index_t i = x; i < M; i += x_size) {
+  for (index_t i = x; i < len; i += x_size) {
     val = negate ? -in[base + i*sa]:in[base + i*sa];
     red::sum::Reduce(
       smem[x], static_cast<DType>(expf((val - smax) / static_cast<DType>(temperature))));
@@ -197,12 +444,13 @@ __global__ void softmax_compute_kernel(DType *in, DType *out, index_t M, int axi
 
   for (index_t i = x; i < M; i += x_size) {
     val = negate ? -in[base + i*sa] : in[base + i*sa];
-    out[base + i*sa] = OP::Map((val - smax)/static_cast<DType>(temperature), ssum);
+    out[base + i*sa] =
+      i < len ? OP::Map((val - smax)/static_cast<DType>(temperature), ssum) : DType(0);
   }
 }
 
-template<typename OP, bool negate, typename DType, int ndim>
-inline void Softmax(Stream<gpu> *s, DType *in, DType *out,
+template<typename OP, bool negate, typename DType, typename IType, int ndim>
+inline void Softmax(Stream<gpu> *s, DType *in, DType *out, IType *length,
                     Shape<ndim> shape, int axis, const double temperature) {
   const int x_bits = 7;
   const int x_size = 1 << x_bits;
@@ -212,15 +460,16 @@ inline void Softmax(Stream<gpu> *s, DType *in, DType *out,
   Shape<ndim> sshape = shape;
   sshape[axis] = 1;
 
-  softmax_compute_kernel<x_bits, OP, negate, DType, ndim>
+  softmax_compute_kernel<x_bits, OP, negate, DType, IType, ndim>
     <<<N, x_size, 0, mshadow::Stream<gpu>::GetStream(s)>>>(
-      in, out, M, axis, sshape, stride, temperature);
+      in, out, length, M, axis, sshape, stride, temperature);
   MSHADOW_CUDA_POST_KERNEL_CHECK(softmax_compute_kernel);
 }
 
 
-template<int x_bits, typename OP1, typename OP2, int Req, bool negate, typename DType, int ndim>
-__global__ void softmax_gradient_kernel(DType *out, DType *ograd, DType *igrad,
+template<int x_bits, typename OP1, typename OP2, int Req, bool negate, typename DType,
+         typename IType, int ndim>
+__global__ void softmax_gradient_kernel(DType *out, DType *ograd, DType *igrad, IType *length,
                                         index_t M, int axis, Shape<ndim> sshape,
                                         Shape<ndim> stride, const double temperature) {
   const unsigned x_size = 1 << x_bits;
@@ -228,9 +477,10 @@ __global__ void softmax_gradient_kernel(DType *out, DType *ograd, DType *igrad,
   index_t sa = stride[axis];
   index_t base = unravel_dot(blockIdx.x, sshape, stride);
   index_t x = threadIdx.x;
+  const index_t len = SoftmaxLength(length, blockIdx.x, M);
 
   red::sum::SetInitValue(smem[x]);
-  for (index_t i = x; i < M; i += x_size) {
+  for (index_t i = x; i < len; i += x_size) {
     red::sum::Reduce(smem[x], OP1::Map(ograd[base + i*sa], out[base + i*sa]));
   }
   __syncthreads();
@@ -245,14 +495,16 @@ __global__ void softmax_gradient_kernel(DType *out, DType *ograd, DType *igrad,
       negate ?
       -OP2::Map(ograd[base + i*sa], out[base + i*sa], ssum) :
       OP2::Map(ograd[base + i*sa], out[base + i*sa], ssum);
-    KERNEL_ASSIGN(igrad[base + i*sa], Req, final_result / static_cast<DType>(temperature));
+    final_result = i < len ? final_result / static_cast<DType>(temperature) : DType(0);
+    KERNEL_ASSIGN(igrad[base + i*sa], Req, final_result);
   }
 }
 
 
-template<typename OP1, typename OP2, int Req, bool negate, typename DType, int ndim>
+template<typename OP1, typename OP2, int Req, bool negate, typename DType, typename IType,
+         int ndim>
 inline void SoftmaxGrad(Stream<gpu> *s, DType *out, DType *ograd,
-                        DType *igrad, Shape<ndim> shape, int axis,
+                        DType *igrad, IType *length, Shape<ndim> shape, int axis,
                         const double temperature) {
   const int x_bits = 7;
   const int x_size = 1 << x_bits;
@@ -262,9 +514,9 @@ inline void SoftmaxGrad(Stream<gpu> *s, DType *out, DType *ograd,
   Shape<ndim> sshape = shape;
   sshape[axis] = 1;
 
-  softmax_gradient_kernel<x_bits, OP1, OP2, Req, negate, DType, ndim>
+  softmax_gradient_kernel<x_bits, OP1, OP2, Req, negate, DType, IType, ndim>
     <<<N, x_size, 0, mshadow::Stream<gpu>::GetStream(s)>>>(
-      out, ograd, igrad, M, axis, sshape, stride, temperature);
+      out, ograd, igrad, length, M, axis, sshape, stride, temperature);
   MSHADOW_CUDA_POST_KERNEL_CHECK(softmax_gradient_kernel);
 }
 #endif
@@ -275,14 +527,144 @@ inline void SoftmaxGrad(Stream<gpu> *s, DType *out, DType *ograd,
 struct SoftmaxParam : public dmlc::Parameter<SoftmaxParam> {
   int axis;
   dmlc::optional<double> temperature;
+  bool use_length;
   DMLC_DECLARE_PARAMETER(SoftmaxParam) {
     DMLC_DECLARE_FIELD(axis).set_default(-1)
       .describe("The axis along which to compute softmax.");
     DMLC_DECLARE_FIELD(temperature).set_default(dmlc::optional<double>())
       .describe("Temperature parameter in softmax");
+    DMLC_DECLARE_FIELD(use_length).set_default(false)
+      .describe("Whether to mask the data with the length input: the elements of each slice "
+                "along the axis from its length on are left out, and give 0 outputs.");
   }
 };
 
+static inline bool softmax_has_length(const nnvm::NodeAttrs& attrs) {
+  return nnvm::get<SoftmaxParam>(attrs.parsed).use_length;
+}
+
+/*!
+ * \brief the output has the shape of the data, and the length the shape of the data without
+ *  the axis
+ */
+static inline bool SoftmaxOpShape(const nnvm::NodeAttrs& attrs,
+                                  std::vector<TShape> *in_attrs,
+                                  std::vector<TShape> *out_attrs) {
+  const bool use_length = softmax_has_length(attrs);
+  CHECK_EQ(in_attrs->size(), use_length ? 2U : 1U);
+  CHECK_EQ(out_attrs->size(), 1U);
+  SHAPE_ASSIGN_CHECK(*out_attrs, 0, in_attrs->at(0));
+  SHAPE_ASSIGN_CHECK(*in_attrs, 0, out_attrs->at(0));
+  const TShape& dshape = in_attrs->at(0);
+  if (use_length && !shape_is_none(dshape)) {
+    const SoftmaxParam& param = nnvm::get<SoftmaxParam>(attrs.parsed);
+    const int axis = CheckAxis(param.axis, dshape.ndim());
+    TShape lshape(dshape.ndim() > 1 ? dshape.ndim() - 1 : 1);
+    lshape[0] = 1;
+    for (int i = 0, j = 0; i < static_cast<int>(dshape.ndim()); ++i) {
+      if (i != axis) lshape[j++] = dshape[i];
+    }
+    SHAPE_ASSIGN_CHECK(*in_attrs, 1, lshape);
+  }
+  return !shape_is_none(out_attrs->at(0));
+}
+
+static inline bool SoftmaxOpType(const nnvm::NodeAttrs& attrs,
+                                 std::vector<int> *in_attrs,
+                                 std::vector<int> *out_attrs) {
+  const bool use_length = softmax_has_length(attrs);
+  CHECK_EQ(in_attrs->size(), use_length ? 2U : 1U);
+  CHECK_EQ(out_attrs->size(), 1U);
+  TYPE_ASSIGN_CHECK(*out_attrs, 0, in_attrs->at(0));
+  TYPE_ASSIGN_CHECK(*in_attrs, 0, out_attrs->at(0));
+  return out_attrs->at(0) != -1 && (!use_length || in_attrs->at(1) != -1);
+}
+
+/*!
+ * \brief the inputs of the gradient are the output gradient, the output and the length, and
+ *  its outputs the gradients of the data and of the length
+ */
+static inline bool SoftmaxGradOpShape(const nnvm::NodeAttrs& attrs,
+                                      std::vector<TShape> *in_attrs,
+                                      std::vector<TShape> *out_attrs) {
+  const bool use_length = softmax_has_length(attrs);
+  CHECK_EQ(in_attrs->size(), use_length ? 3U : 2U);
+  CHECK_EQ(out_attrs->size(), use_length ? 2U : 1U);
+  for (int i = 0; i < 2; ++i) {
+    SHAPE_ASSIGN_CHECK(*out_attrs, 0, in_attrs->at(i));
+  }
+  for (int i = 0; i < 2; ++i) {
+    SHAPE_ASSIGN_CHECK(*in_attrs, i, out_attrs->at(0));
+  }
+  if (use_length) {
+    SHAPE_ASSIGN_CHECK(*out_attrs, 1, in_attrs->at(2));
+    SHAPE_ASSIGN_CHECK(*in_attrs, 2, out_attrs->at(1));
+  }
+  return !shape_is_none(out_attrs->at(0));
+}
+
+static inline bool SoftmaxGradOpType(const nnvm::NodeAttrs& attrs,
+                                     std::vector<int> *in_attrs,
+                                     std::vector<int> *out_attrs) {
+  const bool use_length = softmax_has_length(attrs);
+  CHECK_EQ(in_attrs->size(), use_length ? 3U : 2U);
+  CHECK_EQ(out_attrs->size(), use_length ? 2U : 1U);
+  for (int i = 0; i < 2; ++i) {
+    TYPE_ASSIGN_CHECK(*out_attrs, 0, in_attrs->at(i));
+  }
+  for (int i = 0; i < 2; ++i) {
+    TYPE_ASSIGN_CHECK(*in_attrs, i, out_attrs->at(0));
+  }
+  if (use_length) {
+    TYPE_ASSIGN_CHECK(*out_attrs, 1, in_attrs->at(2));
+    TYPE_ASSIGN_CHECK(*in_attrs, 2, out_attrs->at(1));
+  }
+  return out_attrs->at(0) != -1 && (!use_length || out_attrs->at(1) != -1);
+}
+
+/*! \brief gradient node of softmax, which also takes the length when it is used */
+struct SoftmaxFGradient {
+  const char *op_name;
+  std::vector<nnvm::NodeEntry> operator()(const nnvm::NodePtr& n,
+                                          const std::vector<nnvm::NodeEntry>& ograds) const {
+    if (softmax_has_length(n->attrs)) {
+      std::vector<nnvm::NodeEntry> heads{ograds[0], nnvm::NodeEntry{n, 0, 0}, n->inputs[1]};
+      return MakeGradNode(op_name, n, heads, n->attrs.dict);
+    }
+    return ElemwiseGradUseOut{op_name}(n, ograds);
+  }
+};
+
+/*!
+ * \brief softmax over axis of the compacted 2 or 3 dimensional shape. length is null
+ *  without use_length, so that only one length type is instantiated for that case.
+ */
+template<typename OP, bool negate, typename xpu, typename DType, typename IType>
+inline void SoftmaxCompact(Stream<xpu> *s, DType *in, DType *out, IType *length,
+                           const TShape &shape, int axis, const DType temperature) {
+  if (shape.ndim() == 2) {
+    Softmax<OP, negate>(s, in, out, length, shape.get<2>(), axis, temperature);
+  } else {
+    Softmax<OP, negate>(s, in, out, length, shape.get<3>(), axis, temperature);
+  }
+}
+
+/*! \brief gradient counterpart of SoftmaxCompact */
+template<typename OP1, typename OP2, bool negate, typename xpu, typename DType, typename IType>
+inline void SoftmaxGradCompact(Stream<xpu> *s, OpReqType req, DType *out, DType *ograd,
+                               DType *igrad, IType *length, const TShape &shape, int axis,
+                               const DType temperature) {
+  MXNET_ASSIGN_REQ_SWITCH(req, Req, {
+    if (shape.ndim() == 2) {
+      SoftmaxGrad<OP1, OP2, Req, negate>(s, out, ograd, igrad, length, shape.get<2>(), axis,
+                                         temperature);
+    } else {
+      SoftmaxGrad<OP1, OP2, Req, negate>(s, out, ograd, igrad, length, shape.get<3>(), axis,
+                                         temperature);
+    }
+  });
+}
+
 template<typename xpu, typename OP, bool negate = false>
 void SoftmaxCompute(const nnvm::NodeAttrs& attrs,
                     const OpContext& ctx,
@@ -297,15 +679,18 @@ void SoftmaxCompute(const nnvm::NodeAttrs& attrs,
   const double temperature = param.temperature.has_value() ?
     param.temperature.value() : 1.0;
   TShape shape = AxisShapeCompact(inputs[0].shape_, &axis, true);
+  Stream<xpu> *s = ctx.get_stream<xpu>();
   MSHADOW_REAL_TYPE_SWITCH(inputs[0].type_flag_, DType, {
-    if (shape.ndim() == 2) {
-      Softmax<OP, negate>(ctx.get_stream<xpu>(), inputs[0].dptr<DType>(),
-                          outputs[0].dptr<DType>(), shape.get<2>(), axis,
-                          static_cast<DType>(temperature));
+    DType *in = inputs[0].dptr<DType>();
+    DType *out = outputs[0].dptr<DType>();
+    if (param.use_length) {
+      MSHADOW_TYPE_SWITCH(inputs[1].type_flag_, IType, {
+        SoftmaxCompact<OP, negate>(s, in, out, inputs[1].dptr<IType>(), shape, axis,
+                                   static_cast<DType>(temperature));
+      });
     } else {
-      Softmax<OP, negate>(ctx.get_stream<xpu>(), inputs[0].dptr<DType>(),
-                          outputs[0].dptr<DType>(), shape.get<3>(), axis,
-                          static_cast<DType>(temperature));
+      SoftmaxCompact<OP, negate>(s, in, out, static_cast<int *>(nullptr), shape, axis,
+                                 static_cast<DType>(temperature));
     }
   });
 }
@@ -318,24 +703,34 @@ void SoftmaxGradCompute(const nnvm::NodeAttrs& attrs,
                         const std::vector<OpReqType>& req,
                         const std::vector<TBlob>& outputs) {
   using namespace mxnet_op;
-  if (req[0] == kNullOp) return;
   const SoftmaxParam& param = nnvm::get<SoftmaxParam>(attrs.parsed);
+  Stream<xpu> *s = ctx.get_stream<xpu>();
+  // the length is not differentiable, its gradient is 0
+  if (param.use_length && (req[1] == kWriteTo || req[1] == kWriteInplace)) {
+    MSHADOW_TYPE_SWITCH(outputs[1].type_flag_, IType, {
+      Kernel<set_zero, xpu>::Launch(s, outputs[1].Size(), outputs[1].dptr<IType>());
+    });
+  }
+  if (req[0] == kNullOp) return;
   int axis = CheckAxis(param.axis, inputs[0].ndim());
   const double temperature = param.temperature.has_value() ?
     param.temperature.value() : 1.0;
   TShape shape = AxisShapeCompact(inputs[0].shape_, &axis, true);
   MSHADOW_REAL_TYPE_SWITCH(inputs[0].type_flag_, DType, {
-    MXNET_ASSIGN_REQ_SWITCH(req[0], Req, {
-      if (shape.ndim() == 2) {
-        SoftmaxGrad<OP1, OP2, Req, negate>(ctx.get_stream<xpu>(), inputs[1].dptr<DType>(),
-                                           inputs[0].dptr<DType>(), outputs[0].dptr<DType>(),
-                                           shape.get<2>(), axis, static_cast<DType>(temperature));
-      } else {
-        SoftmaxGrad<OP1, OP2, Req, negate>(ctx.get_stream<xpu>(), inputs[1].dptr<DType>(),
-                                           inputs[0].dptr<DType>(), outputs[0].dptr<DType>(),
-                                           shape.get<3>(), axis, static_cast<DType>(temperature));
-      }
-    });
+    DType *out = inputs[1].dptr<DType>();
+    DType *ograd = inputs[0].dptr<DType>();
+    DType *igrad = outputs[0].dptr<DType>();
+    if (param.use_length) {
+      MSHADOW_TYPE_SWITCH(inputs[2].type_flag_, IType, {
+        SoftmaxGradCompact<OP1, OP2, negate>(s, req[0], out, ograd, igrad,
+                                             inputs[2].dptr<IType>(), shape, axis,
+                                             static_cast<DType>(temperature));
+      });
+    } else {
+      SoftmaxGradCompact<OP1, OP2, negate>(s, req[0], out, ograd, igrad,
+                                           static_cast<int *>(nullptr), shape, axis,
+                                           static_cast<DType>(temperature));
+    }
   });
 }
 
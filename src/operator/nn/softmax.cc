@@ -59,15 +59,55 @@ inline static bool SoftmaxStorageType(const nnvm::NodeAttrs& attrs,
                                       DispatchMode* dispatch_mode,
                                       std::vector<int> *in_attrs,
                                       std::vector<int> *out_attrs) {
-  CHECK_EQ(in_attrs->size(), 1);
-  CHECK_EQ(out_attrs->size(), 1);
+  CHECK_EQ(in_attrs->size(), softmax_has_length(attrs) ? 2U : 1U);
+  CHECK_EQ(out_attrs->size(), 1U);
 
   return MKLDNNStorageType(attrs, dev_mask, true, dispatch_mode, in_attrs,
                            out_attrs);
 }
 #endif
 
-MXNET_OPERATOR_REGISTER_UNARY(softmax)
+/*! \brief softmax and its variants, which take the length as a second input with use_length */
+#define MXNET_OPERATOR_REGISTER_SOFTMAX(name)                                     \
+  NNVM_REGISTER_OP(name)                                                          \
+  .set_num_inputs([](const nnvm::NodeAttrs& attrs) {                              \
+    return softmax_has_length(attrs) ? 2 : 1;                                     \
+  })                                                                              \
+  .set_num_outputs(1)                                                             \
+  .set_attr<nnvm::FListInputNames>("FListInputNames",                             \
+    [](const nnvm::NodeAttrs& attrs) {                                            \
+      return softmax_has_length(attrs) ?                                          \
+        std::vector<std::string>{"data", "length"} :                              \
+        std::vector<std::string>{"data"};                                         \
+    })                                                                            \
+  .set_attr<nnvm::FInferShape>("FInferShape", SoftmaxOpShape)                     \
+  .set_attr<nnvm::FInferType>("FInferType", SoftmaxOpType)                        \
+  .set_attr<nnvm::FInplaceOption>("FInplaceOption",                               \
+    [](const NodeAttrs& attrs){                                                   \
+      return std::vector<std::pair<int, int> >{{0, 0}};                           \
+    })                                                                            \
+  .set_attr_parser(ParamParser<SoftmaxParam>)                                     \
+  .add_argument("data", "NDArray-or-Symbol", "The input array.")                  \
+  .add_argument("length", "NDArray-or-Symbol", "The length array, used with use_length.")
+
+/*! \brief gradient of softmax, from the output gradient, the output and the length */
+#define MXNET_OPERATOR_REGISTER_SOFTMAX_GRAD(name)                                \
+  NNVM_REGISTER_OP(name)                                                          \
+  .set_num_inputs([](const nnvm::NodeAttrs& attrs) {                              \
+    return softmax_has_length(attrs) ? 3 : 2;                                     \
+  })                                                                              \
+  .set_num_outputs([](const nnvm::NodeAttrs& attrs) {                             \
+    return softmax_has_length(attrs) ? 2 : 1;                                     \
+  })                                                                              \
+  .set_attr<nnvm::FInferShape>("FInferShape", SoftmaxGradOpShape)                 \
+  .set_attr<nnvm::FInferType>("FInferType", SoftmaxGradOpType)                    \
+  .set_attr<nnvm::FInplaceOption>("FInplaceOption",                               \
+    [](const NodeAttrs& attrs){                                                   \
+      return std::vector<std::pair<int, int> >{{0, 0}, {1, 0}};                   \
+    })                                                                            \
+  .set_attr_parser(ParamParser<SoftmaxParam>)
+
+MXNET_OPERATOR_REGISTER_SOFTMAX(softmax)
 .describe(R"code(Applies the softmax function.
 
 The resulting array contains elements in the range (0,1) and the elements along the given axis sum up to 1.
@@ -90,8 +130,15 @@ Example::
   softmax(x,axis=1) = [[ 0.33333334,  0.33333334,  0.33333334],
                        [ 0.33333334,  0.33333334,  0.33333334]]
 
+With use_length, the length input gives the number of elements of each slice along the axis
+which are kept, it has the shape of the data without the axis. The other elements give 0::
+
+  length = [1, 2]
+
+  softmax(x, length, axis=1, use_length=True) = [[ 1.,   0.,   0. ],
+                                                 [ 0.5,  0.5,  0. ]]
+
 )code" ADD_FILELINE)
-.set_attr_parser(ParamParser<SoftmaxParam>)
 .set_attr<nnvm::FListOutputNames>("FListOutputNames",
     [](const NodeAttrs& attrs) {
     return std::vector<std::string>{"output"};
@@ -102,15 +149,14 @@ Example::
 .set_attr<FComputeEx>("FComputeEx<cpu>", SoftmaxComputeExCPU)
 .set_attr<FInferStorageType>("FInferStorageType", SoftmaxStorageType)
 #endif
-.set_attr<nnvm::FGradient>("FGradient", ElemwiseGradUseOut{"_backward_softmax"})
+.set_attr<nnvm::FGradient>("FGradient", SoftmaxFGradient{"_backward_softmax"})
 .add_arguments(SoftmaxParam::__FIELDS__());
 
-MXNET_OPERATOR_REGISTER_BINARY(_backward_softmax)
-.set_attr_parser(ParamParser<SoftmaxParam>)
+MXNET_OPERATOR_REGISTER_SOFTMAX_GRAD(_backward_softmax)
 .set_attr<FCompute>("FCompute<cpu>", SoftmaxGradCompute<cpu, op::mshadow_op::mul,
                                                         mxnet_op::softmax_bwd>);
 
-MXNET_OPERATOR_REGISTER_UNARY(softmin)
+MXNET_OPERATOR_REGISTER_SOFTMAX(softmin)
 .describe(R"code(Applies the softmin function.
 
 The resulting array contains elements in the range (0,1) and the elements along the given axis sum
@@ -135,21 +181,19 @@ Example::
                        [ 0.09003057,  0.24472848,  0.66524094]]
 
 )code" ADD_FILELINE)
-.set_attr_parser(ParamParser<SoftmaxParam>)
 .set_attr<nnvm::FListOutputNames>("FListOutputNames",
     [](const NodeAttrs& attrs) {
     return std::vector<std::string>{"output"};
 })
 .set_attr<FCompute>("FCompute<cpu>", SoftmaxCompute<cpu, mxnet_op::softmax_fwd, true>)
-.set_attr<nnvm::FGradient>("FGradient", ElemwiseGradUseOut{"_backward_softmin"})
+.set_attr<nnvm::FGradient>("FGradient", SoftmaxFGradient{"_backward_softmin"})
 .add_arguments(SoftmaxParam::__FIELDS__());
 
-MXNET_OPERATOR_REGISTER_BINARY(_backward_softmin)
-.set_attr_parser(ParamParser<SoftmaxParam>)
+MXNET_OPERATOR_REGISTER_SOFTMAX_GRAD(_backward_softmin)
 .set_attr<FCompute>("FCompute<cpu>", SoftmaxGradCompute<cpu, op::mshadow_op::mul,
                                                         mxnet_op::softmax_bwd, true>);
 
-MXNET_OPERATOR_REGISTER_UNARY(log_softmax)
+MXNET_OPERATOR_REGISTER_SOFTMAX(log_softmax)
 .describe(R"code(Computes the log softmax of the input.
 This is equivalent to computing softmax followed by log.
 
@@ -166,13 +210,11 @@ Examples::
 
 
 )code")
-.set_attr_parser(ParamParser<SoftmaxParam>)
 .set_attr<FCompute>("FCompute<cpu>", SoftmaxCompute<cpu, mxnet_op::log_softmax_fwd>)
-.set_attr<nnvm::FGradient>("FGradient", ElemwiseGradUseOut{"_backward_log_softmax"})
+.set_attr<nnvm::FGradient>("FGradient", SoftmaxFGradient{"_backward_log_softmax"})
 .add_arguments(SoftmaxParam::__FIELDS__());
 
-MXNET_OPERATOR_REGISTER_BINARY(_backward_log_softmax)
-.set_attr_parser(ParamParser<SoftmaxParam>)
+MXNET_OPERATOR_REGISTER_SOFTMAX_GRAD(_backward_log_softmax)
 .set_attr<FCompute>("FCompute<cpu>", SoftmaxGradCompute<cpu, mshadow_op::left,
                                                         mxnet_op::log_softmax_bwd>);
 
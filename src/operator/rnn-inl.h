@@ -111,6 +111,9 @@ inline size_t GetRNNWorkspaceSize(int seq_length,
     case rnn_enum::kLstm:
       size = (seq_length + 1) * batch_size * hidden_size * 4 + batch_size * hidden_size * 2
              + seq_length * batch_size * hidden_size * direction + hidden_size * seq_length * 8;
+      // the inference runs both directions at once, with gates and states for each
+      size += (direction - 1) * (seq_length * batch_size * hidden_size * 4
+                                 + batch_size * hidden_size * 2);
       break;
     case rnn_enum::kGru:
       size = seq_length * batch_size * hidden_size * direction * 4 + batch_size * hidden_size * 8;
@@ -31,6 +31,7 @@
 #include <mxnet/operator.h>
 #include <algorithm>
 #include <map>
+#include <memory>
 #include <vector>
 #include <string>
 #include <utility>
@@ -39,6 +40,9 @@
 #include "./operator_common.h"
 #include "./mshadow_op.h"
 #include "./linalg.h"
+#if MSHADOW_USE_MKL == 1
+#include "mkl.h"
+#endif
 
 
 namespace mxnet {
@@ -54,6 +58,84 @@ inline DType relu(DType x) {
   return x > 0.0f ? static_cast<float>(x) : 0.0f;
 }
 
+/*!
+ * \brief number of hidden units of one row the fused gate kernels of the inference
+ *  steps handle per task, so that small batches still use all threads
+ */
+const int kRNNGateBlock = 64;
+
+/*!
+ * \brief out = h * wh.T + beta * out, with the recurrent weight wh of a layer, at every step.
+ *  With MKL and MXNET_RNN_PACKED_WEIGHTS=1, a float weight is packed once per layer into the
+ *  internal format of the MKL gemm, rather than at every step.
+ */
+template<typename DType>
+class RecurrentGemm {
+ public:
+  RecurrentGemm(const Tensor<cpu, 2, DType>& wh, const int N) : wh_(wh) {}
+
+  void operator()(const Tensor<cpu, 2, DType>& h, const Tensor<cpu, 2, DType>& out,
+                  const DType beta) const {
+    linalg_gemm(h, wh_, out, DType(1), beta, false, true);
+  }
+
+ private:
+  Tensor<cpu, 2, DType> wh_;
+};
+
+#if MSHADOW_USE_MKL == 1
+template<>
+class RecurrentGemm<float> {
+ public:
+  RecurrentGemm(const Tensor<cpu, 2, float>& wh, const int N) : wh_(wh), packed_(nullptr) {
+    static const bool use_packed = dmlc::GetEnv("MXNET_RNN_PACKED_WEIGHTS", false);
+    if (!use_packed) return;
+    const int G = wh.size(0), H = wh.size(1);
+    packed_ = static_cast<float*>(mkl_malloc(cblas_sgemm_pack_get_size(CblasBMatrix, N, G, H),
+                                             64));
+    CHECK(packed_ != nullptr) << "Failed to allocate the packed RNN weight";
+    cblas_sgemm_pack(CblasRowMajor, CblasBMatrix, CblasTrans, N, G, H, 1.0f,
+                     wh.dptr_, wh.stride_, packed_);
+  }
+  RecurrentGemm(const RecurrentGemm&) = delete;
+  RecurrentGemm& operator=(const RecurrentGemm&) = delete;
+  ~RecurrentGemm() {
+    if (packed_ != nullptr) mkl_free(packed_);
+  }
+
+  void operator()(const Tensor<cpu, 2, float>& h, const Tensor<cpu, 2, float>& out,
+                  const float beta) const {
+    if (packed_ == nullptr) {
+      linalg_gemm(h, wh_, out, 1.0f, beta, false, true);
+      return;
+    }
+    cblas_sgemm_compute(CblasRowMajor, CblasNoTrans, CblasPacked, out.size(0), out.size(1),
+                        h.size(1), h.dptr_, h.stride_, packed_, out.size(1), beta,
+                        out.dptr_, out.stride_);
+  }
+
+ private:
+  Tensor<cpu, 2, float> wh_;
+  float* packed_;
+};
+#endif  // MSHADOW_USE_MKL == 1
+
+/*!
+ * \brief sets the n rows of out to the sum of the biases b1 and b2, of size len each,
+ *  so that a gemm with beta = 1 adds the biases
+ */
+template<typename DType>
+void FillBiasRows(const int n, const int len, const DType* b1, const DType* b2, DType* out) {
+  const int omp_threads = mxnet::engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  #pragma omp parallel for num_threads(omp_threads)
+  for (int i = 0; i < n; ++i) {
+    DType* row = out + static_cast<size_t>(i) * len;
+    for (int k = 0; k < len; ++k) {
+      row[k] = b2 ? b1[k] + b2[k] : b1[k];
+    }
+  }
+}
+
 template<typename DType>
 void LstmForwardTrainingSingleLayer(DType* ws,
                                     DType* rs,
@@ -201,60 +283,86 @@ void LstmForwardTraining(DType* ws,
   }
 }
 
+/*!
+ * \brief one layer of LSTM inference, in both directions if D == 2. The input projection of all
+ *  steps, biases included, is one gemm per direction. At every step, the recurrent gemm adds to
+ *  the projection of the step, and one parallel loop computes the gates and states of all
+ *  directions, so that the two directions run in the same steps.
+ */
 template<typename DType>
 void LstmForwardInferenceSingleLayer(DType* ws,
                                      bool state_outputs,
-                                     bool bid,
+                                     const int D,
                                      const int T,
                                      const int N,
                                      const int I,
                                      const int H,
                                      const Tensor<cpu, 2, DType> &x,
-                                     const Tensor<cpu, 2, DType> &hx,
-                                     const Tensor<cpu, 2, DType> &cx,
-                                     const Tensor<cpu, 3, DType> &y,
+                                     const DType* hx_ptr,
+                                     const DType* cx_ptr,
+                                     DType* y_ptr,
                                      DType* w_ptr,
                                      DType* b_ptr,
                                      DType* hy_ptr,
                                      DType* cy_ptr) {
   using namespace mshadow;
-  const Tensor<cpu, 2, DType> wx(w_ptr, Shape2(H * 4, I));
-  const Tensor<cpu, 2, DType> wh(w_ptr + I * H * 4, Shape2(H * 4, H));
-  const Tensor<cpu, 2, DType> bx(b_ptr, Shape2(4, H));
-  const Tensor<cpu, 2, DType> bh(b_ptr + H * 4, Shape2(4, H));
-  Tensor<cpu, 2, DType> yx_flat(ws, Shape2(T * N, H * 4));
-  Tensor<cpu, 2, DType> yh_flat(ws + T * N * H * 4, Shape2(N, H * 4));
-  const Tensor<cpu, 4, DType> yx(yx_flat.dptr_, Shape4(T, N, 4, H));
-  const Tensor<cpu, 3, DType> yh(yh_flat.dptr_, Shape3(N, 4, H));
-  Tensor<cpu, 2, DType> h(yh_flat.dptr_ + N * H * 4, Shape2(N, H));
-  Tensor<cpu, 2, DType> c(h.dptr_ + N * H, Shape2(N, H));
-  const int offset = bid ? H : 0;
-  const DType alpha = 1.0;
-  const DType beta = 0.0;
   const int cell_size = N * H;
-  linalg_gemm(x, wx, yx_flat, alpha, beta, false, true);
+  const int w_size = (I + H) * H * 4;
+  const int b_size = 2 * H * 4;
+  const size_t ws_size = static_cast<size_t>(T) * cell_size * 4 + cell_size * 2;
+  std::vector<std::unique_ptr<RecurrentGemm<DType>>> wh_gemm;
+  for (int d = 0; d < D; ++d) {
+    DType* yx = ws + d * ws_size;
+    const Tensor<cpu, 2, DType> wx(w_ptr + d * w_size, Shape2(H * 4, I));
+    const Tensor<cpu, 2, DType> wh(w_ptr + d * w_size + I * H * 4, Shape2(H * 4, H));
+    const DType* bx = b_ptr + d * b_size;
+    FillBiasRows(T * N, H * 4, bx, bx + H * 4, yx);
+    linalg_gemm(x, wx, Tensor<cpu, 2, DType>(yx, Shape2(T * N, H * 4)),
+                DType(1), DType(1), false, true);
+    wh_gemm.emplace_back(new RecurrentGemm<DType>(wh, N));
+  }
 
+  const int blocks = (H + kRNNGateBlock - 1) / kRNNGateBlock;
   const int omp_threads = mxnet::engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
   for (int i = 0; i < T; ++i) {
-    int t = bid ? T - 1 - i : i;
-    linalg_gemm(i ? h : hx, wh, yh_flat, alpha, beta, false, true);
+    const bool last = i == T - 1 && state_outputs;
+    for (int d = 0; d < D; ++d) {
+      const int t = d ? T - 1 - i : i;
+      DType* h = ws + d * ws_size + static_cast<size_t>(T) * cell_size * 4;
+      const DType* h_prev = i ? h : hx_ptr + d * cell_size;
+      (*wh_gemm[d])(Tensor<cpu, 2, DType>(const_cast<DType*>(h_prev), Shape2(N, H)),
+                    Tensor<cpu, 2, DType>(ws + d * ws_size + t * cell_size * 4,
+                                          Shape2(N, H * 4)),
+                    DType(1));
+    }
     #pragma omp parallel for num_threads(omp_threads)
-    for (int jk = 0; jk < cell_size; ++jk) {
-      int j = jk / H;
-      int k = jk % H;
-      DType it = sigmoid<DType>(yx[t][j][0][k] + yh[j][0][k] + bx[0][k] + bh[0][k]);
-      DType ft = sigmoid<DType>(yx[t][j][1][k] + yh[j][1][k] + bx[1][k] + bh[1][k]);
-      DType gt =           tanh(yx[t][j][2][k] + yh[j][2][k] + bx[2][k] + bh[2][k]);
-      DType ot = sigmoid<DType>(yx[t][j][3][k] + yh[j][3][k] + bx[3][k] + bh[3][k]);
-      DType ct = (i ? c[j][k] : cx[j][k]) * ft + it * gt;
-      DType ht = ot * tanh(ct);
-      y[t][j][k + offset] = ht;
-      if (i == T - 1 && state_outputs) {
-        hy_ptr[jk] = ht;
-        cy_ptr[jk] = ct;
-      } else {
-        h[j][k] = ht;
-        c[j][k] = ct;
+    for (int task = 0; task < D * N * blocks; ++task) {
+      const int d = task / (N * blocks);
+      const int j = task / blocks % N;
+      const int begin = task % blocks * kRNNGateBlock;
+      const int end = std::min(begin + kRNNGateBlock, H);
+      const int t = d ? T - 1 - i : i;
+      // the gates i, f, g and o of row j, H values each
+      const DType* gates = ws + d * ws_size + (static_cast<size_t>(t) * N + j) * H * 4;
+      DType* h = ws + d * ws_size + static_cast<size_t>(T) * cell_size * 4 + j * H;
+      DType* c = h + cell_size;
+      const DType* c_prev = i ? c : cx_ptr + d * cell_size + j * H;
+      DType* y = y_ptr + (static_cast<size_t>(t) * N + j) * D * H + d * H;
+      for (int k = begin; k < end; ++k) {
+        const DType it = sigmoid<DType>(gates[k]);
+        const DType ft = sigmoid<DType>(gates[H + k]);
+        const DType gt = tanh(gates[2 * H + k]);
+        const DType ot = sigmoid<DType>(gates[3 * H + k]);
+        const DType ct = c_prev[k] * ft + it * gt;
+        const DType ht = ot * tanh(ct);
+        y[k] = ht;
+        if (last) {
+          hy_ptr[d * cell_size + j * H + k] = ht;
+          cy_ptr[d * cell_size + j * H + k] = ct;
+        } else {
+          h[k] = ht;
+          c[k] = ct;
+        }
       }
     }
   }
@@ -277,14 +385,10 @@ void LstmForwardInference(DType* ws,
                           DType* y_ptr,
                           DType* hy_ptr,
                           DType* cy_ptr) {
-  const int total_layers = D * L;
-  Tensor<cpu, 3, DType> hx(hx_ptr, Shape3(total_layers, N, H));
-  Tensor<cpu, 3, DType> cx(cx_ptr, Shape3(total_layers, N, H));
   const int b_size = 2 * H * 4;
   const int cell_size = N * H;
-  DType* y_tmp_ptr = ws + (T + 1) * cell_size * 4 + cell_size * 2;
+  DType* y_tmp_ptr = ws + D * (T * cell_size * 4 + cell_size * 2);
   DType* y_cur_ptr = y_ptr;
-  int idx = 0;  // state & cell state's idx;
   bool flag = L % 2 ? false : true;
   for (int i = 0; i < L; ++i) {
     const int input_size = i ? H * D : I;
@@ -295,31 +399,17 @@ void LstmForwardInference(DType* ws,
       flag = !flag;
     }
     Tensor<cpu, 2, DType> x(x_ptr, Shape2(T * N, input_size));
-    Tensor<cpu, 3, DType> y(y_cur_ptr, Shape3(T, N, H * D));
-    LstmForwardInferenceSingleLayer<DType>(ws, state_outputs, false, T, N, input_size, H,
-                                           x, hx[idx], cx[idx], y, w_ptr, b_ptr, hy_ptr, cy_ptr);
-    // If bidirectional, then calculate the reverse direction's forward result.
-    if (D == 2) {
-      w_ptr += w_size;
-      b_ptr += b_size;
-      ++idx;
-      if (state_outputs) {
-        hy_ptr += cell_size;
-        cy_ptr += cell_size;
-      }
-      LstmForwardInferenceSingleLayer<DType>(ws, state_outputs, true, T, N, input_size, H,
-                                             x, hx[idx], cx[idx], y, w_ptr, b_ptr, hy_ptr, cy_ptr);
-    }
-    // Don't need to move pointer in the last layer.
-    if (i != L - 1) {
-      w_ptr += w_size;
-      b_ptr += b_size;
-      x_ptr = y_cur_ptr;
-      ++idx;
-      if (state_outputs) {
-        hy_ptr += cell_size;
-        cy_ptr += cell_size;
-      }
+    LstmForwardInferenceSingleLayer<DType>(ws, state_outputs, D, T, N, input_size, H, x,
+                                           hx_ptr, cx_ptr, y_cur_ptr, w_ptr, b_ptr,
+                                           hy_ptr, cy_ptr);
+    w_ptr += D * w_size;
+    b_ptr += D * b_size;
+    x_ptr = y_cur_ptr;
+    hx_ptr += D * cell_size;
+    cx_ptr += D * cell_size;
+    if (state_outputs) {
+      hy_ptr += D * cell_size;
+      cy_ptr += D * cell_size;
     }
   }
 }
@@ -584,9 +674,13 @@ void LstmBackward(DType* ws,
   }
 }
 
+/*!
+ * \brief one layer of GRU inference, in both directions if D == 2, fused like
+ *  LstmForwardInferenceSingleLayer. The hidden states of the previous step are read from y in
+ *  place, with the stride of its rows.
+ */
 template<typename DType>
 void GruForwardInferenceSingleLayer(DType* ws,
-                                    DType* tmp_buf,
                                     bool state_outputs,
                                     const int D,
                                     const int T,
@@ -601,135 +695,65 @@ void GruForwardInferenceSingleLayer(DType* ws,
                                     DType* bh_ptr,
                                     DType* y_ptr,
                                     DType* hy_ptr) {
-  DType* ht = y_ptr;
-  DType* ht_1 = y_ptr;
-  DType* back_ht_1 = y_ptr + (T-1) * N * H * D + H;
-  DType* back_ht = back_ht_1;
-  DType* gemmC1  = ws;              // [D, T, N, 3 * H]
-  DType* gemmC2  = gemmC1 + D * T * N * 3 * H;  // N * 3 * H
-  DType* rt = gemmC2 + N * 3 * H;
-  DType* zt = rt + N * H;
-  DType* nt = zt + N * H;
-  DType* back_wx_ptr = wx_ptr + I * 3 * H + H * 3 * H;
-  DType* back_wh_ptr = wh_ptr + I * 3 * H + H * 3 * H;
-  DType* back_bx_ptr = (bx_ptr != NULL)? bx_ptr + 3 * H * 2 : NULL;
-  DType* back_bh_ptr = (bh_ptr != NULL)? bh_ptr + 3 * H * 2: NULL;
-  DType* back_gemmC1 = gemmC1 + T * N * 3 * H;
-  DType* gemmC1_t = gemmC1;
-
-  const Tensor<cpu, 2, DType> wx(wx_ptr, Shape2(H * 3, I));
-  const Tensor<cpu, 2, DType> wh(wh_ptr, Shape2(H * 3, H));
-  const Tensor<cpu, 2, DType> bx(bx_ptr, Shape2(3, H));
-  const Tensor<cpu, 2, DType> bh(bh_ptr, Shape2(3, H));
-  const Tensor<cpu, 2, DType> back_wx(back_wx_ptr, Shape2(H * 3, I));
-  const Tensor<cpu, 2, DType> back_wh(back_wh_ptr, Shape2(H * 3, H));
-  const Tensor<cpu, 2, DType> back_bx(back_bx_ptr, Shape2(3, H));
-  const Tensor<cpu, 2, DType> back_bh(back_bh_ptr, Shape2(3, H));
-  const int omp_threads = mxnet::engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
-  if (D == 1) {
-    #pragma omp parallel for num_threads(omp_threads)
-    for (int i = 0; i < N; i++)
-      for (int j = 0; j < H; j++) {
-        y_ptr[i * H + j] = hx[i][j];
-      }
-  } else {
-    #pragma omp parallel for num_threads(omp_threads)
-    for (int i = 0; i < N; i++)
-      for (int j = 0; j < H; j++) {
-        y_ptr[i * D * H + j] = hx[i][j];
-        back_ht_1[i * D * H + j] = hx[N + i][j];
-    }
-  }
-  Tensor<cpu, 2, DType> dgemmC1(ws, Shape2(T * N, 3 * H));
-  Tensor<cpu, 2, DType> dgemmC2(gemmC2, Shape2(N, 3 * H));
-  Tensor<cpu, 2, DType> dback_gemmC1(back_gemmC1, Shape2(T * N, 3 * H));
-
-  // x * wx.T : [T * N, I] * [I, 3 * H]
-  DType alpha = 1.0;
-  DType beta = 0.0;
-  linalg_gemm(x, wx, dgemmC1, alpha, beta, false, true);
-  if (D == 2) {
-    linalg_gemm(x, back_wx, dback_gemmC1, alpha, beta, false, true);
+  using namespace mshadow;
+  const int cell_size = N * H;
+  const int w_size = I * 3 * H + H * 3 * H;
+  DType* gemmC1 = ws;  // [D, T, N, 3 * H]
+  DType* gemmC2 = gemmC1 + D * T * N * 3 * H;  // [D, N, 3 * H]
+  // the gates r and z take the sum of both biases, the gate n only the one of x
+  std::vector<DType> bias(3 * H);
+  std::vector<std::unique_ptr<RecurrentGemm<DType>>> wh_gemm;
+  for (int d = 0; d < D; ++d) {
+    const DType* bx = bx_ptr + d * 3 * H * 2;
+    const DType* bh = bh_ptr + d * 3 * H * 2;
+    for (int k = 0; k < 3 * H; ++k) {
+      bias[k] = k < 2 * H ? bx[k] + bh[k] : bx[k];
+    }
+    DType* c1 = gemmC1 + d * T * N * 3 * H;
+    FillBiasRows<DType>(T * N, 3 * H, bias.data(), nullptr, c1);
+    const Tensor<cpu, 2, DType> wx(wx_ptr + d * w_size, Shape2(H * 3, I));
+    const Tensor<cpu, 2, DType> wh(wh_ptr + d * w_size, Shape2(H * 3, H));
+    linalg_gemm(x, wx, Tensor<cpu, 2, DType>(c1, Shape2(T * N, 3 * H)),
+                DType(1), DType(1), false, true);
+    wh_gemm.emplace_back(new RecurrentGemm<DType>(wh, N));
   }
 
-  for (int t = 0; t < T; t++) {
-    //  perform the first direction, X * wx and H * wh for each step
-    //  ht-1 * wh, ht-1:[N, H] wh:[3 * H, H]
-    Tensor<cpu, 2, DType> dht_1(ht_1, Shape2(N, D * H));
-    if (D == 1) {
-      linalg_gemm(dht_1, wh, dgemmC2, alpha, beta, false, true);
-    } else {
-      Tensor<cpu, 3, DType> dht_1_tmp = Tensor<cpu, 3, DType>(reinterpret_cast<DType*>(tmp_buf),
-                                     Shape3(D, H, N));
-      dht_1_tmp = reshape(dht_1.T(), Shape3(D, H, N));
-      linalg_gemm(dht_1_tmp[0], wh, dgemmC2, alpha, beta, true, true);
+  const int blocks = (H + kRNNGateBlock - 1) / kRNNGateBlock;
+  const int omp_threads = mxnet::engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  for (int i = 0; i < T; ++i) {
+    for (int d = 0; d < D; ++d) {
+      // ht-1 * wh, ht-1:[N, H] wh:[3 * H, H]
+      const int t_prev = d ? T - i : i - 1;
+      const Tensor<cpu, 2, DType> h_prev = i ?
+        Tensor<cpu, 2, DType>(y_ptr + t_prev * N * D * H + d * H, Shape2(N, H), D * H, nullptr) :
+        Tensor<cpu, 2, DType>(hx.dptr_ + d * cell_size, Shape2(N, H));
+      (*wh_gemm[d])(h_prev, Tensor<cpu, 2, DType>(gemmC2 + d * N * 3 * H, Shape2(N, 3 * H)),
+                    DType(0));
     }
-    gemmC1_t = gemmC1 + t * N * 3 * H;
     #pragma omp parallel for num_threads(omp_threads)
-    for (int i = 0; i < N; ++i) {
-      for (int j = 0; j < H; ++j) {
-        int rtb = i * 3 * H;
-        int ztb = i * 3 * H + H;
-        int ntb = i * 3 * H + 2 * H;
-        rt[i * H + j] = sigmoid(gemmC1_t[rtb + j] + gemmC2[rtb + j]
-            + bx[0][j] + bh[0][j]);
-        zt[i * H + j] = sigmoid(gemmC1_t[ztb + j] + gemmC2[ztb + j]
-            + bx[1][j] + bh[1][j]);
-        nt[i * H + j] = tanh(gemmC1_t[ntb + j] + bx[2][j] +
-            rt[i * H + j] * (gemmC2[ntb + j] + bh[2][j]));
-        ht[i * D * H + j] = (1-zt[i * H + j]) * nt[i * H + j] +
-            zt[i * H + j] * ht_1[i * D * H + j];
-      }
-    }
-    ht_1 = ht;
-    ht = ht + D * H * N;
-    //  perform the second direction
-    if (D == 2) {
-      gemmC1_t = back_gemmC1 + (T - 1 - t) * N * 3 * H;
-      Tensor<cpu, 2, DType> dback_ht_1(back_ht_1 - H, Shape2(N, D * H));
-      Tensor<cpu, 3, DType> dback_ht_1_tmp = Tensor<cpu, 3, DType>
-          (reinterpret_cast<DType*>(tmp_buf), Shape3(D, H, N));
-      dback_ht_1_tmp = reshape(dback_ht_1.T(), Shape3(D, H, N));
-      linalg_gemm(dback_ht_1_tmp[1], back_wh, dgemmC2, alpha, beta, true, true);
-
-      #pragma omp parallel for num_threads(omp_threads)
-      for (int i = 0; i < N; ++i) {
-        for (int j = 0; j < H; ++j) {
-          int rtb = i * 3 * H;
-          int ztb = i * 3 * H + H;
-          int ntb = i * 3 * H + 2 * H;
-          rt[i * H + j] = sigmoid(gemmC1_t[rtb + j] +
-              gemmC2[rtb + j] + back_bx[0][j] + back_bh[0][j]);
-          zt[i * H + j] = sigmoid(gemmC1_t[ztb + j] +
-              gemmC2[ztb + j] + back_bx[1][j]+ back_bh[1][j]);
-          nt[i * H + j] = tanh(gemmC1_t[ntb + j] + back_bx[2][j]
-              + rt[i * H + j] * (gemmC2[ntb + j] + back_bh[2][j]));
-          back_ht[i * D * H + j] = (1 - zt[i * H + j]) * nt[i * H + j]
-              + zt[i * H + j] * back_ht_1[i * D * H + j];
+    for (int task = 0; task < D * N * blocks; ++task) {
+      const int d = task / (N * blocks);
+      const int j = task / blocks % N;
+      const int begin = task % blocks * kRNNGateBlock;
+      const int end = std::min(begin + kRNNGateBlock, H);
+      const int t = d ? T - 1 - i : i;
+      const int t_prev = d ? t + 1 : t - 1;
+      // the gates r, z and n of row j, H values each
+      const DType* c1 = gemmC1 + ((d * T + t) * N + j) * 3 * H;
+      const DType* c2 = gemmC2 + (d * N + j) * 3 * H;
+      const DType* bh = bh_ptr + d * 3 * H * 2;
+      const DType* h_prev = i ? y_ptr + (t_prev * N + j) * D * H + d * H
+                              : hx.dptr_ + d * cell_size + j * H;
+      DType* h = y_ptr + (t * N + j) * D * H + d * H;
+      for (int k = begin; k < end; ++k) {
+        const DType rt = sigmoid(c1[k] + c2[k]);
+        const DType zt = sigmoid(c1[H + k] + c2[H + k]);
+        const DType nt = tanh(c1[2 * H + k] + rt * (c2[2 * H + k] + bh[2 * H + k]));
+        h[k] = (1 - zt) * nt + zt * h_prev[k];
+        if (i == T - 1 && state_outputs) {
+          hy_ptr[d * cell_size + j * H + k] = h[k];
         }
       }
-      back_ht_1 = back_ht;
-      back_ht = back_ht - D * H * N;
-    }
-  }
-  //  copy last state to hy, from(N, H * D) to (D, N, H)
-  if (state_outputs) {
-    if (D == 1) {
-      DType* y_start = y_ptr + (T - 1) * N * H;
-      #pragma omp parallel for num_threads(omp_threads)
-      for (int i = 0; i < N; i++)
-        for (int j = 0; j < H; j++) {
-          hy_ptr[i * H + j] = y_start[i * H + j];
-        }
-    } else {
-      DType* y_start = y_ptr + (T - 1) * N * H * D;
-      DType* y_back_start = y_ptr + H;
-      #pragma omp parallel for num_threads(omp_threads)
-      for (int i = 0; i < N; i++)
-        for (int j = 0; j < H; j++) {
-          hy_ptr[i * H + j] = y_start[i * D * H + j];
-          hy_ptr[N * H + i * H + j] = y_back_start[i * D * H + j];
-        }
     }
   }
 }
@@ -756,7 +780,6 @@ void GruForwardInference(DType* ws,
 
   DType* y_tmp = ws;
   DType* y_l = x_ptr;
-  DType* tmp_buf = y_tmp + D * T * N * H;
   DType* ws2 = y_tmp + D * T * N * H + D * H * N;
 
   DType* wx_l = wx;
@@ -773,8 +796,8 @@ void GruForwardInference(DType* ws,
       y_l = y_tmp;
     }
     Tensor<cpu, 2, DType> hx_l = hx[D * l];
-    GruForwardInferenceSingleLayer<DType>(ws2, tmp_buf, state_outputs, D, T, N, I, H,
-                                        x_l, hx_l, wx_l, wh_l, bx_l, bh_l, y_l, hy_l);
+    GruForwardInferenceSingleLayer<DType>(ws2, state_outputs, D, T, N, I, H,
+                                          x_l, hx_l, wx_l, wh_l, bx_l, bh_l, y_l, hy_l);
     hy_l = hy_l + D * N * H;
     bx_l = bx_l + 3 * H * D * 2;
     bh_l = bh_l + 3 * H * D * 2;
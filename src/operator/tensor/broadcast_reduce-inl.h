@@ -31,6 +31,7 @@
 #include <string>
 #include <utility>
 #include "../mshadow_op.h"
+#include "../mxnet_op.h"
 #include "../operator_common.h"
 
 namespace mxnet {
@@ -227,10 +228,217 @@ void seq_reduce_compute_extra_mem(const size_t N, const size_t M, const bool add
   }
 }
 
+/*! \brief independent partial results of the reduction of a contiguous row */
+const int kReduceLanes = 8;
+/*! \brief columns reduced together along a strided axis, whose results stay in cache */
+const index_t kReduceColTile = 256;
+/*! \brief fewest elements for a thread, when the reduced axis is split among threads */
+const index_t kReduceMinChunk = 16384;
+
+/*!
+ * \brief reductions of contiguous elements. The reducers take volatile references, which keep
+ *  every step in memory, so that they reduce into independent lanes which the sum specializes.
+ */
+template<typename Reducer>
+struct contiguous_reduce {
+  /*! \brief reduces OP(x[0]), ..., OP(x[n-1]) into val and residual */
+  template<typename OP, typename DType>
+  MSHADOW_CINLINE static void Row(const DType* x, const index_t n, DType* val,
+                                  DType* residual) {
+    DType lane[kReduceLanes], lane_residual[kReduceLanes];
+    for (int l = 0; l < kReduceLanes; ++l) {
+      Reducer::SetInitValue(lane[l], lane_residual[l]);
+    }
+    index_t j = 0;
+    for (; j + kReduceLanes <= n; j += kReduceLanes) {
+      for (int l = 0; l < kReduceLanes; ++l) {
+        Reducer::Reduce(lane[l], OP::Map(x[j + l]), lane_residual[l]);
+      }
+    }
+    for (; j < n; ++j) {
+      Reducer::Reduce(*val, OP::Map(x[j]), *residual);
+    }
+    for (int l = 0; l < kReduceLanes; ++l) {
+      Reducer::Merge(*val, *residual, lane[l], lane_residual[l]);
+    }
+  }
+
+  /*! \brief reduces OP(x[j]) into val[j] and residual[j], for j < n */
+  template<typename OP, typename DType>
+  MSHADOW_CINLINE static void Columns(const DType* x, const index_t n, DType* val,
+                                      DType* residual) {
+    for (index_t j = 0; j < n; ++j) {
+      Reducer::Reduce(val[j], OP::Map(x[j]), residual[j]);
+    }
+  }
+};
+
+/*! \brief the compensated sum of red::sum, without volatile so that it vectorizes */
+template<>
+struct contiguous_reduce<red::sum> {
+  template<typename OP, typename DType>
+  MSHADOW_CINLINE static void Row(const DType* x, const index_t n, DType* val,
+                                  DType* residual) {
+    DType lane[kReduceLanes], lane_residual[kReduceLanes];
+    for (int l = 0; l < kReduceLanes; ++l) {
+      red::sum::SetInitValue(lane[l], lane_residual[l]);
+    }
+    index_t j = 0;
+    for (; j + kReduceLanes <= n; j += kReduceLanes) {
+      for (int l = 0; l < kReduceLanes; ++l) {
+        const DType y = DType(OP::Map(x[j + l])) - lane_residual[l];
+        const DType t = lane[l] + y;
+        lane_residual[l] = (t - lane[l]) - y;
+        lane[l] = t;
+      }
+    }
+    for (; j < n; ++j) {
+      red::sum::Reduce(*val, OP::Map(x[j]), *residual);
+    }
+    for (int l = 0; l < kReduceLanes; ++l) {
+      red::sum::Merge(*val, *residual, lane[l], lane_residual[l]);
+    }
+  }
+
+  template<typename OP, typename DType>
+  MSHADOW_CINLINE static void Columns(const DType* __restrict x, const index_t n,
+                                      DType* __restrict val, DType* __restrict residual) {
+    for (index_t j = 0; j < n; ++j) {
+      const DType y = DType(OP::Map(x[j])) - residual[j];
+      const DType t = val[j] + y;
+      residual[j] = (t - val[j]) - y;
+      val[j] = t;
+    }
+  }
+};
+
+/*!
+ * \brief whether the elements of big reduced into each element of small lie along a single
+ *  axis, once the axes of size 1 are left out: big is then (outer, M, inner) and small
+ *  (outer, inner) in row-major order. It covers the reductions of the first, the last, a middle
+ *  or all axes after the reduced axes are merged.
+ */
+template<int ndim>
+inline bool SingleAxisReduce(const Shape<ndim>& small, const Shape<ndim>& big,
+                             index_t* outer, index_t* M, index_t* inner) {
+  int first = -1, last = -1;
+  for (int i = 0; i < ndim; ++i) {
+    if (small[i] != big[i]) {
+      if (first < 0) first = i;
+      last = i;
+    }
+  }
+  if (first < 0) return false;
+  for (int i = first; i <= last; ++i) {
+    if (small[i] == big[i] && big[i] != 1) return false;
+  }
+  *outer = *M = *inner = 1;
+  for (int i = 0; i < ndim; ++i) {
+    if (i < first) {
+      *outer *= big[i];
+    } else if (i <= last) {
+      *M *= big[i];
+    } else {
+      *inner *= big[i];
+    }
+  }
+  return true;
+}
+
+/*!
+ * \brief reduction of a number of rows of width elements, stride apart, into val and residual:
+ *  a contiguous row when stride is 1, else the columns row after row. It is run through
+ *  mxnet_op::IsaDispatch, for the instruction set of the cpu.
+ */
+template<typename Reducer, typename OP>
+struct reduce_tile {
+  template<typename DType>
+  MSHADOW_CINLINE static void Run(const DType* big, const index_t rows, const index_t stride,
+                                  const index_t width, DType* val, DType* residual) {
+    if (stride == 1) {
+      contiguous_reduce<Reducer>::template Row<OP>(big, rows, val, residual);
+      return;
+    }
+    for (index_t k = 0; k < rows; ++k) {
+      contiguous_reduce<Reducer>::template Columns<OP>(big + k * stride, width, val, residual);
+    }
+  }
+};
+
+/*!
+ * \brief reduction of big, (outer, M, inner) in row-major order, along its middle axis into
+ *  small, (outer, inner). The work is split in tiles of kReduceColTile columns of each outer
+ *  index, and the reduced axis in chunks when there are fewer tiles than threads. The partial
+ *  results of the chunks are merged in order, so that the result does not depend on the timing.
+ */
+template<typename Reducer, typename DType, typename OP>
+void ReduceAxis(const index_t outer, const index_t M, const index_t inner, const bool addto,
+                const DType* big, DType* small) {
+  const int nthreads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  const index_t tiles = (inner + kReduceColTile - 1) / kReduceColTile;
+  const index_t tasks = outer * tiles;
+  index_t chunks = 1;
+  if (tasks < nthreads) {
+    const index_t width = std::min(inner, kReduceColTile);
+    chunks = std::min<index_t>((nthreads + tasks - 1) / tasks, M * width / kReduceMinChunk);
+    chunks = std::max<index_t>(chunks, 1);
+  }
+  const index_t tile_size = 2 * kReduceColTile;
+  std::vector<DType> partial(chunks > 1 ? tasks * chunks * tile_size : 0);
+  #pragma omp parallel for num_threads(nthreads)
+  for (index_t t = 0; t < tasks * chunks; ++t) {
+    const index_t task = t / chunks, chunk = t % chunks;
+    const index_t a = task / tiles, j0 = (task % tiles) * kReduceColTile;
+    const index_t width = std::min(kReduceColTile, inner - j0);
+    const index_t k0 = chunk * M / chunks, k1 = (chunk + 1) * M / chunks;
+    DType val[kReduceColTile], residual[kReduceColTile];
+    for (index_t j = 0; j < width; ++j) {
+      Reducer::SetInitValue(val[j], residual[j]);
+    }
+    mxnet_op::IsaDispatch<reduce_tile<Reducer, OP>>(big + (a * M + k0) * inner + j0,
+                                                     k1 - k0, inner, width, val, residual);
+    if (chunks == 1) {
+      for (index_t j = 0; j < width; ++j) {
+        Reducer::Finalize(val[j], residual[j]);
+        assign(&small[a * inner + j0 + j], addto, val[j]);
+      }
+    } else {
+      std::copy(val, val + width, partial.begin() + t * tile_size);
+      std::copy(residual, residual + width, partial.begin() + t * tile_size + kReduceColTile);
+    }
+  }
+  if (chunks == 1) return;
+  #pragma omp parallel for num_threads(nthreads)
+  for (index_t task = 0; task < tasks; ++task) {
+    const index_t a = task / tiles, j0 = (task % tiles) * kReduceColTile;
+    const index_t width = std::min(kReduceColTile, inner - j0);
+    DType* val = &partial[task * chunks * tile_size];
+    DType* residual = val + kReduceColTile;
+    for (index_t chunk = 1; chunk < chunks; ++chunk) {
+      DType* chunk_val = val + chunk * tile_size;
+      DType* chunk_residual = chunk_val + kReduceColTile;
+      for (index_t j = 0; j < width; ++j) {
+        Reducer::Merge(val[j], residual[j], chunk_val[j], chunk_residual[j]);
+      }
+    }
+    for (index_t j = 0; j < width; ++j) {
+      Reducer::Finalize(val[j], residual[j]);
+      assign(&small[a * inner + j0 + j], addto, val[j]);
+    }
+  }
+}
+
 template <typename Reducer, int ndim, typename DType, typename OP>
 void Reduce(Stream<cpu>* s, const TBlob& small, const OpReqType req,
             const Tensor<cpu, 1, char>& workspace, const TBlob& big) {
   if (req == kNullOp) return;
+  index_t outer, M_axis, inner;
+  if (SingleAxisReduce(small.shape_.get<ndim>(), big.shape_.get<ndim>(),
+                       &outer, &M_axis, &inner)) {
+    ReduceAxis<Reducer, DType, OP>(outer, M_axis, inner, req == kAddTo,
+                                   big.dptr<DType>(), small.dptr<DType>());
+    return;
+  }
   Shape<ndim> rshape, rstride;
   diff(small.shape_.get<ndim>(), big.shape_.get<ndim>(), &rshape, &rstride);
   size_t N = small.shape_.Size(), M = rshape.Size();
@@ -244,6 +452,13 @@ void ReduceWithExtraMem(Stream<cpu>* s, const TBlob& small, const OpReqType req,
                         const Tensor<cpu, 1, char>& workspace, const TBlob& big) {
   using namespace mxnet_op;
   if (req == kNullOp) return;
+  index_t outer, M_axis, inner;
+  if (SingleAxisReduce(small.shape_.get<ndim>(), big.shape_.get<ndim>(),
+                       &outer, &M_axis, &inner)) {
+    ReduceAxis<Reducer, DType, OP>(outer, M_axis, inner, req == kAddTo,
+                                   big.dptr<DType>(), small.dptr<DType>());
+    return;
+  }
   Shape<ndim> rshape, rstride;
   diff(small.shape_.get<ndim>(), big.shape_.get<ndim>(), &rshape, &rstride);
   index_t* ws_dptr = reinterpret_cast<index_t*>(workspace.dptr_);
@@ -346,14 +346,43 @@ inline bool DotBackwardInferStorageType(const nnvm::NodeAttrs& attrs,
   return dispatched;
 }
 
+/*!
+ * \brief number of columns of the dense operands which the cache blocked kernel of
+ *  dot(csr, dns) = dns processes at once
+ */
+const nnvm::dim_t kDotColBlock = 512;
+
+/*!
+ * \brief splits the rows of a csr matrix into num_blocks blocks of about the same number of
+ *  non-zeros. Block i holds the rows [row_starts[i], row_starts[i+1]).
+ */
+template<typename IType>
+inline void CsrNnzRowBlocks(const IType* indptr, const nnvm::dim_t num_rows,
+                            const nnvm::dim_t num_blocks, std::vector<nnvm::dim_t>* row_starts) {
+  using nnvm::dim_t;
+  const dim_t nnz = indptr[num_rows] - indptr[0];
+  row_starts->resize(num_blocks + 1);
+  (*row_starts)[0] = 0;
+  for (dim_t i = 1; i < num_blocks; ++i) {
+    const IType target = static_cast<IType>(indptr[0] + nnz * i / num_blocks);
+    // the first row which starts at or after the non-zero target
+    const dim_t row = std::lower_bound(indptr, indptr + num_rows + 1, target) - indptr;
+    (*row_starts)[i] = std::max((*row_starts)[i - 1], std::min(row, num_rows));
+  }
+  (*row_starts)[num_blocks] = num_rows;
+}
+
 /*!
  * \brief CPU Kernel of dot(csr, dns1) = dns2
- * Parallelization by row blocks
+ * Parallelization by row blocks of about the same number of non-zeros. The columns of dns1
+ * and dns2 are processed kDotColBlock at a time, so that the block of an output row stays in
+ * cache while the rows of dns1 it sums are streamed, in contiguous loops which are vectorized.
  */
-struct DotCsrDnsDnsByRowBlocks {
+struct DotCsrDnsDnsByNnzBlocks {
   /*!
    * \brief
    * \param i the i-th thread
+   * \param row_starts first row of each block, and the number of rows
    */
   template<typename DType, typename IType, typename CType>
   MSHADOW_CINLINE static void Map(int i,
@@ -362,21 +391,21 @@ struct DotCsrDnsDnsByRowBlocks {
                                   const IType* indptr_l,
                                   const CType* col_idx_l,
                                   const DType* data_r,
-                                  const nnvm::dim_t seg_len,
-                                  const nnvm::dim_t num_rows,
+                                  const nnvm::dim_t* row_starts,
                                   const nnvm::dim_t num_cols) {
     using nnvm::dim_t;
-    const dim_t seg_start = i * seg_len;
-    if (seg_start >= num_rows) return;
-    const dim_t seg_end = std::min(seg_start + seg_len, num_rows);
-    for (dim_t j = seg_start; j < seg_end; ++j) {
-      if (indptr_l[j] == indptr_l[j+1]) continue;
-      const dim_t offset_out = j * num_cols;
-      for (IType k = indptr_l[j]; k < indptr_l[j+1]; ++k) {
-        const DType val = data_l[k];
-        const dim_t offset_r = col_idx_l[k] * num_cols;
-        for (dim_t l = 0; l < num_cols; ++l) {
-          out[offset_out+l] += data_r[offset_r+l] * val;
+    const dim_t seg_start = row_starts[i];
+    const dim_t seg_end = row_starts[i + 1];
+    for (dim_t col_start = 0; col_start < num_cols; col_start += kDotColBlock) {
+      const dim_t cols = std::min(kDotColBlock, num_cols - col_start);
+      for (dim_t j = seg_start; j < seg_end; ++j) {
+        DType* out_row = out + j * num_cols + col_start;
+        for (IType k = indptr_l[j]; k < indptr_l[j+1]; ++k) {
+          const DType val = data_l[k];
+          const DType* rhs_row = data_r + col_idx_l[k] * num_cols + col_start;
+          for (dim_t l = 0; l < cols; ++l) {
+            out_row[l] += rhs_row[l] * val;
+          }
         }
       }
     }
@@ -709,9 +738,12 @@ struct DotDnsCsrDnsByRowBlocks {
 
 /*!
  * \brief CPU Kernel of dot(dns1, csr.T) = dns2
- * Parallelization by row blocks
+ * Parallelization by blocks of rows of csr of about the same number of non-zeros, which are
+ * the columns of dns2. Each thread walks the rows of dns1 once, gathering from each of them for
+ * all the rows of csr of its block while it is in cache. Each element of dns2 is the dot
+ * product of a row of dns1 with a row of csr, accumulated in independent partial sums.
  */
-struct DotDnsCsrTransDnsByRowBlocks {
+struct DotDnsCsrTransDnsByNnzBlocks {
   /*!
    * \brief
    * \param i           the i-th thread
@@ -720,11 +752,10 @@ struct DotDnsCsrTransDnsByRowBlocks {
    * \param data_r      values of csr
    * \param indptr_r    row offsets of csr
    * \param col_idx_r   column indices of csr
-   * \param seg_len     workload of this thread
+   * \param row_starts  first row of csr of each block, and the number of rows of csr
    * \param num_rows_l  number of rows in lhs
    * \param num_cols_l  number of columns in lhs
    * \param num_rows_r  number of rows in rhs
-   * \param num_cols_r  number of columns in rhs
    */
   template<typename DType, typename IType, typename CType>
   MSHADOW_CINLINE static void Map(int i,
@@ -733,23 +764,30 @@ struct DotDnsCsrTransDnsByRowBlocks {
                                   const DType* data_r,
                                   const IType* indptr_r,
                                   const CType* col_idx_r,
-                                  const nnvm::dim_t seg_len,
+                                  const nnvm::dim_t* row_starts,
                                   const nnvm::dim_t num_rows_l,
                                   const nnvm::dim_t num_cols_l,
-                                  const nnvm::dim_t num_rows_r,
-                                  const nnvm::dim_t num_cols_r) {
+                                  const nnvm::dim_t num_rows_r) {
     using nnvm::dim_t;
-    const dim_t seg_start = i * seg_len;
-    if (seg_start >= num_rows_l) return;
-    const dim_t seg_end = std::min(seg_start + seg_len, num_rows_l);
-    for (dim_t j = 0; j < num_rows_r; ++j) {
-      if (indptr_r[j] == indptr_r[j+1]) continue;
-      for (IType k = indptr_r[j]; k < indptr_r[j+1]; ++k) {
-        const CType col_idx = col_idx_r[k];
-        const DType val = data_r[k];
-        for (dim_t r = seg_start; r < seg_end; ++r) {
-          out[r*num_rows_r+j] += data_l[r*num_cols_l+col_idx] * val;
+    const int kLanes = 4;
+    const dim_t seg_start = row_starts[i];
+    const dim_t seg_end = row_starts[i + 1];
+    if (seg_start == seg_end) return;
+    for (dim_t r = 0; r < num_rows_l; ++r) {
+      const DType* lhs_row = data_l + r * num_cols_l;
+      DType* out_row = out + r * num_rows_r;
+      for (dim_t j = seg_start; j < seg_end; ++j) {
+        DType sum[kLanes] = {DType(0)};
+        IType k = indptr_r[j];
+        for (; k + kLanes <= indptr_r[j+1]; k += kLanes) {
+          for (int l = 0; l < kLanes; ++l) {
+            sum[l] += lhs_row[col_idx_r[k + l]] * data_r[k + l];
+          }
         }
+        for (; k < indptr_r[j+1]; ++k) {
+          sum[0] += lhs_row[col_idx_r[k]] * data_r[k];
+        }
+        out_row[j] += (sum[0] + sum[1]) + (sum[2] + sum[3]);
       }
     }
   }
@@ -791,32 +829,21 @@ inline void DotCsrDnsDnsImpl(const OpContext& ctx,
               s, num_threads, data_out.dptr<DType>());
         }
         num_threads = mxnet_op::get_num_threads<cpu>(data_out.shape_[0]);
-        bool dynamic = false;
-        const dim_t large_matrix_threshold = 1024 * 10;
-        if (data_out.shape_[0] > large_matrix_threshold) {
-          dynamic = true;
-          // each unit of work processes at least 1024 elements in the output
-          const dim_t unit_work_per_thread = 1024;
-          num_threads = data_out.Size() / unit_work_per_thread;
-        }
-        dim_t seg_len = (data_out.shape_[0] + num_threads - 1) / num_threads;
         if (trans_lhs) {
+          dim_t seg_len = (data_out.shape_[0] + num_threads - 1) / num_threads;
           mxnet_op::Kernel<DotCsrTransDnsDnsByRowBlocks, cpu>::Launch(s, num_threads,
               data_out.dptr<DType>(), data_l.dptr<DType>(), indptr_l.dptr<IType>(),
               col_idx_l.dptr<CType>(), data_r.dptr<DType>(), seg_len,
               lhs.shape()[0], data_out.shape_[0], data_out.shape_[1]);
         } else {
-          if (dynamic) {
-            mxnet_op::Kernel<DotCsrDnsDnsByRowBlocks, cpu>::LaunchDynamic(s, num_threads,
-                data_out.dptr<DType>(), data_l.dptr<DType>(), indptr_l.dptr<IType>(),
-                col_idx_l.dptr<CType>(), data_r.dptr<DType>(), seg_len,
-                data_out.shape_[0], data_out.shape_[1]);
-          } else {
-            mxnet_op::Kernel<DotCsrDnsDnsByRowBlocks, cpu>::Launch(s, num_threads,
-                data_out.dptr<DType>(), data_l.dptr<DType>(), indptr_l.dptr<IType>(),
-                col_idx_l.dptr<CType>(), data_r.dptr<DType>(), seg_len,
-                data_out.shape_[0], data_out.shape_[1]);
-          }
+          // several blocks per thread, run dynamically, for rows of very different lengths
+          const dim_t num_blocks = std::min<dim_t>(data_out.shape_[0], num_threads * 4);
+          std::vector<dim_t> row_starts;
+          CsrNnzRowBlocks(indptr_l.dptr<IType>(), data_out.shape_[0], num_blocks, &row_starts);
+          mxnet_op::Kernel<DotCsrDnsDnsByNnzBlocks, cpu>::LaunchDynamic(s, num_blocks,
+              data_out.dptr<DType>(), data_l.dptr<DType>(), indptr_l.dptr<IType>(),
+              col_idx_l.dptr<CType>(), data_r.dptr<DType>(), row_starts.data(),
+              data_out.shape_[1]);
         }
       });
     });
@@ -1175,17 +1202,20 @@ inline void DotDnsCsrDnsImpl(const OpContext& ctx, const cpu& cpu_dev,
           mxnet_op::Kernel<mxnet_op::set_zero, cpu>::Launch(
               s, num_threads, data_out.dptr<DType>());
         }
-        num_threads = mxnet_op::get_num_threads<cpu>(data_out.shape_[0]);
-        // seg by output row
-        dim_t seg_len = (data_out.shape_[0] + num_threads - 1) / num_threads;
         if (transpose_b) {
-          mxnet_op::Kernel<DotDnsCsrTransDnsByRowBlocks, cpu>::Launch(s, num_threads,
+          // seg by rows of csr, which are the output columns
+          num_threads = mxnet_op::get_num_threads<cpu>(rhs.shape()[0]);
+          std::vector<dim_t> row_starts;
+          CsrNnzRowBlocks(indptr_r.dptr<IType>(), rhs.shape()[0], num_threads, &row_starts);
+          mxnet_op::Kernel<DotDnsCsrTransDnsByNnzBlocks, cpu>::Launch(s, num_threads,
               data_out.dptr<DType>(), data_l.dptr<DType>(),
               data_r.dptr<DType>(), indptr_r.dptr<IType>(),
-              col_idx_r.dptr<CType>(), seg_len,
-              dns.shape_[0], dns.shape_[1],
-              rhs.shape()[0], rhs.shape()[1]);
+              col_idx_r.dptr<CType>(), row_starts.data(),
+              dns.shape_[0], dns.shape_[1], rhs.shape()[0]);
         } else {
+          num_threads = mxnet_op::get_num_threads<cpu>(data_out.shape_[0]);
+          // seg by output row
+          dim_t seg_len = (data_out.shape_[0] + num_threads - 1) / num_threads;
           mxnet_op::Kernel<DotDnsCsrDnsByRowBlocks, cpu>::Launch(s, num_threads,
               data_out.dptr<DType>(), data_l.dptr<DType>(),
               data_r.dptr<DType>(), indptr_r.dptr<IType>(),
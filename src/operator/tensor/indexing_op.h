@@ -507,6 +507,99 @@ struct tcast_clip {
   }
 };
 
+/*!
+ * \brief sorts the positions of the indices of an embedding by their row, clipped to
+ *  [0, num_rows), and finds the positions of each distinct row, which are
+ *  positions[row_starts[i]] to positions[row_starts[i+1] - 1] for the i-th distinct row.
+ * \return the number of distinct rows
+ */
+template<typename IType>
+inline nnvm::dim_t EmbeddingSortRows(const IType* data, const nnvm::dim_t data_size,
+                                     const nnvm::dim_t num_rows,
+                                     mshadow::Tensor<cpu, 1, nnvm::dim_t> sorted_rows,
+                                     mshadow::Tensor<cpu, 1, nnvm::dim_t> positions,
+                                     nnvm::dim_t* row_starts) {
+  using nnvm::dim_t;
+  const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  #pragma omp parallel for num_threads(omp_threads)
+  for (dim_t i = 0; i < data_size; ++i) {
+    const dim_t row = static_cast<dim_t>(data[i]);
+    sorted_rows[i] = row <= 0 ? 0 : (row >= num_rows ? num_rows - 1 : row);
+    positions[i] = i;
+  }
+  // stable, so that the rows of ograd are summed in the same order at every call
+  SortByKey(sorted_rows, positions, true);
+  dim_t nnr = 0;
+  for (dim_t i = 0; i < data_size; ++i) {
+    if (i == 0 || sorted_rows[i] != sorted_rows[i - 1]) row_starts[nnr++] = i;
+  }
+  row_starts[nnr] = data_size;
+  return nnr;
+}
+
+/*!
+ * \brief sums the rows of ograd of each distinct row of an embedding, sorted by
+ *  EmbeddingSortRows, in parallel over the distinct rows. The sum of the i-th distinct row goes
+ *  to the row sorted_rows[row_starts[i]] of grad, or to its i-th row without sorted_rows. It is
+ *  added to the row with accumulate, and written to it otherwise.
+ */
+template<typename DType>
+inline void EmbeddingSumSortedRows(const DType* ograd, const nnvm::dim_t row_length,
+                                   const nnvm::dim_t* positions, const nnvm::dim_t* row_starts,
+                                   const nnvm::dim_t nnr, const nnvm::dim_t* sorted_rows,
+                                   const bool accumulate, DType* grad) {
+  using nnvm::dim_t;
+  const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  // the numbers of occurences of the rows are very uneven for natural language
+  #pragma omp parallel for num_threads(omp_threads) schedule(dynamic, 16)
+  for (dim_t i = 0; i < nnr; ++i) {
+    const dim_t row = sorted_rows ? sorted_rows[row_starts[i]] : i;
+    DType* out = grad + row * row_length;
+    dim_t k = row_starts[i];
+    if (!accumulate) {
+      const DType* in = ograd + positions[k++] * row_length;
+      for (dim_t l = 0; l < row_length; ++l) out[l] = in[l];
+    }
+    for (; k < row_starts[i + 1]; ++k) {
+      const DType* in = ograd + positions[k] * row_length;
+      for (dim_t l = 0; l < row_length; ++l) out[l] += in[l];
+    }
+  }
+}
+
+/*!
+ * \brief dst[index[i]] += src[i] on cpu, without any two threads adding to the same row: the
+ *  indices are sorted and the rows of src of each distinct index summed by one thread
+ */
+template<typename IType, typename DType>
+inline void EmbeddingAddTakeGrad(const OpContext& ctx,
+                                 mshadow::Tensor<cpu, 2, DType> dst,
+                                 const mshadow::Tensor<cpu, 1, IType>& index,
+                                 const mshadow::Tensor<cpu, 2, DType>& src) {
+  using namespace mshadow;
+  using nnvm::dim_t;
+  const dim_t data_size = index.shape_.Size();
+  if (data_size == 0) return;
+  Stream<cpu> *s = ctx.get_stream<cpu>();
+  Tensor<cpu, 1, dim_t> workspace = ctx.requested[embedding::kTempSpace]
+    .get_space_typed<cpu, 1, dim_t>(Shape1(3 * data_size + 1), s);
+  Tensor<cpu, 1, dim_t> sorted_rows(workspace.dptr_, Shape1(data_size), s);
+  Tensor<cpu, 1, dim_t> positions(workspace.dptr_ + data_size, Shape1(data_size), s);
+  dim_t* row_starts = workspace.dptr_ + 2 * data_size;
+  const dim_t nnr = EmbeddingSortRows(index.dptr_, data_size, dst.size(0), sorted_rows,
+                                      positions, row_starts);
+  EmbeddingSumSortedRows(src.dptr_, static_cast<dim_t>(src.size(1)), positions.dptr_,
+                         row_starts, nnr, sorted_rows.dptr_, true, dst.dptr_);
+}
+
+template<typename IType, typename DType>
+inline void EmbeddingAddTakeGrad(const OpContext& ctx,
+                                 mshadow::Tensor<gpu, 2, DType> dst,
+                                 const mshadow::Tensor<gpu, 1, IType>& index,
+                                 const mshadow::Tensor<gpu, 2, DType>& src) {
+  AddTakeGrad(dst, index, src);
+}
+
 template<typename xpu>
 void EmbeddingOpBackward(const nnvm::NodeAttrs& attrs,
                          const OpContext& ctx,
@@ -538,7 +631,7 @@ void EmbeddingOpBackward(const nnvm::NodeAttrs& attrs,
         if (req[embedding::kWeight] == kWriteTo) {
           grad_in = scalar<DType>(0.0f);
         }
-        AddTakeGrad(grad_in, data, grad_out);
+        EmbeddingAddTakeGrad(ctx, grad_in, data, grad_out);
       } else {
         LOG(FATAL) << "wrong req";
       }
@@ -546,48 +639,6 @@ void EmbeddingOpBackward(const nnvm::NodeAttrs& attrs,
   });
 }
 
-struct AddTakeGradRspKernel {
-  /*!
-   * \brief Each thread i is responsible for row slices in [segment_start, segment_end)
-            of the result gradient
-   * \param tid             global thread id
-   * \param grad            the gradient to calculate
-   * \param prefix_sum      the inclusive prefix sum of row ids of the gradient
-   * \param ograd           output gradient
-   * \param row_length      the length of the row slices of the gradient
-   * \param data_val        the values of input data
-   * \param data_size       number of values of input data
-   * \param segment_length  the length of row segment to process for each thread
-   * \param nnr             total number of non-zero rows of result gradient
-   */
-  template<typename DType, typename IType>
-  MSHADOW_CINLINE static void Map(int tid,
-                                  DType* grad,
-                                  const nnvm::dim_t* prefix_sum,
-                                  const DType* ograd,
-                                  const nnvm::dim_t row_length,
-                                  const IType* data_val,
-                                  const nnvm::dim_t data_size,
-                                  const nnvm::dim_t segment_length,
-                                  const nnvm::dim_t nnr) {
-    using nnvm::dim_t;
-    dim_t segment_start = tid * segment_length;
-    dim_t segment_end = std::min(nnr, segment_start + segment_length);
-    // scan all data
-    for (dim_t data_i = 0; data_i < data_size; data_i++) {
-      dim_t data = static_cast<dim_t>(data_val[data_i]);
-      dim_t grad_row_id = prefix_sum[data] - 1;
-      if (grad_row_id < segment_start || grad_row_id >= segment_end) continue;
-      // no projection is performed
-      dim_t ograd_i = data_i * row_length;
-      dim_t grad_i = grad_row_id * row_length;
-      for (dim_t offset = 0; offset < row_length; offset++) {
-        grad[grad_i + offset] += ograd[ograd_i + offset];
-      }
-    }
-  }
-};
-
 template<typename xpu>
 inline void SparseEmbeddingOpBackwardRspImpl(const bool deterministic,
                                              const OpContext& ctx,
@@ -29,6 +29,7 @@
 #include <dmlc/optional.h>
 #include <mshadow/tensor.h>
 #include <algorithm>
+#include <utility>
 #include <vector>
 #include <type_traits>
 #include "../mshadow_op.h"
@@ -192,6 +193,66 @@ struct fill_ind {
   }
 };
 
+namespace topk {
+/*! \brief number of elements whose comparison with the threshold of the selection is vectorized */
+const int kFilterBlock = 16;
+/*! \brief minimum number of elements of a row which one thread selects from */
+const int kMinSegment = 4096;
+
+/*!
+ * \brief order of the selected elements: by value, and by index for equal values, so that
+ *  the first of equal elements is selected first
+ */
+template<typename DType>
+struct Better {
+  bool is_ascend;
+  bool operator()(const std::pair<DType, int>& a, const std::pair<DType, int>& b) const {
+    if (a.first != b.first) return is_ascend ? a.first < b.first : a.first > b.first;
+    return a.second < b.second;
+  }
+};
+
+/*!
+ * \brief selects the K best of vals[begin, end) into a heap whose top is the worst of them.
+ *  After the first K, each block of kFilterBlock elements is only looked at one by one when one
+ *  of them beats the threshold, the worst selected value, which compilers vectorize.
+ */
+template<typename DType>
+inline void SelectHeap(const DType* vals, int begin, int end, int K, bool is_ascend,
+                       std::pair<DType, int>* heap) {
+  const Better<DType> better{is_ascend};
+  for (int j = 0; j < K; ++j) heap[j] = std::make_pair(vals[begin + j], begin + j);
+  std::make_heap(heap, heap + K, better);
+  int j = begin + K;
+  for (; j + kFilterBlock <= end; j += kFilterBlock) {
+    const DType threshold = heap[0].first;
+    int hits = 0;
+    if (is_ascend) {
+      for (int l = 0; l < kFilterBlock; ++l) hits += vals[j + l] < threshold;
+    } else {
+      for (int l = 0; l < kFilterBlock; ++l) hits += vals[j + l] > threshold;
+    }
+    if (hits == 0) continue;
+    for (int l = j; l < j + kFilterBlock; ++l) {
+      const std::pair<DType, int> cand(vals[l], l);
+      if (better(cand, heap[0])) {
+        std::pop_heap(heap, heap + K, better);
+        heap[K - 1] = cand;
+        std::push_heap(heap, heap + K, better);
+      }
+    }
+  }
+  for (; j < end; ++j) {
+    const std::pair<DType, int> cand(vals[j], j);
+    if (better(cand, heap[0])) {
+      std::pop_heap(heap, heap + K, better);
+      heap[K - 1] = cand;
+      std::push_heap(heap, heap + K, better);
+    }
+  }
+}
+}  // namespace topk
+
 template<typename DType>
 MSHADOW_FORCE_INLINE void TopKSort(const Tensor<cpu, 1, DType>& dat,
                                    const Tensor<cpu, 1, int>& ind,
@@ -203,28 +264,49 @@ MSHADOW_FORCE_INLINE void TopKSort(const Tensor<cpu, 1, DType>& dat,
   // Batch size.
   const int M(work.size(0)/(sizeof(DType)*N));
   const int omp_threads(engine::OpenMP::Get()->GetRecommendedOMPThreadCount());
+  // Tensor `work` stores the flattened source data, while `dat` stores the sorted result.
+  const DType *vals = reinterpret_cast<DType*>(work.dptr_);
+  if (!full_sort) {
+    // Select the K best of each row with a heap, in several segments of the row by several
+    // threads when there are fewer rows than threads, and merge the selections of the segments.
+    int segments = 1;
+    if (M < omp_threads) {
+      segments = std::min((omp_threads + M - 1) / M, N / std::max(K, topk::kMinSegment));
+      segments = std::max(segments, 1);
+    }
+    std::vector<std::pair<DType, int>> selected(static_cast<size_t>(M) * segments * K);
+    #pragma omp parallel for num_threads(omp_threads)
+    for (int t = 0; t < M * segments; ++t) {
+      const int i = t / segments, seg = t % segments;
+      // segments of at least N / segments >= K elements
+      const int begin = static_cast<int64_t>(seg) * N / segments;
+      const int end = static_cast<int64_t>(seg + 1) * N / segments;
+      topk::SelectHeap(vals + static_cast<size_t>(i) * N, begin, end, K, is_ascend,
+                       selected.data() + static_cast<size_t>(t) * K);
+    }
+    #pragma omp parallel for num_threads(omp_threads)
+    for (int i = 0; i < M; ++i) {
+      std::pair<DType, int>* row = selected.data() + static_cast<size_t>(i) * segments * K;
+      std::partial_sort(row, row + K, row + segments * K, topk::Better<DType>{is_ascend});
+      DType *sorted_vals = dat.dptr_+i*N;
+      int *indices = ind.dptr_+i*N;
+      for (int j = 0; j < K; ++j) {
+        sorted_vals[j] = row[j].first;
+        indices[j] = i * N + row[j].second;
+      }
+    }
+    return;
+  }
   #pragma omp parallel for num_threads(omp_threads)
   for (int i = 0; i < M; ++i) {
-    // Tensor `work` stores the flattened source data, while `dat` stores the sorted result.
-    DType *vals = reinterpret_cast<DType*>(work.dptr_);
     DType *sorted_vals = dat.dptr_+i*N;
     int *indices = ind.dptr_+i*N;
     if (is_ascend) {
-      if (full_sort) {
-        std::sort(indices, indices+N,
-                  [&](const int& i1, const int& i2){ return vals[i1] < vals[i2]; });
-      } else {
-        std::partial_sort(indices, indices+K, indices+N,
-                          [&](const int& i1, const int& i2){ return vals[i1] < vals[i2]; });
-      }
+      std::sort(indices, indices+N,
+                [&](const int& i1, const int& i2){ return vals[i1] < vals[i2]; });
     } else {
-      if (full_sort) {
-        std::sort(indices, indices+N,
-                  [&](const int& i1, const int& i2){ return vals[i1] > vals[i2]; });
-      } else {
-        std::partial_sort(indices, indices+K, indices+N,
-                          [&](const int& i1, const int& i2){ return vals[i1] > vals[i2]; });
-      }
+      std::sort(indices, indices+N,
+                [&](const int& i1, const int& i2){ return vals[i1] > vals[i2]; });
     }
     for (int j = 0; j < K; ++j) {
       sorted_vals[j] = vals[indices[j]];
@@ -0,0 +1,110 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+/*!
+ *  \file batch_loader_test.cc
+ *  \brief BatchLoader assembling batches into buffers offered by the prefetcher
+ */
+
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "../../src/io/iter_batchloader.h"
+
+using namespace mxnet;
+using namespace mxnet::io;
+
+namespace {
+
+/*! \brief yields instances i = 0..n-1 holding {i, i, i} and label i */
+class CountingIter : public IIterator<DataInst> {
+ public:
+  explicit CountingIter(int n) : n_(n) {}
+  void Init(const std::vector<std::pair<std::string, std::string> >& kwargs) override {}
+  void BeforeFirst() override { pos_ = 0; }
+  bool Next() override {
+    if (pos_ >= n_) return false;
+    std::fill(data_, data_ + 3, static_cast<float>(pos_));
+    label_ = static_cast<float>(pos_);
+    out_.index = pos_++;
+    out_.data = {TBlob(data_, mshadow::Shape1(3), cpu::kDevMask),
+                 TBlob(&label_, mshadow::Shape1(1), cpu::kDevMask)};
+    return true;
+  }
+  const DataInst &Value() const override { return out_; }
+
+ private:
+  int n_, pos_{0};
+  float data_[3], label_;
+  DataInst out_;
+};
+
+std::vector<std::pair<std::string, std::string> > BatchArgs(int batch_size) {
+  return {{"batch_size", std::to_string(batch_size)}, {"round_batch", "1"}};
+}
+
+}  // namespace
+
+TEST(BatchLoader, WritesIntoOfferedBuffers) {
+  BatchLoader loader(new CountingIter(6));
+  loader.Init(BatchArgs(4));
+  loader.BeforeFirst();
+  ASSERT_TRUE(loader.Next());
+  const TBlobBatch &first = loader.Value();
+  ASSERT_EQ(first.data.size(), 2U);
+  ASSERT_EQ(first.data[0].shape_, TShape(mshadow::Shape2(4, 3)));
+
+  std::vector<float> data(12, -1.f), label(4, -1.f);
+  std::vector<TBlob> slot = {TBlob(data.data(), mshadow::Shape2(4, 3), cpu::kDevMask),
+                             TBlob(label.data(), mshadow::Shape2(4, 1), cpu::kDevMask)};
+  loader.SetOutputBuffers(slot);
+  // the second batch wraps around: instances 4, 5, 0, 1
+  ASSERT_TRUE(loader.Next());
+  const TBlobBatch &second = loader.Value();
+  EXPECT_EQ(second.data[0].dptr_, slot[0].dptr_);
+  EXPECT_EQ(second.data[1].dptr_, slot[1].dptr_);
+  EXPECT_EQ(second.num_batch_padd, 2U);
+  const float expected[4] = {4.f, 5.f, 0.f, 1.f};
+  for (int r = 0; r < 4; ++r) {
+    EXPECT_EQ(label[r], expected[r]);
+    for (int c = 0; c < 3; ++c) EXPECT_EQ(data[r * 3 + c], expected[r]);
+  }
+}
+
+TEST(BatchLoader, IgnoresMismatchedBuffers) {
+  BatchLoader loader(new CountingIter(8));
+  loader.Init(BatchArgs(4));
+  loader.BeforeFirst();
+  ASSERT_TRUE(loader.Next());
+  const void *internal = loader.Value().data[0].dptr_;
+
+  std::vector<float> data(6, -1.f);
+  loader.SetOutputBuffers({TBlob(data.data(), mshadow::Shape2(2, 3), cpu::kDevMask)});
+  ASSERT_TRUE(loader.Next());
+  const TBlobBatch &batch = loader.Value();
+  EXPECT_EQ(batch.data[0].dptr_, internal);
+  EXPECT_EQ(batch.data[0].dptr<float>()[0], 4.f);
+  EXPECT_EQ(data[0], -1.f);
+  // offered buffers only apply to a single batch
+  loader.SetOutputBuffers({});
+  EXPECT_FALSE(loader.Next());
+}
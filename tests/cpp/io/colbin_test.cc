@@ -0,0 +1,244 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ *  \file colbin_test.cc
+ *  \brief ShuffleRLE codec and Writer/Reader round trips of the colbin format
+ */
+
+#include <gtest/gtest.h>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "../../src/io/colbin_format.h"
+
+using namespace mxnet::io;
+
+namespace {
+
+/*! \brief encodes and decodes n elements of elem_size bytes, returns the encoded size */
+size_t RoundTrip(const std::vector<char>& raw, size_t elem_size) {
+  std::string encoded;
+  colbin::ShuffleRLEEncode(raw.data(), raw.size() / elem_size, elem_size, &encoded);
+  std::vector<char> decoded(raw.size());
+  colbin::ShuffleRLEDecode(encoded.data(), encoded.size(), raw.size(), elem_size,
+                           decoded.data());
+  EXPECT_EQ(decoded, raw);
+  return encoded.size();
+}
+
+/*! \brief rows with a dense column of width 3 and a csr column of width 1000 */
+struct Table {
+  explicit Table(size_t num_rows) : indptr(1, 0) {
+    std::mt19937 gen(11);
+    std::uniform_int_distribution<int> nnz_dist(0, 6), index_dist(0, 999);
+    for (size_t i = 0; i < num_rows; ++i) {
+      for (int k = 0; k < 3; ++k) dense.push_back(static_cast<float>(i * 3 + k) * 0.5f);
+      const int nnz = nnz_dist(gen);
+      for (int k = 0; k < nnz; ++k) {
+        index.push_back(index_dist(gen));
+        value.push_back(1.0f);
+      }
+      indptr.push_back(static_cast<int64_t>(index.size()));
+    }
+  }
+  std::vector<float> dense, value;
+  std::vector<int64_t> indptr, index;
+};
+
+const std::vector<colbin::ColumnDesc> kColumns = {
+  {colbin::kDenseColumn, mshadow::kFloat32, 3},
+  {colbin::kCSRColumn, mshadow::kFloat32, 1000}
+};
+
+/*! \brief writes table in chunks of chunk_rows rows with the codec, reads it back */
+void CheckWriterReader(const Table& table, size_t chunk_rows, colbin::Codec codec) {
+  const std::string path = "colbin_test.colbin";
+  const size_t num_rows = table.indptr.size() - 1;
+  {
+    std::unique_ptr<dmlc::Stream> fo(dmlc::Stream::Create(path.c_str(), "w"));
+    colbin::Writer writer(fo.get(), kColumns, codec);
+    std::vector<int64_t> indptr;
+    for (size_t begin = 0; begin < num_rows; begin += chunk_rows) {
+      const size_t rows = std::min(chunk_rows, num_rows - begin);
+      const int64_t base = table.indptr[begin];
+      indptr.clear();
+      for (size_t i = 0; i <= rows; ++i) indptr.push_back(table.indptr[begin + i] - base);
+      std::vector<colbin::ColumnData> data(2);
+      data[0].value = &table.dense[begin * 3];
+      data[1].indptr = indptr.data();
+      data[1].index = table.index.data() + base;
+      data[1].value = table.value.data() + base;
+      writer.WriteChunk(rows, data);
+    }
+    writer.Finish();
+  }
+  {
+    colbin::Reader reader(path);
+    ASSERT_EQ(reader.columns().size(), kColumns.size());
+    EXPECT_EQ(reader.columns()[1].width, 1000U);
+    ASSERT_EQ(reader.NumChunks(), (num_rows + chunk_rows - 1) / chunk_rows);
+    colbin::ChunkView view;
+    size_t row = 0;
+    for (size_t c = 0; c < reader.NumChunks(); ++c) {
+      reader.ReadChunk(c, &view);
+      const colbin::ColumnData& dense = view.columns[0];
+      const colbin::ColumnData& csr = view.columns[1];
+      ASSERT_EQ(std::memcmp(dense.value, &table.dense[row * 3],
+                            view.num_rows * 3 * sizeof(float)), 0) << "chunk " << c;
+      if (view.decoded[0].empty()) {
+        // uncompressed payloads are used in place and aligned
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(dense.value) % colbin::kAlign, 0U);
+      }
+      const int64_t base = table.indptr[row];
+      for (size_t i = 0; i <= view.num_rows; ++i) {
+        ASSERT_EQ(csr.indptr[i], table.indptr[row + i] - base);
+      }
+      const size_t nnz = csr.indptr[view.num_rows];
+      for (size_t k = 0; k < nnz; ++k) {
+        ASSERT_EQ(csr.index[k], table.index[base + k]);
+        ASSERT_EQ(static_cast<const float*>(csr.value)[k], table.value[base + k]);
+      }
+      row += view.num_rows;
+    }
+    EXPECT_EQ(row, num_rows);
+  }
+  std::remove(path.c_str());
+}
+
+}  // namespace
+
+/*!
+ * \brief runs of every length around the limits of the control byte, and literals longer
+ *  than one block
+ */
+TEST(COLBIN, ShuffleRLERoundTrip) {
+  for (size_t len : {1, 2, 3, 4, 127, 128, 129, 130, 131, 260, 1000}) {
+    std::vector<char> raw(len, 7);
+    RoundTrip(raw, 1);
+    for (size_t i = 0; i < len; i += 2) raw[i] = static_cast<char>(i);
+    RoundTrip(raw, 1);
+  }
+  // one-hot float values and sorted int64 indices compress
+  std::vector<float> values(4096, 1.0f);
+  std::vector<char> raw(reinterpret_cast<char*>(values.data()),
+                        reinterpret_cast<char*>(values.data() + values.size()));
+  EXPECT_LT(RoundTrip(raw, sizeof(float)), raw.size() / 10);
+  std::vector<int64_t> indices(4096);
+  for (size_t i = 0; i < indices.size(); ++i) indices[i] = i * 3;
+  raw.assign(reinterpret_cast<char*>(indices.data()),
+             reinterpret_cast<char*>(indices.data() + indices.size()));
+  EXPECT_LT(RoundTrip(raw, sizeof(int64_t)), raw.size());
+  // random bytes grow, and the writer then stores them raw
+  std::mt19937 gen(3);
+  for (char& c : raw) c = static_cast<char>(gen());
+  EXPECT_GT(RoundTrip(raw, sizeof(int64_t)), raw.size());
+}
+
+/*!
+ * \brief a corrupted buffer is detected rather than read out of bounds
+ */
+TEST(COLBIN, ShuffleRLECorrupted) {
+  std::vector<char> raw(64, 5), decoded(raw.size());
+  std::string encoded;
+  colbin::ShuffleRLEEncode(raw.data(), raw.size(), 1, &encoded);
+  EXPECT_THROW(colbin::ShuffleRLEDecode(encoded.data(), encoded.size(), raw.size() - 1, 1,
+                                        decoded.data()), dmlc::Error);
+  EXPECT_THROW(colbin::ShuffleRLEDecode(encoded.data(), encoded.size() - 1, raw.size(), 1,
+                                        decoded.data()), dmlc::Error);
+}
+
+/*!
+ * \brief dense and csr columns read back as written, raw and compressed, with a last chunk
+ *  shorter than the others
+ */
+TEST(COLBIN, WriterReaderRoundTrip) {
+  const Table table(1000);
+  CheckWriterReader(table, 1000, colbin::kNoCompression);
+  CheckWriterReader(table, 64, colbin::kNoCompression);
+  CheckWriterReader(table, 64, colbin::kShuffleRLE);
+  CheckWriterReader(table, 7, colbin::kShuffleRLE);
+}
+
+/*!
+ * \brief buffers whose sizes do not match the columns, and csr buffers breaking their
+ *  invariants, fail when the chunk is read instead of being read past their end
+ */
+TEST(COLBIN, ReaderCorruptedChunk) {
+  const Table table(20);
+  const std::string path = "colbin_test_corrupted.colbin";
+  std::string file;
+  {
+    std::unique_ptr<dmlc::Stream> fo(dmlc::Stream::Create(path.c_str(), "w"));
+    colbin::Writer writer(fo.get(), kColumns, colbin::kNoCompression);
+    std::vector<colbin::ColumnData> data(2);
+    data[0].value = table.dense.data();
+    data[1].indptr = table.indptr.data();
+    data[1].index = table.index.data();
+    data[1].value = table.value.data();
+    writer.WriteChunk(20, data);
+    writer.Finish();
+  }
+  {
+    std::unique_ptr<dmlc::Stream> fi(dmlc::Stream::Create(path.c_str(), "r"));
+    char buf[4096];
+    for (size_t n; (n = fi->Read(buf, sizeof(buf))) != 0;) file.append(buf, n);
+  }
+  // offset of the payload equal to the bytes of v, its header is right before it
+  auto find = [&file](const void* v, size_t size) {
+    const size_t pos = file.find(std::string(static_cast<const char*>(v), size));
+    EXPECT_NE(pos, std::string::npos);
+    return pos;
+  };
+  const size_t dense = find(table.dense.data(), table.dense.size() * sizeof(float));
+  const size_t indptr = find(table.indptr.data(), table.indptr.size() * sizeof(int64_t));
+  const size_t index = find(table.index.data(), table.index.size() * sizeof(int64_t));
+  auto check = [&](size_t offset, const void* v, size_t size, bool valid) {
+    std::string corrupted = file;
+    corrupted.replace(offset, size, static_cast<const char*>(v), size);
+    {
+      std::unique_ptr<dmlc::Stream> fo(dmlc::Stream::Create(path.c_str(), "w"));
+      fo->Write(corrupted.data(), corrupted.size());
+    }
+    colbin::Reader reader(path);
+    colbin::ChunkView view;
+    if (valid) {
+      EXPECT_NO_THROW(reader.ReadChunk(0, &view));
+    } else {
+      EXPECT_THROW(reader.ReadChunk(0, &view), dmlc::Error) << "at " << offset;
+    }
+  };
+  const size_t raw_bytes = offsetof(colbin::BufferHeader, raw_bytes);
+  const size_t stored_bytes = offsetof(colbin::BufferHeader, stored_bytes);
+  const size_t header = sizeof(colbin::BufferHeader);
+  const int64_t index_width = 999, index_out = 1000, indptr_negative = -1;
+  const uint64_t dense_bytes = (20 * 3 + 1) * sizeof(float);
+  const uint64_t stored_huge = uint64_t(1) << 62;
+  check(index, &index_width, sizeof(int64_t), true);
+  check(index, &index_out, sizeof(int64_t), false);
+  check(indptr + sizeof(int64_t), &indptr_negative, sizeof(int64_t), false);
+  check(dense - header + raw_bytes, &dense_bytes, sizeof(uint64_t), false);
+  check(dense - header + stored_bytes, &dense_bytes, sizeof(uint64_t), false);
+  check(index - header + stored_bytes, &stored_huge, sizeof(uint64_t), false);
+  std::remove(path.c_str());
+}
@@ -0,0 +1,121 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ *  \file image_aug_perf.cc
+ *  \brief Correctness and perf run of the fused HWC->CHW image kernel
+ */
+
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+#include "../include/test_perf.h"
+#include "../include/test_util.h"
+#include "../../src/io/image_aug_kernel.h"
+
+using namespace mxnet;
+
+namespace {
+
+const int swap_bgr[3] = {2, 1, 0};
+const float mean[3] = {123.68f, 116.28f, 103.53f};
+const float mult[3] = {1.f / 58.395f, 1.f / 57.12f, 1.f / 57.375f};
+const float bias[3] = {0.1f, 0.2f, 0.3f};
+
+/*! \brief per-pixel reference, as ImageRecordIOParser2::ProcessImage used to do it */
+void ReferencePack(const std::vector<uint8_t> &src, int rows, int cols, bool mirror,
+                   const float *mean_img, float *dst) {
+  for (int i = 0; i < rows; ++i) {
+    const uint8_t *im_data = &src[i * cols * 3];
+    for (int j = 0; j < cols; ++j) {
+      float rgb[3];
+      for (int k = 0; k < 3; ++k) {
+        const float m = mean_img ? mean_img[(k * rows + i) * cols + j] : mean[k];
+        rgb[k] = (im_data[swap_bgr[k]] - m) * mult[k] + bias[k];
+      }
+      for (int k = 0; k < 3; ++k) {
+        dst[(k * rows + i) * cols + (mirror ? cols - j - 1 : j)] = rgb[k];
+      }
+      im_data += 3;
+    }
+  }
+}
+
+void RandomImage(int rows, int cols, std::vector<uint8_t> *img, std::vector<float> *mean_img) {
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<int> pixel(0, 255);
+  img->resize(rows * cols * 3);
+  mean_img->resize(rows * cols * 3);
+  for (auto &v : *img) v = static_cast<uint8_t>(pixel(rng));
+  for (auto &v : *mean_img) v = static_cast<float>(pixel(rng));
+}
+
+}  // namespace
+
+TEST(IMAGE_AUG_PERF, PackMatchesReference) {
+  const int rows = 37, cols = 53;  // odd sizes to exercise the SIMD remainders
+  std::vector<uint8_t> img;
+  std::vector<float> mean_img;
+  RandomImage(rows, cols, &img, &mean_img);
+  std::vector<float> expected(img.size()), actual(img.size());
+  for (bool mirror : {false, true}) {
+    for (const float *mimg : {static_cast<const float *>(nullptr),
+                              static_cast<const float *>(mean_img.data())}) {
+      ReferencePack(img, rows, cols, mirror, mimg, expected.data());
+      io::image_kernel::PackImageCHW(img.data(), cols * 3, rows, cols, 3, swap_bgr, mirror,
+                                     true, mean, mult, bias, mimg, cols,
+                                     actual.data(), cols);
+      for (size_t i = 0; i < expected.size(); ++i) {
+        ASSERT_NEAR(expected[i], actual[i], 1e-5f) << "at " << i;
+      }
+    }
+  }
+}
+
+TEST(IMAGE_AUG_PERF, TimingCPU) {
+  std::vector<std::pair<int, int>> shapes;
+  if (test::performance_run) {
+    shapes = { {224, 224}, {299, 299}, {512, 512} };
+  } else {
+    shapes = { {224, 224} };
+  }
+  const size_t iterations = test::performance_run ? 200 : 10;
+  for (const auto &shape : shapes) {
+    const int rows = shape.first, cols = shape.second;
+    std::vector<uint8_t> img;
+    std::vector<float> mean_img;
+    RandomImage(rows, cols, &img, &mean_img);
+    std::vector<float> out(img.size());
+    const std::string label = std::to_string(rows) + "x" + std::to_string(cols);
+    {
+      test::perf::TimedScope timer("Per-pixel image pack " + label, iterations);
+      for (size_t n = 0; n < iterations; ++n) {
+        ReferencePack(img, rows, cols, n % 2 == 0, nullptr, out.data());
+      }
+    }
+    {
+      test::perf::TimedScope timer("Fused image pack     " + label, iterations);
+      for (size_t n = 0; n < iterations; ++n) {
+        io::image_kernel::PackImageCHW(img.data(), cols * 3, rows, cols, 3, swap_bgr,
+                                       n % 2 == 0, true, mean, mult, bias, nullptr, 0,
+                                       out.data(), cols);
+      }
+    }
+  }
+}
@@ -0,0 +1,151 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ *  \file text_parse_test.cc
+ *  \brief numbers and lines of the text data iterators
+ */
+
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include "../../src/io/text_parse.h"
+
+using namespace mxnet::io;
+
+namespace {
+
+/*! \brief parses the number at the start of text, returns the number of characters used */
+template<typename DType>
+size_t Parse(const std::string& text, DType* out) {
+  return ParseNumber(text.data(), text.data() + text.size(), out) - text.data();
+}
+
+}  // namespace
+
+/*!
+ * \brief signs, exponents, fractions without leading or trailing digits, and the
+ *  delimiter after the number
+ */
+TEST(TEXT_PARSE, Numbers) {
+  const struct {
+    const char* text;
+    float value;
+    size_t used;
+  } cases[] = {
+    {"-1.5,2", -1.5f, 4}, {"+2 ", 2.0f, 2}, {"1e3", 1e3f, 3}, {"-2.5E-2\t", -2.5e-2f, 7},
+    {"1e+2:", 1e2f, 4}, {".5", 0.5f, 2}, {"-.25", -0.25f, 4}, {"7.", 7.0f, 2},
+    {"  3", 3.0f, 3}, {"-0", -0.0f, 2}, {"1.17549435e-38", 1.17549435e-38f, 14},
+    {"3.4e38", 3.4e38f, 6}, {"4.25\r\n", 4.25f, 4}, {"-1e-45", -1e-45f, 6}
+  };
+  for (const auto& c : cases) {
+    float value;
+    EXPECT_EQ(Parse(c.text, &value), c.used) << c.text;
+    EXPECT_EQ(value, c.value) << c.text;
+  }
+  int64_t i;
+  EXPECT_EQ(Parse("-2147483648,", &i), 11U);
+  EXPECT_EQ(i, -2147483648LL);
+  EXPECT_EQ(Parse("123456789012345678", &i), 18U);
+  EXPECT_EQ(i, 123456789012345678LL);
+  int32_t j;
+  EXPECT_EQ(Parse("-7\r", &j), 2U);
+  EXPECT_EQ(j, -7);
+}
+
+/*!
+ * \brief empty fields, and malformed ones, read as the C library reads them
+ */
+TEST(TEXT_PARSE, EmptyFields) {
+  float value = 1;
+  EXPECT_EQ(Parse(",3", &value), 0U);
+  EXPECT_EQ(value, 0.0f);
+  value = 1;
+  EXPECT_EQ(Parse("", &value), 0U);
+  EXPECT_EQ(value, 0.0f);
+  value = 1;
+  EXPECT_EQ(Parse("\r\n", &value), 0U);
+  EXPECT_EQ(value, 0.0f);
+  EXPECT_EQ(Parse("1e,2", &value), 2U);
+  EXPECT_EQ(value, 1.0f);
+  EXPECT_EQ(Parse("-,2", &value), 1U);
+  EXPECT_EQ(value, 0.0f);
+}
+
+/*!
+ * \brief floats are rounded once, to the value strtof gives, and doubles to the one
+ *  strtod gives
+ */
+TEST(TEXT_PARSE, CorrectlyRounded) {
+  // just above the midpoint of two floats, and rounded to that midpoint in double
+  for (const char* text : {"1.90711909532547", "7.67591404914856", "-6.82437539100647"}) {
+    float f;
+    Parse(text, &f);
+    EXPECT_EQ(f, std::strtof(text, nullptr)) << text;
+  }
+  std::mt19937_64 gen(13);
+  for (int n = 0; n < 200000; ++n) {
+    // 1 to 17 significant digits, the point anywhere, and an exponent or none
+    std::string text = gen() % 2 ? "-" : "";
+    const int digits = 1 + gen() % 17;
+    const int point = gen() % (digits + 1);
+    for (int d = 0; d < digits; ++d) {
+      if (d == point) text += '.';
+      text += static_cast<char>('0' + gen() % 10);
+    }
+    if (gen() % 2) text += "e" + std::to_string(static_cast<int>(gen() % 81) - 40);
+    float f;
+    double d;
+    ASSERT_EQ(Parse(text, &f), text.size()) << text;
+    ASSERT_EQ(Parse(text, &d), text.size()) << text;
+    const float expected_f = std::strtof(text.c_str(), nullptr);
+    const double expected_d = std::strtod(text.c_str(), nullptr);
+    ASSERT_EQ(std::memcmp(&f, &expected_f, sizeof(f)), 0) << text;
+    ASSERT_EQ(std::memcmp(&d, &expected_d, sizeof(d)), 0) << text;
+  }
+}
+
+/*!
+ * \brief \n, \r\n and \r line endings, and blank lines
+ */
+TEST(TEXT_PARSE, Lines) {
+  const std::string text = "1,2\r\n\r\n \t\n3\r4";
+  const char* begin = text.data();
+  const char* end = begin + text.size();
+  const char* eol = FindEOL(begin, end);
+  EXPECT_EQ(eol - begin, 3);
+  EXPECT_FALSE(IsBlankLine(begin, eol));
+  const char* p = SkipEOL(eol, end);
+  EXPECT_EQ(p - begin, 7);
+  eol = FindEOL(p, end);
+  EXPECT_TRUE(IsBlankLine(p, eol));
+  p = SkipEOL(eol, end);
+  EXPECT_EQ(*p, '3');
+  eol = FindEOL(p, end);
+  EXPECT_EQ(*eol, '\r');
+  p = SkipEOL(eol, end);
+  EXPECT_EQ(FindEOL(p, end), end);
+  // a line start found from the middle of a line, and from a line start
+  EXPECT_EQ(AlignToLine(begin, begin + 1, end) - begin, 7);
+  EXPECT_EQ(AlignToLine(begin, begin + 5, end) - begin, 7);
+  EXPECT_EQ(AlignToLine(begin, begin, end), begin);
+}
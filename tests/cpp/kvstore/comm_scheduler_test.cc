@@ -0,0 +1,148 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file comm_scheduler_test.cc
+ * \brief send order and flow control of the kvstore communication scheduler
+*/
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "../src/kvstore/comm_scheduler.h"
+
+using mxnet::kvstore::CommScheduler;
+
+namespace {
+
+/*!
+ * \brief records the messages sent by a scheduler, and keeps their responses
+ *  back until Respond() is called
+ */
+class FakeNetwork {
+ public:
+  CommScheduler::SendFn Message(int id) {
+    return [this, id](const CommScheduler::Callback& on_response) {
+      std::lock_guard<std::mutex> lock(mu_);
+      sent_.push_back(id);
+      pending_.push_back(on_response);
+      cond_.notify_all();
+    };
+  }
+
+  /*! \brief waits until n messages are sent, returns false on timeout */
+  bool WaitSent(size_t n) {
+    std::unique_lock<std::mutex> lock(mu_);
+    return cond_.wait_for(lock, std::chrono::seconds(10), [this, n]() {
+      return sent_.size() >= n;
+    });
+  }
+
+  /*! \brief answers the oldest message which is not answered yet */
+  void Respond() {
+    CommScheduler::Callback cb;
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      cb = pending_.front();
+      pending_.erase(pending_.begin());
+    }
+    cb();
+  }
+
+  std::vector<int> sent() {
+    std::lock_guard<std::mutex> lock(mu_);
+    return sent_;
+  }
+
+ private:
+  std::mutex mu_;
+  std::condition_variable cond_;
+  std::vector<int> sent_;
+  std::vector<CommScheduler::Callback> pending_;
+};
+
+}  // namespace
+
+TEST(CommScheduler, ZeroCreditSendsAtOnce) {
+  FakeNetwork net;
+  CommScheduler scheduler(0);
+  for (int i = 0; i < 3; ++i) scheduler.Send(i, 100, net.Message(i));
+  EXPECT_EQ(net.sent(), std::vector<int>({0, 1, 2}));
+  EXPECT_EQ(scheduler.in_flight(), 0U);
+}
+
+TEST(CommScheduler, PriorityOrder) {
+  FakeNetwork net;
+  CommScheduler scheduler(100);
+  // occupies the credit, so that the next messages are queued
+  scheduler.Send(0, 100, net.Message(0));
+  ASSERT_TRUE(net.WaitSent(1));
+  scheduler.Send(-3, 100, net.Message(1));
+  scheduler.Send(-1, 100, net.Message(2));
+  scheduler.Send(-2, 100, net.Message(3));
+  scheduler.Send(-1, 100, net.Message(4));
+  for (size_t n = 2; n <= 5; ++n) {
+    net.Respond();
+    ASSERT_TRUE(net.WaitSent(n));
+    EXPECT_EQ(net.sent().size(), n);
+  }
+  // equal priorities are sent in the order they were queued
+  EXPECT_EQ(net.sent(), std::vector<int>({0, 2, 4, 3, 1}));
+  net.Respond();
+  EXPECT_EQ(scheduler.in_flight(), 0U);
+}
+
+TEST(CommScheduler, CreditLimit) {
+  FakeNetwork net;
+  CommScheduler scheduler(250);
+  for (int i = 0; i < 5; ++i) scheduler.Send(0, 100, net.Message(i));
+  ASSERT_TRUE(net.WaitSent(2));
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_EQ(net.sent().size(), 2U);
+  EXPECT_EQ(scheduler.in_flight(), 200U);
+  net.Respond();
+  ASSERT_TRUE(net.WaitSent(3));
+  net.Respond();
+  ASSERT_TRUE(net.WaitSent(4));
+  net.Respond();
+  ASSERT_TRUE(net.WaitSent(5));
+  EXPECT_EQ(net.sent(), std::vector<int>({0, 1, 2, 3, 4}));
+  net.Respond();
+  net.Respond();
+  EXPECT_EQ(scheduler.in_flight(), 0U);
+}
+
+TEST(CommScheduler, OversizeMessage) {
+  FakeNetwork net;
+  CommScheduler scheduler(100);
+  scheduler.Send(0, 50, net.Message(0));
+  ASSERT_TRUE(net.WaitSent(1));
+  // larger than the credit, waits until nothing else is in flight
+  scheduler.Send(0, 1000, net.Message(1));
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_EQ(net.sent().size(), 1U);
+  net.Respond();
+  ASSERT_TRUE(net.WaitSent(2));
+  EXPECT_EQ(scheduler.in_flight(), 1000U);
+  net.Respond();
+  EXPECT_EQ(scheduler.in_flight(), 0U);
+}
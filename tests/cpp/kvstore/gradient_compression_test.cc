@@ -0,0 +1,129 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file gradient_compression_test.cc
+ * \brief round trips of the gradient compression kernels
+*/
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+#include "../src/kvstore/gradient_compression-inl.h"
+
+using mxnet::TBlob;
+using mxnet::kvstore::CompressionType;
+
+namespace {
+
+std::vector<float> RandomGradient(size_t n, unsigned seed) {
+  std::mt19937 gen(seed);
+  std::normal_distribution<float> dis(0.f, 1.f);
+  std::vector<float> grad(n);
+  for (float &g : grad) g = dis(gen);
+  return grad;
+}
+
+TBlob Blob(std::vector<float> *v) {
+  return TBlob(v->data(), mshadow::Shape1(v->size()), mshadow::cpu::kDevMask);
+}
+
+/*!
+ * \brief quantizes grad with a zero residual and dequantizes it again,
+ *  returns the dequantized gradient and leaves the error in residual
+ */
+std::vector<float> RoundTrip(const std::vector<float> &grad, size_t compressed_size,
+                             CompressionType type, float threshold, int block_size,
+                             std::vector<float> *residual) {
+  std::vector<float> in(grad), compressed(compressed_size), out(grad.size());
+  residual->assign(grad.size(), 0.f);
+  mxnet::kvstore::QuantizeImpl(nullptr, {Blob(&in), Blob(residual), Blob(&compressed)},
+                               type, threshold, block_size);
+  mxnet::kvstore::DequantizeImpl(nullptr, {Blob(&compressed), Blob(&out)},
+                                 type, threshold, block_size);
+  return out;
+}
+
+}  // namespace
+
+TEST(GradientCompression, CastKeepsErrorInResidual) {
+  const std::vector<float> grad = RandomGradient(1001, 1);
+  for (CompressionType type : {CompressionType::kFP16, CompressionType::kBF16}) {
+    std::vector<float> residual;
+    std::vector<float> out = RoundTrip(grad, 501, type, 0.f, 0, &residual);
+    const float tol = type == CompressionType::kFP16 ? 1e-3f : 1e-2f;
+    for (size_t i = 0; i < grad.size(); ++i) {
+      EXPECT_NEAR(out[i], grad[i], tol * std::fabs(grad[i]) + 1e-6f);
+      EXPECT_FLOAT_EQ(out[i] + residual[i], grad[i]);
+    }
+  }
+}
+
+TEST(GradientCompression, OneBitSendsScaledSigns) {
+  const float threshold = 0.25f;
+  const std::vector<float> grad = RandomGradient(100, 2);
+  std::vector<float> residual;
+  std::vector<float> out = RoundTrip(grad, 4, CompressionType::kOneBit, threshold, 0, &residual);
+  for (size_t i = 0; i < grad.size(); ++i) {
+    EXPECT_EQ(out[i], grad[i] >= 0 ? threshold : -threshold);
+    EXPECT_FLOAT_EQ(residual[i], grad[i] - out[i]);
+  }
+}
+
+TEST(GradientCompression, TopKSendsLargestOfEachBlock) {
+  const int block = 16;
+  const std::vector<float> grad = RandomGradient(200, 3);
+  std::vector<float> residual;
+  std::vector<float> out = RoundTrip(grad, 13, CompressionType::kTopK, 0.f, block, &residual);
+  for (size_t start = 0; start < grad.size(); start += block) {
+    const size_t end = std::min(grad.size(), start + block);
+    size_t best = start;
+    for (size_t i = start; i < end; ++i) {
+      if (std::fabs(grad[i]) > std::fabs(grad[best])) best = i;
+    }
+    for (size_t i = start; i < end; ++i) {
+      if (i == best) {
+        EXPECT_NEAR(out[i], grad[i], 1e-3f * std::fabs(grad[i]) + 1e-6f);
+      } else {
+        EXPECT_EQ(out[i], 0.f);
+      }
+      EXPECT_FLOAT_EQ(out[i] + residual[i], grad[i]);
+    }
+  }
+}
+
+TEST(GradientCompression, TopKPartitionsAlongBlocks) {
+  // servers dequantize their own range of the compressed array on its own
+  const int block = 8;
+  const std::vector<float> grad = RandomGradient(61, 4);
+  std::vector<float> residual;
+  std::vector<float> full = RoundTrip(grad, 8, CompressionType::kTopK, 0.f, block, &residual);
+  std::vector<float> in(grad), compressed(8), part(grad.size() - 3 * block);
+  residual.assign(grad.size(), 0.f);
+  mxnet::kvstore::QuantizeImpl(nullptr, {Blob(&in), Blob(&residual), Blob(&compressed)},
+                               CompressionType::kTopK, 0.f, block);
+  std::vector<float> tail(compressed.begin() + 3, compressed.end());
+  mxnet::kvstore::DequantizeImpl(nullptr, {Blob(&tail), Blob(&part)},
+                                 CompressionType::kTopK, 0.f, block);
+  for (size_t i = 0; i < part.size(); ++i) {
+    EXPECT_EQ(part[i], full[3 * block + i]);
+  }
+}
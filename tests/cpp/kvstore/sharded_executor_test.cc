@@ -0,0 +1,188 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file sharded_executor_test.cc
+ * \brief order and exclusion of the threads handling the requests of a kvstore server
+*/
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "../src/kvstore/sharded_executor.h"
+
+using mxnet::kvstore::KeyMap;
+using mxnet::kvstore::ShardedExecutor;
+
+namespace {
+
+const int kNumThreads = 4;
+const int kNumShards = 8;
+
+/*! \brief counts the functions running on the thread of each shard */
+struct Busy {
+  Busy() : running(kNumThreads) {
+    for (auto& count : running) count = 0;
+  }
+  /*! \brief marks the threads of the shards busy for a while, returns whether they were idle */
+  bool Run(const std::vector<size_t>& shards) {
+    std::vector<size_t> threads;
+    for (size_t shard : shards) {
+      if (std::find(threads.begin(), threads.end(), shard % kNumThreads) == threads.end()) {
+        threads.push_back(shard % kNumThreads);
+      }
+    }
+    bool idle = true;
+    for (size_t t : threads) idle = ++running[t] == 1 && idle;
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+    for (size_t t : threads) --running[t];
+    return idle;
+  }
+  std::vector<std::atomic<int>> running;
+};
+
+}  // namespace
+
+/*!
+ * \brief the functions of a shard run in the order they were queued
+ */
+TEST(ShardedExecutor, OrderWithinShard) {
+  std::vector<std::vector<int>> seen(kNumShards);
+  {
+    ShardedExecutor exec(kNumThreads);
+    for (int i = 0; i < 1000; ++i) {
+      exec.Exec(i % kNumShards, [&seen, i]() { seen[i % kNumShards].push_back(i); });
+    }
+    exec.WaitAll();
+  }
+  for (int shard = 0; shard < kNumShards; ++shard) {
+    ASSERT_EQ(seen[shard].size(), 1000U / kNumShards);
+    for (size_t j = 0; j < seen[shard].size(); ++j) {
+      EXPECT_EQ(seen[shard][j], static_cast<int>(j * kNumShards + shard));
+    }
+  }
+}
+
+/*!
+ * \brief without threads the functions run on the calling thread, posted ones too
+ */
+TEST(ShardedExecutor, NoThreads) {
+  ShardedExecutor exec(0);
+  const std::thread::id caller = std::this_thread::get_id();
+  int count = 0;
+  exec.Exec(3, [&]() {
+    EXPECT_EQ(std::this_thread::get_id(), caller);
+    exec.Post({1, 2}, [&]() { ++count; });
+    EXPECT_EQ(count, 1);
+    ++count;
+  });
+  EXPECT_EQ(count, 2);
+  exec.ExecExclusive([&]() { ++count; });
+  EXPECT_EQ(count, 3);
+}
+
+/*!
+ * \brief an exclusive function runs after the functions queued before, and alone
+ */
+TEST(ShardedExecutor, Exclusive) {
+  ShardedExecutor exec(kNumThreads);
+  Busy busy;
+  std::atomic<int> done(0);
+  for (int round = 0; round < 20; ++round) {
+    for (int i = 0; i < 50; ++i) {
+      exec.Exec(i, [&busy, &done, i]() {
+        EXPECT_TRUE(busy.Run({static_cast<size_t>(i)}));
+        ++done;
+      });
+    }
+    exec.ExecExclusive([&]() {
+      EXPECT_EQ(done.load(), (round + 1) * 50);
+      for (auto& count : busy.running) EXPECT_EQ(count.load(), 0);
+    });
+  }
+  exec.WaitAll();
+}
+
+/*!
+ * \brief a function posted by a queued function runs while no other function of its
+ * shards runs
+ */
+TEST(ShardedExecutor, Post) {
+  ShardedExecutor exec(kNumThreads);
+  Busy busy;
+  std::atomic<int> posted(0);
+  for (int i = 0; i < 400; ++i) {
+    exec.Exec(i % kNumShards, [&, i]() {
+      EXPECT_TRUE(busy.Run({static_cast<size_t>(i % kNumShards)}));
+      // a shard of the same thread, a shard of another thread, and several shards
+      const std::vector<size_t> shards = i % 3 == 0 ? std::vector<size_t>{0} :
+        i % 3 == 1 ? std::vector<size_t>{1, 2} : std::vector<size_t>{3, 4, 7};
+      exec.Post(shards, [&busy, &posted, shards]() {
+        EXPECT_TRUE(busy.Run(shards));
+        ++posted;
+      });
+    });
+  }
+  exec.WaitAll();
+  EXPECT_EQ(posted.load(), 400);
+}
+
+/*!
+ * \brief a function posted by an exclusive function runs once it returned
+ */
+TEST(ShardedExecutor, PostFromExclusive) {
+  ShardedExecutor exec(kNumThreads);
+  std::atomic<bool> returned(false);
+  std::atomic<int> posted(0);
+  exec.ExecExclusive([&]() {
+    exec.Post({0}, [&]() { EXPECT_TRUE(returned); ++posted; });
+    exec.Post({1, 2, 3}, [&]() { EXPECT_TRUE(returned); ++posted; });
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    returned = true;
+  });
+  exec.WaitAll();
+  EXPECT_EQ(posted.load(), 2);
+}
+
+/*!
+ * \brief threads add keys concurrently, and the references to the values stay valid
+ */
+TEST(KeyMap, ConcurrentInsert) {
+  KeyMap<std::vector<int>> map;
+  std::vector<int>* first = &map[0];
+  first->push_back(-1);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kNumThreads; ++t) {
+    threads.emplace_back([&map, t]() {
+      for (int key = t; key < 10000; key += kNumThreads) map[key].push_back(key);
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  EXPECT_EQ(&map[0], first);
+  EXPECT_EQ(map[0], std::vector<int>({-1, 0}));
+  size_t count = 0;
+  for (const auto& entry : map) {
+    EXPECT_EQ(entry.second.back(), entry.first);
+    ++count;
+  }
+  EXPECT_EQ(count, 10000U);
+}
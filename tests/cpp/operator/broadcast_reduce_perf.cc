@@ -0,0 +1,183 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ *  \file broadcast_reduce_perf.cc
+ *  \brief cpu reductions along a single axis against the generic reduction
+ */
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "../include/test_util.h"
+#include "../../src/operator/tensor/broadcast_reduce_op.h"
+
+using namespace mxnet;
+
+namespace {
+
+const int kNDim = op::broadcast::MAX_DIM;
+
+/*! \brief data of shape big, and the shape small where the axes in axes are reduced */
+struct ReduceBlobs {
+  ReduceBlobs(const std::vector<index_t>& shape, const std::vector<int>& axes)
+    : big(shape.size(), 1), small(shape.size(), 1) {
+    for (size_t i = 0; i < shape.size(); ++i) {
+      big[i] = small[i] = shape[i];
+    }
+    for (int axis : axes) small[axis] = 1;
+    // leading axes of size 1, as BROADCAST_NDIM_SWITCH pads the shapes
+    TShape padded_big(kNDim), padded_small(kNDim);
+    for (int i = 0; i < kNDim; ++i) {
+      const int j = i - (kNDim - static_cast<int>(shape.size()));
+      padded_big[i] = j < 0 ? 1 : big[j];
+      padded_small[i] = j < 0 ? 1 : small[j];
+    }
+    big = padded_big;
+    small = padded_small;
+    data.resize(big.Size());
+    std::mt19937 gen(23);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    for (float& v : data) v = dist(gen);
+  }
+
+  TBlob Big() {
+    return TBlob(data.data(), big, cpu::kDevMask);
+  }
+  TBlob Small(std::vector<float>* out) {
+    out->assign(small.Size(), 0.5f);
+    return TBlob(out->data(), small, cpu::kDevMask);
+  }
+
+  TShape big, small;
+  std::vector<float> data;
+};
+
+/*! \brief the reduction of seq_reduce_compute, which walks the reduced axes by coordinates */
+template<typename Reducer>
+void GenericReduce(const TBlob& small, OpReqType req, const TBlob& big) {
+  using namespace op::broadcast;
+  mshadow::Shape<kNDim> rshape, rstride;
+  diff(small.shape_.get<kNDim>(), big.shape_.get<kNDim>(), &rshape, &rstride);
+  seq_reduce_compute<Reducer, kNDim, float, op::mshadow_op::identity>(
+    small.shape_.Size(), rshape.Size(), req == kAddTo, big.dptr<float>(), small.dptr<float>(),
+    big.shape_.get<kNDim>(), small.shape_.get<kNDim>(), rshape, rstride);
+}
+
+template<typename Reducer>
+void FastReduce(const TBlob& small, OpReqType req, const TBlob& big) {
+  mshadow::Tensor<cpu, 1, char> workspace;
+  op::broadcast::Reduce<Reducer, kNDim, float, op::mshadow_op::identity>(
+    nullptr, small, req, workspace, big);
+}
+
+template<typename Reducer>
+void CompareWithGeneric(const std::vector<index_t>& shape, const std::vector<int>& axes) {
+  ReduceBlobs blobs(shape, axes);
+  for (OpReqType req : {kWriteTo, kAddTo}) {
+    std::vector<float> fast, generic;
+    FastReduce<Reducer>(blobs.Small(&fast), req, blobs.Big());
+    GenericReduce<Reducer>(blobs.Small(&generic), req, blobs.Big());
+    for (size_t i = 0; i < fast.size(); ++i) {
+      ASSERT_NEAR(fast[i], generic[i], 1e-5f * (1 + std::abs(generic[i])))
+        << "at " << i << " of " << blobs.big << " into " << blobs.small;
+    }
+  }
+}
+
+template<typename F>
+double MillisecondsPerCall(F f, int count) {
+  f();
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < count; ++i) f();
+  const std::chrono::duration<double, std::milli> elapsed =
+    std::chrono::steady_clock::now() - start;
+  return elapsed.count() / count;
+}
+
+}  // namespace
+
+/*!
+ * \brief the single axis reductions give the results of the generic reduction
+ */
+TEST(BROADCAST_REDUCE_PERF, SingleAxisMatchesGeneric) {
+  // last, first and middle axes, of sizes which are and are not multiples of the lanes
+  CompareWithGeneric<mshadow::red::sum>({7, 1000}, {1});
+  CompareWithGeneric<mshadow::red::sum>({1000, 7}, {0});
+  CompareWithGeneric<mshadow::red::sum>({3, 333, 517}, {1});
+  CompareWithGeneric<mshadow::red::maximum>({7, 1000}, {1});
+  CompareWithGeneric<mshadow::red::maximum>({3, 333, 517}, {1});
+  CompareWithGeneric<mshadow::red::minimum>({1000, 7}, {0});
+  CompareWithGeneric<op::mshadow_op::product>({5, 13}, {1});
+  CompareWithGeneric<op::mshadow_op::nrm2>({9, 300}, {0});
+  // all axes, and a reduced axis long enough to be split among threads
+  CompareWithGeneric<mshadow::red::sum>({5, 6, 7}, {0, 1, 2});
+  CompareWithGeneric<mshadow::red::sum>({2, 100000}, {1});
+  CompareWithGeneric<mshadow::red::maximum>({100000, 3}, {0});
+  // axes of size 1 between the reduced ones
+  CompareWithGeneric<mshadow::red::sum>({4, 1, 60, 5}, {0, 2});
+  // the generic reduction is used for the axes which are not adjacent
+  CompareWithGeneric<mshadow::red::sum>({4, 3, 60}, {0, 2});
+}
+
+/*!
+ * \brief timing of the reductions of the first, a middle, the last and all axes
+ */
+TEST(BROADCAST_REDUCE_PERF, TimingCPU) {
+  std::vector<std::vector<index_t>> shapes;
+  if (test::performance_run) {
+    shapes = {{4096, 1024}, {128, 128, 128}, {32, 512, 768}};
+  } else {
+    shapes = {{1024, 256}, {32, 64, 64}};
+  }
+  const int count = test::quick_test ? 1 : 10;
+  for (const std::vector<index_t>& shape : shapes) {
+    std::vector<std::vector<int>> axes_list;
+    for (int axis = 0; axis < static_cast<int>(shape.size()); ++axis) {
+      axes_list.push_back({axis});
+    }
+    axes_list.push_back({});
+    for (int axis = 0; axis < static_cast<int>(shape.size()); ++axis) {
+      axes_list.back().push_back(axis);
+    }
+    for (const std::vector<int>& axes : axes_list) {
+      ReduceBlobs blobs(shape, axes);
+      std::vector<float> out;
+      const TBlob big = blobs.Big(), small = blobs.Small(&out);
+      const double fast_sum = MillisecondsPerCall([&]() {
+        FastReduce<mshadow::red::sum>(small, kWriteTo, big);
+      }, count);
+      const double generic_sum = MillisecondsPerCall([&]() {
+        GenericReduce<mshadow::red::sum>(small, kWriteTo, big);
+      }, count);
+      const double fast_max = MillisecondsPerCall([&]() {
+        FastReduce<mshadow::red::maximum>(small, kWriteTo, big);
+      }, count);
+      const double generic_max = MillisecondsPerCall([&]() {
+        GenericReduce<mshadow::red::maximum>(small, kWriteTo, big);
+      }, count);
+      std::cout << "Reduce " << blobs.big << " into " << blobs.small << ": sum "
+                << fast_sum << " ms single axis, " << generic_sum << " ms generic; max "
+                << fast_max << " ms single axis, " << generic_max << " ms generic" << std::endl;
+    }
+  }
+}
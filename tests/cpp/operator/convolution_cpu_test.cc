@@ -0,0 +1,204 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ *  \file convolution_cpu_test.cc
+ *  \brief Winograd, depthwise kernels and algorithm registry of the cpu convolution
+ */
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <random>
+#include <vector>
+#include "../../src/operator/nn/convolution-inl.h"
+
+using namespace mxnet;
+
+namespace {
+
+/*! \brief direct 3x3 convolution of stride 1, (num, channels, height, width) data */
+std::vector<double> DirectConvolution(const std::vector<double>& data,
+                                      const std::vector<double>& weight,
+                                      int num, int channels, int height, int width,
+                                      int num_filter, int group, int pad) {
+  const int out_h = height + 2 * pad - 2, out_w = width + 2 * pad - 2;
+  const int cg = channels / group, mg = num_filter / group;
+  std::vector<double> out(num * num_filter * out_h * out_w, 0);
+  for (int n = 0; n < num; ++n) {
+    for (int m = 0; m < num_filter; ++m) {
+      const int g = m / mg;
+      for (int oh = 0; oh < out_h; ++oh) {
+        for (int ow = 0; ow < out_w; ++ow) {
+          double sum = 0;
+          for (int c = 0; c < cg; ++c) {
+            for (int kh = 0; kh < 3; ++kh) {
+              for (int kw = 0; kw < 3; ++kw) {
+                const int h = oh - pad + kh, w = ow - pad + kw;
+                if (h < 0 || h >= height || w < 0 || w >= width) continue;
+                sum += data[((n * channels + g * cg + c) * height + h) * width + w] *
+                       weight[((m * cg + c) * 3 + kh) * 3 + kw];
+              }
+            }
+          }
+          out[((n * num_filter + m) * out_h + oh) * out_w + ow] = sum;
+        }
+      }
+    }
+  }
+  return out;
+}
+
+/*! \brief the Winograd transforms and the 16 products of each group, as in ConvolutionOp */
+void CompareWinograd(int num, int channels, int height, int width,
+                     int num_filter, int group, int pad) {
+  std::mt19937 gen(5);
+  std::uniform_real_distribution<double> dist(-1.0, 1.0);
+  std::vector<double> data(num * channels * height * width);
+  std::vector<double> weight(num_filter * channels / group * 9);
+  for (double& v : data) v = dist(gen);
+  for (double& v : weight) v = dist(gen);
+  const int out_h = height + 2 * pad - 2, out_w = width + 2 * pad - 2;
+  const int cg = channels / group, mg = num_filter / group;
+  const index_t tiles_h = op::winograd::NumTiles(out_h);
+  const index_t tiles_w = op::winograd::NumTiles(out_w);
+  const index_t p_size = num * tiles_h * tiles_w;
+  std::vector<double> u(16 * num_filter * cg), v(16 * cg * p_size), prod(16 * mg * p_size);
+  std::vector<double> out(num * num_filter * out_h * out_w);
+  op::winograd::TransformFilters(weight.data(), num_filter, cg, u.data());
+  for (int g = 0; g < group; ++g) {
+    op::winograd::TransformInput(data.data() + g * cg * height * width, num, cg,
+                                 channels * height * width, height, width, pad, pad,
+                                 tiles_h, tiles_w, v.data());
+    for (int xi = 0; xi < 16; ++xi) {
+      for (int m = 0; m < mg; ++m) {
+        for (index_t p = 0; p < p_size; ++p) {
+          double sum = 0;
+          for (int c = 0; c < cg; ++c) {
+            sum += u[(xi * num_filter + g * mg + m) * cg + c] * v[(xi * cg + c) * p_size + p];
+          }
+          prod[(xi * mg + m) * p_size + p] = sum;
+        }
+      }
+    }
+    op::winograd::TransformOutput(prod.data(), num, mg, num_filter * out_h * out_w,
+                                  out_h, out_w, tiles_h, tiles_w,
+                                  out.data() + g * mg * out_h * out_w);
+  }
+  const std::vector<double> expected = DirectConvolution(data, weight, num, channels, height,
+                                                         width, num_filter, group, pad);
+  for (size_t i = 0; i < out.size(); ++i) {
+    ASSERT_NEAR(out[i], expected[i], 1e-10) << "at " << i;
+  }
+}
+
+double Dot(const std::vector<double>& a, const std::vector<double>& b) {
+  double sum = 0;
+  for (size_t i = 0; i < a.size(); ++i) sum += a[i] * b[i];
+  return sum;
+}
+
+/*!
+ * \brief the depthwise forward gives the direct convolution for 3x3 kernels of stride 1, and
+ *  its backward is the adjoint of the forward for any kernel, stride, pad and dilation:
+ *  <out_grad, conv(data, weight)> = <in_grad, data> = <weight_grad, weight>
+ */
+void CheckDepthwise(int num, int channels, int height, int width,
+                    int kernel, int stride, int pad, int dilate) {
+  op::depthwise::Shape shape;
+  shape.num = num;
+  shape.channels = channels;
+  shape.height = height;
+  shape.width = width;
+  shape.out_h = (height + 2 * pad - dilate * (kernel - 1) - 1) / stride + 1;
+  shape.out_w = (width + 2 * pad - dilate * (kernel - 1) - 1) / stride + 1;
+  shape.kernel_h = shape.kernel_w = kernel;
+  shape.stride_h = shape.stride_w = stride;
+  shape.pad_h = shape.pad_w = pad;
+  shape.dilate_h = shape.dilate_w = dilate;
+  std::mt19937 gen(7);
+  std::uniform_real_distribution<double> dist(-1.0, 1.0);
+  std::vector<double> data(num * channels * height * width), weight(channels * kernel * kernel);
+  std::vector<double> out_grad(num * channels * shape.out_h * shape.out_w);
+  for (double& v : data) v = dist(gen);
+  for (double& v : weight) v = dist(gen);
+  for (double& v : out_grad) v = dist(gen);
+  std::vector<double> out(out_grad.size()), in_grad(data.size()), weight_grad(weight.size());
+  op::depthwise::Forward(shape, data.data(), weight.data(), out.data());
+  if (kernel == 3 && stride == 1 && dilate == 1) {
+    const std::vector<double> expected = DirectConvolution(data, weight, num, channels, height,
+                                                           width, channels, channels, pad);
+    for (size_t i = 0; i < out.size(); ++i) {
+      ASSERT_NEAR(out[i], expected[i], 1e-10) << "at " << i;
+    }
+  }
+  op::depthwise::BackwardData(shape, out_grad.data(), weight.data(), kWriteTo, in_grad.data());
+  op::depthwise::BackwardWeight(shape, out_grad.data(), data.data(), kWriteTo,
+                                weight_grad.data());
+  const double expected = Dot(out_grad, out);
+  EXPECT_NEAR(Dot(in_grad, data), expected, 1e-9 * (1 + std::abs(expected)));
+  EXPECT_NEAR(Dot(weight_grad, weight), expected, 1e-9 * (1 + std::abs(expected)));
+}
+
+}  // namespace
+
+/*!
+ * \brief Winograd F(2x2, 3x3) gives the direct convolution, for odd and even output sizes
+ */
+TEST(CONVOLUTION_CPU, WinogradMatchesDirect) {
+  CompareWinograd(1, 3, 6, 6, 4, 1, 0);
+  CompareWinograd(2, 5, 7, 9, 3, 1, 1);
+  CompareWinograd(3, 4, 5, 4, 6, 2, 2);
+  CompareWinograd(2, 16, 14, 14, 16, 1, 1);
+}
+
+/*!
+ * \brief the algorithm of a convolution is set once and then reused
+ */
+TEST(CONVOLUTION_CPU, AlgoRegistry) {
+  op::ConvolutionParam param;
+  param.Init(std::vector<std::pair<std::string, std::string>>{
+    {"kernel", "(3,3)"}, {"num_filter", "8"}, {"pad", "(1,1)"}});
+  const TShape data_shape({4, 8, 10, 10}), weight_shape({8, 8, 3, 3});
+  auto reg = op::CPUConvAlgoReg<op::ConvolutionParam>::Get();
+  int calls = 0;
+  auto setter = [&calls]() {
+    ++calls;
+    return static_cast<int>(op::conv::kWinograd);
+  };
+  EXPECT_EQ(reg->FindOrElseRegister(param, data_shape, weight_shape, mshadow::kFloat32, setter),
+            op::conv::kWinograd);
+  EXPECT_EQ(reg->FindOrElseRegister(param, data_shape, weight_shape, mshadow::kFloat32, setter),
+            op::conv::kWinograd);
+  EXPECT_EQ(calls, 1);
+  // another batch size is another convolution
+  reg->FindOrElseRegister(param, TShape({1, 8, 10, 10}), weight_shape, mshadow::kFloat32,
+                          setter);
+  EXPECT_EQ(calls, 2);
+}
+
+/*!
+ * \brief the direct depthwise kernels, for rows which are and are not multiples of the lanes
+ */
+TEST(CONVOLUTION_CPU, Depthwise) {
+  CheckDepthwise(2, 3, 7, 9, 3, 1, 1, 1);
+  CheckDepthwise(1, 4, 12, 17, 3, 1, 0, 1);
+  CheckDepthwise(2, 3, 13, 13, 3, 2, 1, 1);
+  CheckDepthwise(1, 2, 11, 20, 5, 1, 2, 2);
+  CheckDepthwise(3, 2, 9, 10, 1, 2, 0, 1);
+}
@@ -0,0 +1,186 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ *  \file layer_norm_perf.cc
+ *  \brief fused cpu LayerNorm against the broadcast and reduce implementation
+ */
+
+#include <gtest/gtest.h>
+#include <mxnet/resource.h>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "../include/test_util.h"
+#include "../../src/operator/nn/layer_norm-inl.h"
+
+using namespace mxnet;
+
+namespace {
+
+/*! \brief inputs and outputs of a LayerNorm forward and backward */
+struct LayerNormBlobs {
+  explicit LayerNormBlobs(const TShape& shape, int axis)
+    : shape(shape), moments_shape(shape), param_shape(mshadow::Shape1(shape[axis])),
+      data(shape.Size()), gamma(param_shape.Size()), beta(param_shape.Size()),
+      out(shape.Size()), mean(shape.Size() / shape[axis]), std_dev(mean.size()),
+      ograd(shape.Size()), grad_data(shape.Size()),
+      grad_gamma(param_shape.Size()), grad_beta(param_shape.Size()) {
+    moments_shape[axis] = 1;
+    std::mt19937 gen(17);
+    std::uniform_real_distribution<float> dist(-2.0f, 2.0f);
+    for (float& v : data) v = dist(gen);
+    for (float& v : ograd) v = dist(gen);
+    for (float& v : gamma) v = dist(gen);
+    for (float& v : beta) v = dist(gen);
+  }
+
+  static TBlob Blob(std::vector<float>* v, const TShape& shape) {
+    return TBlob(v->data(), shape, cpu::kDevMask);
+  }
+
+  std::vector<TBlob> inputs() {
+    return {Blob(&data, shape), Blob(&gamma, param_shape), Blob(&beta, param_shape)};
+  }
+  std::vector<TBlob> outputs() {
+    return {Blob(&out, shape), Blob(&mean, moments_shape), Blob(&std_dev, moments_shape)};
+  }
+  std::vector<TBlob> grad_inputs() {
+    return {Blob(&ograd, shape), Blob(&data, shape), Blob(&gamma, param_shape),
+            Blob(&mean, moments_shape), Blob(&std_dev, moments_shape)};
+  }
+  std::vector<TBlob> grad_outputs() {
+    return {Blob(&grad_data, shape), Blob(&grad_gamma, param_shape),
+            Blob(&grad_beta, param_shape)};
+  }
+
+  TShape shape, moments_shape, param_shape;
+  std::vector<float> data, gamma, beta, out, mean, std_dev;
+  std::vector<float> ograd, grad_data, grad_gamma, grad_beta;
+};
+
+nnvm::NodeAttrs LayerNormAttrs(int axis) {
+  nnvm::NodeAttrs attrs;
+  attrs.op = nnvm::Op::Get("LayerNorm");
+  attrs.dict = {{"axis", std::to_string(axis)}};
+  attrs.op->attr_parser(&attrs);
+  return attrs;
+}
+
+OpContext CPUContext() {
+  OpContext ctx;
+  ctx.is_train = true;
+  ctx.run_ctx.ctx = Context::CPU();
+  ctx.requested.push_back(ResourceManager::Get()->Request(
+      Context::CPU(), ResourceRequest(ResourceRequest::kTempSpace)));
+  return ctx;
+}
+
+void ExpectNear(const std::vector<float>& a, const std::vector<float>& b, float tol) {
+  ASSERT_EQ(a.size(), b.size());
+  for (size_t i = 0; i < a.size(); ++i) {
+    ASSERT_NEAR(a[i], b[i], tol * (1 + std::abs(b[i]))) << "at " << i;
+  }
+}
+
+/*! \brief runs the fused and the generic implementation on the same inputs */
+void CompareWithGeneric(const TShape& shape, int axis) {
+  const nnvm::NodeAttrs attrs = LayerNormAttrs(axis);
+  const OpContext ctx = CPUContext();
+  const std::vector<OpReqType> req(3, kWriteTo);
+  LayerNormBlobs fused(shape, axis), generic(shape, axis);
+  op::LayerNormComputeCPU(attrs, ctx, fused.inputs(), req, fused.outputs());
+  op::LayerNormCompute<cpu>(attrs, ctx, generic.inputs(), req, generic.outputs());
+  ExpectNear(fused.out, generic.out, 1e-4f);
+  ExpectNear(fused.mean, generic.mean, 1e-4f);
+  ExpectNear(fused.std_dev, generic.std_dev, 1e-4f);
+  op::LayerNormGradComputeCPU(attrs, ctx, fused.grad_inputs(), req, fused.grad_outputs());
+  op::LayerNormGradCompute<cpu>(attrs, ctx, generic.grad_inputs(), req,
+                                generic.grad_outputs());
+  ExpectNear(fused.grad_data, generic.grad_data, 1e-3f);
+  ExpectNear(fused.grad_gamma, generic.grad_gamma, 1e-3f);
+  ExpectNear(fused.grad_beta, generic.grad_beta, 1e-3f);
+}
+
+template<typename F>
+double MillisecondsPerCall(F f, int count) {
+  f();
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < count; ++i) f();
+  const std::chrono::duration<double, std::milli> elapsed =
+    std::chrono::steady_clock::now() - start;
+  return elapsed.count() / count;
+}
+
+}  // namespace
+
+/*!
+ * \brief the fused kernels give the results of the broadcast and reduce implementation
+ */
+TEST(LAYER_NORM_PERF, FusedMatchesGeneric) {
+  // rows of lengths which are and are not multiples of the vector width
+  CompareWithGeneric(TShape({4, 7}), -1);
+  CompareWithGeneric(TShape({3, 5, 64}), -1);
+  CompareWithGeneric(TShape({33, 1023}), 1);
+  // trailing axes of size 1 keep the rows contiguous
+  CompareWithGeneric(TShape({6, 40, 1}), 1);
+  // the generic implementation is used for the other axes
+  CompareWithGeneric(TShape({6, 40, 3}), 1);
+}
+
+/*!
+ * \brief timing of the fused kernels and the broadcast and reduce implementation
+ */
+TEST(LAYER_NORM_PERF, TimingCPU) {
+  std::vector<TShape> shapes;
+  if (test::performance_run) {
+    // (batch * sequence length, hidden size) of transformer layers
+    shapes = {{128, 768}, {4096, 768}, {4096, 1024}, {16384, 512}};
+  } else {
+    shapes = {{128, 768}, {1024, 512}};
+  }
+  const int count = test::quick_test ? 1 : 10;
+  const nnvm::NodeAttrs attrs = LayerNormAttrs(-1);
+  const OpContext ctx = CPUContext();
+  const std::vector<OpReqType> req(3, kWriteTo);
+  for (const TShape& shape : shapes) {
+    LayerNormBlobs blobs(shape, 1);
+    const std::vector<TBlob> inputs = blobs.inputs(), outputs = blobs.outputs();
+    const std::vector<TBlob> grad_inputs = blobs.grad_inputs();
+    const std::vector<TBlob> grad_outputs = blobs.grad_outputs();
+    const double fused_fwd = MillisecondsPerCall([&]() {
+      op::LayerNormComputeCPU(attrs, ctx, inputs, req, outputs);
+    }, count);
+    const double generic_fwd = MillisecondsPerCall([&]() {
+      op::LayerNormCompute<cpu>(attrs, ctx, inputs, req, outputs);
+    }, count);
+    const double fused_bwd = MillisecondsPerCall([&]() {
+      op::LayerNormGradComputeCPU(attrs, ctx, grad_inputs, req, grad_outputs);
+    }, count);
+    const double generic_bwd = MillisecondsPerCall([&]() {
+      op::LayerNormGradCompute<cpu>(attrs, ctx, grad_inputs, req, grad_outputs);
+    }, count);
+    std::cout << "LayerNorm " << shape << ": forward " << fused_fwd << " ms fused, "
+              << generic_fwd << " ms generic; backward " << fused_bwd << " ms fused, "
+              << generic_bwd << " ms generic" << std::endl;
+  }
+}
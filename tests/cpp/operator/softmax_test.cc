@@ -0,0 +1,123 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ *  \file softmax_test.cc
+ *  \brief the fast exp of the cpu softmax, and the rows of softmax and log softmax using it
+ */
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+#include "../../src/operator/nn/softmax-inl.h"
+
+using mxnet::index_t;
+using mxnet::op::mxnet_op::FastExp;
+
+namespace {
+
+/*! \brief relative error of FastExp at x */
+double FastExpError(float x) {
+  const double expected = std::exp(static_cast<double>(x));
+  return std::abs(FastExp(x) - expected) / expected;
+}
+
+/*! \brief softmax, or log softmax, of a row in double */
+std::vector<double> ReferenceRow(const std::vector<float>& in, bool is_log) {
+  double mmax = -std::numeric_limits<double>::infinity();
+  for (float x : in) mmax = std::max(mmax, static_cast<double>(x));
+  double sum = 0;
+  for (float x : in) sum += std::exp(x - mmax);
+  std::vector<double> out;
+  for (float x : in) out.push_back(is_log ? x - mmax - std::log(sum) : std::exp(x - mmax) / sum);
+  return out;
+}
+
+void CheckRow(const std::vector<float>& in) {
+  const index_t M = in.size();
+  std::vector<float> out(M);
+  mxnet::op::mxnet_op::SoftmaxRow<true, false>(in.data(), out.data(), M, M, 1.0f);
+  std::vector<double> expected = ReferenceRow(in, false);
+  for (index_t j = 0; j < M; ++j) {
+    // below exp(-87) the fast exp gives exp(-87)
+    EXPECT_NEAR(out[j], expected[j], 1e-5 * expected[j] + 2e-38) << "softmax at " << j;
+  }
+  mxnet::op::mxnet_op::SoftmaxRow<true, true>(in.data(), out.data(), M, M, 1.0f);
+  expected = ReferenceRow(in, true);
+  for (index_t j = 0; j < M; ++j) {
+    EXPECT_NEAR(out[j], expected[j], 1e-6 * (1 + std::abs(expected[j])))
+      << "log softmax at " << j;
+  }
+}
+
+}  // namespace
+
+/*!
+ * \brief the relative error of FastExp is below 4e-7 in [-87, 88]
+ */
+TEST(SOFTMAX, FastExpError) {
+  double worst = 0;
+  std::mt19937 gen(5);
+  std::uniform_real_distribution<float> dist(-87.0f, 88.0f);
+  for (int i = 0; i < 1000000; ++i) worst = std::max(worst, FastExpError(dist(gen)));
+  // every float around the bounds, 0, and the ends of the interval of the polynomial
+  for (float center : {-87.0f, -0.34657359f, 0.0f, 0.34657359f, 88.0f}) {
+    float x = center;
+    for (int i = 0; i < 10000; ++i) x = std::nextafter(x, -100.0f);
+    for (int i = 0; i < 20000; ++i, x = std::nextafter(x, 100.0f)) {
+      if (x >= -87.0f && x <= 88.0f) worst = std::max(worst, FastExpError(x));
+    }
+  }
+  EXPECT_LT(worst, 4e-7);
+  EXPECT_EQ(FastExp(0.0f), 1.0f);
+}
+
+/*!
+ * \brief inputs out of [-87, 88] are clamped, NaN stays NaN
+ */
+TEST(SOFTMAX, FastExpEdges) {
+  const float inf = std::numeric_limits<float>::infinity();
+  for (float x : {-87.5f, -100.0f, -1e4f, -1e30f, -inf}) EXPECT_EQ(FastExp(x), FastExp(-87.0f));
+  for (float x : {88.5f, 100.0f, 1e4f, 1e30f, inf}) EXPECT_EQ(FastExp(x), FastExp(88.0f));
+  EXPECT_TRUE(std::isfinite(FastExp(88.0f)));
+  EXPECT_GT(FastExp(-87.0f), 0.0f);
+  EXPECT_TRUE(std::isnan(FastExp(std::numeric_limits<float>::quiet_NaN())));
+}
+
+/*!
+ * \brief softmax and log softmax of rows with the fast exp, longer than a block, with
+ *  inputs at the bounds of the fast exp and of large magnitude
+ */
+TEST(SOFTMAX, FastRows) {
+  std::mt19937 gen(7);
+  std::normal_distribution<float> dist(0.0f, 10.0f);
+  std::vector<float> row(300);
+  for (float& x : row) x = dist(gen);
+  CheckRow(row);
+  // exp of every input from -87 to 0
+  for (size_t j = 0; j < row.size(); ++j) row[j] = -87.0f * j / (row.size() - 1);
+  CheckRow(row);
+  // differences to the max beyond the bound
+  for (size_t j = 0; j < row.size(); ++j) row[j] = j % 3 == 0 ? 1e4f : (j % 3 == 1 ? -1e4f : 0);
+  CheckRow(row);
+  for (size_t j = 0; j < row.size(); ++j) row[j] = j % 2 ? 88.0f : -88.0f;
+  CheckRow(row);
+}
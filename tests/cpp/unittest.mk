@@ -77,3 +77,4 @@ testclean:
 -include build/tests/cpp/operator/*.d
 -include build/tests/cpp/storage/*.d
 -include build/tests/cpp/engine/*.d
+-include build/tests/cpp/io/*.d
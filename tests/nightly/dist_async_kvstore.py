@@ -18,9 +18,13 @@
 # under the License.
 
 # pylint: skip-file
+import os
 import sys
+import threading
+import time
 sys.path.insert(0, "../../python/")
 import mxnet as mx
+import numpy as np
 
 kv = mx.kv.create('dist_async')
 my_rank = kv.rank
@@ -48,5 +52,72 @@ def test_gluon_trainer_type():
     check_trainer_kv_update('row_sparse', None)
     print('worker ' + str(my_rank) + ' passed test_gluon_trainer_type')
 
+def test_staleness():
+    """with MXNET_KVSTORE_STALENESS=s, a pull after the t-th push of a worker
+    sees at least t - s pushes of every other worker"""
+    staleness = int(os.environ['MXNET_KVSTORE_STALENESS'])
+    shape = (20, 3)
+    num_steps = 10
+    kv.set_optimizer(mx.optimizer.Test(rescale_grad=1.0))
+    dense_key, sparse_key = 100, 101
+    kv.init(dense_key, mx.nd.ones(shape))
+    kv.init(sparse_key, mx.nd.ones(shape).tostype('row_sparse'))
+    all_rows = mx.nd.arange(shape[0], dtype='int64')
+    for t in range(1, num_steps + 1):
+        # the workers run at different speeds
+        time.sleep(0.02 * my_rank)
+        kv.push(dense_key, mx.nd.ones(shape))
+        kv.push(sparse_key, mx.nd.ones(shape).tostype('row_sparse'))
+        dense = mx.nd.zeros(shape)
+        sparse = mx.nd.zeros(shape, stype='row_sparse')
+        kv.pull(dense_key, out=dense)
+        kv.row_sparse_pull(sparse_key, out=sparse, row_ids=all_rows)
+        # the initial value is one
+        lower_bound = 1 + t + (nworker - 1) * max(t - staleness, 0)
+        for val in [dense, sparse]:
+            assert np.all(val.asnumpy() >= lower_bound), (t, val.asnumpy().min(), lower_bound)
+    kv._barrier()
+    print('worker ' + str(my_rank) + ' passed test_staleness')
+
+def test_elastic_staleness():
+    """a worker which joins again starts at the clock of the slowest other worker"""
+    staleness = int(os.environ['MXNET_KVSTORE_STALENESS'])
+    shape = (2, 3)
+    key = 102
+    kv.set_optimizer(mx.optimizer.Test(rescale_grad=1.0))
+    kv.init(key, mx.nd.zeros(shape))
+    leaver = nworker - 1
+
+    def step():
+        kv.push(key, mx.nd.ones(shape))
+        val = mx.nd.zeros(shape)
+        kv.pull(key, out=val)
+        val.wait_to_read()
+
+    kv._barrier()
+    if my_rank == leaver:
+        kv.set_active(False)
+    kv._barrier()
+    if my_rank != leaver:
+        for _ in range(staleness + 3):
+            step()
+    kv._barrier()
+    if my_rank == leaver:
+        kv.set_active(True)
+    kv._barrier()
+    if my_rank != leaver:
+        # the others are more than staleness pushes ahead of the clock the joining worker
+        # had, their pulls would wait for its pushes if it did not start at their clock
+        thread = threading.Thread(target=step)
+        thread.daemon = True
+        thread.start()
+        thread.join(60)
+        assert not thread.is_alive(), 'the pull waits for the worker which joined'
+    kv._barrier()
+    print('worker ' + str(my_rank) + ' passed test_elastic_staleness')
+
 if __name__ == "__main__":
     test_gluon_trainer_type()
+    if 'MXNET_KVSTORE_STALENESS' in os.environ:
+        test_staleness()
+        test_elastic_staleness()
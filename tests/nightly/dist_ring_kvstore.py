@@ -0,0 +1,102 @@
+#!/usr/bin/env python
+
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+# pylint: skip-file
+import sys
+sys.path.insert(0, "../../python/")
+import argparse
+import os
+import numpy as np
+
+parser = argparse.ArgumentParser(description='test the dist_ring kvstore')
+parser.add_argument('--hierarchical', action='store_true',
+                    help='pretend the workers run on two hosts to test the hierarchical ring')
+args = parser.parse_args()
+if args.hierarchical:
+    # 127.0.0.0/8 is all loopback, even and odd workers form two "hosts"
+    os.environ['MXNET_KVSTORE_RING_HOST'] = '127.0.0.%d' % (1 + int(os.environ['DMLC_TASK_ID']) % 2)
+# make a fused bucket hold a few of the small keys only
+os.environ['MXNET_KVSTORE_RING_FUSION_BYTES'] = '1024'
+
+import mxnet as mx
+from mxnet.test_utils import assert_almost_equal
+
+kv = mx.kv.create('dist_ring')
+my_rank = kv.rank
+nworker = kv.num_workers
+
+small_keys = ['small%d' % i for i in range(10)]
+small_shape = (7, 11)
+big_key = 'big'
+big_shape = (1013, 97)
+nrepeat = 3
+
+def init_kv():
+    # only the values of rank 0 count
+    kv.init(small_keys, [mx.nd.ones(small_shape) * (my_rank + 1)] * len(small_keys))
+    kv.init(big_key, mx.nd.ones(big_shape) * (my_rank + 1))
+    kv._barrier()
+
+def test_init():
+    for k in small_keys:
+        val = mx.nd.zeros(small_shape)
+        kv.pull(k, out=val)
+        assert_almost_equal(val.asnumpy(), np.ones(small_shape))
+    val = mx.nd.zeros(big_shape)
+    kv.pull(big_key, out=val)
+    assert_almost_equal(val.asnumpy(), np.ones(big_shape))
+    print('worker ' + str(my_rank) + ' passed test_init')
+
+def test_push_pull():
+    # without an updater the pushed values are summed over the workers and devices
+    num_devs = 2
+    for i in range(nrepeat):
+        vals = [mx.nd.ones(small_shape, mx.cpu(d)) * (my_rank + 1) * (i + 1)
+                for i in range(len(small_keys)) for d in range(num_devs)]
+        kv.push([k for k in small_keys for d in range(num_devs)], vals)
+        kv.push(big_key, [mx.nd.ones(big_shape, mx.cpu(d)) * (my_rank + 1)
+                          for d in range(num_devs)])
+        rank_sum = nworker * (nworker + 1) / 2
+        for i, k in enumerate(small_keys):
+            val = mx.nd.zeros(small_shape)
+            kv.pull(k, out=val)
+            assert_almost_equal(val.asnumpy(), np.ones(small_shape) * rank_sum * (i + 1) * num_devs)
+        val = mx.nd.zeros(big_shape)
+        kv.pull(big_key, out=val)
+        assert_almost_equal(val.asnumpy(), np.ones(big_shape) * rank_sum * num_devs)
+    print('worker ' + str(my_rank) + ' passed test_push_pull')
+
+def test_updater():
+    # every worker applies the same update to its own replica
+    kv.set_optimizer(mx.optimizer.create('test', rescale_grad=1))
+    val = mx.nd.zeros(big_shape)
+    kv.pull(big_key, out=val)
+    expected = val.asnumpy()
+    for i in range(nrepeat):
+        kv.push(big_key, mx.nd.ones(big_shape) * (my_rank + 1))
+        expected += nworker * (nworker + 1) / 2
+    kv.pull(big_key, out=val)
+    assert_almost_equal(val.asnumpy(), expected)
+    print('worker ' + str(my_rank) + ' passed test_updater')
+
+if __name__ == "__main__":
+    init_kv()
+    test_init()
+    test_push_pull()
+    test_updater()
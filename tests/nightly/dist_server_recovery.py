@@ -0,0 +1,109 @@
+#!/usr/bin/env python
+
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+"""Kills the server of a dist_async kvstore and restarts it from its checkpoint.
+
+Run with one server, checkpoints and heartbeats:
+
+    MXNET_KVSTORE_CHECKPOINT_DIR=$(mktemp -d) MXNET_KVSTORE_CHECKPOINT_INTERVAL=1 \\
+    PS_HEARTBEAT_INTERVAL=1 PS_HEARTBEAT_TIMEOUT=2 PS_RESEND=1 \\
+        ../../tools/launch.py -n 2 -s 1 --launcher local python dist_server_recovery.py
+"""
+
+# pylint: skip-file
+import os
+import signal
+import subprocess
+import sys
+import time
+
+checkpoint_dir = os.environ['MXNET_KVSTORE_CHECKPOINT_DIR']
+pid_file = os.path.join(checkpoint_dir, 'server.pid')
+if os.environ.get('DMLC_ROLE') == 'server':
+    # the server runs when mxnet is imported, let the worker of rank 0 kill it
+    with open(pid_file, 'w') as f:
+        f.write(str(os.getpid()))
+
+sys.path.insert(0, "../../python/")
+import mxnet as mx
+import numpy as np
+
+kv = mx.kv.create('dist_async')
+my_rank = kv.rank
+nworker = kv.num_workers
+
+shape = (4, 5)
+key = 3
+lr = 0.1
+momentum = 0.9
+num_steps = 5
+
+def expected_value(num_updates):
+    """the weight after num_updates updates with gradients of ones"""
+    weight, mom = np.float32(1), np.float32(0)
+    for _ in range(num_updates):
+        mom = momentum * mom - lr
+        weight += mom
+    return weight
+
+def push_and_pull(num_updates):
+    for _ in range(num_steps):
+        kv.push(key, mx.nd.ones(shape))
+    # the pull waits for the pushes, and the barrier for the pushes of the other workers
+    val = mx.nd.zeros(shape)
+    kv.pull(key, out=val)
+    val.wait_to_read()
+    kv._barrier()
+    kv.pull(key, out=val)
+    np.testing.assert_allclose(val.asnumpy(), expected_value(num_updates), rtol=1e-5)
+
+def restart_server():
+    interval = int(os.environ.get('MXNET_KVSTORE_CHECKPOINT_INTERVAL', 60))
+    timeout = int(os.environ['PS_HEARTBEAT_TIMEOUT'])
+    # a checkpoint of the values after the last update
+    time.sleep(3 * interval)
+    # the manifest and the files it lists, those of the previous checkpoints are removed
+    files = sorted(os.listdir(os.path.join(checkpoint_dir, 'server_0')))
+    assert len(files) == 3, files
+    assert files[0].startswith('key_%d_' % key), files
+    assert files[1] == 'meta', files
+    assert files[2].startswith('optimizer_states_'), files
+    with open(pid_file) as f:
+        os.kill(int(f.read()), signal.SIGKILL)
+    # the scheduler hands the id of the server to a new node once it is dead
+    time.sleep(2 * timeout)
+    env = dict(os.environ, DMLC_ROLE='server')
+    return subprocess.Popen([sys.executable, os.path.abspath(__file__)], env=env)
+
+def test_server_recovery():
+    # the states of the momentum are restored as well
+    kv.set_optimizer(mx.optimizer.create('sgd', learning_rate=lr, momentum=momentum))
+    kv.init(key, mx.nd.ones(shape))
+    push_and_pull(nworker * num_steps)
+    if my_rank == 0:
+        restart_server()
+    kv._barrier()
+    val = mx.nd.zeros(shape)
+    kv.pull(key, out=val)
+    np.testing.assert_allclose(val.asnumpy(), expected_value(nworker * num_steps), rtol=1e-5)
+    push_and_pull(2 * nworker * num_steps)
+    print('worker ' + str(my_rank) + ' passed test_server_recovery')
+
+if __name__ == "__main__":
+    test_server_recovery()
@@ -112,6 +112,20 @@ def test_sync_push_pull(nrepeat):
                 kv.pull(k, out=val)
                 check_diff(val, num)
 
+    def check_fused_keys(dtype, nrepeat):
+        # the small keys of one call are fused into a single message per server
+        ks = keys_shapes if dtype == 'float32' else fp16_keys_shapes
+        keys = [k for k, _ in ks]
+        before = [mx.nd.zeros(s, dtype=dtype) for _, s in ks]
+        kv.pull(keys, out=before)
+        for i in range(nrepeat):
+            kv.push(keys, [mx.nd.ones(s, dtype=dtype)*(my_rank+1) for _, s in ks])
+            vals = [mx.nd.zeros(s, dtype=dtype) for _, s in ks]
+            kv.pull(keys, out=vals)
+            num = (nworker + 1) * nworker * rate / 2 * (i + 1)
+            for val, b in zip(vals, before):
+                check_diff(val, b + num)
+
     def check_row_sparse_keys(dtype, nrepeat):
         # prepare gradient
         v = mx.nd.zeros(shape, dtype=dtype)
@@ -142,6 +156,9 @@ def test_sync_push_pull(nrepeat):
             for row in row_ids_np:
                 expected[row] = updated_val[row]
             check_diff(val, expected, kv.rank)
+            # pull again without an update in between, served by the row cache if enabled
+            kv.row_sparse_pull(k, out=val, row_ids=row_ids)
+            check_diff(val, expected, kv.rank)
 
     def check_row_sparse_keys_with_zeros(dtype, nrepeat):
         if dtype == 'float32':
@@ -225,6 +242,7 @@ def test_sync_push_pull(nrepeat):
 
     for dtype in ['float16', 'float32']:
         check_default_keys(dtype, nrepeat)
+        check_fused_keys(dtype, nrepeat)
         check_row_sparse_keys(dtype, nrepeat)
         check_row_sparse_keys_with_zeros(dtype, nrepeat)
         check_big_row_sparse_keys(dtype, nrepeat)
@@ -412,7 +430,28 @@ def test_gluon_trainer_step():
         trainer.step(1)
         expected = 1 - (1 + nworker) * nworker / 2
         assert_almost_equal(x.data(ctx).asnumpy(), np.full(shape, expected))
+
+    def check_trainer_step_batched(update_on_kv):
+        # more parameters than one push of MXNET_UPDATE_AGGREGATION_SIZE keys, of distinct sizes
+        ctx = mx.cpu(0)
+        params = mx.gluon.ParameterDict()
+        for i in range(37):
+            params.get('x%d' % i, shape=(i + 1, 3))
+        params.initialize(ctx=ctx, init='ones')
+        trainer = mx.gluon.Trainer(params, 'sgd', {'learning_rate': 1.0, 'multi_precision': False},
+                                   kvstore=kv, update_on_kvstore=update_on_kv)
+        with mx.autograd.record():
+            y = sum([(my_rank + 1) * (i + 1) * mx.nd.sum(p.data(ctx))
+                     for i, p in enumerate(params.values())])
+        y.backward()
+        trainer.step(1)
+        for i, p in enumerate(params.values()):
+            expected = 1 - (i + 1) * (1 + nworker) * nworker / 2
+            assert_almost_equal(p.data(ctx).asnumpy(), np.full(p.shape, expected))
+
     check_trainer_step()
+    check_trainer_step_batched(True)
+    check_trainer_step_batched(False)
     print('worker ' + str(my_rank) + ' passed test_gluon_trainer_step')
 
 def test_gluon_trainer_sparse_step():
@@ -433,6 +472,103 @@ def test_gluon_trainer_sparse_step():
     check_trainer_sparse_step()
     print('worker ' + str(my_rank) + ' passed test_gluon_trainer_sparse_step')
 
+def test_elastic_workers():
+    """the last worker leaves and joins again between steps"""
+    kv.set_optimizer(mx.optimizer.Test(rescale_grad=1.0))
+    dense_key, sparse_key = '1500', '1501'
+    kv.init(dense_key, mx.nd.zeros(shape))
+    kv.init(sparse_key, mx.nd.zeros(shape).tostype('row_sparse'))
+    all_rows = mx.nd.arange(shape[0], dtype='int64')
+    leaver = nworker - 1
+
+    def check_step(expected):
+        kv.push(dense_key, mx.nd.ones(shape))
+        kv.push(sparse_key, mx.nd.ones(shape).tostype('row_sparse'))
+        dense = mx.nd.zeros(shape)
+        sparse = mx.nd.zeros(shape, stype='row_sparse')
+        kv.pull(dense_key, out=dense)
+        kv.row_sparse_pull(sparse_key, out=sparse, row_ids=all_rows)
+        check_diff(dense, expected, my_rank)
+        check_diff(sparse, expected, my_rank)
+
+    check_step(nworker)
+    kv._barrier()
+    if my_rank == leaver:
+        # the step of the others completes once it left, whether they pushed before or after
+        kv.set_active(False)
+        assert kv.active_rank == -1
+    else:
+        check_step(2 * nworker - 1)
+        assert kv.num_active_workers == nworker - 1
+        assert kv.active_rank == my_rank
+    kv._barrier()
+    if my_rank == leaver:
+        kv.set_active(True)
+    kv._barrier()
+    assert kv.num_active_workers == nworker
+    assert kv.active_rank == my_rank
+    check_step(3 * nworker - 1)
+    print('worker ' + str(my_rank) + ' passed test_elastic_workers')
+
+def test_repeated_pushes(nrepeat):
+    """a worker pushes several times before the other workers push once"""
+    lr, wd = 0.1, 0.5
+    kv.set_optimizer(mx.optimizer.SGD(learning_rate=lr, wd=wd, rescale_grad=1.0))
+    # a key pushed in one request, a key pushed in slices, and keys fused in one request
+    keys_shapes = [('1600', shape), ('1601', big_shape), ('1602', shape), ('1603', shape)]
+    for k, s in keys_shapes:
+        kv.init(k, mx.nd.zeros(s))
+
+    def push_all():
+        for _ in range(nrepeat):
+            kv.push('1600', mx.nd.ones(shape) * (my_rank + 1))
+            kv.push('1601', mx.nd.ones(big_shape) * (my_rank + 1))
+            kv.push(['1602', '1603'], [mx.nd.ones(shape) * (my_rank + 1)] * 2)
+        mx.nd.waitall()
+
+    if my_rank == 0:
+        push_all()
+    kv._barrier()
+    if my_rank != 0:
+        push_all()
+    # the weight decay makes the result depend on the gradient of every round
+    expected = 0
+    for _ in range(nrepeat):
+        expected = (1 - lr * wd) * expected - lr * (1 + nworker) * nworker / 2
+    for k, s in keys_shapes:
+        val = mx.nd.zeros(s)
+        kv.pull(k, out=val)
+        assert_almost_equal(val.asnumpy(), np.full(s, expected), rtol=1e-5)
+    print('worker ' + str(my_rank) + ' passed test_repeated_pushes')
+
+def test_row_cache():
+    """the row caches get again the rows an update changed, with standard and lazy updates"""
+    lr, wd = 0.1, 0.5
+    rsp_shape = (4, 3)
+    all_rows = mx.nd.arange(rsp_shape[0], dtype='int64')
+    grad_sum = (1 + nworker) * nworker / 2
+    for key, lazy_update in [('1700', False), ('1701', True)]:
+        kv.set_optimizer(mx.optimizer.SGD(learning_rate=lr, wd=wd, rescale_grad=1.0,
+                                          lazy_update=lazy_update))
+        kv.init(key, mx.nd.ones(rsp_shape).tostype('row_sparse'))
+        expected = np.ones(rsp_shape)
+        for step in range(rsp_shape[0] + 1):
+            out = mx.nd.zeros(rsp_shape, stype='row_sparse')
+            kv.row_sparse_pull(key, out=out, row_ids=all_rows)
+            assert_almost_equal(out.asnumpy(), expected)
+            # a gradient of one row, the weight decay of a standard update changes all rows
+            row = step % rsp_shape[0]
+            grad = mx.nd.zeros(rsp_shape)
+            grad[row] = my_rank + 1
+            kv.push(key, grad.tostype('row_sparse'))
+            if lazy_update:
+                expected[row] *= 1 - lr * wd
+            else:
+                expected *= 1 - lr * wd
+            expected[row] -= lr * grad_sum
+        kv._barrier()
+    print('worker ' + str(my_rank) + ' passed test_row_cache')
+
 if __name__ == "__main__":
     parser = argparse.ArgumentParser(description='test distributed kvstore in dist_sync mode')
     parser.add_argument('--nrepeat', type=int, default=7)
@@ -448,6 +584,12 @@ if __name__ == "__main__":
         test_gluon_trainer_sparse_step()
     elif opt.type == 'invalid_cpu':
         test_invalid_operations()
+    elif opt.type == 'elastic_cpu':
+        test_elastic_workers()
+    elif opt.type == 'repeated_push_cpu':
+        test_repeated_pushes(opt.nrepeat)
+    elif opt.type == 'row_cache_cpu':
+        test_row_cache()
     elif opt.type == 'init_gpu':
         test_sync_init(opt.gpu)
     elif opt.type == 'default_cpu':
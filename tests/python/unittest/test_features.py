@@ -15,10 +15,16 @@
 # specific language governing permissions and limitations
 # under the License.
 
-import mxnet as mx
+import os
+import shutil
+import subprocess
 import sys
+import tempfile
+import numpy as np
+import mxnet as mx
 from mxnet.mxfeatures import *
-from mxnet.base import MXNetError
+from mxnet.base import MXNetError, py_str
+from mxnet.test_utils import assert_almost_equal
 from nose.tools import *
 
 def test_runtime_features():
@@ -30,6 +36,61 @@ def test_runtime_features():
     ok_(type(features_enabled_str()) is str)
     print("Features enabled: {}".format(features_enabled_str()))
 
+# computes the kernels of the instruction set MXNET_CPU_ISA selects on the data of argv[1],
+# saves the results to argv[2] and prints the selected instruction set
+_KERNEL_ISA_SCRIPT = """
+import sys
+import mxnet as mx
+from mxnet.mxfeatures import features_enabled
+data = mx.nd.load(sys.argv[1])[0]
+row = data[:, :1, :]
+mx.nd.save(sys.argv[2], [data * 2 + 1, mx.nd.relu(data), mx.nd.broadcast_mul(data, row),
+                         mx.nd.broadcast_add(data, row), mx.nd.sum(data, axis=1),
+                         mx.nd.sum(data, axis=2), mx.nd.sum(data), mx.nd.max(data, axis=0),
+                         mx.nd.min(data, axis=2)])
+print(','.join(f.name for f in features_enabled() if f.name.startswith('KERNEL_')))
+"""
+
+def test_kernel_isa():
+    kernels = [f.name for f in features_enabled() if f.name.startswith('KERNEL_')]
+    # at most one instruction set is selected, and only when the kernels are built for several
+    ok_(len(kernels) <= 1)
+    if not has_feature(Feature.ISA_DISPATCH.value):
+        eq_(kernels, [])
+    # the kernels give the same results whichever instruction set MXNET_CPU_ISA selects
+    isas = ['generic', 'sse4.2', 'avx2', 'avx512']
+    names = ['', 'KERNEL_SSE4_2', 'KERNEL_AVX2', 'KERNEL_AVX512']
+    data = np.random.uniform(-1, 1, size=(7, 33, 65)).astype(np.float32)
+    tmp = tempfile.mkdtemp()
+    try:
+        data_file = os.path.join(tmp, 'data')
+        mx.nd.save(data_file, [mx.nd.array(data)])
+        results = []
+        widest = 0
+        for i, isa in enumerate(isas):
+            out_file = os.path.join(tmp, isa)
+            selected = subprocess.check_output(
+                [sys.executable, '-c', _KERNEL_ISA_SCRIPT, data_file, out_file],
+                env=dict(os.environ, MXNET_CPU_ISA=isa))
+            selected = py_str(selected).strip().split('\n')[-1]
+            # the widest instruction set the cpu supports, at most the requested one
+            ok_(selected in names[widest:i + 1], (isa, selected))
+            widest = names.index(selected)
+            results.append([arr.asnumpy() for arr in mx.nd.load(out_file)])
+    finally:
+        shutil.rmtree(tmp)
+    if 'MXNET_CPU_ISA' not in os.environ:
+        eq_(selected, kernels[0] if kernels else '')
+    expected = [data * 2 + 1, np.maximum(data, 0), data * data[:, :1, :], data + data[:, :1, :],
+                data.sum(axis=1), data.sum(axis=2), data.sum().reshape(1), data.max(axis=0),
+                data.min(axis=2)]
+    for isa, result in zip(isas, results):
+        for out, exp in zip(result, expected):
+            assert_almost_equal(out, exp, rtol=1e-5, atol=1e-5, names=(isa, 'numpy'))
+        # the vector widths change the order of the sums only
+        for out, generic in zip(result, results[0]):
+            assert_almost_equal(out, generic, rtol=1e-5, atol=1e-6, names=(isa, 'generic'))
+
 @raises(MXNetError)
 def test_has_feature_2large():
     has_feature(sys.maxsize)
@@ -332,6 +332,61 @@ def test_LibSVMIter():
             assert_almost_equal(data.asnumpy(), expected)
             i += 1
 
+    def check_libSVMIter_generated(label_file, batch_size):
+        # enough lines for the parallel parser, with qid, label:weight pairs, features
+        # without values, empty rows and \r\n endings, read for epochs that wrap around
+        rng = np.random.RandomState(11)
+        num_rows, num_cols = 300, 50
+        data = np.zeros((num_rows, num_cols), dtype=np.float32)
+        label = np.zeros((num_rows, 3), dtype=np.float32)
+        labels = rng.randint(-5, 6, size=num_rows).astype(np.float32)
+        data_lines, label_lines = [], []
+        for i in range(num_rows):
+            tokens = ['%d' % labels[i] + (':0.5' if i % 3 == 0 else '')]
+            if i % 4 == 0:
+                tokens.append('qid:%d' % (i // 10))
+            nnz = 0 if i % 17 == 0 else rng.randint(1, 30 if i % 5 == 0 else 8)
+            for col in np.sort(rng.choice(num_cols - 1, nnz, replace=False)):
+                value = '%.3f' % rng.uniform(-10, 10)
+                data[i, col] = float(value)
+                tokens.append('%d:%s' % (col, value))
+            if i % 5 == 0:
+                data[i, num_cols - 1] = 1
+                tokens.append('%d' % (num_cols - 1))
+            data_lines.append(' '.join(tokens))
+            label[i, i % 3] = i
+            label_lines.append('0 %d:%d' % (i % 3, i))
+        cwd = os.getcwd()
+        data_path = os.path.join(cwd, 'generated_data.t')
+        label_path = os.path.join(cwd, 'generated_label.t')
+        with open(data_path, 'wb') as fout:
+            fout.write(('\r\n'.join(data_lines) + '\r\n').encode())
+        with open(label_path, 'wb') as fout:
+            fout.write(('\n'.join(label_lines) + '\n').encode())
+        if label_file:
+            data_iter = mx.io.LibSVMIter(data_libsvm=data_path, data_shape=(num_cols,),
+                                         label_libsvm=label_path, label_shape=(3,),
+                                         batch_size=batch_size)
+        else:
+            data_iter = mx.io.LibSVMIter(data_libsvm=data_path, data_shape=(num_cols,),
+                                         batch_size=batch_size)
+        # with round_batch, the rows used to fill the last batch start the next epoch
+        start = 0
+        for epoch in range(3):
+            end = (start // num_rows + 1) * num_rows
+            for batch in data_iter:
+                rows = np.arange(start, start + batch_size) % num_rows
+                batch.data[0].check_format(True)
+                assert_almost_equal(batch.data[0].asnumpy(), data[rows])
+                if label_file:
+                    assert_almost_equal(batch.label[0].asnumpy(), label[rows])
+                else:
+                    assert_almost_equal(batch.label[0].asnumpy(), labels[rows])
+                assert batch.pad == max(0, start + batch_size - end)
+                start += batch_size
+            assert start >= end
+            data_iter.reset()
+
     def check_libSVMIter_news_data():
         news_metadata = {
             'name': 'news20.t',
@@ -386,6 +441,9 @@ def test_LibSVMIter():
             data_train.get_data().asnumpy()
 
     check_libSVMIter_synthetic()
+    for label_file in [False, True]:
+        for batch_size in [64, 7]:
+            check_libSVMIter_generated(label_file, batch_size)
     check_libSVMIter_news_data()
     assertRaises(MXNetError, check_libSVMIter_exception)
 
@@ -428,8 +486,120 @@ def test_CSVIter():
             assert_almost_equal(data_batch.asnumpy(), expected.asnumpy())
             assert data_batch.asnumpy().dtype == expected.asnumpy().dtype
 
+    def check_CSVIter_edge_cases():
+        # negatives, exponents, empty fields, \r\n and \r endings, and blank lines
+        data_path = os.path.join(os.getcwd(), 'edge.t')
+        with open(data_path, 'wb') as fout:
+            fout.write(b'-1.5,2e3,,-4.25E-2\r\n'
+                       b'\r\n'
+                       b'.5, -7 ,,1e+1\r\n'
+                       b'  \t\n'
+                       b'0,-0.001,3.4e38,-1\r'
+                       b'1,2,3,4')
+        expected = np.array([[-1.5, 2e3, 0, -4.25e-2], [0.5, -7, 0, 10],
+                             [0, -0.001, 3.4e38, -1], [1, 2, 3, 4]], dtype=np.float32)
+        data_iter = mx.io.CSVIter(data_csv=data_path, data_shape=(4,), batch_size=4)
+        batches = [batch.data[0].asnumpy() for batch in data_iter]
+        assert len(batches) == 1
+        assert_almost_equal(batches[0], expected)
+
     for dtype in ['int32', 'int64', 'float32']:
         check_CSVIter_synthetic(dtype=dtype)
+    check_CSVIter_edge_cases()
+
+def write_colbin(path, columns, chunks):
+    """Writes a colbin file as src/io/colbin_format.h describes it, without compression.
+    columns holds (kind, width) of float32 columns, kind 0 for dense and 1 for csr; every
+    chunk holds one entry per column, a 2-D array for dense and a scipy csr matrix for csr."""
+    import struct
+    out = bytearray()
+
+    def pad(align):
+        out.extend(b'\0' * (-len(out) % align))
+
+    def buffer(array):
+        payload = np.ascontiguousarray(array).tobytes()
+        out.extend(b'\0' * (-(len(out) + 24) % 64))
+        out.extend(struct.pack('<IIQQ', 0, array.dtype.itemsize, len(payload), len(payload)))
+        out.extend(payload)
+
+    out.extend(b'MXCOLBIN' + struct.pack('<II', 1, len(columns)))
+    for kind, width in columns:
+        out.extend(struct.pack('<IiQ', kind, 0, width))
+    index = []
+    for chunk in chunks:
+        pad(8)
+        num_rows = chunk[0].shape[0]
+        index.append((len(out), num_rows))
+        out.extend(struct.pack('<QQ', num_rows, 0))
+        for (kind, _), col in zip(columns, chunk):
+            if kind == 0:
+                buffer(col.astype(np.float32))
+            else:
+                buffer(col.indptr.astype(np.int64))
+                buffer(col.indices.astype(np.int64))
+                buffer(col.data.astype(np.float32))
+    pad(8)
+    footer = len(out)
+    for offset, num_rows in index:
+        out.extend(struct.pack('<QQ', offset, num_rows))
+    out.extend(struct.pack('<QQ', len(index), footer) + b'MXCOLBIN')
+    with open(path, 'wb') as fout:
+        fout.write(out)
+
+
+def test_ColBinIter():
+    import scipy.sparse as spsp
+    cwd = os.getcwd()
+    num_rows, width = 23, 5
+    dense = np.random.uniform(-1, 1, (num_rows, width)).astype(np.float32)
+    labels = np.arange(num_rows, dtype=np.float32).reshape(num_rows, 1)
+    csr = spsp.random(num_rows, 50, density=0.1, format='csr', dtype=np.float32)
+    csv_path = os.path.join(cwd, 'data.csv')
+    label_path = os.path.join(cwd, 'label.csv')
+    libsvm_path = os.path.join(cwd, 'data.libsvm')
+    np.savetxt(csv_path, dense, delimiter=',', fmt='%.9g')
+    np.savetxt(label_path, labels, fmt='%d')
+    with open(libsvm_path, 'w') as fout:
+        for i in range(num_rows):
+            row = csr.getrow(i)
+            fout.write(' '.join(['%d' % i] + ['%d:%.9g' % (j, v)
+                                               for j, v in zip(row.indices, row.data)]) + '\n')
+
+    def check(colbin_iter, reference_iter, csr_data):
+        num_batches = 0
+        for batch, expected in zip_longest(colbin_iter, reference_iter):
+            assert batch is not None and expected is not None
+            assert batch.pad == expected.pad
+            # the rows of a round_batch=False tail are padding, whatever their content
+            valid = 5 - batch.pad
+            data = batch.data[0]
+            if csr_data:
+                data.check_format(True)
+            assert_almost_equal(data.asnumpy()[:valid], expected.data[0].asnumpy()[:valid])
+            assert_almost_equal(batch.label[0].asnumpy().reshape(-1)[:valid],
+                                expected.label[0].asnumpy().reshape(-1)[:valid])
+            num_batches += 1
+        assert num_batches == (num_rows + 4) // 5
+
+    # chunks of 10 rows hold batches of 5 in place, chunks of 7 rows split some batches
+    for chunk_rows in [10, 7]:
+        chunks = [(dense[i:i + chunk_rows], labels[i:i + chunk_rows], csr[i:i + chunk_rows])
+                  for i in range(0, num_rows, chunk_rows)]
+        path = os.path.join(cwd, 'data.colbin')
+        write_colbin(path, [(0, width), (0, 1), (1, 50)], chunks)
+        for round_batch in [True, False]:
+            check(mx.io.ColBinIter(path=path, data_column=0, label_column=1, batch_size=5,
+                                   round_batch=round_batch),
+                  mx.io.CSVIter(data_csv=csv_path, data_shape=(width,), label_csv=label_path,
+                                batch_size=5, round_batch=round_batch),
+                  False)
+            check(mx.io.ColBinIter(path=path, data_column=2, label_column=1, batch_size=5,
+                                   round_batch=round_batch),
+                  mx.io.LibSVMIter(data_libsvm=libsvm_path, data_shape=(50,), batch_size=5,
+                                   round_batch=round_batch),
+                  True)
+
 
 def test_ImageRecordIter_seed_augmentation():
     get_cifar10()
@@ -565,5 +735,6 @@ if __name__ == "__main__":
     test_LibSVMIter()
     test_NDArrayIter_csr()
     test_CSVIter()
+    test_ColBinIter()
     test_ImageRecordIter_seed_augmentation()
     test_image_iter_exception()
@@ -223,6 +223,44 @@ def test_sparse_aggregator():
     check_sparse_aggregator(False)
     check_sparse_aggregator(True)
 
+
+@with_seed()
+def test_aggregator_large():
+    """aggregate arrays above MXNET_KVSTORE_BIGARRAY_BOUND, which are reduced in parallel"""
+    def check_dense(num_devs, size, dtype):
+        kv = mx.kv.create()
+        devs = [mx.Context('cpu', i) for i in range(num_devs)]
+        kv.init('a', mx.nd.zeros((size,), dtype=dtype))
+        vals = [mx.nd.random.uniform(-1, 1, shape=(size,), ctx=d).astype(dtype) for d in devs]
+        expected = np.sum([v.asnumpy().astype(np.float64) for v in vals], axis=0)
+        out = mx.nd.empty((size,), dtype=dtype)
+        kv.push('a', vals)
+        kv.pull('a', out=out)
+        rtol = 1e-2 if dtype == np.float16 else 1e-5
+        assert_almost_equal(out.asnumpy(), expected, rtol=rtol, atol=rtol)
+
+    def check_row_sparse(num_devs, num_rows, row_len):
+        kv = mx.kv.create()
+        devs = [mx.Context('cpu', i) for i in range(num_devs)]
+        shape = (num_rows, row_len)
+        kv.init('a', mx.nd.zeros(shape, stype='row_sparse'))
+        # includes an empty array
+        densities = [0.5, 0, 0.01, 0.3]
+        vals = [rand_ndarray(shape, 'row_sparse', density=densities[i % 4]).copyto(d)
+                for i, d in enumerate(devs)]
+        expected = np.sum([v.asnumpy() for v in vals], axis=0)
+        out = mx.nd.sparse.zeros('row_sparse', shape)
+        kv.push('a', vals)
+        kv.row_sparse_pull('a', out=out, row_ids=mx.nd.arange(num_rows))
+        assert_almost_equal(out.asnumpy(), expected)
+
+    for num_devs in [2, 3, 5, 8]:
+        for size in [1000003, 2 ** 21]:
+            check_dense(num_devs, size, np.float32)
+        check_dense(num_devs, 1000003, np.float16)
+        check_dense(num_devs, 1000003, np.float64)
+        check_row_sparse(num_devs, 20000, 64)
+
 def updater(key, recv, local):
     """use updater: += with int keys"""
     assert(isinstance(key, int))
@@ -31,6 +31,8 @@ from mxnet.base import py_str, MXNetError, _as_list
 from common import setup_module, with_seed, teardown, assert_raises_cudnn_not_satisfied, assertRaises
 import unittest
 import os
+import subprocess
+import sys
 
 def check_rnn_consistency(cell1, cell2, T, N, I, H, grad_req, rtol=1e-2, atol=1e-4):
     dshape = (N, T, I)
@@ -3798,6 +3800,16 @@ def test_order():
                            expected=[gt_topk(dat=a_npy, axis=1, ret_typ="indices", k=1,
                                              is_ascend=True)])
 
+    # a single row, which several threads select from
+    single_row_npy = large_matrix_npy[:1]
+    for is_ascend in [True, False]:
+        b = mx.sym.topk(a, axis=1, is_ascend=is_ascend, ret_typ="both", k=10)
+        check_symbolic_forward(b, location={'a': single_row_npy},
+                               expected=[gt_topk(dat=single_row_npy, axis=1, ret_typ="value",
+                                                 k=10, is_ascend=is_ascend),
+                                         gt_topk(dat=single_row_npy, axis=1, ret_typ="indices",
+                                                 k=10, is_ascend=is_ascend)])
+
 
 @with_seed()
 def test_blockgrad():
@@ -4501,6 +4513,35 @@ def test_log_softmax():
             check_symbolic_forward(sym, [data], [np.log(np_softmax(data, axis=axis)+1e-20)])
             check_numeric_gradient(sym, [data], rtol=0.05, atol=1e-3)
 
+@with_seed()
+def test_softmax_with_length():
+    shape = (3, 37, 5)
+    for axis in [1, -1]:
+        for dtype in [np.float32, np.float64]:
+            data = np.random.uniform(-2, 2, size=shape).astype(dtype)
+            lshape = tuple(n for i, n in enumerate(shape) if i != axis % len(shape))
+            length = np.random.randint(0, shape[axis] + 1, size=lshape)
+            ograd = np.random.uniform(-1, 1, size=shape).astype(dtype)
+            # the slices along the axis are moved last, and masked from their length on
+            x = np.moveaxis(data, axis, -1)
+            og = np.moveaxis(ograd, axis, -1)
+            mask = np.arange(shape[axis]) < np.expand_dims(length, -1)
+            e = np.where(mask, np.exp(x - x.max(axis=-1, keepdims=True)), 0)
+            sm = e / np.maximum(e.sum(axis=-1, keepdims=True), 1e-30)
+            log_sm = np.where(mask, np.log(np.maximum(sm, 1e-30)), 0)
+            sm_grad = sm * (og - (og * sm).sum(axis=-1, keepdims=True))
+            og_sum = np.where(mask, og, 0).sum(axis=-1, keepdims=True)
+            log_sm_grad = np.where(mask, og - sm * og_sum, 0)
+            for op, out, grad in [(mx.sym.softmax, sm, sm_grad),
+                                  (mx.sym.log_softmax, log_sm, log_sm_grad)]:
+                sym = op(mx.sym.Variable('data'), mx.sym.Variable('length'), axis=axis,
+                         use_length=True)
+                check_symbolic_forward(sym, [data, length], [np.moveaxis(out, -1, axis)],
+                                       rtol=1e-4, atol=1e-5, dtype=dtype)
+                check_symbolic_backward(sym, [data, length], [ograd],
+                                        [np.moveaxis(grad, -1, axis), np.zeros(lshape)],
+                                        rtol=1e-4, atol=1e-5, dtype=dtype)
+
 def test_softmax_with_large_inputs():
     def softmax_forward(input_data, true_output):
         data = mx.sym.Variable('data')
@@ -4516,6 +4557,46 @@ def test_softmax_with_large_inputs():
     softmax_forward(mx.nd.array([[[[-3.4e38,-3.4e38]]]]), np.array([1.0,1.0]))
     softmax_forward(mx.nd.array([[[[3.4e38,3.4e38]]]]), np.array([1.0,1.0]))
 
+@with_seed()
+def check_softmax_fast_exp():
+    """softmax, log_softmax and their gradients with MXNET_SOFTMAX_FAST_EXP=1, against float64"""
+    shape = (5, 300)
+    data = np.random.normal(0, 10, size=shape).astype(np.float32)
+    cols = np.arange(shape[1])
+    # exp of every input from -87 to 0, and differences to the max beyond the bounds of the
+    # fast exp, where it gives exp(-87) rather than 0
+    data[1] = np.linspace(-87, 0, shape[1])
+    data[2] = np.where(cols % 3 == 0, 1e4, np.where(cols % 3 == 1, -1e4, 0))
+    data[3] = np.where(cols % 2, 88, -88)
+    data[4] = np.where(cols == 0, 1e30, -1e30)
+    ograd = np.random.uniform(-1, 1, size=shape)
+    x = data.astype(np.float64)
+    shifted = x - x.max(axis=-1, keepdims=True)
+    e = np.exp(shifted)
+    sm = e / e.sum(axis=-1, keepdims=True)
+    log_sm = shifted - np.log(e.sum(axis=-1, keepdims=True))
+    sm_grad = sm * (ograd - (ograd * sm).sum(axis=-1, keepdims=True))
+    log_sm_grad = ograd - sm * ograd.sum(axis=-1, keepdims=True)
+    # the relative error of the fast exp is below 4e-7, the sums in float add to it
+    for op, out, grad, atol in [(mx.nd.softmax, sm, sm_grad, 1e-30),
+                                (mx.nd.log_softmax, log_sm, log_sm_grad, 1e-5)]:
+        x_nd = mx.nd.array(data)
+        x_nd.attach_grad()
+        with mx.autograd.record():
+            y = op(x_nd, axis=-1)
+        y.backward(mx.nd.array(ograd))
+        assert_almost_equal(y.asnumpy(), out, rtol=1e-5, atol=atol)
+        assert_almost_equal(x_nd.grad.asnumpy(), grad, rtol=1e-4, atol=1e-6)
+
+def test_softmax_fast_exp():
+    # the flag is read once by a process, the softmax tests run again in another one
+    env = dict(os.environ, MXNET_SOFTMAX_FAST_EXP='1')
+    code = ('import sys; sys.path.insert(0, {!r}); import test_operator as t; '
+            't.check_softmax_fast_exp(); t.test_softmax_with_length(); '
+            't.test_softmax_with_large_inputs()').format(
+                os.path.dirname(os.path.abspath(__file__)))
+    subprocess.check_call([sys.executable, '-c', code], env=env)
+
 @with_seed()
 def test_pick():
     def test_pick_helper(index_type=np.int32):
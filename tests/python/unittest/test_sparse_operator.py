@@ -1907,6 +1907,42 @@ def test_sparse_embedding():
             check_sparse_embedding(in_dim, out_dim, batch, densities, sparse_grad, weight_stype)
             check_sparse_embedding(in_dim, out_dim, batch, densities, sparse_grad, weight_stype)
 
+@with_seed()
+def test_embedding_sparse_grad_duplicates():
+    ''' test the gradient of Embedding for a large vocabulary and repeated indices '''
+    in_dim = 100000
+    out_dim = 7
+    # a few frequent rows and many rare ones, as for the words of a text
+    np_data = np.concatenate([np.random.randint(0, 5, size=200),
+                              np.random.randint(0, in_dim, size=300)])
+    np.random.shuffle(np_data)
+    np_grad = np.random.uniform(-1, 1, (np_data.shape[0], out_dim)).astype(np.float32)
+    expected_idx = np.unique(np_data)
+    expected = np.zeros((in_dim, out_dim), dtype=np.float32)
+    np.add.at(expected, np_data, np_grad)
+    for sparse_grad in [True, False]:
+        for grad_req in ['write', 'add']:
+            if sparse_grad and grad_req == 'add':
+                continue
+            data = mx.sym.Variable("data")
+            embed = mx.sym.Embedding(data=data, input_dim=in_dim, output_dim=out_dim,
+                                     sparse_grad=sparse_grad, name='embed')
+            exe = embed.simple_bind(default_context(), data=np_data.shape,
+                                    grad_req={'data': 'null', 'embed_weight': grad_req})
+            exe.arg_dict['data'][:] = np_data
+            if not sparse_grad:
+                exe.grad_dict['embed_weight'][:] = 1
+            exe.forward(is_train=True)
+            exe.backward([mx.nd.array(np_grad)])
+            weight_grad = exe.grad_dict['embed_weight']
+            if sparse_grad:
+                assert weight_grad.stype == 'row_sparse'
+                assert_almost_equal(weight_grad.indices.asnumpy(), expected_idx)
+                assert_almost_equal(weight_grad.data.asnumpy(), expected[expected_idx],
+                                    rtol=1e-5, atol=1e-5)
+            offset = 1 if grad_req == 'add' else 0
+            assert_almost_equal(weight_grad.asnumpy(), expected + offset, rtol=1e-5, atol=1e-5)
+
 @with_seed()
 def test_sparse_broadcast_add_sub():
     def check_broadcast_add(mx_lhs, mx_rhs, np_lhs, np_rhs, dtype):
@@ -0,0 +1,131 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ *  Copyright (c) 2019 by Contributors
+ * \file colbin.cc
+ * \brief convert the output of any data iterator (CSVIter, LibSVMIter, ...)
+ *  into the columnar binary format read by ColBinIter
+ * \sa src/io/colbin_format.h
+ */
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include <dmlc/base.h>
+#include <dmlc/io.h>
+#include <dmlc/logging.h>
+#include <dmlc/timer.h>
+#include <mxnet/io.h>
+#include <mxnet/ndarray.h>
+#include "../src/io/colbin_format.h"
+
+using namespace mxnet;
+using namespace mxnet::io;
+
+/*! \brief describe a column after the first batch of the iterator */
+colbin::ColumnDesc DescribeColumn(const NDArray &arr) {
+  colbin::ColumnDesc desc;
+  desc.dtype = arr.dtype();
+  const TShape &shape = arr.shape();
+  CHECK_GE(shape.ndim(), 1U);
+  desc.width = shape.ndim() == 1 ? 1 : shape.Size() / shape[0];
+  if (arr.storage_type() == kCSRStorage) {
+    CHECK_EQ(arr.aux_type(csr::kIdx), mshadow::kInt64) << "csr indices must be int64";
+    CHECK_EQ(arr.aux_type(csr::kIndPtr), mshadow::kInt64) << "csr indptr must be int64";
+    desc.kind = colbin::kCSRColumn;
+  } else {
+    CHECK_EQ(arr.storage_type(), kDefaultStorage) << "unsupported storage type";
+    desc.kind = colbin::kDenseColumn;
+  }
+  return desc;
+}
+
+int main(int argc, char *argv[]) {
+  if (argc < 3) {
+    printf("Usage: <iterator> <output.colbin> [iterator parameters in form key=value]\n"\
+           "Writes every batch of the iterator as one chunk of the colbin file, the data\n"\
+           "becomes column 0 and the label column 1. Padding of the last batch is dropped.\n"\
+           "Possible additional parameters:\n"\
+           "\tcompress=COMPRESS[default=0] shuffle and run-length encode the chunks (1)\n"\
+           "Example:\n"\
+           "\tcolbin LibSVMIter train.colbin data_libsvm=train.libsvm "\
+           "data_shape=(1000000,) batch_size=65536\n");
+    return 0;
+  }
+  auto *reg = dmlc::Registry<DataIteratorReg>::Find(argv[1]);
+  CHECK(reg != nullptr) << "unknown data iterator " << argv[1];
+  std::vector<std::pair<std::string, std::string> > kwargs;
+  colbin::Codec codec = colbin::kNoCompression;
+  for (int i = 3; i < argc; ++i) {
+    char key[128], val[1024];
+    CHECK_EQ(sscanf(argv[i], "%127[^=]=%1023s", key, val), 2)
+        << "parameters must be in form key=value: " << argv[i];
+    if (!strcmp(key, "compress")) {
+      codec = atoi(val) ? colbin::kShuffleRLE : colbin::kNoCompression;
+    } else {
+      kwargs.emplace_back(key, val);
+    }
+  }
+  std::unique_ptr<IIterator<DataBatch> > iter(reg->body());
+  iter->Init(kwargs);
+  iter->BeforeFirst();
+
+  std::unique_ptr<dmlc::Stream> fo(dmlc::Stream::Create(argv[2], "w"));
+  std::unique_ptr<colbin::Writer> writer;
+  std::vector<colbin::ColumnDesc> columns;
+  size_t rows = 0, chunks = 0;
+  double tstart = dmlc::GetTime();
+  while (iter->Next()) {
+    const DataBatch &batch = iter->Value();
+    if (writer == nullptr) {
+      for (const NDArray &arr : batch.data) {
+        columns.push_back(DescribeColumn(arr));
+      }
+      writer.reset(new colbin::Writer(fo.get(), columns, codec));
+    }
+    CHECK_EQ(batch.data.size(), columns.size());
+    const TShape &shape = batch.data[0].shape();
+    const size_t num_rows = shape[0] - batch.num_batch_padd;
+    std::vector<colbin::ColumnData> data(columns.size());
+    for (size_t i = 0; i < columns.size(); ++i) {
+      const NDArray &arr = batch.data[i];
+      arr.WaitToRead();
+      data[i].value = arr.data().dptr_;
+      if (columns[i].kind == colbin::kCSRColumn) {
+        data[i].indptr = arr.aux_data(csr::kIndPtr).dptr<int64_t>();
+        data[i].index = arr.aux_data(csr::kIdx).dptr<int64_t>();
+      }
+    }
+    writer->WriteChunk(num_rows, data);
+    rows += num_rows;
+    if (++chunks % 100 == 0) {
+      LOG(INFO) << chunks << " chunks, " << rows << " rows written, "
+                << dmlc::GetTime() - tstart << " sec elapsed";
+    }
+  }
+  CHECK(writer != nullptr) << "the iterator returned no data";
+  writer->Finish();
+  LOG(INFO) << "Total: " << rows << " rows in " << chunks << " chunks written to " << argv[2]
+            << " in " << dmlc::GetTime() - tstart << " sec";
+  return 0;
+}